@@ -0,0 +1,28 @@
+#version 450 core
+
+layout(location = 0) out vec4 o_Color;
+
+layout(location = 0) in vec2 v_TexCoord;
+
+layout(binding = 0) uniform sampler2D u_Density;
+
+uniform int u_Transfer; // 0 = threshold (metaball), 1 = volumetric
+uniform float u_DensityScale;
+uniform float u_Threshold;
+uniform float u_Softness;
+uniform float u_Absorption;
+
+void main()
+{
+	vec4 cell = texture(u_Density, v_TexCoord);
+	float density = cell.a * u_DensityScale;
+	vec3 color = cell.rgb / max(cell.a, 1e-5);
+
+	float alpha;
+	if (u_Transfer == 0)
+		alpha = smoothstep(u_Threshold - u_Softness, u_Threshold + u_Softness, density);
+	else
+		alpha = 1.0 - exp(-density * u_Absorption);
+
+	o_Color = vec4(color, alpha);
+}
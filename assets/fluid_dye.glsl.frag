@@ -0,0 +1,15 @@
+#version 450 core
+
+layout(location = 0) out vec4 o_Color;
+
+layout(location = 0) in vec2 v_TexCoord;
+
+layout(binding = 0) uniform sampler2D u_Dye;
+
+uniform vec4 u_Color;
+
+void main()
+{
+	float dye = texture(u_Dye, v_TexCoord).r;
+	o_Color = vec4(u_Color.rgb, u_Color.a * (1.0 - exp(-dye)));
+}
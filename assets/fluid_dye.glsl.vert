@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) out vec2 v_TexCoord;
+
+uniform mat4 u_ViewProj;
+uniform vec4 u_Bounds; // world-space rectangle the texture covers: (min.xy, max.xy)
+
+// Two triangles over the rectangle, no vertex buffer needed
+void main()
+{
+	const vec2 corners[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0));
+	v_TexCoord = corners[gl_VertexID];
+	gl_Position = u_ViewProj * vec4(mix(u_Bounds.xy, u_Bounds.zw, v_TexCoord), 0.0, 1.0);
+}
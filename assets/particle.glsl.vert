@@ -0,0 +1,19 @@
+#version 450 core
+
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec4 a_Color;
+layout(location = 2) in vec4 a_Instance; // xy = position, z = rotation, w = size
+
+uniform mat4 u_ViewProj;
+
+layout(location = 0) out vec4 v_Color;
+
+void main()
+{
+	float s = sin(a_Instance.z), c = cos(a_Instance.z);
+	vec2 local = a_Position.xy * a_Instance.w;
+	vec2 world = vec2(local.x * c - local.y * s, local.x * s + local.y * c) + a_Instance.xy;
+
+	v_Color = a_Color;
+	gl_Position = u_ViewProj * vec4(world, 0.0, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) out vec4 o_Color;
+
+layout(location = 0) in vec2 v_TexCoord;
+
+layout(binding = 0) uniform sampler2D u_Canvas;
+
+// The canvas is premultiplied; the blend state expects straight alpha
+void main()
+{
+	vec4 canvas = texture(u_Canvas, v_TexCoord);
+	o_Color = vec4(canvas.rgb / max(canvas.a, 1.0 / 255.0), canvas.a);
+}
@@ -0,0 +1,25 @@
+#version 450 core
+
+// PackedParticleInstance: the vertex fetch already normalized color and
+// position and expanded the half floats
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec4 a_Color;
+layout(location = 2) in vec2 a_PackedPosition; // 0..1 across u_Bounds
+layout(location = 3) in vec2 a_RotationSize;
+
+uniform mat4 u_ViewProj;
+uniform vec4 u_Bounds; // min.xy, max.xy
+
+layout(location = 0) out vec4 v_Color;
+
+void main()
+{
+	vec2 center = mix(u_Bounds.xy, u_Bounds.zw, a_PackedPosition);
+
+	float s = sin(a_RotationSize.x), c = cos(a_RotationSize.x);
+	vec2 local = a_Position.xy * a_RotationSize.y;
+	vec2 world = vec2(local.x * c - local.y * s, local.x * s + local.y * c) + center;
+
+	v_Color = a_Color;
+	gl_Position = u_ViewProj * vec4(world, 0.0, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 450 core
+
+layout(location = 0) out vec4 o_Color;
+
+layout(location = 0) in vec4 v_Color;
+layout(location = 1) in vec2 v_TexCoord;
+
+layout(binding = 0) uniform sampler2D u_Atlas;
+
+void main()
+{
+	o_Color = texture(u_Atlas, v_TexCoord) * v_Color;
+}
@@ -0,0 +1,35 @@
+#version 450 core
+
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec4 a_Color;
+layout(location = 2) in vec4 a_Instance; // xy = position, z = rotation, w = size
+layout(location = 3) in float a_Age;     // 0 at birth, 1 at death
+layout(location = 4) in uint a_Flipbook;
+
+uniform mat4 u_ViewProj;
+
+// Must match SpriteAtlas::MaxRegions / MaxFlipbooks
+layout(std140, binding = 0) uniform SpriteAtlas
+{
+	vec4 u_Regions[256];  // uv min.xy, uv max.xy
+	vec4 u_Flipbooks[64]; // first region, frame count, cycles
+};
+
+layout(location = 0) out vec4 v_Color;
+layout(location = 1) out vec2 v_TexCoord;
+
+void main()
+{
+	vec4 flipbook = u_Flipbooks[a_Flipbook];
+	uint frameCount = uint(flipbook.y);
+	uint frame = min(uint(a_Age * flipbook.y * flipbook.z), uint(flipbook.y * flipbook.z) - 1u) % frameCount;
+	vec4 region = u_Regions[uint(flipbook.x) + frame];
+
+	float s = sin(a_Instance.z), c = cos(a_Instance.z);
+	vec2 local = a_Position.xy * a_Instance.w;
+	vec2 world = vec2(local.x * c - local.y * s, local.x * s + local.y * c) + a_Instance.xy;
+
+	v_Color = a_Color;
+	v_TexCoord = mix(region.xy, region.zw, a_Position.xy + 0.5);
+	gl_Position = u_ViewProj * vec4(world, 0.0, 1.0);
+}
@@ -0,0 +1,1787 @@
+// Headless particle workload: runs the emit, update and render-prep stages of
+// ParticlePool at realistic counts without a window or GL context.
+// It is the training run for the PGO build and the scenario set every
+// optimized build is measured against (python3 build.py pgo).
+// --behaviors compares scripted ParticleBehavior effects with hand-written C++.
+// --sampling compares the EmissionSampler sources by cost and clumping.
+// --fluid times the FluidGrid solver per resolution and particle advection per count.
+// --pbd times the ConstraintSolver on 100K constraints of soft bodies, colored and Jacobi.
+// --effects times compiling, loading and looking up a 1,000-effect library.
+// --timelines compares EffectSequencer with a timer per cue per instance on ~12K playing timelines.
+// --burst compares EmitBurst with an Emit loop and checks it is thread-count independent.
+// --colliders times ColliderSet on 1M particles against 1,000 moving colliders and checks the grid against one cell.
+// --forces times ForceVolumeSet on 1M particles with 3,000 local volumes against evaluating every volume.
+// --expiry compares ExpiryWheel retirement of 1M variable-lifetime particles with a lifetime test per particle.
+// --throttle compares a stationary emitter with and without EmissionThrottle by live count, fill and image.
+// --canvas compares a long-running splatter kept alive with one stamped into a ParticleCanvas once it settles.
+// --fused compares ParticlePool::UpdateAndPack with the separate update, prep, bounds and pack passes.
+// --roofline measures peak L2, LLC and DRAM bandwidth and the FLOP rate, then places each per-frame particle kernel
+// under the roof of the level its working set fits in.
+// --capture times encoding 1080p frames of a fountain to PNG and Y4M, as the capture worker does.
+// --telemetry times TelemetryWriter::Write() on the producer side and checks nothing is lost.
+#include "ParticlePool.h"
+#include "ParticleCanvas.h"
+#include "ConstraintSolver.h"
+#include "ColliderSet.h"
+#include "ForceVolumeSet.h"
+#include "EffectCompiler.h"
+#include "EffectLibrary.h"
+#include "EffectSequencer.h"
+#include "Telemetry.h"
+#include "FrameEncoder.h"
+#include "ParticleBehavior.h"
+#include "EmissionSampler.h"
+#include "FluidGrid.h"
+#include "Random.h"
+#include "InstancePacking.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+	#include <xmmintrin.h>
+	#define PARTICLE_BENCH_SSE 1
+#endif
+
+#if defined(__linux__)
+	#include <unistd.h>
+#endif
+
+struct BenchScenario
+{
+	const char* Name;
+	uint32_t Capacity;
+	uint32_t EmitPerFrame;
+	uint32_t BurstInterval; // frames between bursts, 0 = emit every frame
+	float LifeTime;
+};
+
+static const BenchScenario s_Scenarios[] = {
+	{ "fountain", 100000, 1000, 0, 1.5f },
+	{ "sparse", 1000000, 2000, 0, 1.0f },
+	{ "burst", 1000000, 500000, 60, 1.0f },
+};
+
+struct BenchResult
+{
+	double EmitMs = 0.0, UpdateMs = 0.0, PrepMs = 0.0, PackMs = 0.0;
+	uint64_t Instances = 0;
+};
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double ElapsedMs(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static ParticleProps MakeProps(const BenchScenario& scenario)
+{
+	ParticleProps props;
+	props.ColorBegin = { 254 / 255.0f, 212 / 255.0f, 123 / 255.0f, 1.0f };
+	props.ColorEnd = { 254 / 255.0f, 109 / 255.0f, 41 / 255.0f, 1.0f };
+	props.SizeBegin = 0.5f, props.SizeVariation = 0.3f, props.SizeEnd = 0.0f;
+	props.LifeTime = scenario.LifeTime;
+	props.Velocity = { 0.0f, 0.0f };
+	props.VelocityVariation = { 3.0f, 1.0f };
+	props.Position = { 0.0f, 0.0f };
+	return props;
+}
+
+static BenchResult RunScenario(const BenchScenario& scenario, uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f;
+
+	ParticlePool pool(scenario.Capacity);
+	std::vector<ParticleInstance> instances;
+	std::vector<PackedParticleInstance> packed(scenario.Capacity);
+	ParticleProps props = MakeProps(scenario);
+
+	BenchResult result;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		Clock::time_point start = Clock::now();
+		if (scenario.BurstInterval == 0 || frame % scenario.BurstInterval == 0)
+		{
+			for (uint32_t i = 0; i < scenario.EmitPerFrame; i++)
+			{
+				props.Position = { (float)(i % 64) * 0.1f, (float)(frame % 32) * 0.1f };
+				pool.Emit(props);
+			}
+		}
+		result.EmitMs += ElapsedMs(start);
+
+		start = Clock::now();
+		pool.Update(ts);
+		result.UpdateMs += ElapsedMs(start);
+
+		start = Clock::now();
+		uint32_t count = pool.BuildInstances(instances);
+		result.PrepMs += ElapsedMs(start);
+		result.Instances += count;
+
+		start = Clock::now();
+		PackInstances(instances.data(), count, ComputeInstanceBounds(instances.data(), count), packed.data());
+		result.PackMs += ElapsedMs(start);
+	}
+	return result;
+}
+
+struct BehaviorEffect
+{
+	const char* Name;
+	const char* Source;
+	void (*Native)(Particle& particle, float ts, float time);
+};
+
+static glm::vec4 SampleFire(float t)
+{
+	const float stops[] = { 0.0f, 0.4f, 1.0f };
+	const glm::vec4 colors[] = { { 1.0f, 0.9f, 0.5f, 1.0f }, { 1.0f, 0.4f, 0.1f, 0.8f }, { 0.2f, 0.2f, 0.2f, 0.0f } };
+	size_t k = 0;
+	while (k < 2 && t > stops[k + 1])
+		k++;
+	if (k == 2 || t <= stops[k])
+		return colors[k];
+	return glm::mix(colors[k], colors[k + 1], (t - stops[k]) / (stops[k + 1] - stops[k]));
+}
+
+static const BehaviorEffect s_Effects[] = {
+	{
+		"drift",
+		"param gravity = vec2(0, -9.8)\n"
+		"param drag = 0.8\n"
+		"vel += gravity * dt\n"
+		"vel *= 1 - drag * dt\n"
+		"rotation += 2 * dt\n",
+		[](Particle& particle, float ts, float)
+		{
+			particle.Velocity += glm::vec2(0.0f, -9.8f) * ts;
+			particle.Velocity *= 1.0f - 0.8f * ts;
+			particle.Rotation += 2.0f * ts;
+		}
+	},
+	{
+		"fade",
+		"gradient fire = 0.0 (1, 0.9, 0.5, 1), 0.4 (1, 0.4, 0.1, 0.8), 1.0 (0.2, 0.2, 0.2, 0)\n"
+		"color = gradient(fire, age)\n"
+		"size = mix(0.6, 0.0, age * age)\n",
+		[](Particle& particle, float, float)
+		{
+			float age = 1.0f - particle.LifeRemaining / particle.LifeTime;
+			particle.ColorBegin = particle.ColorEnd = SampleFire(age);
+			particle.SizeBegin = particle.SizeEnd = 0.6f + (0.0f - 0.6f) * (age * age);
+		}
+	},
+	{
+		"swirl",
+		"param swirl = 1.5\n"
+		"vel += vec2(-pos.y, pos.x) * (swirl * dt)\n"
+		"pos += vec2(sin(time + pos.y), cos(time + pos.x)) * (0.2 * dt)\n"
+		"color.a = clamp(life * 2, 0, 1)\n",
+		[](Particle& particle, float ts, float time)
+		{
+			float life = particle.LifeRemaining / particle.LifeTime;
+			glm::vec4 color = glm::mix(particle.ColorEnd, particle.ColorBegin, life);
+			particle.Velocity += glm::vec2(-particle.Position.y, particle.Position.x) * (1.5f * ts);
+			particle.Position += glm::vec2(std::sin(time + particle.Position.y), std::cos(time + particle.Position.x)) * (0.2f * ts);
+			color.a = std::min(std::max(particle.LifeRemaining * 2.0f, 0.0f), 1.0f);
+			particle.ColorBegin = particle.ColorEnd = color;
+		}
+	},
+};
+
+static float MaxDifference(const std::vector<Particle>& a, const std::vector<Particle>& b)
+{
+	float difference = 0.0f;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		glm::vec4 color = glm::abs(a[i].ColorBegin - b[i].ColorBegin);
+		glm::vec2 position = glm::abs(a[i].Position - b[i].Position), velocity = glm::abs(a[i].Velocity - b[i].Velocity);
+		difference = std::max({ difference, color.r, color.g, color.b, color.a, position.x, position.y, velocity.x, velocity.y,
+			std::abs(a[i].SizeBegin - b[i].SizeBegin), std::abs(a[i].Rotation - b[i].Rotation) });
+	}
+	return difference;
+}
+
+static int RunBehaviors(uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f;
+	const uint32_t capacity = 200000;
+
+	BenchScenario scenario = { "behavior", capacity, capacity, 0, 4.0f };
+	ParticlePool pool(capacity);
+	ParticleProps props = MakeProps(scenario);
+	for (uint32_t i = 0; i < capacity; i++)
+	{
+		props.Position = { (float)(i % 64) * 0.1f, (float)(i / 64 % 64) * 0.1f };
+		props.LifeTime = 1.0f + (float)(i % 97) * 0.03f;
+		pool.Emit(props);
+	}
+	pool.Update(ts);
+	const std::vector<Particle> initial = pool.GetParticles();
+
+	std::printf("%-10s %8s %12s %10s %10s %8s %10s\n", "effect", "frames", "instructions", "script", "native", "ratio", "maxdiff");
+	for (const BehaviorEffect& effect : s_Effects)
+	{
+		std::string error;
+		auto behavior = ParticleBehavior::Compile(effect.Source, error);
+		if (!behavior)
+		{
+			std::printf("%-10s %s\n", effect.Name, error.c_str());
+			return 1;
+		}
+
+		std::vector<Particle> scripted = initial, native = initial;
+		double scriptMs = 0.0, nativeMs = 0.0;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			float time = frame * ts;
+
+			Clock::time_point start = Clock::now();
+			behavior->Execute(scripted, ts, time);
+			scriptMs += ElapsedMs(start);
+
+			start = Clock::now();
+			JobSystem::ParallelFor((uint32_t)native.size(), 4096, [&](uint32_t begin, uint32_t end, uint32_t)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					if (native[i].Active)
+						effect.Native(native[i], ts, time);
+				}
+			});
+			nativeMs += ElapsedMs(start);
+		}
+
+		std::printf("%-10s %8u %12u %8.3fms %8.3fms %7.2fx %10.2g\n", effect.Name, frames, behavior->GetInstructionCount(),
+			scriptMs / frames, nativeMs / frames, scriptMs / nativeMs, MaxDifference(scripted, native));
+	}
+	return 0;
+}
+
+// Spread of 8x8 bin counts of the velocity jitter over windows of `count`
+// consecutive emissions, relative to the expected count (0 = perfectly even)
+static double Clumping(EmissionSampling sampling, uint32_t count)
+{
+	const uint32_t windows = 64;
+	EmissionSampler sampler;
+	double sum = 0.0;
+	for (uint32_t window = 0; window < windows; window++)
+	{
+		uint32_t bins[64] = {};
+		for (uint32_t i = 0; i < count; i++)
+		{
+			glm::vec4 jitter = sampler.Next(sampling);
+			// Random::Float() may return exactly 1.0
+			uint32_t x = std::min((uint32_t)(jitter.y * 8.0f), 7u), y = std::min((uint32_t)(jitter.z * 8.0f), 7u);
+			bins[y * 8 + x]++;
+		}
+
+		double expected = count / 64.0, variance = 0.0;
+		for (uint32_t bin : bins)
+			variance += (bin - expected) * (bin - expected) / 64.0;
+		sum += std::sqrt(variance) / expected;
+	}
+	return sum / windows;
+}
+
+static void RunSampling()
+{
+	const char* names[] = { "random", "r2", "sobol", "bluenoise" };
+	const uint32_t samples = 4000000;
+
+	std::printf("%-10s %12s %12s %12s\n", "sampling", "ns/sample", "clump@256", "clump@128");
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		EmissionSampling sampling = (EmissionSampling)i;
+		EmissionSampler sampler;
+		sampler.Next(sampling); // builds the blue-noise table outside the timed loop
+
+		glm::vec4 sum(0.0f);
+		Clock::time_point start = Clock::now();
+		for (uint32_t sample = 0; sample < samples; sample++)
+			sum += sampler.Next(sampling);
+		double ns = ElapsedMs(start) * 1e6 / samples;
+
+		std::printf("%-10s %12.2f %12.3f %12.3f%s\n", names[i], ns, Clumping(sampling, 256), Clumping(sampling, 128), sum.x < 0.0f ? " " : "");
+	}
+}
+
+static void RunFluid(uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f;
+	const glm::uvec2 resolutions[] = { { 64, 36 }, { 128, 72 }, { 256, 144 } };
+	const uint32_t particleCounts[] = { 10000, 100000, 1000000 };
+
+	std::printf("%-10s %8s %10s", "grid", "frames", "step");
+	for (uint32_t count : particleCounts)
+		std::printf(" %11u", count);
+	std::printf("\n");
+
+	for (const glm::uvec2& resolution : resolutions)
+	{
+		FluidGrid fluid;
+		fluid.GetProps().Width = resolution.x;
+		fluid.GetProps().Height = resolution.y;
+
+		double stepMs = 0.0;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			// A stirring splat circling the centre keeps the field busy
+			float angle = frame * 0.05f;
+			glm::vec2 position = glm::vec2(std::cos(angle), std::sin(angle)) * 0.6f;
+			fluid.AddSplat(position, glm::vec2(-position.y, position.x) * 20.0f, 0.5f, 0.15f);
+
+			Clock::time_point start = Clock::now();
+			fluid.Step(ts);
+			stepMs += ElapsedMs(start);
+		}
+
+		char name[32];
+		std::snprintf(name, sizeof(name), "%ux%u", resolution.x, resolution.y);
+		std::printf("%-10s %8u %8.3fms", name, frames, stepMs / frames);
+
+		// Advection cost scales with particles; the step above never sees them
+		for (uint32_t count : particleCounts)
+		{
+			std::vector<Particle> particles(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				particles[i].Active = true;
+				particles[i].Position = { (float)(i % 1000) * 0.004f - 2.0f, (float)(i / 1000 % 500) * 0.0045f - 1.125f };
+			}
+
+			Clock::time_point start = Clock::now();
+			for (uint32_t frame = 0; frame < 10; frame++)
+				fluid.AdvectParticles(particles, ts);
+			std::printf(" %9.3fms", ElapsedMs(start) / 10);
+		}
+		std::printf("\n");
+	}
+}
+
+static void RunConstraints(uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f;
+	// 200 jellies of 10x10 particles, 502 constraints each, dropped onto the floor and a bumper
+	const uint32_t bodies = 200, columns = 10, rows = 10;
+	const glm::vec2 size = { 0.15f, 0.15f };
+
+	std::printf("%-10s %8s %12s %8s %8s %10s %10s\n", "solver", "frames", "constraints", "colors", "jacobi", "step", "stretch");
+	for (bool jacobi : { false, true })
+	{
+		ParticlePool pool(bodies * columns * rows + 1000);
+		ConstraintSolver solver(pool);
+		solver.GetProps().ForceJacobi = jacobi;
+		solver.AddCircleCollider({ 0.0f, -0.8f }, 0.3f);
+
+		ParticleProps look = {};
+		look.SizeBegin = 0.01f;
+		std::vector<uint32_t> firsts;
+		for (uint32_t body = 0; body < bodies; body++)
+		{
+			glm::vec2 center = { (float)(body % 20) * 0.2f - 1.9f, (float)(body / 20) * 0.2f - 0.5f };
+			firsts.push_back(solver.AddSoftBody(center, size, columns, rows, look, 1.0f));
+		}
+
+		double stepMs = 0.0;
+		for (uint32_t frame = 0; frame < frames; frame++)
+		{
+			Clock::time_point start = Clock::now();
+			solver.Step(ts);
+			stepMs += ElapsedMs(start);
+			pool.Update(ts);
+		}
+
+		// Mean relative error of the horizontal springs: how far the solve is from converged
+		const std::vector<Particle>& particles = pool.GetParticles();
+		float spacing = size.x / (columns - 1);
+		double stretch = 0.0;
+		for (uint32_t first : firsts)
+		{
+			for (uint32_t y = 0; y < rows; y++)
+			{
+				for (uint32_t x = 0; x + 1 < columns; x++)
+				{
+					uint32_t i = first + y * columns + x;
+					stretch += std::abs(glm::distance(particles[i].Position, particles[i + 1].Position) - spacing) / spacing;
+				}
+			}
+		}
+		stretch /= (double)bodies * rows * (columns - 1);
+
+		std::printf("%-10s %8u %12u %8u %8u %8.3fms %10.4f\n", jacobi ? "jacobi" : "colored", frames,
+			solver.GetConstraintCount(), solver.GetColorCount(), solver.GetJacobiCount(), stepMs / frames, stretch);
+	}
+}
+
+static int RunEffects()
+{
+	const uint32_t effectCount = 1000;
+	const char* filepath = "effects_bench.pfx";
+
+	std::string source;
+	char buffer[512];
+	for (uint32_t i = 0; i < effectCount; i++)
+	{
+		std::snprintf(buffer, sizeof(buffer),
+			"effect generated_%u\nloop\nduration %.2f\n"
+			"emitter\n\tshape circle %.2f\n\trate %u\n\tlifetime %.2f\n\tvelocity 0 %.2f\n\tvariation 0.5 0.5\n"
+			"\tsize 0 0.3, 0.5 0.2, 1 0\n\tcolor 0 (1, 0.9, 0.5, 1), 0.5 (1, 0.4, 0.1, 0.8), 1 (0.2, 0.2, 0.2, 0)\n"
+			"emitter\n\tburst %u\n\tlifetime 0.5\n\tvariation 4 4\n\tsize 0.1\n\tcolor (1, 1, 1, 1)\n\n",
+			i, 1.0f + (i % 7) * 0.25f, 0.05f + (i % 5) * 0.02f, 20 + i % 200, 0.5f + (i % 9) * 0.2f, 0.5f + (i % 4) * 0.5f, i % 50);
+		source += buffer;
+	}
+
+	std::string error;
+	EffectCompiler compiler;
+	Clock::time_point start = Clock::now();
+	if (!compiler.AddSource(source, "generated", error) || !compiler.Write(filepath, error))
+	{
+		std::printf("%s\n", error.c_str());
+		return 1;
+	}
+	double compileMs = ElapsedMs(start);
+
+	// Mapping is lazy, so each load also touches every record through validation
+	const uint32_t loads = 50;
+	EffectLibrary library;
+	start = Clock::now();
+	for (uint32_t i = 0; i < loads; i++)
+	{
+		if (!library.Load(filepath, error))
+		{
+			std::printf("%s\n", error.c_str());
+			return 1;
+		}
+	}
+	double loadMs = ElapsedMs(start) / loads;
+
+	std::vector<std::string> names;
+	for (uint32_t i = 0; i < effectCount; i++)
+		names.push_back("generated_" + std::to_string(i));
+
+	const uint32_t rounds = 100;
+	uint32_t found = 0, emitters = 0;
+	start = Clock::now();
+	for (uint32_t round = 0; round < rounds; round++)
+	{
+		for (const std::string& name : names)
+		{
+			const EffectRecord* effect = library.Find(name);
+			found += effect != nullptr;
+			emitters += effect ? effect->EmitterCount : 0;
+		}
+	}
+	double lookupNs = ElapsedMs(start) * 1e6 / ((double)rounds * effectCount);
+
+	std::printf("%-8s %10s %12s %10s %10s %12s\n", "effects", "bytes", "compile", "load", "lookup", "found");
+	std::printf("%-8u %10u %10.3fms %8.3fms %8.1fns %12u\n", library.GetEffectCount(), (uint32_t)compiler.Build().size(),
+		compileMs, loadMs, lookupNs, found / rounds);
+	std::remove(filepath);
+	return found == rounds * effectCount && emitters == found * 2 ? 0 : 1;
+}
+
+static int RunTimelines(uint32_t frames)
+{
+	// 16 one-frame cues over 2 s; 100 new instances a frame keep ~12K playing
+	std::string source = "effect tick\nduration 0.01\nemitter\n\tburst 1\n\tlifetime 0.1\n\tvariation 1 1\n\ntimeline chain\n";
+	for (uint32_t i = 0; i < 16; i++)
+		source += "at " + std::to_string(i * 0.125f) + " tick\n";
+	const uint32_t startsPerFrame = 100;
+	const float ts = 1.0f / 60.0f;
+
+	std::string error;
+	EffectCompiler compiler;
+	EffectLibrary library;
+	if (!compiler.AddSource(source, "timelines", error) || !library.Load(compiler.Build(), error))
+	{
+		std::printf("%s\n", error.c_str());
+		return 1;
+	}
+	const TimelineRecord& timeline = *library.FindTimeline("chain");
+	const TimelineCue* cues = library.GetCues(timeline);
+	const EffectRecord& tick = library.GetEffect(0);
+	double playLength = tick.Duration;
+
+	ParticlePool sequencedPool(100000), timedPool(100000);
+	EffectSequencer sequencer;
+	sequencer.SetLibrary(&library);
+
+	// What layer code did before: every instance checks every cue every frame
+	struct TimedInstance
+	{
+		glm::vec2 Position;
+		double Time;
+	};
+	std::vector<TimedInstance> timed;
+	uint64_t timedFired = 0;
+
+	double sequencedMs = 0.0, timedMs = 0.0;
+	uint32_t peakInstances = 0;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		for (uint32_t i = 0; i < startsPerFrame; i++)
+		{
+			glm::vec2 position = { Random::Float() * 10.0f - 5.0f, Random::Float() * 6.0f - 3.0f };
+			sequencer.Play(timeline, position);
+			timed.push_back({ position, 0.0 });
+		}
+
+		Clock::time_point start = Clock::now();
+		sequencer.OnUpdate(sequencedPool, ts);
+		sequencedMs += ElapsedMs(start);
+
+		start = Clock::now();
+		for (size_t i = 0; i < timed.size();)
+		{
+			TimedInstance& instance = timed[i];
+			double begin = instance.Time, end = begin + ts;
+			instance.Time = end;
+			for (uint32_t c = 0; c < timeline.CueCount; c++)
+			{
+				double cueEnd = cues[c].Time + playLength;
+				if (end <= cues[c].Time || begin >= cueEnd)
+					continue;
+				double clippedBegin = std::max(begin, (double)cues[c].Time), clippedEnd = std::min(end, cueEnd);
+				timedFired += begin <= cues[c].Time;
+				library.Emit(tick, timedPool, instance.Position, (float)(clippedEnd - cues[c].Time), (float)(clippedEnd - clippedBegin));
+			}
+
+			if (end >= timeline.Length + playLength)
+			{
+				instance = timed.back();
+				timed.pop_back();
+				continue;
+			}
+			i++;
+		}
+		timedMs += ElapsedMs(start);
+		peakInstances = std::max(peakInstances, sequencer.GetInstanceCount());
+	}
+
+	std::printf("%-10s %10s %10s %12s\n", "scheduler", "instances", "fired", "per frame");
+	std::printf("%-10s %10u %10llu %10.3fms\n", "timers", peakInstances, (unsigned long long)timedFired, timedMs / frames);
+	std::printf("%-10s %10u %10llu %10.3fms\n", "sequencer", peakInstances, (unsigned long long)sequencer.GetFiredCount(), sequencedMs / frames);
+	std::printf("speedup %.2fx\n", timedMs / sequencedMs);
+	return sequencer.GetFiredCount() == timedFired ? 0 : 1;
+}
+
+static int RunTelemetry()
+{
+	TelemetryProps props;
+	props.Directory = "telemetry_bench";
+	props.MaxFileBytes = 1 << 20; // forces a few rotations
+	props.MaxFiles = 4;
+
+	TelemetryWriter writer;
+	std::string error;
+	if (!writer.Open(props, error))
+	{
+		std::printf("%s\n", error.c_str());
+		return 1;
+	}
+
+	// Bursts of a few seconds' worth of frames, far faster than a real frame loop
+	const uint32_t bursts = 100, burstSize = 1000;
+	double writeMs = 0.0;
+	TelemetryRecord record = {};
+	for (uint32_t burst = 0; burst < bursts; burst++)
+	{
+		Clock::time_point start = Clock::now();
+		for (uint32_t i = 0; i < burstSize; i++)
+		{
+			record.Frame++;
+			record.FrameMs = 16.6f + (float)(i % 7);
+			writer.Write(record);
+		}
+		writeMs += ElapsedMs(start);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	writer.Close();
+
+	uint64_t files = 0, bytes = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(props.Directory))
+	{
+		files++;
+		bytes += entry.file_size();
+	}
+	std::filesystem::remove_all(props.Directory);
+
+	std::printf("%10s %12s %10s %10s %8s %12s\n", "records", "write", "written", "dropped", "files", "kept bytes");
+	std::printf("%10u %10.1fns %10llu %10llu %8llu %12llu\n", bursts * burstSize, writeMs * 1e6 / (bursts * burstSize),
+		(unsigned long long)writer.GetWrittenCount(), (unsigned long long)writer.GetDroppedCount(),
+		(unsigned long long)files, (unsigned long long)bytes);
+	return writer.GetWrittenCount() + writer.GetDroppedCount() == bursts * burstSize && files <= props.MaxFiles ? 0 : 1;
+}
+
+// Unrotated alpha-blended squares in a 16:9 view 10 units high, like the sandbox's default camera
+static void RasterizeInstances(const std::vector<ParticleInstance>& instances, uint32_t count, uint32_t width, uint32_t height, std::vector<uint8_t>& rgba)
+{
+	std::fill(rgba.begin(), rgba.end(), (uint8_t)0);
+	float scale = height / 10.0f;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const ParticleInstance& instance = instances[i];
+		float half = instance.Size * scale * 0.5f;
+		float cx = width * 0.5f + instance.Position.x * scale, cy = height * 0.5f + instance.Position.y * scale;
+		int x0 = std::max(0, (int)(cx - half)), x1 = std::min((int)width, (int)(cx + half) + 1);
+		int y0 = std::max(0, (int)(cy - half)), y1 = std::min((int)height, (int)(cy + half) + 1);
+		float alpha = glm::clamp(instance.Color.a, 0.0f, 1.0f);
+		for (int y = y0; y < y1; y++)
+		{
+			uint8_t* pixel = rgba.data() + ((size_t)y * width + x0) * 4;
+			for (int x = x0; x < x1; x++, pixel += 4)
+			{
+				for (int c = 0; c < 3; c++)
+					pixel[c] = (uint8_t)(pixel[c] + (glm::clamp(instance.Color[c], 0.0f, 1.0f) * 255.0f - pixel[c]) * alpha);
+				pixel[3] = 255;
+			}
+		}
+	}
+}
+
+static int RunCapture(uint32_t frames)
+{
+	const uint32_t width = 1920, height = 1080;
+	const float ts = 1.0f / 60.0f;
+
+	ParticlePool pool(100000);
+	ParticleProps props = MakeProps(s_Scenarios[0]);
+	std::vector<ParticleInstance> instances;
+	std::vector<uint8_t> rgba((size_t)width * height * 4), png, yuv;
+
+	double rasterMs = 0.0, pngMs = 0.0, yuvMs = 0.0;
+	uint64_t pngBytes = 0;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		for (uint32_t i = 0; i < 50; i++)
+			pool.Emit(props);
+		pool.Update(ts);
+		uint32_t count = pool.BuildInstances(instances);
+
+		Clock::time_point start = Clock::now();
+		RasterizeInstances(instances, count, width, height, rgba);
+		rasterMs += ElapsedMs(start);
+
+		start = Clock::now();
+		FrameEncoder::EncodePNG(rgba.data(), width, height, png);
+		pngMs += ElapsedMs(start);
+		pngBytes += png.size();
+
+		start = Clock::now();
+		FrameEncoder::ConvertYUV420(rgba.data(), width, height, yuv);
+		yuvMs += ElapsedMs(start);
+	}
+
+	// Round trip through the file writers once
+	std::string error;
+	FrameEncoder encoder;
+	bool written = encoder.Open("capture_bench", CaptureFormat::PNG, width, height, 60, error) && encoder.Encode(rgba.data());
+	written = written && encoder.Open("capture_bench/capture.y4m", CaptureFormat::Y4M, width, height, 60, error) && encoder.Encode(rgba.data());
+	encoder.Close();
+	std::filesystem::remove_all("capture_bench");
+
+	const double rawMB = width * height * 4 / 1e6;
+	std::printf("%ux%u, %u frames, %.2f MB raw RGBA, %.2f ms to rasterize\n", width, height, frames, rawMB, rasterMs / frames);
+	std::printf("%-8s %10s %12s %12s %14s\n", "format", "encode", "frame size", "worker load", "worker MB/s");
+	std::printf("%-8s %8.3fms %10.3fMB %11.1f%% %14.1f\n", "png", pngMs / frames, pngBytes / 1e6 / frames,
+		pngMs / frames / (1000.0 / 60.0) * 100.0, pngBytes / 1e6 / frames * 60.0);
+	std::printf("%-8s %8.3fms %10.3fMB %11.1f%% %14.1f\n", "y4m", yuvMs / frames, yuv.size() / 1e6,
+		yuvMs / frames / (1000.0 / 60.0) * 100.0, yuv.size() / 1e6 * 60.0);
+	if (!written)
+		std::printf("write failed: %s\n", error.c_str());
+	return written ? 0 : 1;
+}
+
+static bool SameParticles(const ParticlePool& a, const ParticlePool& b)
+{
+	for (uint32_t i = 0; i < a.GetCapacity(); i++)
+	{
+		const Particle& x = a.GetParticles()[i];
+		const Particle& y = b.GetParticles()[i];
+		if (x.Active != y.Active || x.Position != y.Position || x.Velocity != y.Velocity || x.Rotation != y.Rotation
+			|| x.SizeBegin != y.SizeBegin || x.ColorBegin != y.ColorBegin || x.LifeRemaining != y.LifeRemaining)
+			return false;
+	}
+	return true;
+}
+
+static int RunBurst()
+{
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	const EmissionSampling samplings[] = { EmissionSampling::Random, EmissionSampling::R2, EmissionSampling::Sobol, EmissionSampling::BlueNoise };
+	const char* samplingNames[] = { "random", "r2", "sobol", "bluenoise" };
+	BenchScenario scenario = s_Scenarios[2];
+	ParticleProps props = MakeProps(scenario);
+
+	std::printf("%-10s %10s %12s %12s %8s\n", "sampling", "count", "emit loop", "burst", "speedup");
+	for (uint32_t s = 0; s < 4; s++)
+	{
+		props.Sampling = samplings[s];
+		ParticlePool warmup(16);
+		warmup.Emit(props); // builds the blue-noise table outside the timings
+		for (uint32_t count : counts)
+		{
+			ParticlePool serial(count + 1000), burst(count + 1000);
+
+			Clock::time_point start = Clock::now();
+			for (uint32_t i = 0; i < count; i++)
+				serial.Emit(props);
+			double serialMs = ElapsedMs(start);
+
+			// Second burst lands on warm, already-touched memory like it would in a running effect
+			burst.EmitBurst(props, count);
+			start = Clock::now();
+			burst.EmitBurst(props, count);
+			double burstMs = ElapsedMs(start);
+
+			std::printf("%-10s %10u %10.3fms %10.3fms %7.2fx\n", samplingNames[s], count, serialMs, burstMs, serialMs / burstMs);
+		}
+	}
+
+	// Same seed, different worker counts: every slot must match
+	const uint32_t threadCounts[] = { 1, 3, 8 };
+	std::vector<std::unique_ptr<ParticlePool>> pools;
+	for (uint32_t threads : threadCounts)
+	{
+		JobSystem::Shutdown();
+		JobSystem::Init(threads);
+		pools.push_back(std::make_unique<ParticlePool>(300000));
+		pools.back()->SetSeed(1234);
+		for (uint32_t s = 0; s < 4; s++)
+		{
+			props.Sampling = samplings[s];
+			pools.back()->EmitBurst(props, 70001);
+		}
+	}
+	JobSystem::Shutdown();
+	JobSystem::Init();
+
+	bool identical = SameParticles(*pools[0], *pools[1]) && SameParticles(*pools[0], *pools[2]);
+	std::printf("1, 3 and 8 worker threads: %s\n", identical ? "identical" : "DIFFERENT");
+	return identical ? 0 : 1;
+}
+
+// Circles, capsules and boxes on Lissajous paths, covering about 12% of the area
+static void PlaceColliders(ColliderSet& set, uint32_t count, const glm::vec2& half, float time)
+{
+	std::vector<Collider>& colliders = set.GetColliders();
+	colliders.resize(count);
+	float size = 0.35f * std::sqrt(4.0f * half.x * half.y / count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		float speed = 0.2f + 0.05f * (i % 7);
+		float a = time * speed + i * 2.4f, b = 1.3f * time * speed + i * 1.7f;
+		glm::vec2 position = half * glm::vec2(std::sin(a), std::sin(b));
+
+		Collider& collider = colliders[i];
+		collider.Shape = (ColliderShape)(i % 3);
+		collider.Velocity = half * glm::vec2(std::cos(a) * speed, std::cos(b) * 1.3f * speed);
+		collider.Position = position;
+		collider.Radius = size;
+		if (collider.Shape == ColliderShape::Capsule)
+		{
+			glm::vec2 direction = { std::cos(a * 1.5f), std::sin(a * 1.5f) };
+			collider.Position = position - direction * size;
+			collider.End = position + direction * size;
+			collider.Radius = size * 0.5f;
+		}
+		else if (collider.Shape == ColliderShape::Box)
+		{
+			collider.HalfExtents = { size, size * 0.5f };
+			collider.Rotation = a * 2.0f;
+		}
+	}
+}
+
+static int RunColliders(uint32_t frames)
+{
+	const uint32_t particleCount = 1000000, colliderCount = 1000, checkCount = 100000;
+	const glm::vec2 half = { 40.0f, 22.5f };
+	const float ts = 1.0f / 60.0f;
+
+	ParticlePool pool(particleCount);
+	for (Particle& particle : pool.GetParticles())
+	{
+		particle.Active = true;
+		particle.LifeTime = particle.LifeRemaining = 1e6f;
+		particle.Position = half * glm::vec2(Random::Float() * 2.0f - 1.0f, Random::Float() * 2.0f - 1.0f);
+		particle.Velocity = { Random::Float() * 4.0f - 2.0f, Random::Float() * 4.0f - 2.0f };
+	}
+
+	ColliderSet grid;
+	double buildMs = 0.0, collideMs = 0.0;
+	uint64_t contacts = 0;
+	float time = 0.0f;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		time += ts;
+		PlaceColliders(grid, colliderCount, half, time);
+		Clock::time_point start = Clock::now();
+		grid.Build();
+		buildMs += ElapsedMs(start);
+
+		pool.Update(ts);
+		start = Clock::now();
+		contacts += grid.CollideParticles(pool.GetParticles());
+		collideMs += ElapsedMs(start);
+	}
+
+	std::printf("%u particles, %u colliders, %ux%u grid, %u threads\n", particleCount, colliderCount, grid.GetGridWidth(), grid.GetGridHeight(), JobSystem::GetThreadCount());
+	std::printf("%-10s %12s %12s %14s\n", "", "build", "collide", "contacts");
+	std::printf("%-10s %10.3fms %10.3fms %14llu\n", "per frame", buildMs / frames, collideMs / frames, (unsigned long long)(contacts / frames));
+	std::printf("collide %.2f ns per particle\n", collideMs * 1e6 / ((double)frames * particleCount));
+
+	// Every collider in one cell is the brute-force answer; the grid must match it exactly
+	ColliderSet single;
+	single.GetProps().CellSize = 1e6f;
+	PlaceColliders(single, colliderCount, half, time);
+	single.Build();
+
+	std::vector<Particle> gridParticles(pool.GetParticles().begin(), pool.GetParticles().begin() + checkCount);
+	std::vector<Particle> singleParticles = gridParticles;
+	for (Particle& particle : gridParticles)
+		particle.Position += particle.Velocity * ts;
+	for (Particle& particle : singleParticles)
+		particle.Position += particle.Velocity * ts;
+
+	Clock::time_point start = Clock::now();
+	uint32_t gridContacts = grid.CollideParticles(gridParticles);
+	double gridMs = ElapsedMs(start);
+	start = Clock::now();
+	uint32_t singleContacts = single.CollideParticles(singleParticles);
+	double singleMs = ElapsedMs(start);
+
+	bool identical = gridContacts == singleContacts;
+	for (uint32_t i = 0; i < checkCount && identical; i++)
+	{
+		identical = gridParticles[i].Position == singleParticles[i].Position && gridParticles[i].Velocity == singleParticles[i].Velocity;
+	}
+	std::printf("%u particles: grid %.3fms, all colliders %.3fms (%.1fx), %u contacts, %s\n",
+		checkCount, gridMs, singleMs, singleMs / gridMs, gridContacts, identical ? "identical" : "DIFFERENT");
+	return identical ? 0 : 1;
+}
+
+// Drifting wind boxes, turning fans and repeating shockwaves at fixed anchors, as in the sandbox
+static ForceVolume MakeForceVolume(uint32_t i, uint32_t count, const glm::vec2& half, float time)
+{
+	float size = 0.4f * std::sqrt(4.0f * half.x * half.y / count);
+	glm::vec2 anchor = half * glm::vec2(std::sin(i * 2.4f + 0.3f), std::sin(i * 1.7f + 1.1f));
+	float phase = time * (0.3f + 0.05f * (i % 5)) + i;
+
+	ForceVolume volume;
+	volume.Position = anchor;
+	volume.Falloff = 1.0f;
+	if (i % 3 == 0)
+	{
+		volume.Shape = ForceVolumeShape::Box;
+		volume.Position.x += std::sin(phase) * size;
+		volume.HalfExtents = { size, size * 0.5f };
+		volume.Force = glm::vec2(std::cos(phase * 0.7f), 0.3f) * 4.0f;
+		volume.Falloff = 0.0f;
+	}
+	else if (i % 3 == 1)
+	{
+		volume.Shape = ForceVolumeShape::Cone;
+		volume.Radius = size * 2.0f;
+		volume.Rotation = phase;
+		volume.Angle = 0.35f;
+		volume.Radial = 6.0f;
+	}
+	else
+	{
+		float age = phase - std::floor(phase);
+		volume.Radius = size * 1.5f * age;
+		volume.Radial = 20.0f * (1.0f - age);
+	}
+	return volume;
+}
+
+static int RunForces(uint32_t frames)
+{
+	const uint32_t particleCount = 1000000, volumeCount = 3000, checkCount = 100000;
+	const glm::vec2 half = { 40.0f, 22.5f };
+	const float ts = 1.0f / 60.0f;
+	float size = 0.4f * std::sqrt(4.0f * half.x * half.y / volumeCount);
+
+	std::vector<Particle> particles(particleCount);
+	for (Particle& particle : particles)
+	{
+		particle.Active = true;
+		particle.LifeTime = particle.LifeRemaining = 1e6f;
+		particle.Position = half * glm::vec2(Random::Float() * 2.0f - 1.0f, Random::Float() * 2.0f - 1.0f);
+	}
+
+	ForceVolumeSet set;
+	set.SetGrid(-half * 1.2f, half * 1.2f, size * 2.0f);
+	std::vector<uint32_t> ids(volumeCount);
+	for (uint32_t i = 0; i < volumeCount; i++)
+		ids[i] = set.Add(MakeForceVolume(i, volumeCount, half, 0.0f));
+	set.Apply(particles, ts);
+
+	double setMs = 0.0, applyMs = 0.0;
+	uint64_t rebinned = 0, tests = 0, binned = 0;
+	float time = 0.0f;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		time += ts;
+		Clock::time_point start = Clock::now();
+		for (uint32_t i = 0; i < volumeCount; i++)
+			set.Set(ids[i], MakeForceVolume(i, volumeCount, half, time));
+		setMs += ElapsedMs(start);
+
+		start = Clock::now();
+		set.Apply(particles, ts);
+		applyMs += ElapsedMs(start);
+
+		const ForceVolumeStats& stats = set.GetStats();
+		rebinned += stats.Rebinned;
+		tests += stats.Tests;
+		binned += stats.BinnedParticles;
+	}
+
+	std::printf("%u particles, %u volumes, %ux%u grid, %u threads\n", particleCount, volumeCount, set.GetGridWidth(), set.GetGridHeight(), JobSystem::GetThreadCount());
+	std::printf("%-10s %12s %12s %12s %12s %14s\n", "", "set", "apply", "re-binned", "binned", "tests");
+	std::printf("%-10s %10.3fms %10.3fms %12llu %12llu %14llu\n", "per frame", setMs / frames, applyMs / frames,
+		(unsigned long long)(rebinned / frames), (unsigned long long)(binned / frames), (unsigned long long)(tests / frames));
+	std::printf("tests per particle %.2f instead of %u\n", (double)tests / ((double)frames * particleCount), volumeCount);
+
+	// Every volume in one cell is the brute-force answer: each particle against every volume
+	ForceVolumeSet single;
+	single.SetGrid(-half * 1.2f, half * 1.2f, 1e6f);
+	for (uint32_t i = 0; i < volumeCount; i++)
+		single.Add(set.Get(ids[i]));
+
+	std::vector<Particle> gridParticles(particles.begin(), particles.begin() + checkCount);
+	std::vector<Particle> singleParticles = gridParticles;
+	Clock::time_point start = Clock::now();
+	set.Apply(gridParticles, ts);
+	double gridMs = ElapsedMs(start);
+	start = Clock::now();
+	single.Apply(singleParticles, ts);
+	double singleMs = ElapsedMs(start);
+
+	// Volumes sum in a different order per cell, so allow rounding
+	float maxDifference = 0.0f;
+	for (uint32_t i = 0; i < checkCount; i++)
+	{
+		glm::vec2 difference = glm::abs(gridParticles[i].Velocity - singleParticles[i].Velocity);
+		maxDifference = std::max({ maxDifference, difference.x, difference.y });
+	}
+	bool match = maxDifference < 1e-4f;
+	std::printf("%u particles: grid %.3fms, every volume %.3fms (%.1fx), max velocity difference %g, %s\n",
+		checkCount, gridMs, singleMs, singleMs / gridMs, maxDifference, match ? "match" : "MISMATCH");
+
+	// Volumes with no particles in their cells are never visited
+	ForceVolumeSet away;
+	away.SetGrid(-half * 1.2f, glm::vec2(half.x * 5.0f, half.y * 1.2f), size * 2.0f);
+	for (uint32_t i = 0; i < volumeCount; i++)
+	{
+		ForceVolume volume = set.Get(ids[i]);
+		volume.Position.x += half.x * 3.0f;
+		away.Add(volume);
+	}
+	start = Clock::now();
+	away.Apply(particles, ts);
+	std::printf("%u volumes away from the particles: apply %.3fms, %llu tests\n", volumeCount, ElapsedMs(start), (unsigned long long)away.GetStats().Tests);
+	return match && away.GetStats().Tests == 0 ? 0 : 1;
+}
+
+static int RunExpiry(uint32_t frames)
+{
+	const uint32_t capacity = 1000000, warmup = 330;
+	const float ts = 1.0f / 60.0f, minLife = 0.5f, maxLife = 5.0f;
+	const uint32_t emitPerFrame = (uint32_t)(capacity * ts / maxLife);
+
+	// Same emission into the pool and into a copy updated the old way, testing every lifetime every step
+	ParticlePool pool(capacity);
+	std::vector<Particle> scanned(capacity);
+	uint32_t scanIndex = 0;
+	ParticleProps props = MakeProps({ "expiry", capacity, emitPerFrame, 0, 1.0f });
+	auto emit = [&]()
+	{
+		for (uint32_t i = 0; i < emitPerFrame; i++)
+		{
+			props.LifeTime = minLife + Random::Float() * (maxLife - minLife);
+			pool.Emit(props);
+			Particle& particle = scanned[scanIndex];
+			particle = Particle();
+			particle.Active = true;
+			particle.Velocity = props.Velocity;
+			particle.LifeTime = particle.LifeRemaining = props.LifeTime;
+			scanIndex = (scanIndex + 1) % capacity;
+		}
+	};
+	auto scanUpdate = [&]()
+	{
+		uint32_t expired = 0;
+		for (Particle& particle : scanned)
+		{
+			if (!particle.Active)
+				continue;
+			if (particle.LifeRemaining <= 0.0f)
+			{
+				particle.Active = false;
+				expired++;
+				continue;
+			}
+			particle.LifeRemaining -= ts;
+			particle.Position += particle.Velocity * ts;
+			particle.Rotation += 0.01f * ts;
+		}
+		return expired;
+	};
+
+	for (uint32_t frame = 0; frame < warmup; frame++)
+	{
+		emit();
+		pool.Update(ts);
+		scanUpdate();
+	}
+
+	double wheelMs = 0.0, scanMs = 0.0;
+	uint64_t wheelExpired = 0, scanExpired = 0, scheduled = 0, early = 0, late = 0;
+	std::vector<uint8_t> wasActive(capacity);
+	std::vector<Particle>& particles = pool.GetParticles();
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		emit();
+		for (uint32_t i = 0; i < capacity; i++)
+			wasActive[i] = particles[i].Active;
+
+		Clock::time_point start = Clock::now();
+		pool.Update(ts);
+		wheelMs += ElapsedMs(start);
+		wheelExpired += pool.GetExpiredCount();
+		scheduled += pool.GetExpiry().GetScheduledCount();
+
+		start = Clock::now();
+		scanExpired += scanUpdate();
+		scanMs += ElapsedMs(start);
+
+		// Retired no earlier than the tick their lifetime ends in, and never left active with negative life
+		for (uint32_t i = 0; i < capacity; i++)
+		{
+			if (wasActive[i] && !particles[i].Active && particles[i].LifeRemaining > ExpiryWheel::TickDuration + 1e-4f)
+				early++;
+			if (particles[i].Active && particles[i].LifeRemaining < 0.0f)
+				late++;
+		}
+	}
+
+	std::printf("%u slots, %u emitted per frame, lifetimes %.1f-%.1fs\n", capacity, emitPerFrame, minLife, maxLife);
+	std::printf("%-10s %12s %12s %12s\n", "", "update", "expired", "scheduled");
+	std::printf("%-10s %10.3fms %12llu %12llu\n", "wheel", wheelMs / frames, (unsigned long long)(wheelExpired / frames), (unsigned long long)(scheduled / frames));
+	std::printf("%-10s %10.3fms %12llu %12s\n", "scan", scanMs / frames, (unsigned long long)(scanExpired / frames), "-");
+	std::printf("retired early %llu, late %llu\n", (unsigned long long)early, (unsigned long long)late);
+	return early == 0 && late == 0 ? 0 : 1;
+}
+
+static int RunThrottle(uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f;
+	const uint32_t warmup = 120, width = 320, height = 180;
+	const glm::vec2 viewMin = { -80.0f / 9.0f, -5.0f }, viewMax = { 80.0f / 9.0f, 5.0f };
+	const float viewArea = (viewMax.x - viewMin.x) * (viewMax.y - viewMin.y);
+
+	struct ThrottleScenario
+	{
+		const char* Name;
+		uint32_t EmitPerFrame;
+		glm::vec2 VelocityVariation;
+		float AlphaEnd;
+	};
+	// The sandbox's mouse emitter held still, then a denser, slower one that fades out
+	const ThrottleScenario scenarios[] = {
+		{ "cursor", 5, { 3.0f, 1.0f }, 1.0f },
+		{ "pile", 50, { 1.0f, 1.0f }, 0.0f }
+	};
+
+	struct ThrottleResult
+	{
+		double LiveCount = 0.0, Overdraw = 0.0, UpdateMs = 0.0;
+		std::vector<float> Image; // average over the measured frames
+	};
+	auto run = [&](const ThrottleScenario& scenario, bool throttled)
+	{
+		// Room for every emission: wrapping the ring would put new particles over older ones in one run and not another
+		uint32_t capacity = (warmup + frames) * scenario.EmitPerFrame;
+		ParticlePool pool(capacity);
+		pool.GetThrottle().GetProps().Enabled = throttled;
+		pool.GetThrottle().SetView(viewMin, viewMax);
+		ParticleProps props = MakeProps({ scenario.Name, capacity, scenario.EmitPerFrame, 0, 1.0f });
+		props.Position = { 1.0f, 0.5f };
+		props.VelocityVariation = scenario.VelocityVariation;
+		props.ColorEnd.a = scenario.AlphaEnd;
+
+		ThrottleResult result;
+		result.Image.assign((size_t)width * height * 3, 0.0f);
+		std::vector<ParticleInstance> instances;
+		std::vector<uint8_t> rgba((size_t)width * height * 4);
+		for (uint32_t frame = 0; frame < warmup + frames; frame++)
+		{
+			Clock::time_point start = Clock::now();
+			for (uint32_t i = 0; i < scenario.EmitPerFrame; i++)
+				pool.Emit(props);
+			pool.Update(ts);
+			uint32_t count = pool.BuildInstances(instances);
+			double updateMs = ElapsedMs(start);
+			if (frame < warmup)
+				continue;
+
+			// Fill cost measured from the instances, independently of the throttle's own estimate
+			double area = 0.0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const ParticleInstance& instance = instances[i];
+				glm::vec2 low = glm::max(instance.Position - instance.Size * 0.5f, viewMin);
+				glm::vec2 high = glm::min(instance.Position + instance.Size * 0.5f, viewMax);
+				if (low.x < high.x && low.y < high.y)
+					area += (high.x - low.x) * (high.y - low.y);
+			}
+			result.LiveCount += count;
+			result.Overdraw += area / viewArea;
+			result.UpdateMs += updateMs;
+
+			RasterizeInstances(instances, count, width, height, rgba);
+			for (size_t p = 0; p < (size_t)width * height; p++)
+			{
+				for (int c = 0; c < 3; c++)
+					result.Image[p * 3 + c] += rgba[p * 4 + c];
+			}
+		}
+		result.LiveCount /= frames;
+		result.Overdraw /= frames;
+		result.UpdateMs /= frames;
+		for (float& value : result.Image)
+			value /= frames;
+		return result;
+	};
+	// Mean and largest absolute difference over every channel
+	auto difference = [](const std::vector<float>& a, const std::vector<float>& b)
+	{
+		double sum = 0.0, largest = 0.0;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			double error = std::abs(a[i] - b[i]);
+			sum += error;
+			largest = std::max(largest, error);
+		}
+		return glm::dvec2(sum / a.size(), largest);
+	};
+
+	// Unthrottled repeats give the image difference random emission alone produces; the worst of them is the floor.
+	// The floor is a sample too, so an unthrottled run beats it one time in five: the throttle passes within
+	// a quarter above it, if it never adds particles.
+	const uint32_t repeats = 4;
+	bool pass = true;
+	std::printf("%u frames at 60 Hz, emitter held still; image error compares the averaged frames with the first run, in 8-bit levels\n", frames);
+	std::printf("%-8s %-10s %8s %10s %10s %10s %10s\n", "", "", "live", "overdraw", "update", "mean err", "max err");
+	for (const ThrottleScenario& scenario : scenarios)
+	{
+		ThrottleResult reference = run(scenario, false);
+		glm::dvec2 noise(0.0);
+		for (uint32_t i = 0; i < repeats; i++)
+			noise = glm::max(noise, difference(reference.Image, run(scenario, false).Image));
+		ThrottleResult throttled = run(scenario, true);
+		glm::dvec2 change = difference(reference.Image, throttled.Image);
+		bool visible = change.x > noise.x * 1.25 || change.y > noise.y * 1.25;
+
+		std::printf("%-8s %-10s %8.0f %9.2fx %8.3fms %10s %10s\n", scenario.Name, "off", reference.LiveCount, reference.Overdraw, reference.UpdateMs, "-", "-");
+		std::printf("%-8s %-10s %8s %10s %10s %10.3f %10.1f\n", "", "noise", "", "", "", noise.x, noise.y);
+		std::printf("%-8s %-10s %8.0f %9.2fx %8.3fms %10.3f %10.1f%s\n", "", "throttled", throttled.LiveCount, throttled.Overdraw, throttled.UpdateMs, change.x, change.y,
+			visible ? "  above the noise floor" : "");
+		pass = pass && !visible && throttled.LiveCount <= reference.LiveCount;
+	}
+
+	// Emit() alone never wraps this ring; a burst that does puts the next emissions over older particles, so for one
+	// lifetime none may be dropped
+	{
+		const ThrottleScenario& scenario = scenarios[1];
+		const uint32_t capacity = 10000, frameCount = 30;
+		ParticlePool pool(capacity);
+		pool.GetThrottle().GetProps().Enabled = true;
+		pool.GetThrottle().SetView(viewMin, viewMax);
+		ParticleProps props = MakeProps({ scenario.Name, capacity, scenario.EmitPerFrame, 0, 1.0f });
+		props.Position = { 1.0f, 0.5f };
+		props.VelocityVariation = scenario.VelocityVariation;
+		props.ColorEnd.a = scenario.AlphaEnd;
+
+		uint32_t dropped[2] = {};
+		for (uint32_t frame = 0; frame < 60 + 2 * frameCount; frame++)
+		{
+			if (frame == 60 + frameCount)
+				pool.EmitBurst(props, capacity * 3 / 4);
+			for (uint32_t i = 0; i < scenario.EmitPerFrame; i++)
+				pool.Emit(props);
+			pool.Update(ts);
+			if (frame > 60)
+				dropped[frame > 60 + frameCount] += pool.GetThrottle().GetStats().Dropped;
+		}
+		std::printf("%s emission over %u frames: %u dropped before a burst wraps the ring, %u after\n", scenario.Name, frameCount, dropped[0], dropped[1]);
+		pass = pass && dropped[0] > 0 && dropped[1] == 0;
+	}
+	return pass ? 0 : 1;
+}
+
+static int RunCanvas(uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f, drag = 0.9f;
+	const uint32_t capacity = 200000, burstSize = 200;
+
+	// Paint flecks thrown from a wandering point, slowed by a bench-side drag until they settle.
+	// Same seed in both pools, so they emit identical particles.
+	ParticleProps props = MakeProps({ "canvas", capacity, burstSize, 1, 60.0f });
+	props.ColorBegin = props.ColorEnd = { 0.8f, 0.1f, 0.2f, 1.0f };
+	props.SizeBegin = props.SizeEnd = 0.08f;
+	props.SizeVariation = 0.04f;
+	props.VelocityVariation = { 6.0f, 6.0f };
+
+	struct CanvasRun
+	{
+		ParticlePool Pool{ capacity };
+		ParticleCanvas Canvas;
+		double UpdateMs = 0.0, PrepMs = 0.0, StampMs = 0.0;
+		uint64_t DirtyTiles = 0;
+	};
+	auto countLive = [](const ParticlePool& pool)
+	{
+		uint32_t live = 0;
+		for (const Particle& particle : pool.GetParticles())
+			live += particle.Active;
+		return live;
+	};
+
+	CanvasRun runs[2];
+	for (CanvasRun& run : runs)
+	{
+		run.Pool.SetSeed(7);
+		run.Canvas.ClearDirtyTiles();
+	}
+	std::vector<ParticleInstance> instances;
+
+	std::printf("%u frames, a %u-particle burst per frame, 60 s lifetimes, settling after ~%.0f frames\n", frames, burstSize,
+		std::log(runs[0].Pool.GetRestSpeed() / 4.2f) / std::log(drag));
+	std::printf("%-10s %12s %12s\n", "frame", "live", "live stamped");
+	for (uint32_t frame = 1; frame <= frames; frame++)
+	{
+		float t = frame * ts;
+		props.Position = { std::sin(t * 3.0f) * 6.0f, std::cos(t * 1.9f) * 3.0f };
+		for (uint32_t r = 0; r < 2; r++)
+		{
+			CanvasRun& run = runs[r];
+			props.Stamp = r ? (uint32_t)ParticleStampAtRest : 0u;
+			run.Pool.EmitBurst(props, burstSize);
+
+			Clock::time_point start = Clock::now();
+			for (Particle& particle : run.Pool.GetParticles())
+				particle.Velocity *= drag;
+			run.Pool.Update(ts);
+			run.UpdateMs += ElapsedMs(start);
+
+			start = Clock::now();
+			run.Pool.BuildInstances(instances);
+			run.PrepMs += ElapsedMs(start);
+
+			start = Clock::now();
+			const std::vector<ParticleInstance>& stamps = run.Pool.GetStamps();
+			run.Canvas.Stamp(stamps.data(), (uint32_t)stamps.size());
+			run.Pool.ClearStamps();
+			run.StampMs += ElapsedMs(start);
+			run.DirtyTiles += run.Canvas.GetDirtyTiles().size();
+			run.Canvas.ClearDirtyTiles();
+		}
+		if (frame % (frames / 6 ? frames / 6 : 1) == 0)
+			std::printf("%-10u %12u %12u\n", frame, countLive(runs[0].Pool), countLive(runs[1].Pool));
+	}
+
+	uint32_t tileBytes = runs[1].Canvas.GetTileSize() * runs[1].Canvas.GetTileSize() * 4;
+	std::printf("\n%-10s %10s %10s %10s %14s %14s\n", "", "update", "prep", "stamp", "dirty tiles", "upload/frame");
+	for (uint32_t r = 0; r < 2; r++)
+	{
+		const CanvasRun& run = runs[r];
+		std::printf("%-10s %8.3fms %8.3fms %8.3fms %8.1f/%-5u %12.1fKB\n", r ? "stamped" : "live", run.UpdateMs / frames, run.PrepMs / frames, run.StampMs / frames,
+			(double)run.DirtyTiles / frames, run.Canvas.GetTileCount(), (double)run.DirtyTiles * tileBytes / frames / 1024.0);
+	}
+
+	// The stamped canvas with what is still moving drawn on top, against every particle of the other run drawn at once.
+	// Flecks left alive drift under half a texel after passing the rest speed, so only edges may differ.
+	uint32_t count = runs[1].Pool.BuildInstances(instances);
+	runs[1].Canvas.Stamp(instances.data(), count);
+	count = runs[0].Pool.BuildInstances(instances);
+	runs[0].Canvas.Stamp(instances.data(), count);
+
+	uint64_t covered = 0, mismatched = 0;
+	for (uint32_t tile = 0; tile < runs[0].Canvas.GetTileCount(); tile++)
+	{
+		const uint8_t* a = runs[0].Canvas.GetTile(tile);
+		const uint8_t* b = runs[1].Canvas.GetTile(tile);
+		for (uint32_t i = 0; i < tileBytes; i += 4)
+		{
+			covered += a[i + 3] != 0;
+			mismatched += (a[i + 3] != 0) != (b[i + 3] != 0);
+		}
+	}
+	std::printf("\n%llu texels covered, %llu (%.3f%%) differ in coverage\n", (unsigned long long)covered, (unsigned long long)mismatched,
+		covered ? 100.0 * mismatched / covered : 0.0);
+	return countLive(runs[1].Pool) < countLive(runs[0].Pool) && mismatched <= covered / 50 ? 0 : 1;
+}
+
+static int RunFused(uint32_t frames)
+{
+	const float ts = 1.0f / 60.0f;
+	// Everything in view, then only x >= 0 with quads straddling the edge; either way the fused output must match
+	// the multi-pass instances culled the same way, byte for byte, with no centre clamped into the packing rectangle
+	const glm::vec2 views[2][2] = { { { -1e4f, -1e4f }, { 1e4f, 1e4f } }, { { 0.0f, -1e4f }, { 1e4f, 1e4f } } };
+	const char* viewNames[2] = { "all", "half" };
+
+	std::printf("%-10s %-6s %-10s %10s %12s %12s %12s\n", "scenario", "view", "path", "frame", "instances", "read", "written");
+	bool identical = true;
+	for (const BenchScenario& scenario : s_Scenarios)
+	{
+		for (uint32_t v = 0; v < 2; v++)
+		{
+			ParticlePool multi(scenario.Capacity), fused(scenario.Capacity);
+			multi.SetSeed(7);
+			fused.SetSeed(7);
+			ParticleProps props = MakeProps(scenario);
+			std::vector<ParticleInstance> instances, visible;
+			std::vector<PackedParticleInstance> multiPacked(scenario.Capacity), fusedPacked(scenario.Capacity);
+			ParticleBounds view = { views[v][0], views[v][1] };
+
+			double multiMs = 0.0, fusedMs = 0.0;
+			uint64_t multiInstances = 0, fusedInstances = 0;
+			ParticleTraffic multiTraffic, fusedTraffic;
+			for (uint32_t frame = 0; frame < frames; frame++)
+			{
+				if (scenario.BurstInterval == 0 || frame % scenario.BurstInterval == 0)
+				{
+					props.Position = { (float)(frame % 64) * 0.1f - 3.2f, (float)(frame % 32) * 0.1f };
+					multi.EmitBurst(props, scenario.EmitPerFrame);
+					fused.EmitBurst(props, scenario.EmitPerFrame);
+				}
+
+				Clock::time_point start = Clock::now();
+				multi.Update(ts);
+				uint32_t count = multi.BuildInstances(instances);
+				ComputeInstanceBounds(instances.data(), count);
+				PackInstances(instances.data(), count, view, multiPacked.data());
+				multiMs += ElapsedMs(start);
+
+				start = Clock::now();
+				FusedUpdateStats stats = fused.UpdateAndPack(ts, view.Min, view.Max, fusedPacked.data());
+				fusedMs += ElapsedMs(start);
+
+				ParticleTraffic traffic = EstimateMultiPassTraffic(scenario.Capacity, count, true);
+				multiTraffic.ReadBytes += traffic.ReadBytes;
+				multiTraffic.WrittenBytes += traffic.WrittenBytes;
+				traffic = EstimateFusedTraffic(scenario.Capacity, stats.LiveCount, stats.InstanceCount);
+				fusedTraffic.ReadBytes += traffic.ReadBytes;
+				fusedTraffic.WrittenBytes += traffic.WrittenBytes;
+				multiInstances += count;
+				fusedInstances += stats.InstanceCount;
+
+				visible.clear();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const ParticleInstance& instance = instances[i];
+					float reach = std::abs(instance.Size) * 0.70711f;
+					if (glm::all(glm::greaterThanEqual(instance.Position + reach, view.Min)) && glm::all(glm::lessThanEqual(instance.Position - reach, view.Max)))
+					{
+						visible.push_back(instance);
+						if (glm::any(glm::lessThan(instance.Position, stats.PackMin)) || glm::any(glm::greaterThan(instance.Position, stats.PackMax)))
+							identical = false;
+					}
+				}
+				PackInstances(visible.data(), (uint32_t)visible.size(), { stats.PackMin, stats.PackMax }, multiPacked.data());
+				if (visible.size() != stats.InstanceCount || std::memcmp(multiPacked.data(), fusedPacked.data(), visible.size() * sizeof(PackedParticleInstance)) != 0)
+					identical = false;
+			}
+
+			auto print = [&](const char* path, double ms, uint64_t instanceCount, const ParticleTraffic& traffic)
+			{
+				std::printf("%-10s %-6s %-10s %8.3fms %12llu %10.2fMB %10.2fMB\n", scenario.Name, viewNames[v], path, ms / frames,
+					(unsigned long long)(instanceCount / frames), traffic.ReadBytes / (1048576.0 * frames), traffic.WrittenBytes / (1048576.0 * frames));
+			};
+			print("multi-pass", multiMs, multiInstances, multiTraffic);
+			print("fused", fusedMs, fusedInstances, fusedTraffic);
+		}
+	}
+	std::printf("packed instances against the multi-pass path, culled the same way: %s\n", identical ? "identical" : "DIFFERENT");
+	return identical ? 0 : 1;
+}
+
+// STREAM triad a = b + s * c on every thread, each over its own arrays of `bytes` / threads in total,
+// best of several runs, in GB/s. Bytes include the write-allocate read of `a`, unlike STREAM, since that
+// is traffic the bus really carries and the kernels' written lines were already read.
+// Arrays that fit a cache are swept `passes` times per run so the first, cold pass does not dominate.
+static double MeasurePeakBandwidth(size_t bytes, uint32_t passes)
+{
+	const uint32_t runs = 5;
+	uint32_t threads = JobSystem::GetThreadCount();
+	size_t count = std::max<size_t>(bytes / (3 * sizeof(double) * threads), 1024);
+	std::vector<std::vector<double>> a(threads, std::vector<double>(count)), b(threads, std::vector<double>(count, 1.0)), c(threads, std::vector<double>(count, 2.0));
+
+	double best = 0.0;
+	for (uint32_t run = 0; run < runs; run++)
+	{
+		Clock::time_point start = Clock::now();
+		JobSystem::ParallelFor(threads, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+		{
+			for (uint32_t t = begin; t < end; t++)
+			{
+				double* out = a[t].data();
+				const double* x = b[t].data();
+				const double* y = c[t].data();
+				for (uint32_t pass = 0; pass < passes; pass++)
+				{
+					for (size_t i = 0; i < count; i++)
+						out[i] = x[i] + 3.0 * y[i];
+				}
+			}
+		});
+		double ms = ElapsedMs(start);
+		best = std::max(best, 4.0 * sizeof(double) * count * threads * passes / (ms * 1e6));
+	}
+	return a[threads - 1][count / 2] == 7.0 ? best : 0.0;
+}
+
+// Per-core L2 and shared last-level cache sizes in bytes, with typical desktop sizes where the OS does not say
+static void GetCacheSizes(size_t& l2, size_t& llc)
+{
+	l2 = 1u << 20;
+	llc = 32u << 20;
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+	long level2 = sysconf(_SC_LEVEL2_CACHE_SIZE), level3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+	if (level2 > 0)
+		l2 = (size_t)level2;
+	llc = level3 > 0 ? (size_t)level3 : l2;
+#endif
+}
+
+// Independent multiply-add chains on every thread, enough of them to hide the latency; in GFLOP/s
+static double MeasurePeakFlops()
+{
+	const uint32_t iterations = 20000000, chains = 12;
+	uint32_t threads = JobSystem::GetThreadCount();
+	std::vector<float> sums(threads);
+
+	Clock::time_point start = Clock::now();
+	JobSystem::ParallelFor(threads, 1, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t t = begin; t < end; t++)
+		{
+#if PARTICLE_BENCH_SSE
+			__m128 acc[chains];
+			for (uint32_t k = 0; k < chains; k++)
+				acc[k] = _mm_set1_ps((float)(k + t));
+			__m128 scale = _mm_set1_ps(0.999999f), offset = _mm_set1_ps(1e-7f);
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				for (uint32_t k = 0; k < chains; k++)
+					acc[k] = _mm_add_ps(_mm_mul_ps(acc[k], scale), offset);
+			}
+			alignas(16) float lanes[4];
+			__m128 total = acc[0];
+			for (uint32_t k = 1; k < chains; k++)
+				total = _mm_add_ps(total, acc[k]);
+			_mm_store_ps(lanes, total);
+			sums[t] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+			float acc[chains * 4];
+			for (uint32_t k = 0; k < chains * 4; k++)
+				acc[k] = (float)(k + t);
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				for (uint32_t k = 0; k < chains * 4; k++)
+					acc[k] = acc[k] * 0.999999f + 1e-7f;
+			}
+			sums[t] = 0.0f;
+			for (uint32_t k = 0; k < chains * 4; k++)
+				sums[t] += acc[k];
+#endif
+		}
+	});
+	double ms = ElapsedMs(start);
+
+	float sum = 0.0f;
+	for (float value : sums)
+		sum += value;
+	return sum != 0.0f ? 2.0 * 4.0 * chains * iterations * threads / (ms * 1e6) : 0.0;
+}
+
+static int RunRoofline()
+{
+	const uint32_t capacity = 1000000, live = 600000, reps = 20;
+	const float ts = 1.0f / 60.0f;
+
+	// One roof per level, each triad sized to half of it; the DRAM one spans four times the LLC
+	// (at least 768 MB) so no cache can hold it
+	uint32_t threads = JobSystem::GetThreadCount();
+	size_t l2Size, llcSize;
+	GetCacheSizes(l2Size, llcSize);
+	size_t l2Bytes = l2Size / 2 * threads, llcBytes = llcSize / 2, dramBytes = std::max<size_t>(llcSize * 4, (size_t)768 << 20);
+	std::printf("measuring peak memory bandwidth and FLOP rate on %u threads (L2 %zu KB per core, LLC %zu MB)...\n", threads, l2Size >> 10, llcSize >> 20);
+	const char* levels[] = { "L2", "LLC", "DRAM" };
+	size_t roofBytes[] = { l2Bytes, llcBytes, dramBytes };
+	double bandwidth[] = { MeasurePeakBandwidth(l2Bytes, 50), MeasurePeakBandwidth(llcBytes, 4), MeasurePeakBandwidth(dramBytes, 1) };
+	double peakFlops = MeasurePeakFlops();
+	if (bandwidth[0] <= 0.0 || bandwidth[1] <= 0.0 || bandwidth[2] <= 0.0 || peakFlops <= 0.0)
+	{
+		std::printf("peak measurement failed\n");
+		return 1;
+	}
+	// A faster level is never slower than the one behind it; a dip is measurement noise
+	for (int level = 1; level >= 0; level--)
+		bandwidth[level] = std::max(bandwidth[level], bandwidth[level + 1]);
+	std::printf("triad L2 %.2f GB/s, LLC %.2f GB/s, DRAM %.2f GB/s; multiply-add %.2f GFLOP/s; ridge point %.2f flop/byte (DRAM)\n",
+		bandwidth[0], bandwidth[1], bandwidth[2], peakFlops, peakFlops / bandwidth[2]);
+
+	// Long-lived particles, so every kernel sees the same live count on every rep
+	BenchScenario scenario = { "roofline", capacity, live, 0, 1e4f };
+	ParticlePool pool(capacity);
+	pool.SetSeed(7);
+	pool.EmitBurst(MakeProps(scenario), live);
+	std::vector<ParticleInstance> instances;
+	std::vector<PackedParticleInstance> packed(capacity);
+	ParticleBounds view = { { -1e4f, -1e4f }, { 1e4f, 1e4f } };
+	pool.Update(ts);
+	uint32_t count = pool.BuildInstances(instances);
+
+	// Analytic costs per kernel. Bytes are traffic: every slot walked and every live one
+	// written back in full, so achieved GB/s is an upper estimate. Footprint is the distinct
+	// data touched, which decides the roof: repeated runs keep it in the smallest level it fits.
+	// Flops are the float adds, muls, divides, mins and maxes of the source; the integer half
+	// conversion is not counted.
+	const double particle = sizeof(Particle), instance = sizeof(ParticleInstance), record = sizeof(PackedParticleInstance);
+	ParticleTraffic fusedTraffic = EstimateFusedTraffic(capacity, count, count);
+	struct RooflineKernel
+	{
+		const char* Name;
+		double Bytes, Footprint, Flops;
+		std::function<void()> Run;
+	};
+	const RooflineKernel kernels[] = {
+		// LifeRemaining -= ts; Position += Velocity * ts; Rotation += 0.01 * ts
+		{ "update", capacity * particle + count * particle, capacity * particle, count * 7.0, [&]() { pool.Update(ts); } },
+		// life = remaining / lifetime; color and size lerps at 3 flops per component
+		{ "prep", capacity * particle + count * instance, capacity * particle + count * instance, count * 16.0, [&]() { pool.BuildInstances(instances); } },
+		// min and max of x and y
+		{ "bounds", count * instance, count * instance, count * 4.0, [&]() { ComputeInstanceBounds(instances.data(), count); } },
+		// position offset, scale, clamp and round (5 per axis); color clamp, scale and round (4 per channel)
+		{ "pack", count * (instance + record), count * (instance + record), count * 26.0, [&]() { PackInstances(instances.data(), count, view, packed.data()); } },
+		// update, life, size lerp, bounds and cull on every live particle; color lerp and packing on the visible ones
+		{ "fused", (double)fusedTraffic.ReadBytes + fusedTraffic.WrittenBytes, capacity * particle + count * record,
+			count * 20.0 + count * 38.0, [&]() { pool.UpdateAndPack(ts, view.Min, view.Max, packed.data()); } },
+	};
+
+	std::printf("%u slots, %u live, best of %u\n", capacity, count, reps);
+	std::printf("%-8s %9s %9s %9s %9s %10s %8s %9s %6s %12s %8s %8s\n", "kernel", "time", "MB", "MB held", "Mflop", "flop/byte", "GB/s", "GFLOP/s", "roof", "attainable", "of roof", "bound");
+	for (const RooflineKernel& kernel : kernels)
+	{
+		double best = 1e30;
+		for (uint32_t rep = 0; rep < reps; rep++)
+		{
+			Clock::time_point start = Clock::now();
+			kernel.Run();
+			best = std::min(best, ElapsedMs(start));
+		}
+
+		uint32_t level = 0;
+		while (level < 2 && kernel.Footprint > roofBytes[level])
+			level++;
+
+		// Attainable GFLOP/s is the lower of the compute roof and intensity times bandwidth. Traffic is an
+		// upper estimate and part of it may hit a faster level than the footprint suggests, so the
+		// fraction is capped at the roof rather than reported past it.
+		double intensity = kernel.Flops / kernel.Bytes;
+		double gflops = kernel.Flops / (best * 1e6);
+		double attainable = std::min(peakFlops, intensity * bandwidth[level]);
+		std::printf("%-8s %7.3fms %9.2f %9.2f %9.2f %10.3f %8.2f %9.3f %6s %12.2f %7.1f%% %8s\n", kernel.Name, best, kernel.Bytes / 1e6, kernel.Footprint / 1e6,
+			kernel.Flops / 1e6, intensity, kernel.Bytes / (best * 1e6), gflops, levels[level], attainable, std::min(100.0, 100.0 * gflops / attainable),
+			intensity < peakFlops / bandwidth[level] ? "memory" : "compute");
+	}
+	return 0;
+}
+
+static void PrintUsage()
+{
+	std::printf("usage: ParticleBench [--frames N] [--scenario NAME] [--behaviors] [--sampling] [--fluid] [--pbd] [--effects] [--timelines] [--telemetry] [--burst] [--colliders] [--forces] [--expiry] [--throttle] [--canvas] [--fused] [--roofline] [--capture]\n");
+	std::printf("scenarios:");
+	for (const BenchScenario& scenario : s_Scenarios)
+		std::printf(" %s", scenario.Name);
+	std::printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frames = 300;
+	std::string only;
+	bool behaviors = false, sampling = false, fluid = false, pbd = false, effects = false, timelines = false, telemetry = false, burst = false, colliders = false, forces = false, expiry = false, throttle = false, canvas = false, fused = false, roofline = false, capture = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+			frames = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+		else if (!std::strcmp(argv[i], "--scenario") && i + 1 < argc)
+			only = argv[++i];
+		else if (!std::strcmp(argv[i], "--behaviors"))
+			behaviors = true;
+		else if (!std::strcmp(argv[i], "--sampling"))
+			sampling = true;
+		else if (!std::strcmp(argv[i], "--fluid"))
+			fluid = true;
+		else if (!std::strcmp(argv[i], "--pbd"))
+			pbd = true;
+		else if (!std::strcmp(argv[i], "--effects"))
+			effects = true;
+		else if (!std::strcmp(argv[i], "--timelines"))
+			timelines = true;
+		else if (!std::strcmp(argv[i], "--telemetry"))
+			telemetry = true;
+		else if (!std::strcmp(argv[i], "--burst"))
+			burst = true;
+		else if (!std::strcmp(argv[i], "--colliders"))
+			colliders = true;
+		else if (!std::strcmp(argv[i], "--forces"))
+			forces = true;
+		else if (!std::strcmp(argv[i], "--expiry"))
+			expiry = true;
+		else if (!std::strcmp(argv[i], "--throttle"))
+			throttle = true;
+		else if (!std::strcmp(argv[i], "--canvas"))
+			canvas = true;
+		else if (!std::strcmp(argv[i], "--fused"))
+			fused = true;
+		else if (!std::strcmp(argv[i], "--roofline"))
+			roofline = true;
+		else if (!std::strcmp(argv[i], "--capture"))
+			capture = true;
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (sampling)
+	{
+		RunSampling();
+		return 0;
+	}
+
+	if (effects)
+		return RunEffects();
+	if (timelines)
+		return RunTimelines(frames);
+	if (telemetry)
+		return RunTelemetry();
+	if (capture)
+		return RunCapture(std::min(frames, 60u));
+	if (expiry)
+		return RunExpiry(std::min(frames, 120u));
+	if (throttle)
+		return RunThrottle(frames);
+
+	JobSystem::Init();
+
+	if (behaviors)
+	{
+		int status = RunBehaviors(frames);
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (burst)
+	{
+		int status = RunBurst();
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (colliders)
+	{
+		int status = RunColliders(std::min(frames, 60u));
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (roofline)
+	{
+		int status = RunRoofline();
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (canvas)
+	{
+		int status = RunCanvas(std::min(frames, 600u));
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (fused)
+	{
+		int status = RunFused(std::min(frames, 120u));
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (forces)
+	{
+		int status = RunForces(std::min(frames, 60u));
+		JobSystem::Shutdown();
+		return status;
+	}
+
+	if (fluid)
+	{
+		RunFluid(frames);
+		JobSystem::Shutdown();
+		return 0;
+	}
+
+	if (pbd)
+	{
+		RunConstraints(frames);
+		JobSystem::Shutdown();
+		return 0;
+	}
+
+	std::printf("%-10s %8s %10s %10s %10s %10s %10s %12s %14s %14s\n", "scenario", "frames", "emit", "update", "prep", "pack", "total", "instances", "upload", "packed");
+	bool ranAny = false;
+	for (const BenchScenario& scenario : s_Scenarios)
+	{
+		if (!only.empty() && only != scenario.Name)
+			continue;
+
+		BenchResult result = RunScenario(scenario, frames);
+		double total = result.EmitMs + result.UpdateMs + result.PrepMs + result.PackMs;
+		double instances = (double)result.Instances / frames;
+		std::printf("%-10s %8u %8.3fms %8.3fms %8.3fms %8.3fms %8.3fms %12.0f %12.2fMB %12.2fMB\n", scenario.Name, frames,
+			result.EmitMs / frames, result.UpdateMs / frames, result.PrepMs / frames, result.PackMs / frames, total / frames,
+			instances, instances * sizeof(ParticleInstance) / 1e6, instances * sizeof(PackedParticleInstance) / 1e6);
+		ranAny = true;
+	}
+
+	JobSystem::Shutdown();
+
+	if (!ranAny)
+	{
+		PrintUsage();
+		return 1;
+	}
+	return 0;
+}
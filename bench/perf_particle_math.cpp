@@ -0,0 +1,169 @@
+// Compares the per-particle math of ParticleSystem::OnRender (color/size lerp and the
+// translate * rotate * scale transform) on packed (scalar) and aligned (SIMD) glm types.
+// Modelled on thirdparty/glm/test/perf; build and run with: python3 build.py bench
+#define GLM_FORCE_INTRINSICS
+#define GLM_FORCE_INLINE
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_aligned.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/ext/matrix_relational.hpp>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+template <glm::qualifier Q>
+struct particle
+{
+	glm::vec<4, float, Q> ColorBegin, ColorEnd;
+	glm::vec<2, float, Q> Position;
+	float Rotation;
+	float SizeBegin, SizeEnd;
+	float LifeTime, LifeRemaining;
+};
+
+template <glm::qualifier Q>
+struct instance
+{
+	glm::mat<4, 4, float, Q> Transform;
+	glm::vec<4, float, Q> Color;
+};
+
+template <glm::qualifier Q>
+static void test_particle_prep(glm::mat<4, 4, float, Q> const& ViewProj, std::vector<particle<Q> > const& I, std::vector<instance<Q> >& O)
+{
+	typedef glm::vec<3, float, Q> vec3Type;
+	typedef glm::mat<4, 4, float, Q> mat4Type;
+
+	for (std::size_t i = 0, n = I.size(); i < n; ++i)
+	{
+		particle<Q> const& P = I[i];
+
+		float const Life = P.LifeRemaining / P.LifeTime;
+		float const Size = glm::mix(P.SizeEnd, P.SizeBegin, Life);
+
+		mat4Type const Transform = glm::translate(mat4Type(1.0f), vec3Type(P.Position.x, P.Position.y, 0.0f))
+			* glm::rotate(mat4Type(1.0f), P.Rotation, vec3Type(0.0f, 0.0f, 1.0f))
+			* glm::scale(mat4Type(1.0f), vec3Type(Size, Size, 1.0f));
+
+		O[i].Transform = ViewProj * Transform;
+		O[i].Color = glm::mix(P.ColorEnd, P.ColorBegin, Life);
+	}
+}
+
+template <glm::qualifier Q>
+static int launch_particle_prep(std::vector<instance<Q> >& O, std::size_t Samples, std::size_t Iterations)
+{
+	std::vector<particle<Q> > I(Samples);
+	O.resize(Samples);
+
+	for (std::size_t i = 0; i < Samples; ++i)
+	{
+		float const t = static_cast<float>(i) / static_cast<float>(Samples);
+		I[i].ColorBegin = glm::vec<4, float, Q>(1.0f, 0.8f, 0.5f, 1.0f);
+		I[i].ColorEnd = glm::vec<4, float, Q>(1.0f, 0.4f, 0.2f, 0.0f);
+		I[i].Position = glm::vec<2, float, Q>(t * 10.0f - 5.0f, t * 4.0f - 2.0f);
+		I[i].Rotation = t * glm::two_pi<float>();
+		I[i].SizeBegin = 0.5f;
+		I[i].SizeEnd = 0.0f;
+		I[i].LifeTime = 1.0f;
+		I[i].LifeRemaining = t;
+	}
+
+	glm::mat<4, 4, float, Q> const ViewProj(
+		0.1f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.17f, 0.0f, 0.0f,
+		0.0f, 0.0f, -1.0f, 0.0f,
+		-0.2f, 0.1f, 0.0f, 1.0f);
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < Iterations; ++i)
+		test_particle_prep<Q>(ViewProj, I, O);
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / Iterations);
+}
+
+template <glm::qualifier Q>
+static int launch_color_lerp(std::vector<glm::vec<4, float, Q> >& O, std::size_t Samples, std::size_t Iterations)
+{
+	std::vector<float> Life(Samples);
+	O.resize(Samples);
+	for (std::size_t i = 0; i < Samples; ++i)
+		Life[i] = static_cast<float>(i) / static_cast<float>(Samples);
+
+	glm::vec<4, float, Q> const Begin(1.0f, 0.8f, 0.5f, 1.0f);
+	glm::vec<4, float, Q> const End(1.0f, 0.4f, 0.2f, 0.0f);
+
+	std::chrono::high_resolution_clock::time_point t1 = std::chrono::high_resolution_clock::now();
+	for (std::size_t j = 0; j < Iterations; ++j)
+		for (std::size_t i = 0; i < Samples; ++i)
+			O[i] = glm::mix(End, Begin, Life[i]);
+	std::chrono::high_resolution_clock::time_point t2 = std::chrono::high_resolution_clock::now();
+
+	return static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / Iterations);
+}
+
+static int comp_particle_prep(std::size_t Samples, std::size_t Iterations)
+{
+	int Error = 0;
+
+	std::vector<instance<glm::packed_highp> > SISD;
+	std::printf("- SISD: %d us\n", launch_particle_prep<glm::packed_highp>(SISD, Samples, Iterations));
+
+	std::vector<instance<glm::aligned_highp> > SIMD;
+	std::printf("- SIMD: %d us\n", launch_particle_prep<glm::aligned_highp>(SIMD, Samples, Iterations));
+
+	for (std::size_t i = 0; i < Samples; ++i)
+	{
+		glm::mat4 const A = SISD[i].Transform;
+		glm::mat4 const B = SIMD[i].Transform;
+		Error += glm::all(glm::equal(A, B, 0.001f)) ? 0 : 1;
+		Error += glm::all(glm::equal(glm::vec4(SISD[i].Color), glm::vec4(SIMD[i].Color), 0.001f)) ? 0 : 1;
+	}
+
+	return Error;
+}
+
+static int comp_color_lerp(std::size_t Samples, std::size_t Iterations)
+{
+	int Error = 0;
+
+	std::vector<glm::vec<4, float, glm::packed_highp> > SISD;
+	std::printf("- SISD: %d us\n", launch_color_lerp<glm::packed_highp>(SISD, Samples, Iterations));
+
+	std::vector<glm::vec<4, float, glm::aligned_highp> > SIMD;
+	std::printf("- SIMD: %d us\n", launch_color_lerp<glm::aligned_highp>(SIMD, Samples, Iterations));
+
+	for (std::size_t i = 0; i < Samples; ++i)
+		Error += glm::all(glm::equal(glm::vec4(SISD[i]), glm::vec4(SIMD[i]), 0.001f)) ? 0 : 1;
+
+	return Error;
+}
+
+int main()
+{
+	std::size_t const Samples = 100000;
+	std::size_t const Iterations = 20;
+
+	int Error = 0;
+
+#if GLM_CONFIG_SIMD == GLM_ENABLE
+	std::printf("GLM SIMD: enabled\n");
+#else
+	std::printf("GLM SIMD: disabled, both columns run scalar code\n");
+#endif
+	std::printf("particle alignment: packed %d, aligned %d\n",
+		static_cast<int>(alignof(particle<glm::packed_highp>)), static_cast<int>(alignof(particle<glm::aligned_highp>)));
+
+	std::printf("color lerp (vec4):\n");
+	Error += comp_color_lerp(Samples, Iterations);
+
+	std::printf("render prep (lerp + translate * rotate * scale + view projection):\n");
+	Error += comp_particle_prep(Samples, Iterations);
+
+	if (Error)
+		std::printf("%d mismatching results\n", Error);
+
+	return Error;
+}
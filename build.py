@@ -1,6 +1,21 @@
-# Run with: python3 build.py
+# Run with: python3 build.py  builds the sandbox on the SDL2 platform layer, then
+#                             ./prog [--present vsync|uncapped|offscreen] [--frames N] [--size WxH] [--autopilot]
+#   python3 build.py --release  builds with -O2
+#   python3 build.py --simd     builds with GLM SSE intrinsics and aligned vector types
+#   python3 build.py --pgo      builds with -O2 and LTO, the simulation sources against the
+#                               profile trained by `python3 build.py pgo`
+#   python3 build.py bench      builds and runs the benchmarks in ./bench
+#   python3 build.py pgo        profile-guided + LTO build of the headless benchmark,
+#                               compared against a plain -O2 build
+#   python3 build.py effects    compiles assets/effects/*.effect into assets/effects.pfx
+#   python3 build.py tools      builds the command line tools into ./tools/build
+#   python3 build.py glad       regenerates the GL 4.5 core loader in ./thirdparty/glad from the system's GL/glcorearb.h
+#   python3 build.py sprites    regenerates the BC7 flipbook sheet assets/particles.ktx
+import glob
 import os
 import platform
+import shutil
+import sys
 
 # (1)==================== COMMON CONFIGURATION OPTIONS ======================= #
 COMPILER="g++ -g -std=c++17"   # The compiler we want to use 
@@ -9,6 +24,104 @@ SOURCE="./src/*.cpp"    # Where the source code lives
 EXECUTABLE="prog"        # Name of the final executable
 # ======================= COMMON CONFIGURATION OPTIONS ======================= #
 
+if "--release" in sys.argv:
+    COMPILER=COMPILER+" -O2 -D NDEBUG"
+
+# GLM intrinsics must be enabled for every translation unit or none of them,
+# since they change the size and alignment of glm types.
+SIMD_ARGUMENTS="-msse4.1 -D GLM_FORCE_INTRINSICS -D GLM_FORCE_DEFAULT_ALIGNED_GENTYPES"
+if "--simd" in sys.argv:
+    COMPILER=COMPILER+" "+SIMD_ARGUMENTS
+
+# (1b)================= Headless benchmarks and PGO ============================ #
+# Benchmarks only need the vendored glm and the GL-free simulation sources,
+# so they build without SDL2/GLCore.
+BENCH_COMPILER="g++ -std=c++17 -msse4.1 -pthread -I ./src/ -I ./thirdparty/glm/"
+HEADLESS_SOURCES=["./src/ParticlePool.cpp", "./src/ParticleCanvas.cpp", "./src/ExpiryWheel.cpp", "./src/EmissionThrottle.cpp", "./src/Random.cpp", "./src/JobSystem.cpp", "./src/InstancePacking.cpp", "./src/ParticleBehavior.cpp", "./src/EmissionSampler.cpp", "./src/FluidGrid.cpp", "./src/ConstraintSolver.cpp", "./src/ColliderSet.cpp", "./src/ForceVolumeSet.cpp", "./src/EffectCompiler.cpp", "./src/EffectLibrary.cpp", "./src/EffectSequencer.cpp", "./src/Telemetry.cpp", "./src/FrameEncoder.cpp"]
+BENCH_DIR="./bench/build"
+TOOLS_DIR="./tools/build"
+
+def run(command):
+    print(command)
+    return os.system(command)==0
+
+# Compiles every source to its own object so the .gcda files written by the
+# instrumented run line up with the objects of the -fprofile-use build.
+def build_headless(flags, output):
+    objDir=BENCH_DIR+"/obj"
+    os.makedirs(objDir, exist_ok=True)
+    objects=[]
+    for source in HEADLESS_SOURCES+["./bench/ParticleBench.cpp"]:
+        obj=objDir+"/"+os.path.splitext(os.path.basename(source))[0]+".o"
+        if not run(BENCH_COMPILER+" "+flags+" -c "+source+" -o "+obj):
+            exit(1)
+        objects.append(obj)
+    if not run(BENCH_COMPILER+" "+flags+" "+" ".join(objects)+" -o "+output):
+        exit(1)
+
+def run_scenarios(executable, frames):
+    output=os.popen(executable+" --frames "+str(frames)).read()
+    print(output)
+    lines=output.splitlines()
+    totalColumn=lines[0].split().index("total")
+    totals={}
+    for line in lines[1:]:
+        columns=line.split()
+        totals[columns[0]]=float(columns[totalColumn].rstrip("ms"))
+    return totals
+
+if "bench" in sys.argv:
+    os.makedirs(BENCH_DIR, exist_ok=True)
+    if not run(BENCH_COMPILER+" -O2 ./bench/perf_particle_math.cpp -o "+BENCH_DIR+"/perf_particle_math"):
+        exit(1)
+    build_headless("-O2", BENCH_DIR+"/ParticleBench")
+    exit(0 if run(BENCH_DIR+"/perf_particle_math") and run(BENCH_DIR+"/ParticleBench") and run(BENCH_DIR+"/ParticleBench --behaviors") and run(BENCH_DIR+"/ParticleBench --sampling") and run(BENCH_DIR+"/ParticleBench --fluid") and run(BENCH_DIR+"/ParticleBench --pbd --frames 120") and run(BENCH_DIR+"/ParticleBench --effects") and run(BENCH_DIR+"/ParticleBench --timelines") and run(BENCH_DIR+"/ParticleBench --telemetry") and run(BENCH_DIR+"/ParticleBench --burst") and run(BENCH_DIR+"/ParticleBench --colliders") and run(BENCH_DIR+"/ParticleBench --forces") and run(BENCH_DIR+"/ParticleBench --expiry") and run(BENCH_DIR+"/ParticleBench --throttle") and run(BENCH_DIR+"/ParticleBench --canvas --frames 600") and run(BENCH_DIR+"/ParticleBench --fused") and run(BENCH_DIR+"/ParticleBench --roofline") and run(BENCH_DIR+"/ParticleBench --capture") else 1)
+
+def build_tools():
+    os.makedirs(TOOLS_DIR, exist_ok=True)
+    for tool in ["EffectConverter", "TelemetryDecoder"]:
+        if not run(BENCH_COMPILER+" -O2 ./tools/"+tool+".cpp "+" ".join(HEADLESS_SOURCES)+" -o "+TOOLS_DIR+"/"+tool):
+            exit(1)
+
+if "tools" in sys.argv:
+    build_tools()
+    exit(0)
+
+if "glad" in sys.argv:
+    exit(0 if run("python3 ./tools/GenerateGlad.py --output ./thirdparty/glad") else 1)
+
+if "sprites" in sys.argv:
+    exit(0 if run("python3 ./tools/GenerateParticleSheet.py --output ./assets/particles.ktx") else 1)
+
+if "effects" in sys.argv:
+    build_tools()
+    sources=sorted(glob.glob("./assets/effects/*.effect"))
+    exit(0 if run(TOOLS_DIR+"/EffectConverter ./assets/effects.pfx "+" ".join(sources)) else 1)
+
+PROFILE_DIR=os.path.abspath(BENCH_DIR+"/profile")
+PROFILE_USE="-fprofile-correction -Wno-missing-profile -freorder-functions -freorder-blocks-and-partition"
+
+if "pgo" in sys.argv:
+    OPTIMIZED="-O2 -flto -fprofile-use="+PROFILE_DIR+" "+PROFILE_USE
+
+    # 1. Baseline everything is measured against
+    build_headless("-O2", BENCH_DIR+"/ParticleBench-O2")
+    # 2. Instrumented build and training run over the same scenarios
+    os.system("rm -rf "+PROFILE_DIR)
+    build_headless("-O2 -fprofile-generate="+PROFILE_DIR+" -fprofile-update=atomic", BENCH_DIR+"/ParticleBench-instrumented")
+    if not run(BENCH_DIR+"/ParticleBench-instrumented --frames 120"):
+        exit(1)
+    # 3. Profile-guided rebuild with LTO and hot/cold function reordering
+    build_headless(OPTIMIZED, BENCH_DIR+"/ParticleBench-pgo")
+
+    baseline=run_scenarios(BENCH_DIR+"/ParticleBench-O2", 300)
+    optimized=run_scenarios(BENCH_DIR+"/ParticleBench-pgo", 300)
+    print("%-10s %12s %12s %8s" % ("scenario", "-O2", "pgo+lto", "speedup"))
+    for name in baseline:
+        print("%-10s %10.3fms %10.3fms %7.2fx" % (name, baseline[name], optimized[name], baseline[name]/optimized[name]))
+    exit(0)
+# (1b)================= Headless benchmarks and PGO ============================ #
+
 # (2)=================== Platform specific configuration ===================== #
 # For each platform we need to set the following items
 ARGUMENTS=""            # Arguments needed for our program (Add others as you see fit)
@@ -17,8 +130,8 @@ LIBRARIES=""            # What libraries do we want to include
 
 if platform.system()=="Linux":
     ARGUMENTS="-D LINUX" # -D is a #define sent to preprocessor
-    INCLUDE_DIR="-I ./include/ -I ./../../common/thirdparty/glm/"
-    LIBRARIES="-lSDL2 -ldl"
+    INCLUDE_DIR="-I ./include/ -I ./../../common/thirdparty/glm/ "+os.popen("sdl2-config --cflags").read().strip()
+    LIBRARIES="-lSDL2 -ldl -pthread"
 elif platform.system()=="Darwin":
     ARGUMENTS="-D MAC" # -D is a #define sent to the preprocessor.
     INCLUDE_DIR="-I ./include/ -I/Library/Frameworks/SDL2.framework/Headers -I./thirdparty/old/glm"
@@ -30,6 +143,77 @@ elif platform.system()=="Windows":
     LIBRARIES="-lmingw32 -lSDL2main -lSDL2 -mwindows"
 # (2)=================== Platform specific configuration ===================== #
 
+# (2b)===================== SDL2 platform layer =============================== #
+# GLCore is GLFW based and built with premake; here the sandbox links against
+# the GLCore subset in ./platform/sdl2 instead. It needs the GL 4.5 core glad
+# loader vendored in ./thirdparty/glad (the one in ./include stops at 3.3) and
+# optionally Dear ImGui >= 1.89. Without ImGui the UI calls compile against a
+# no-op header, so the sandbox runs with its defaults and no controls.
+def find_dir(candidates, marker):
+    for candidate in candidates:
+        if os.path.exists(os.path.join(candidate, marker)):
+            return candidate
+    return None
+
+GLAD_DIR=find_dir(["./thirdparty/glad", "../OpenGL-Core/vendor/Glad"], "src/glad.c")
+if GLAD_DIR is None:
+    print("Missing a GL 4.5 core glad loader: run python3 build.py glad to generate ./thirdparty/glad")
+    print("\tor check out OpenGL-Core next to this repository")
+    exit(1)
+IMGUI_DIR=find_dir(["./thirdparty/imgui", "../OpenGL-Core/vendor/imgui"], "backends/imgui_impl_sdl2.cpp")
+
+PLATFORM_OBJ_DIR="./platform/sdl2/build"
+os.makedirs(PLATFORM_OBJ_DIR, exist_ok=True)
+if not run("gcc -c "+GLAD_DIR+"/src/glad.c -I "+GLAD_DIR+"/include -o "+PLATFORM_OBJ_DIR+"/glad.o"):
+    exit(1)
+
+ARGUMENTS=ARGUMENTS+" -D GLCORE_SDL2"
+SOURCE=SOURCE+" ./platform/sdl2/*.cpp "+PLATFORM_OBJ_DIR+"/glad.o"
+INCLUDE_DIR="-I ./platform/sdl2/include/ -I ./src/ -I "+GLAD_DIR+"/include/ "+INCLUDE_DIR+" -I ./thirdparty/glm/"
+if IMGUI_DIR is None:
+    print("Dear ImGui not found in ./thirdparty/imgui, building without UI controls")
+    INCLUDE_DIR=INCLUDE_DIR+" -I ./platform/sdl2/imgui_stub/"
+else:
+    ARGUMENTS=ARGUMENTS+" -D GLCORE_IMGUI"
+    SOURCE=SOURCE+" "+IMGUI_DIR+"/imgui*.cpp "+IMGUI_DIR+"/backends/imgui_impl_sdl2.cpp "+IMGUI_DIR+"/backends/imgui_impl_opengl3.cpp"
+    INCLUDE_DIR=INCLUDE_DIR+" -I "+IMGUI_DIR+" -I "+IMGUI_DIR+"/backends/"
+# (2b)===================== SDL2 platform layer =============================== #
+
+# (2c)================ Profile-guided app build (--pgo) ========================= #
+# The training run only covers the headless simulation, so those sources are
+# compiled one by one against its profile; the GL, UI and platform code gets
+# -O2 and LTO without a profile.
+if "--pgo" in sys.argv:
+    if not os.path.isdir(PROFILE_DIR):
+        print("No profile in "+PROFILE_DIR+", run python3 build.py pgo first")
+        exit(1)
+
+    # gcc names each .gcda after its object's path joined to the working directory
+    # as given (not normalised), with '/' mangled to '#'
+    def profile_name(objectStem):
+        return os.path.join(os.getcwd(), objectStem).replace("/", "#")+".gcda"
+
+    APP_PROFILE_DIR=os.path.abspath(PLATFORM_OBJ_DIR+"/profile")
+    PGO_OBJ_DIR=PLATFORM_OBJ_DIR+"/pgo"
+    os.makedirs(APP_PROFILE_DIR, exist_ok=True)
+    os.makedirs(PGO_OBJ_DIR, exist_ok=True)
+    COMPILER=COMPILER+" -O2 -flto"
+
+    # Functions whose code differs from the benchmark build (other defines, --simd) drop their profile
+    objects=[]
+    for source in HEADLESS_SOURCES:
+        name=os.path.splitext(os.path.basename(source))[0]
+        trained=os.path.join(PROFILE_DIR, profile_name(BENCH_DIR+"/obj/"+name))
+        if os.path.exists(trained):
+            shutil.copyfile(trained, os.path.join(APP_PROFILE_DIR, profile_name(PGO_OBJ_DIR+"/"+name)))
+        obj=PGO_OBJ_DIR+"/"+name+".o"
+        if not run(COMPILER+" -msse4.1 -pthread "+ARGUMENTS+" -fprofile-use="+APP_PROFILE_DIR+" "+PROFILE_USE+" -Wno-coverage-mismatch -c "+source+" -o "+obj+" "+INCLUDE_DIR):
+            exit(1)
+        objects.append(obj)
+    unprofiled=[source for source in sorted(glob.glob("./src/*.cpp")) if source not in HEADLESS_SOURCES]
+    SOURCE=SOURCE.replace("./src/*.cpp", " ".join(unprofiled+objects))
+# (2c)================ Profile-guided app build (--pgo) ========================= #
+
 # (3)====================== Building the Executable ========================== #
 # Build a string of our compile commands that we run in the terminal
 compileString=COMPILER+" "+ARGUMENTS+" "+SOURCE+" -o "+EXECUTABLE+" "+" "+INCLUDE_DIR+" "+LIBRARIES
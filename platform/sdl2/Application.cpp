@@ -0,0 +1,522 @@
+#include "GLCore/Core/Application.h"
+#include "GLCore/Core/Input.h"
+#include "GLCore/Core/KeyCodes.h"
+#include "GLCore/Core/MouseButtonCodes.h"
+
+#include "RenderThread.h"
+
+#include <glad/glad.h>
+#include <SDL.h>
+
+#ifdef GLCORE_IMGUI
+	#include <imgui.h>
+	#include <imgui_impl_opengl3.h>
+	#include <imgui_impl_sdl2.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace GLCore {
+
+	namespace {
+
+		ApplicationSettings s_Settings;
+		float s_AutopilotTime = 0.0f;
+
+		double ToMs(uint64_t begin, uint64_t end)
+		{
+			return (double)(end - begin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+		}
+
+		bool ParseSize(const char* text, uint32_t& width, uint32_t& height)
+		{
+			unsigned int w = 0, h = 0;
+			if (std::sscanf(text, "%ux%u", &w, &h) != 2 || w == 0 || h == 0)
+				return false;
+			width = w;
+			height = h;
+			return true;
+		}
+
+#ifdef GLCORE_IMGUI
+		// ImGui rebuilds its draw lists every NewFrame(), so the render thread draws from copies
+		struct ImGuiDrawSnapshot
+		{
+			ImDrawData Data;
+			std::vector<ImDrawList*> Lists;
+
+			~ImGuiDrawSnapshot()
+			{
+				for (ImDrawList* list : Lists)
+					IM_DELETE(list);
+			}
+		};
+
+		void RecordImGui(RenderCommandList& commands)
+		{
+			ImDrawData* data = ImGui::GetDrawData();
+			if (!data || !data->Valid || data->CmdListsCount == 0)
+				return;
+
+			auto snapshot = std::make_shared<ImGuiDrawSnapshot>();
+			snapshot->Data = *data;
+			for (int i = 0; i < data->CmdListsCount; i++)
+				snapshot->Lists.push_back(data->CmdLists[i]->CloneOutput());
+	#if IMGUI_VERSION_NUM >= 18980
+			for (int i = 0; i < data->CmdListsCount; i++)
+				snapshot->Data.CmdLists[i] = snapshot->Lists[i];
+	#else
+			snapshot->Data.CmdLists = snapshot->Lists.data();
+	#endif
+			commands.Execute([snapshot]() { ImGui_ImplOpenGL3_RenderDrawData(&snapshot->Data); });
+		}
+#endif
+
+	}
+
+	Application* Application::s_Instance = nullptr;
+
+	bool Application::ParseCommandLine(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (std::strcmp(arg, "--present") == 0 && value)
+			{
+				if (std::strcmp(value, "vsync") == 0)
+					s_Settings.Present = PresentMode::VSync;
+				else if (std::strcmp(value, "uncapped") == 0)
+					s_Settings.Present = PresentMode::Uncapped;
+				else if (std::strcmp(value, "offscreen") == 0)
+					s_Settings.Present = PresentMode::Offscreen;
+				else
+				{
+					std::fprintf(stderr, "Unknown presentation mode '%s' (vsync, uncapped or offscreen)\n", value);
+					return false;
+				}
+				i++;
+			}
+			else if (std::strcmp(arg, "--frames") == 0 && value)
+			{
+				s_Settings.FrameLimit = (uint32_t)std::strtoul(value, nullptr, 10);
+				i++;
+			}
+			else if (std::strcmp(arg, "--size") == 0 && value)
+			{
+				if (!ParseSize(value, s_Settings.Width, s_Settings.Height))
+				{
+					std::fprintf(stderr, "Bad window size '%s' (expected WIDTHxHEIGHT)\n", value);
+					return false;
+				}
+				i++;
+			}
+			else if (std::strcmp(arg, "--autopilot") == 0)
+				s_Settings.Autopilot = true;
+			else
+			{
+				std::fprintf(stderr, "usage: %s [--present vsync|uncapped|offscreen] [--frames N] [--size WIDTHxHEIGHT] [--autopilot]\n", argv[0]);
+				return false;
+			}
+		}
+		if (s_Settings.Present == PresentMode::Offscreen)
+			s_Settings.Autopilot = true;
+		return true;
+	}
+
+	const ApplicationSettings& Application::GetSettings()
+	{
+		return s_Settings;
+	}
+
+	Application::Application(const std::string& name, uint32_t width, uint32_t height)
+	{
+		s_Instance = this;
+		m_StartCounter = SDL_GetPerformanceCounter();
+
+		// Without a display, offscreen runs fall back to SDL's EGL-backed offscreen driver
+		if (s_Settings.Present == PresentMode::Offscreen && !std::getenv("SDL_VIDEODRIVER") && !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY"))
+			SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+
+		if (SDL_Init(SDL_INIT_VIDEO) != 0)
+		{
+			std::fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+			std::exit(1);
+		}
+		uint64_t initialized = SDL_GetPerformanceCounter();
+
+		WindowProps props;
+		props.Title = name;
+		props.Width = s_Settings.Width ? s_Settings.Width : width;
+		props.Height = s_Settings.Height ? s_Settings.Height : height;
+		props.Present = s_Settings.Present;
+
+		std::string error;
+		m_Window = std::unique_ptr<Window>(Window::Create(props, error));
+		if (!m_Window)
+		{
+			std::fprintf(stderr, "%s\n", error.c_str());
+			std::exit(1);
+		}
+		uint64_t created = SDL_GetPerformanceCounter();
+
+#ifdef GLCORE_IMGUI
+		// No UI offscreen: nobody would see it, and it would only add CPU time
+		if (props.Present != PresentMode::Offscreen)
+		{
+			IMGUI_CHECKVERSION();
+			ImGui::CreateContext();
+			ImGui::StyleColorsDark();
+			ImGui_ImplSDL2_InitForOpenGL((SDL_Window*)m_Window->GetNativeWindow(), m_Window->GetContext());
+			ImGui_ImplOpenGL3_Init("#version 410");
+			m_ImGui = true;
+		}
+#endif
+
+		m_StartupMs[0] = ToMs(m_StartCounter, initialized);
+		m_StartupMs[1] = ToMs(initialized, created);
+		m_LastFrameCounter = SDL_GetPerformanceCounter();
+	}
+
+	Application::~Application()
+	{
+		// The last frame may still reference layer data
+		RenderThread::WaitIdle();
+		for (Layer* layer : m_Layers)
+		{
+			layer->OnDetach();
+			delete layer;
+		}
+		m_Layers.clear();
+
+		// Runs the GL deletes the layers queued, then hands the context back to this thread
+		RenderThread::Stop();
+		SDL_GL_MakeCurrent((SDL_Window*)m_Window->GetNativeWindow(), m_Window->GetContext());
+
+#ifdef GLCORE_IMGUI
+		if (m_ImGui)
+		{
+			ImGui_ImplOpenGL3_Shutdown();
+			ImGui_ImplSDL2_Shutdown();
+			ImGui::DestroyContext();
+		}
+#endif
+
+		m_Window.reset();
+		SDL_Quit();
+		s_Instance = nullptr;
+	}
+
+	void Application::PushLayer(Layer* layer)
+	{
+		m_Layers.insert(m_Layers.begin() + m_LayerInsertIndex, layer);
+		m_LayerInsertIndex++;
+		layer->OnAttach();
+	}
+
+	void Application::PushOverlay(Layer* layer)
+	{
+		m_Layers.push_back(layer);
+		layer->OnAttach();
+	}
+
+	void Application::Run()
+	{
+		uint64_t runStart = SDL_GetPerformanceCounter();
+		m_StartupMs[2] = ToMs(m_LastFrameCounter, runStart);
+		m_LastFrameCounter = runStart;
+
+		// Layers were built for the default 16:9 size; let them pick up the real one
+		WindowResizeEvent resize(m_Window->GetWidth(), m_Window->GetHeight());
+		OnEvent(resize);
+
+#ifdef GLCORE_IMGUI
+		// Creates the backend's shader and font texture while the context is still current here
+		if (m_ImGui)
+			ImGui_ImplOpenGL3_NewFrame();
+#endif
+
+		// From here on only the render thread touches GL: it replays each frame's list and presents
+		SDL_Window* window = (SDL_Window*)m_Window->GetNativeWindow();
+		void* context = m_Window->GetContext();
+		SDL_GL_MakeCurrent(window, nullptr);
+		RenderThread::Start([window, context]() { SDL_GL_MakeCurrent(window, context); },
+			[this]() { m_Window->OnUpdate(); },
+			[window]() { SDL_GL_MakeCurrent(window, nullptr); });
+
+		uint64_t frame = 0;
+		while (m_Running)
+		{
+			uint64_t now = SDL_GetPerformanceCounter();
+			Timestep timestep = (float)(ToMs(m_LastFrameCounter, now) * 0.001);
+			m_LastFrameCounter = now;
+			if (frame > 0)
+				m_FrameTimes.push_back(timestep.GetMilliseconds());
+			s_AutopilotTime += timestep;
+
+			PollEvents();
+			if (!m_Running)
+				break;
+
+			for (Layer* layer : m_Layers)
+				layer->OnUpdate(timestep);
+
+#ifdef GLCORE_IMGUI
+			if (m_ImGui)
+			{
+				ImGui_ImplSDL2_NewFrame();
+				ImGui::NewFrame();
+				for (Layer* layer : m_Layers)
+					layer->OnImGuiRender();
+				ImGui::Render();
+				RecordImGui(RenderThread::GetCommandList());
+			}
+#endif
+
+			// Presented by the render thread once the list has been replayed
+			RenderThread::EndFrame();
+			frame++;
+
+			if (frame == 1)
+			{
+				// Startup ends once the first frame has actually been presented
+				RenderThread::WaitIdle();
+				m_StartupMs[3] = ToMs(runStart, SDL_GetPerformanceCounter());
+				std::printf("Startup %.1f ms: SDL %.1f, window + GL context %.1f, layers %.1f, first frame %.1f\n",
+					ToMs(m_StartCounter, SDL_GetPerformanceCounter()), m_StartupMs[0], m_StartupMs[1], m_StartupMs[2], m_StartupMs[3]);
+				m_LastFrameCounter = SDL_GetPerformanceCounter();
+			}
+
+			if (s_Settings.FrameLimit && frame >= s_Settings.FrameLimit)
+				m_Running = false;
+		}
+
+		PrintFrameStats();
+	}
+
+	void Application::PollEvents()
+	{
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+#ifdef GLCORE_IMGUI
+			if (m_ImGui)
+			{
+				ImGui_ImplSDL2_ProcessEvent(&event);
+				if (event.type == SDL_MOUSEWHEEL && ImGui::GetIO().WantCaptureMouse)
+					continue;
+			}
+#endif
+
+			switch (event.type)
+			{
+				case SDL_QUIT:
+				{
+					WindowCloseEvent close;
+					OnEvent(close);
+					break;
+				}
+				case SDL_WINDOWEVENT:
+				{
+					if (event.window.event != SDL_WINDOWEVENT_SIZE_CHANGED)
+						break;
+					m_Window->OnResize((uint32_t)event.window.data1, (uint32_t)event.window.data2);
+					WindowResizeEvent resize(m_Window->GetWidth(), m_Window->GetHeight());
+					OnEvent(resize);
+					break;
+				}
+				case SDL_MOUSEWHEEL:
+				{
+					MouseScrolledEvent scrolled((float)event.wheel.x, (float)event.wheel.y);
+					OnEvent(scrolled);
+					break;
+				}
+			}
+		}
+	}
+
+	void Application::OnEvent(Event& event)
+	{
+		if (event.GetEventType() == EventType::WindowClose)
+		{
+			m_Running = false;
+			event.Handled = true;
+			return;
+		}
+
+		for (auto it = m_Layers.rbegin(); it != m_Layers.rend(); ++it)
+		{
+			(*it)->OnEvent(event);
+			if (event.Handled)
+				break;
+		}
+	}
+
+	void Application::PrintFrameStats() const
+	{
+		if (m_FrameTimes.empty())
+			return;
+
+		std::vector<float> sorted = m_FrameTimes;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0.0;
+		for (float ms : sorted)
+			total += ms;
+		auto percentile = [&sorted](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * (double)sorted.size()))]; };
+
+		const char* modes[] = { "vsync", "uncapped", "offscreen" };
+		std::printf("Present %s: %zu frames in %.2f s, %.1f fps; frame ms mean %.3f, p50 %.3f, p99 %.3f, max %.3f\n",
+			modes[(int)m_Window->GetPresentMode()], sorted.size(), total * 0.001, sorted.size() * 1000.0 / total,
+			total / sorted.size(), percentile(0.5), percentile(0.99), sorted.back());
+	}
+
+	Window* Window::Create(const WindowProps& props, std::string& error)
+	{
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+
+		Uint32 flags = SDL_WINDOW_OPENGL;
+		flags |= props.Present == PresentMode::Offscreen ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE;
+
+		std::unique_ptr<Window> window(new Window());
+		window->m_Present = props.Present;
+		window->m_Width = props.Width;
+		window->m_Height = props.Height;
+		window->m_Window = SDL_CreateWindow(props.Title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, (int)props.Width, (int)props.Height, flags);
+		if (!window->m_Window)
+		{
+			error = std::string("SDL_CreateWindow failed: ") + SDL_GetError();
+			return nullptr;
+		}
+
+		window->m_Context = SDL_GL_CreateContext(window->m_Window);
+		if (!window->m_Context)
+		{
+			error = std::string("could not create an OpenGL 4.5 core context: ") + SDL_GetError();
+			return nullptr;
+		}
+		SDL_GL_MakeCurrent(window->m_Window, window->m_Context);
+
+		if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress))
+		{
+			error = "failed to load OpenGL functions";
+			return nullptr;
+		}
+
+		// Uncapped and offscreen never wait for the display; offscreen doesn't swap at all
+		SDL_GL_SetSwapInterval(props.Present == PresentMode::VSync ? 1 : 0);
+		return window.release();
+	}
+
+	Window::~Window()
+	{
+		if (m_Context)
+		{
+			for (GLsync& fence : m_FrameFences)
+			{
+				if (fence)
+					glDeleteSync(fence);
+				fence = nullptr;
+			}
+			SDL_GL_DeleteContext(m_Context);
+		}
+		if (m_Window)
+			SDL_DestroyWindow(m_Window);
+	}
+
+	void Window::OnUpdate()
+	{
+		if (m_Present != PresentMode::Offscreen)
+		{
+			SDL_GL_SwapWindow(m_Window);
+			return;
+		}
+
+		// Bound the queue the way a swap chain would, so the CPU can't run
+		// arbitrarily far ahead of the GPU, without waiting on a display
+		GLsync& fence = m_FrameFences[m_FrameIndex++ % m_FrameFences.size()];
+		if (fence)
+		{
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+			glDeleteSync(fence);
+		}
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush();
+	}
+
+	void Window::OnResize(uint32_t width, uint32_t height)
+	{
+		m_Width = width;
+		m_Height = height;
+	}
+
+	static SDL_Scancode ToScancode(int keycode)
+	{
+		if (keycode >= HZ_KEY_A && keycode <= HZ_KEY_Z)
+			return (SDL_Scancode)(SDL_SCANCODE_A + (keycode - HZ_KEY_A));
+		if (keycode == HZ_KEY_0)
+			return SDL_SCANCODE_0;
+		if (keycode > HZ_KEY_0 && keycode <= HZ_KEY_9)
+			return (SDL_Scancode)(SDL_SCANCODE_1 + (keycode - HZ_KEY_0 - 1));
+
+		switch (keycode)
+		{
+			case HZ_KEY_SPACE:  return SDL_SCANCODE_SPACE;
+			case HZ_KEY_ESCAPE: return SDL_SCANCODE_ESCAPE;
+			case HZ_KEY_RIGHT:  return SDL_SCANCODE_RIGHT;
+			case HZ_KEY_LEFT:   return SDL_SCANCODE_LEFT;
+			case HZ_KEY_DOWN:   return SDL_SCANCODE_DOWN;
+			case HZ_KEY_UP:     return SDL_SCANCODE_UP;
+		}
+		return SDL_SCANCODE_UNKNOWN;
+	}
+
+	bool Input::IsKeyPressed(int keycode)
+	{
+		SDL_Scancode scancode = ToScancode(keycode);
+		return scancode != SDL_SCANCODE_UNKNOWN && SDL_GetKeyboardState(nullptr)[scancode];
+	}
+
+	bool Input::IsMouseButtonPressed(int button)
+	{
+		if (s_Settings.Autopilot)
+			return button == HZ_MOUSE_BUTTON_LEFT;
+
+		int sdlButton = button == HZ_MOUSE_BUTTON_LEFT ? SDL_BUTTON_LEFT : button == HZ_MOUSE_BUTTON_RIGHT ? SDL_BUTTON_RIGHT : SDL_BUTTON_MIDDLE;
+		return (SDL_GetMouseState(nullptr, nullptr) & SDL_BUTTON(sdlButton)) != 0;
+	}
+
+	std::pair<float, float> Input::GetMousePosition()
+	{
+		if (s_Settings.Autopilot)
+		{
+			Window& window = Application::Get().GetWindow();
+			float centerX = window.GetWidth() * 0.5f, centerY = window.GetHeight() * 0.5f;
+			float radius = std::min(centerX, centerY) * 0.5f;
+			return { centerX + radius * std::cos(s_AutopilotTime * 1.5f), centerY + radius * std::sin(s_AutopilotTime * 1.5f) };
+		}
+
+		int x, y;
+		SDL_GetMouseState(&x, &y);
+		return { (float)x, (float)y };
+	}
+
+	float Input::GetMouseX()
+	{
+		return GetMousePosition().first;
+	}
+
+	float Input::GetMouseY()
+	{
+		return GetMousePosition().second;
+	}
+
+}
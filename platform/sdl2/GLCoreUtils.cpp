@@ -0,0 +1,193 @@
+#include "GLCoreUtils.h"
+
+#include "GLCore/Core/Input.h"
+#include "GLCore/Core/KeyCodes.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace GLCore::Utils {
+
+	static std::string ReadFileAsString(const std::string& filepath)
+	{
+		std::ifstream in(filepath, std::ios::in | std::ios::binary);
+		if (!in)
+		{
+			std::fprintf(stderr, "Could not open file '%s'\n", filepath.c_str());
+			return {};
+		}
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	Shader::~Shader()
+	{
+		glDeleteProgram(m_RendererID);
+	}
+
+	Shader* Shader::FromGLSLTextFiles(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+	{
+		Shader* shader = new Shader();
+		shader->LoadFromGLSLTextFiles(vertexShaderPath, fragmentShaderPath);
+		return shader;
+	}
+
+	void Shader::LoadFromGLSLTextFiles(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+	{
+		GLuint program = glCreateProgram();
+		GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, ReadFileAsString(vertexShaderPath));
+		GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, ReadFileAsString(fragmentShaderPath));
+		glAttachShader(program, vertexShader);
+		glAttachShader(program, fragmentShader);
+		glLinkProgram(program);
+
+		GLint isLinked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+		if (isLinked == GL_FALSE)
+		{
+			GLint maxLength = 0;
+			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+			std::string infoLog(std::max(maxLength, 1), '\0');
+			glGetProgramInfoLog(program, maxLength, &maxLength, infoLog.data());
+			std::fprintf(stderr, "Shader link failed (%s, %s):\n%s\n", vertexShaderPath.c_str(), fragmentShaderPath.c_str(), infoLog.c_str());
+
+			glDeleteProgram(program);
+			program = 0;
+		}
+
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		m_RendererID = program;
+	}
+
+	GLuint Shader::CompileShader(GLenum type, const std::string& source)
+	{
+		GLuint shader = glCreateShader(type);
+		const GLchar* sourceCStr = source.c_str();
+		glShaderSource(shader, 1, &sourceCStr, nullptr);
+		glCompileShader(shader);
+
+		GLint isCompiled = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+		if (isCompiled == GL_FALSE)
+		{
+			GLint maxLength = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &maxLength);
+			std::string infoLog(std::max(maxLength, 1), '\0');
+			glGetShaderInfoLog(shader, maxLength, &maxLength, infoLog.data());
+			std::fprintf(stderr, "%s shader compile failed:\n%s\n", type == GL_VERTEX_SHADER ? "Vertex" : "Fragment", infoLog.c_str());
+		}
+		return shader;
+	}
+
+	OrthographicCamera::OrthographicCamera(float left, float right, float bottom, float top)
+		: m_ProjectionMatrix(glm::ortho(left, right, bottom, top, -1.0f, 1.0f))
+	{
+		m_ViewProjectionMatrix = m_ProjectionMatrix * m_ViewMatrix;
+	}
+
+	void OrthographicCamera::SetProjection(float left, float right, float bottom, float top)
+	{
+		m_ProjectionMatrix = glm::ortho(left, right, bottom, top, -1.0f, 1.0f);
+		m_ViewProjectionMatrix = m_ProjectionMatrix * m_ViewMatrix;
+	}
+
+	void OrthographicCamera::RecalculateViewMatrix()
+	{
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), m_Position) *
+			glm::rotate(glm::mat4(1.0f), glm::radians(m_Rotation), glm::vec3(0, 0, 1));
+
+		m_ViewMatrix = glm::inverse(transform);
+		m_ViewProjectionMatrix = m_ProjectionMatrix * m_ViewMatrix;
+	}
+
+	OrthographicCameraController::OrthographicCameraController(float aspectRatio, bool rotation)
+		: m_AspectRatio(aspectRatio),
+		m_Bounds({ -m_AspectRatio * m_ZoomLevel, m_AspectRatio * m_ZoomLevel, -m_ZoomLevel, m_ZoomLevel }),
+		m_Camera(m_Bounds.Left, m_Bounds.Right, m_Bounds.Bottom, m_Bounds.Top),
+		m_Rotation(rotation)
+	{
+	}
+
+	void OrthographicCameraController::OnUpdate(Timestep ts)
+	{
+		if (Input::IsKeyPressed(HZ_KEY_A))
+			m_CameraPosition.x -= m_CameraTranslationSpeed * ts;
+		else if (Input::IsKeyPressed(HZ_KEY_D))
+			m_CameraPosition.x += m_CameraTranslationSpeed * ts;
+
+		if (Input::IsKeyPressed(HZ_KEY_W))
+			m_CameraPosition.y += m_CameraTranslationSpeed * ts;
+		else if (Input::IsKeyPressed(HZ_KEY_S))
+			m_CameraPosition.y -= m_CameraTranslationSpeed * ts;
+
+		if (m_Rotation)
+		{
+			if (Input::IsKeyPressed(HZ_KEY_Q))
+				m_CameraRotation += m_CameraRotationSpeed * ts;
+			if (Input::IsKeyPressed(HZ_KEY_E))
+				m_CameraRotation -= m_CameraRotationSpeed * ts;
+
+			m_Camera.SetRotation(m_CameraRotation);
+		}
+
+		m_Camera.SetPosition(m_CameraPosition);
+		m_CameraTranslationSpeed = m_ZoomLevel;
+	}
+
+	void OrthographicCameraController::OnEvent(Event& e)
+	{
+		switch (e.GetEventType())
+		{
+			case EventType::MouseScrolled:
+			{
+				m_ZoomLevel -= static_cast<MouseScrolledEvent&>(e).GetYOffset() * 0.25f;
+				m_ZoomLevel = std::max(m_ZoomLevel, 0.25f);
+				CalculateView();
+				break;
+			}
+			case EventType::WindowResize:
+			{
+				auto& resize = static_cast<WindowResizeEvent&>(e);
+				if (resize.GetHeight() > 0)
+				{
+					m_AspectRatio = (float)resize.GetWidth() / (float)resize.GetHeight();
+					CalculateView();
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	void OrthographicCameraController::CalculateView()
+	{
+		m_Bounds = { -m_AspectRatio * m_ZoomLevel, m_AspectRatio * m_ZoomLevel, -m_ZoomLevel, m_ZoomLevel };
+		m_Camera.SetProjection(m_Bounds.Left, m_Bounds.Right, m_Bounds.Bottom, m_Bounds.Top);
+	}
+
+	static void APIENTRY OpenGLLogMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+	{
+		if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+			return;
+		std::fprintf(stderr, "[OpenGL %s] %s\n", severity == GL_DEBUG_SEVERITY_HIGH ? "Error" : "Warning", message);
+	}
+
+	void EnableGLDebugging()
+	{
+		// Core since 4.3; glad leaves the pointer null on older contexts
+		if (!glDebugMessageCallback)
+			return;
+
+		glDebugMessageCallback(OpenGLLogMessage, nullptr);
+		glEnable(GL_DEBUG_OUTPUT);
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	}
+
+}
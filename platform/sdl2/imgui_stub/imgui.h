@@ -0,0 +1,38 @@
+#pragma once
+
+// No-op stand-in for Dear ImGui, used by the SDL2 build when no imgui checkout
+// is found. Windows are never shown, so every widget reports "unchanged".
+
+struct ImVec2
+{
+	float x = 0.0f, y = 0.0f;
+	ImVec2() = default;
+	ImVec2(float x, float y) : x(x), y(y) {}
+};
+
+struct ImVec4
+{
+	float x = 0.0f, y = 0.0f, z = 0.0f, w = 0.0f;
+	ImVec4() = default;
+	ImVec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+};
+
+namespace ImGui {
+
+	inline bool Begin(const char*, bool* = nullptr, int = 0) { return false; }
+	inline void End() {}
+
+	inline bool Button(const char*, const ImVec2& = ImVec2()) { return false; }
+	inline bool Checkbox(const char*, bool*) { return false; }
+	inline bool ColorEdit4(const char*, float*, int = 0) { return false; }
+	inline bool Combo(const char*, int*, const char* const[], int, int = -1) { return false; }
+	inline bool DragFloat(const char*, float*, float = 1.0f, float = 0.0f, float = 0.0f, const char* = "%.3f", int = 0) { return false; }
+	inline bool DragInt2(const char*, int*, float = 1.0f, int = 0, int = 0, const char* = "%d", int = 0) { return false; }
+	inline bool SliderInt(const char*, int*, int, int, const char* = "%d", int = 0) { return false; }
+
+	inline void SameLine(float = 0.0f, float = -1.0f) {}
+	inline void Separator() {}
+	inline void Text(const char*, ...) {}
+	inline void TextColored(const ImVec4&, const char*, ...) {}
+
+}
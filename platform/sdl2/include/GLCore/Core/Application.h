@@ -0,0 +1,64 @@
+#pragma once
+
+#include "GLCore/Core/Layer.h"
+#include "GLCore/Core/Window.h"
+#include "GLCore/Events/Event.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GLCore {
+
+	struct ApplicationSettings
+	{
+		PresentMode Present = PresentMode::VSync;
+		uint32_t Width = 0, Height = 0; // 0 = what the application asked for
+		uint32_t FrameLimit = 0;        // exit after this many frames, 0 = run until closed
+		bool Autopilot = false;         // synthetic mouse input, always on offscreen
+	};
+
+	// Lean SDL2 stand-in for GLCore::Application, used by the build.py build.
+	// Run() hands the context to a RenderThread: layers and ImGui only record,
+	// and each frame's list is replayed and presented there while the next one
+	// is recorded. Prints startup time once the first frame is presented, and
+	// frame time statistics on exit. Nothing in the loop sleeps or paces frames:
+	// vsync is the only limiter, and only in PresentMode::VSync.
+	class Application
+	{
+	public:
+		Application(const std::string& name = "OpenGL Sandbox", uint32_t width = 1280, uint32_t height = 720);
+		virtual ~Application();
+
+		// Call before constructing the application:
+		//     --present vsync|uncapped|offscreen  --frames N  --size WIDTHxHEIGHT  --autopilot
+		static bool ParseCommandLine(int argc, char** argv);
+		static const ApplicationSettings& GetSettings();
+
+		void Run();
+		void Close() { m_Running = false; }
+
+		void PushLayer(Layer* layer);
+		void PushOverlay(Layer* layer);
+
+		Window& GetWindow() { return *m_Window; }
+		static Application& Get() { return *s_Instance; }
+	private:
+		void PollEvents();
+		void OnEvent(Event& event);
+		void PrintFrameStats() const;
+	private:
+		std::unique_ptr<Window> m_Window;
+		std::vector<Layer*> m_Layers;
+		size_t m_LayerInsertIndex = 0;
+		bool m_Running = true;
+		bool m_ImGui = false;
+
+		uint64_t m_StartCounter = 0, m_LastFrameCounter = 0;
+		double m_StartupMs[4] = {}; // SDL, window + context, layers, first frame
+		std::vector<float> m_FrameTimes;
+	private:
+		static Application* s_Instance;
+	};
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <utility>
+
+namespace GLCore {
+
+	// Polled state of the current frame. In offscreen mode, and with --autopilot,
+	// the left button is held and the cursor circles the window centre, so
+	// mouse-driven layers keep working without a user.
+	class Input
+	{
+	public:
+		static bool IsKeyPressed(int keycode);
+		static bool IsMouseButtonPressed(int button);
+		static std::pair<float, float> GetMousePosition();
+		static float GetMouseX();
+		static float GetMouseY();
+	};
+
+}
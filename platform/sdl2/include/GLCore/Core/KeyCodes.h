@@ -0,0 +1,18 @@
+#pragma once
+
+// The subset of GLCore's (GLFW's) key codes the platform layer maps to SDL
+#define HZ_KEY_SPACE  32
+#define HZ_KEY_0      48
+#define HZ_KEY_9      57
+#define HZ_KEY_A      65
+#define HZ_KEY_D      68
+#define HZ_KEY_E      69
+#define HZ_KEY_Q      81
+#define HZ_KEY_S      83
+#define HZ_KEY_W      87
+#define HZ_KEY_Z      90
+#define HZ_KEY_ESCAPE 256
+#define HZ_KEY_RIGHT  262
+#define HZ_KEY_LEFT   263
+#define HZ_KEY_DOWN   264
+#define HZ_KEY_UP     265
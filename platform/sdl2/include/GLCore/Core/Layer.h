@@ -0,0 +1,28 @@
+#pragma once
+
+#include "GLCore/Core/Timestep.h"
+#include "GLCore/Events/Event.h"
+
+#include <string>
+
+namespace GLCore {
+
+	class Layer
+	{
+	public:
+		Layer(const std::string& name = "Layer")
+			: m_DebugName(name) {}
+		virtual ~Layer() = default;
+
+		virtual void OnAttach() {}
+		virtual void OnDetach() {}
+		virtual void OnUpdate(Timestep ts) {}
+		virtual void OnImGuiRender() {}
+		virtual void OnEvent(Event& event) {}
+
+		const std::string& GetName() const { return m_DebugName; }
+	protected:
+		std::string m_DebugName;
+	};
+
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Same values as GLCore's (GLFW's) codes
+#define HZ_MOUSE_BUTTON_LEFT   0
+#define HZ_MOUSE_BUTTON_RIGHT  1
+#define HZ_MOUSE_BUTTON_MIDDLE 2
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+struct SDL_Window;
+
+namespace GLCore {
+
+	enum class PresentMode
+	{
+		VSync = 0, // swap interval 1
+		Uncapped,  // swap interval 0; throughput still bounded by the swap chain
+		Offscreen  // hidden window, no swap; fences keep at most two frames in flight
+	};
+
+	struct WindowProps
+	{
+		std::string Title;
+		uint32_t Width, Height;
+		PresentMode Present;
+	};
+
+	class Window
+	{
+	public:
+		~Window();
+
+		// nullptr on failure, with the reason in `error`
+		static Window* Create(const WindowProps& props, std::string& error);
+
+		// Presents (or, offscreen, fences) the frame that was just drawn
+		void OnUpdate();
+		void OnResize(uint32_t width, uint32_t height);
+
+		unsigned int GetWidth() const { return m_Width; }
+		unsigned int GetHeight() const { return m_Height; }
+		PresentMode GetPresentMode() const { return m_Present; }
+		void* GetNativeWindow() const { return m_Window; }
+		void* GetContext() const { return m_Context; }
+	private:
+		Window() = default;
+	private:
+		SDL_Window* m_Window = nullptr;
+		void* m_Context = nullptr;
+		uint32_t m_Width = 0, m_Height = 0;
+		PresentMode m_Present = PresentMode::VSync;
+
+		std::array<GLsync, 2> m_FrameFences = {};
+		uint64_t m_FrameIndex = 0;
+	};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+namespace GLCore {
+
+	enum class EventType
+	{
+		None = 0,
+		WindowClose, WindowResize,
+		MouseScrolled
+	};
+
+	class Event
+	{
+	public:
+		virtual ~Event() = default;
+		virtual EventType GetEventType() const = 0;
+
+		bool Handled = false;
+	};
+
+	class WindowCloseEvent : public Event
+	{
+	public:
+		EventType GetEventType() const override { return EventType::WindowClose; }
+	};
+
+	class WindowResizeEvent : public Event
+	{
+	public:
+		WindowResizeEvent(unsigned int width, unsigned int height)
+			: m_Width(width), m_Height(height) {}
+
+		unsigned int GetWidth() const { return m_Width; }
+		unsigned int GetHeight() const { return m_Height; }
+		EventType GetEventType() const override { return EventType::WindowResize; }
+	private:
+		unsigned int m_Width, m_Height;
+	};
+
+	class MouseScrolledEvent : public Event
+	{
+	public:
+		MouseScrolledEvent(float xOffset, float yOffset)
+			: m_XOffset(xOffset), m_YOffset(yOffset) {}
+
+		float GetXOffset() const { return m_XOffset; }
+		float GetYOffset() const { return m_YOffset; }
+		EventType GetEventType() const override { return EventType::MouseScrolled; }
+	private:
+		float m_XOffset, m_YOffset;
+	};
+
+}
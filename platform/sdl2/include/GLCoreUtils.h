@@ -0,0 +1,100 @@
+#pragma once
+
+// GLCore::Utils for the SDL2 platform layer: same names and behaviour as GLCore's
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+
+#include "GLCore/Core/Timestep.h"
+#include "GLCore/Events/Event.h"
+
+namespace GLCore::Utils {
+
+	class Shader
+	{
+	public:
+		~Shader();
+
+		GLuint GetRendererID() { return m_RendererID; }
+
+		static Shader* FromGLSLTextFiles(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	private:
+		Shader() = default;
+
+		void LoadFromGLSLTextFiles(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+		GLuint CompileShader(GLenum type, const std::string& source);
+	private:
+		GLuint m_RendererID = 0;
+	};
+
+	class OrthographicCamera
+	{
+	public:
+		OrthographicCamera(float left, float right, float bottom, float top);
+
+		void SetProjection(float left, float right, float bottom, float top);
+
+		const glm::vec3& GetPosition() const { return m_Position; }
+		void SetPosition(const glm::vec3& position) { m_Position = position; RecalculateViewMatrix(); }
+
+		float GetRotation() const { return m_Rotation; }
+		void SetRotation(float rotation) { m_Rotation = rotation; RecalculateViewMatrix(); }
+
+		const glm::mat4& GetProjectionMatrix() const { return m_ProjectionMatrix; }
+		const glm::mat4& GetViewMatrix() const { return m_ViewMatrix; }
+		const glm::mat4& GetViewProjectionMatrix() const { return m_ViewProjectionMatrix; }
+	private:
+		void RecalculateViewMatrix();
+	private:
+		glm::mat4 m_ProjectionMatrix;
+		glm::mat4 m_ViewMatrix = glm::mat4(1.0f);
+		glm::mat4 m_ViewProjectionMatrix;
+
+		glm::vec3 m_Position = { 0.0f, 0.0f, 0.0f };
+		float m_Rotation = 0.0f;
+	};
+
+	struct OrthographicCameraBounds
+	{
+		float Left, Right;
+		float Bottom, Top;
+
+		float GetWidth() { return Right - Left; }
+		float GetHeight() { return Top - Bottom; }
+	};
+
+	class OrthographicCameraController
+	{
+	public:
+		OrthographicCameraController(float aspectRatio, bool rotation = false);
+
+		void OnUpdate(Timestep ts);
+		void OnEvent(Event& e);
+
+		OrthographicCamera& GetCamera() { return m_Camera; }
+		const OrthographicCamera& GetCamera() const { return m_Camera; }
+
+		float GetZoomLevel() const { return m_ZoomLevel; }
+		void SetZoomLevel(float level) { m_ZoomLevel = level; CalculateView(); }
+
+		const OrthographicCameraBounds& GetBounds() const { return m_Bounds; }
+	private:
+		void CalculateView();
+	private:
+		float m_AspectRatio;
+		float m_ZoomLevel = 1.0f;
+		OrthographicCameraBounds m_Bounds;
+		OrthographicCamera m_Camera;
+
+		bool m_Rotation;
+
+		glm::vec3 m_CameraPosition = { 0.0f, 0.0f, 0.0f };
+		float m_CameraRotation = 0.0f;
+		float m_CameraTranslationSpeed = 1.0f, m_CameraRotationSpeed = 180.0f;
+	};
+
+	void EnableGLDebugging();
+
+}
@@ -1,3 +1,9 @@
+newoption
+{
+	trigger = "glm-simd",
+	description = "Build GLM with SSE4.1 intrinsics and 16-byte aligned vector types"
+}
+
 project "OpenGL-Sandbox"
 	kind "ConsoleApp"
 	language "C++"
@@ -28,6 +34,15 @@ project "OpenGL-Sandbox"
 		"OpenGL-Core"
 	}
 
+	filter "options:glm-simd"
+		vectorextensions "SSE4.1"
+
+		defines
+		{
+			"GLM_FORCE_INTRINSICS",
+			"GLM_FORCE_DEFAULT_ALIGNED_GENTYPES"
+		}
+
 	filter "system:windows"
 		systemversion "latest"
 
@@ -44,4 +59,5 @@ project "OpenGL-Sandbox"
 	filter "configurations:Release"
 		defines "GLCORE_RELEASE"
 		runtime "Release"
-        optimize "on"
+		optimize "Speed"
+		flags { "LinkTimeOptimization" }
@@ -0,0 +1,37 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+	std::atomic<uint64_t> s_AllocationCount{ 0 };
+	std::atomic<uint64_t> s_AllocatedBytes{ 0 };
+
+}
+
+AllocationStats GetAllocationStats()
+{
+	return { s_AllocationCount.load(std::memory_order_relaxed), s_AllocatedBytes.load(std::memory_order_relaxed) };
+}
+
+// The array and nothrow forms forward to these in the standard library
+void* operator new(size_t size)
+{
+	s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	s_AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	if (void* memory = std::malloc(size ? size : 1))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
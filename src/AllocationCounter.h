@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Process-wide heap allocation counters, fed by the global operator new
+// replacement in AllocationCounter.cpp (one relaxed atomic add per call).
+// Only counts when that translation unit is linked in.
+struct AllocationStats
+{
+	uint64_t Count = 0;
+	uint64_t Bytes = 0;
+};
+
+AllocationStats GetAllocationStats();
@@ -0,0 +1,270 @@
+#include "ColliderSet.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+	#include <xmmintrin.h>
+	#define COLLIDER_SET_SSE 1
+#endif
+
+// Keeps a runaway collider from allocating an enormous grid
+static constexpr uint32_t MaxGridSize = 256;
+static constexpr float FarAway = 1e18f;
+
+#ifndef COLLIDER_SET_SSE
+// Signed distance from p to a rounded oriented box; negative inside
+static float Distance(const glm::vec2& center, const glm::vec2& axis, const glm::vec2& extents, float radius, const glm::vec2& p)
+{
+	glm::vec2 d = p - center;
+	glm::vec2 local = { d.x * axis.x + d.y * axis.y, d.y * axis.x - d.x * axis.y };
+	glm::vec2 q = glm::abs(local) - extents;
+	return glm::length(glm::max(q, 0.0f)) + std::min(std::max(q.x, q.y), 0.0f) - radius;
+}
+#endif
+
+void ColliderSet::Build()
+{
+	uint32_t count = (uint32_t)m_Colliders.size();
+	m_Shapes.resize(count);
+	m_Bounds.resize(count);
+	m_CellRanges.resize(count);
+	if (count == 0)
+	{
+		m_Width = m_Height = 0;
+		m_Groups.clear();
+		m_CellStart.assign(1, 0);
+		return;
+	}
+
+	glm::vec2 boundsMin(FarAway), boundsMax(-FarAway);
+	float sizeSum = 0.0f;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Collider& collider = m_Colliders[i];
+		Shape& shape = m_Shapes[i];
+		switch (collider.Shape)
+		{
+			case ColliderShape::Capsule:
+			{
+				glm::vec2 segment = collider.End - collider.Position;
+				float length = glm::length(segment);
+				shape.Center = (collider.Position + collider.End) * 0.5f;
+				shape.Axis = length > 0.0f ? segment / length : glm::vec2(1.0f, 0.0f);
+				shape.Extents = { length * 0.5f, 0.0f };
+				shape.Radius = collider.Radius;
+				break;
+			}
+			case ColliderShape::Box:
+				shape.Center = collider.Position;
+				shape.Axis = { std::cos(collider.Rotation), std::sin(collider.Rotation) };
+				shape.Extents = collider.HalfExtents;
+				shape.Radius = 0.0f;
+				break;
+			default:
+				shape.Center = collider.Position;
+				shape.Axis = { 1.0f, 0.0f };
+				shape.Extents = { 0.0f, 0.0f };
+				shape.Radius = collider.Radius;
+				break;
+		}
+
+		glm::vec2 half = {
+			std::abs(shape.Axis.x) * shape.Extents.x + std::abs(shape.Axis.y) * shape.Extents.y + shape.Radius,
+			std::abs(shape.Axis.y) * shape.Extents.x + std::abs(shape.Axis.x) * shape.Extents.y + shape.Radius
+		};
+		m_Bounds[i] = { shape.Center - half, shape.Center + half };
+		boundsMin = glm::min(boundsMin, shape.Center - half);
+		boundsMax = glm::max(boundsMax, shape.Center + half);
+		sizeSum += 2.0f * std::max(half.x, half.y);
+	}
+
+	glm::vec2 extent = boundsMax - boundsMin;
+	float cellSize = m_Props.CellSize > 0.0f ? m_Props.CellSize : 2.0f * sizeSum / count;
+	cellSize = std::max({ cellSize, extent.x / MaxGridSize, extent.y / MaxGridSize, 1e-4f });
+	m_Origin = boundsMin;
+	m_InverseCellSize = 1.0f / cellSize;
+	m_Width = std::clamp((uint32_t)std::ceil(extent.x * m_InverseCellSize), 1u, MaxGridSize);
+	m_Height = std::clamp((uint32_t)std::ceil(extent.y * m_InverseCellSize), 1u, MaxGridSize);
+
+	// Counting sort: cells covered by each collider, then a prefix sum in groups of four
+	uint32_t cellCount = m_Width * m_Height;
+	m_CellCounts.assign(cellCount, 0);
+	auto toCell = [&](float value, float origin, uint32_t size)
+	{
+		return std::clamp((int)((value - origin) * m_InverseCellSize), 0, (int)size - 1);
+	};
+	for (uint32_t i = 0; i < count; i++)
+	{
+		glm::ivec4& range = m_CellRanges[i];
+		range = { toCell(m_Bounds[i].x, m_Origin.x, m_Width), toCell(m_Bounds[i].y, m_Origin.y, m_Height),
+			toCell(m_Bounds[i].z, m_Origin.x, m_Width), toCell(m_Bounds[i].w, m_Origin.y, m_Height) };
+		for (int y = range.y; y <= range.w; y++)
+		{
+			for (int x = range.x; x <= range.z; x++)
+				m_CellCounts[(size_t)y * m_Width + x]++;
+		}
+	}
+
+	m_CellStart.resize(cellCount + 1);
+	m_CellStart[0] = 0;
+	for (uint32_t cell = 0; cell < cellCount; cell++)
+	{
+		m_CellStart[cell + 1] = m_CellStart[cell] + (m_CellCounts[cell] + 3) / 4;
+		m_CellCounts[cell] = 0;
+	}
+
+	ShapeGroup empty;
+	for (uint32_t lane = 0; lane < 4; lane++)
+	{
+		empty.CenterX[lane] = empty.CenterY[lane] = FarAway;
+		empty.AxisX[lane] = 1.0f;
+		empty.AxisY[lane] = empty.ExtentX[lane] = empty.ExtentY[lane] = empty.Radius[lane] = 0.0f;
+		empty.Index[lane] = UINT32_MAX;
+	}
+	m_Groups.assign(m_CellStart[cellCount], empty);
+
+	// In collider order, so every cell lists its colliders by index
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Shape& shape = m_Shapes[i];
+		const glm::ivec4& range = m_CellRanges[i];
+		for (int y = range.y; y <= range.w; y++)
+		{
+			for (int x = range.x; x <= range.z; x++)
+			{
+				size_t cell = (size_t)y * m_Width + x;
+				uint32_t slot = m_CellCounts[cell]++;
+				ShapeGroup& group = m_Groups[m_CellStart[cell] + slot / 4];
+				uint32_t lane = slot % 4;
+				group.CenterX[lane] = shape.Center.x;
+				group.CenterY[lane] = shape.Center.y;
+				group.AxisX[lane] = shape.Axis.x;
+				group.AxisY[lane] = shape.Axis.y;
+				group.ExtentX[lane] = shape.Extents.x;
+				group.ExtentY[lane] = shape.Extents.y;
+				group.Radius[lane] = shape.Radius;
+				group.Index[lane] = i;
+			}
+		}
+	}
+}
+
+uint32_t ColliderSet::CollideParticles(std::vector<Particle>& particles, uint32_t first) const
+{
+	if (m_Width == 0 || first >= particles.size())
+		return 0;
+
+	std::atomic<uint32_t> contacts{ 0 };
+	JobSystem::ParallelFor((uint32_t)particles.size() - first, 4096, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		uint32_t localContacts = 0;
+		for (uint32_t i = first + begin; i < first + end; i++)
+		{
+			Particle& particle = particles[i];
+			if (!particle.Active)
+				continue;
+
+			float cellX = (particle.Position.x - m_Origin.x) * m_InverseCellSize;
+			float cellY = (particle.Position.y - m_Origin.y) * m_InverseCellSize;
+			if (!(cellX >= 0.0f && cellY >= 0.0f && cellX < (float)m_Width && cellY < (float)m_Height))
+				continue;
+
+			size_t cell = (size_t)cellY * m_Width + (uint32_t)cellX;
+			uint32_t firstGroup = m_CellStart[cell], lastGroup = m_CellStart[cell + 1];
+
+			// Deepest contact; ties go to the lower collider index, as groups and lanes are in index order
+			float deepest = 0.0f;
+			uint32_t hit = UINT32_MAX;
+#ifdef COLLIDER_SET_SSE
+			__m128 px = _mm_set1_ps(particle.Position.x), py = _mm_set1_ps(particle.Position.y);
+			__m128 zero = _mm_setzero_ps(), signMask = _mm_set1_ps(-0.0f);
+			for (uint32_t g = firstGroup; g < lastGroup; g++)
+			{
+				const ShapeGroup& group = m_Groups[g];
+				__m128 dx = _mm_sub_ps(px, _mm_load_ps(group.CenterX));
+				__m128 dy = _mm_sub_ps(py, _mm_load_ps(group.CenterY));
+				__m128 ax = _mm_load_ps(group.AxisX), ay = _mm_load_ps(group.AxisY);
+				__m128 lx = _mm_add_ps(_mm_mul_ps(dx, ax), _mm_mul_ps(dy, ay));
+				__m128 ly = _mm_sub_ps(_mm_mul_ps(dy, ax), _mm_mul_ps(dx, ay));
+				__m128 qx = _mm_sub_ps(_mm_andnot_ps(signMask, lx), _mm_load_ps(group.ExtentX));
+				__m128 qy = _mm_sub_ps(_mm_andnot_ps(signMask, ly), _mm_load_ps(group.ExtentY));
+				__m128 ox = _mm_max_ps(qx, zero), oy = _mm_max_ps(qy, zero);
+				__m128 outside = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)));
+				__m128 inside = _mm_min_ps(_mm_max_ps(qx, qy), zero);
+				__m128 distance = _mm_sub_ps(_mm_add_ps(outside, inside), _mm_load_ps(group.Radius));
+
+				int mask = _mm_movemask_ps(_mm_cmplt_ps(distance, _mm_set1_ps(deepest)));
+				if (mask == 0)
+					continue;
+
+				alignas(16) float distances[4];
+				_mm_store_ps(distances, distance);
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					if (distances[lane] < deepest)
+					{
+						deepest = distances[lane];
+						hit = group.Index[lane];
+					}
+				}
+			}
+#else
+			for (uint32_t g = firstGroup; g < lastGroup; g++)
+			{
+				const ShapeGroup& group = m_Groups[g];
+				for (uint32_t lane = 0; lane < 4; lane++)
+				{
+					float distance = Distance({ group.CenterX[lane], group.CenterY[lane] }, { group.AxisX[lane], group.AxisY[lane] },
+						{ group.ExtentX[lane], group.ExtentY[lane] }, group.Radius[lane], particle.Position);
+					if (distance < deepest)
+					{
+						deepest = distance;
+						hit = group.Index[lane];
+					}
+				}
+			}
+#endif
+
+			if (hit != UINT32_MAX)
+			{
+				Resolve(particle, hit, deepest);
+				localContacts++;
+			}
+		}
+		contacts.fetch_add(localContacts, std::memory_order_relaxed);
+	});
+	return contacts.load(std::memory_order_relaxed);
+}
+
+void ColliderSet::Resolve(Particle& particle, uint32_t collider, float distance) const
+{
+	const Shape& shape = m_Shapes[collider];
+	glm::vec2 d = particle.Position - shape.Center;
+	glm::vec2 local = { d.x * shape.Axis.x + d.y * shape.Axis.y, d.y * shape.Axis.x - d.x * shape.Axis.y };
+	glm::vec2 q = glm::abs(local) - shape.Extents;
+	glm::vec2 sign = { local.x < 0.0f ? -1.0f : 1.0f, local.y < 0.0f ? -1.0f : 1.0f };
+
+	// Outside the core box the normal points away from its nearest point, inside along the shallowest axis
+	glm::vec2 normal;
+	if (q.x > 0.0f || q.y > 0.0f)
+		normal = glm::normalize(glm::max(q, 0.0f) * sign);
+	else
+		normal = q.x > q.y ? glm::vec2(sign.x, 0.0f) : glm::vec2(0.0f, sign.y);
+	normal = { normal.x * shape.Axis.x - normal.y * shape.Axis.y, normal.x * shape.Axis.y + normal.y * shape.Axis.x };
+
+	particle.Position -= normal * distance;
+
+	glm::vec2 velocity = m_Colliders[collider].Velocity;
+	glm::vec2 relative = particle.Velocity - velocity;
+	float normalSpeed = glm::dot(relative, normal);
+	if (normalSpeed < 0.0f)
+	{
+		glm::vec2 tangent = relative - normal * normalSpeed;
+		relative = tangent * (1.0f - m_Props.Friction) - normal * (normalSpeed * m_Props.Restitution);
+	}
+	particle.Velocity = relative + velocity;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+enum class ColliderShape : uint32_t
+{
+	Circle = 0, // Position, Radius
+	Capsule,    // segment Position -> End, Radius
+	Box         // centre Position, HalfExtents, Rotation
+};
+
+struct Collider
+{
+	ColliderShape Shape = ColliderShape::Circle;
+	glm::vec2 Position = { 0.0f, 0.0f };
+	glm::vec2 End = { 0.0f, 0.0f };
+	glm::vec2 HalfExtents = { 0.0f, 0.0f };
+	float Radius = 0.0f;
+	float Rotation = 0.0f; // radians
+	glm::vec2 Velocity = { 0.0f, 0.0f }; // world units per second, passed on to particles it hits
+};
+
+struct ColliderSetProps
+{
+	float CellSize = 0.0f;    // 0 = twice the mean collider size
+	float Restitution = 0.4f; // share of the normal speed kept by a bounce
+	float Friction = 0.1f;    // share of the tangential speed lost per contact
+};
+
+// Moving obstacles particles bounce off. Owners rewrite the colliders every
+// frame and call Build(), which buckets them into a uniform grid over their
+// bounds with a counting sort, in O(colliders + covered cells).
+// CollideParticles() then tests each particle only against its own cell,
+// four colliders at a time: every shape is stored as a rounded oriented box
+// (a circle is a point with a radius, a capsule a segment with one), so one
+// branch-free SSE signed distance covers all three. A particle inside a
+// collider is moved to the surface of the deepest one and bounced relative
+// to that collider's velocity. Particles are points; no GL dependency.
+class ColliderSet
+{
+public:
+	ColliderSetProps& GetProps() { return m_Props; }
+	std::vector<Collider>& GetColliders() { return m_Colliders; }
+	const std::vector<Collider>& GetColliders() const { return m_Colliders; }
+
+	// Call after moving the colliders, before CollideParticles()
+	void Build();
+
+	// Particles before `first` are left alone (ParticlePool::GetReservedCount(): constraint
+	// bodies collide inside their own solver). Returns how many particles were in contact.
+	uint32_t CollideParticles(std::vector<Particle>& particles, uint32_t first = 0) const;
+
+	uint32_t GetGridWidth() const { return m_Width; }
+	uint32_t GetGridHeight() const { return m_Height; }
+private:
+	struct Shape
+	{
+		glm::vec2 Center, Axis, Extents;
+		float Radius;
+	};
+
+	// Colliders of one cell in SSE lanes; unused lanes are far away
+	struct alignas(16) ShapeGroup
+	{
+		float CenterX[4], CenterY[4];
+		float AxisX[4], AxisY[4];
+		float ExtentX[4], ExtentY[4];
+		float Radius[4];
+		uint32_t Index[4];
+	};
+
+	void Resolve(Particle& particle, uint32_t collider, float distance) const;
+private:
+	ColliderSetProps m_Props;
+	std::vector<Collider> m_Colliders;
+
+	std::vector<Shape> m_Shapes;
+	std::vector<ShapeGroup> m_Groups;
+	std::vector<uint32_t> m_CellStart; // first group of each cell, then the group count
+	std::vector<uint32_t> m_CellCounts;
+	std::vector<glm::vec4> m_Bounds;      // per collider: min and max corner
+	std::vector<glm::ivec4> m_CellRanges; // per collider: first and last cell covered
+
+	glm::vec2 m_Origin = { 0.0f, 0.0f };
+	float m_InverseCellSize = 1.0f;
+	uint32_t m_Width = 0, m_Height = 0;
+};
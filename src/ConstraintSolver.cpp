@@ -0,0 +1,424 @@
+#include "ConstraintSolver.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+
+ConstraintSolver::ConstraintSolver(ParticlePool& pool)
+	: m_Pool(pool)
+{
+}
+
+uint32_t ConstraintSolver::ReserveBody(uint32_t count, const ParticleProps& look)
+{
+	uint32_t first = m_Pool.Reserve(count);
+	if (first == UINT32_MAX)
+		return first;
+
+	m_Predicted.resize(m_Pool.GetReservedCount(), glm::vec2(0.0f));
+	m_InverseMass.resize(m_Pool.GetReservedCount(), 1.0f);
+
+	std::vector<Particle>& particles = m_Pool.GetParticles();
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		Particle& particle = particles[i];
+		particle.Active = true;
+		particle.Velocity = { 0.0f, 0.0f };
+		particle.ColorBegin = look.ColorBegin;
+		particle.ColorEnd = look.ColorEnd;
+		particle.SizeBegin = particle.SizeEnd = look.SizeBegin;
+		particle.Flipbook = look.Flipbook;
+		// Bodies live until Clear()
+		particle.LifeTime = particle.LifeRemaining = FLT_MAX;
+	}
+	m_BatchesDirty = true;
+	return first;
+}
+
+uint32_t ConstraintSolver::AddRope(const glm::vec2& start, const glm::vec2& end, uint32_t segments, const ParticleProps& look,
+	bool pinStart, float stiffness, float bendStiffness)
+{
+	segments = std::max(1u, segments);
+	uint32_t first = ReserveBody(segments + 1, look);
+	if (first == UINT32_MAX)
+		return first;
+
+	std::vector<Particle>& particles = m_Pool.GetParticles();
+	for (uint32_t i = 0; i <= segments; i++)
+		particles[first + i].Position = glm::mix(start, end, (float)i / (float)segments);
+
+	for (uint32_t i = 0; i < segments; i++)
+		AddDistanceConstraint(first + i, first + i + 1, stiffness);
+	for (uint32_t i = 0; i + 1 < segments; i++)
+		AddBendingConstraint(first + i, first + i + 1, first + i + 2, bendStiffness);
+
+	if (pinStart)
+		SetInverseMass(first, 0.0f);
+	return first;
+}
+
+uint32_t ConstraintSolver::AddSoftBody(const glm::vec2& center, const glm::vec2& size, uint32_t columns, uint32_t rows, const ParticleProps& look,
+	float stiffness, float bendStiffness)
+{
+	columns = std::max(2u, columns);
+	rows = std::max(2u, rows);
+	uint32_t first = ReserveBody(columns * rows, look);
+	if (first == UINT32_MAX)
+		return first;
+
+	auto index = [&](uint32_t x, uint32_t y) { return first + y * columns + x; };
+
+	std::vector<Particle>& particles = m_Pool.GetParticles();
+	glm::vec2 origin = center - size * 0.5f;
+	glm::vec2 spacing = size / glm::vec2(columns - 1, rows - 1);
+	for (uint32_t y = 0; y < rows; y++)
+	{
+		for (uint32_t x = 0; x < columns; x++)
+			particles[index(x, y)].Position = origin + glm::vec2(x, y) * spacing;
+	}
+
+	// Structural and shear springs, then bending along rows and columns
+	for (uint32_t y = 0; y < rows; y++)
+	{
+		for (uint32_t x = 0; x < columns; x++)
+		{
+			if (x + 1 < columns)
+				AddDistanceConstraint(index(x, y), index(x + 1, y), stiffness);
+			if (y + 1 < rows)
+				AddDistanceConstraint(index(x, y), index(x, y + 1), stiffness);
+			if (x + 1 < columns && y + 1 < rows)
+			{
+				AddDistanceConstraint(index(x, y), index(x + 1, y + 1), stiffness);
+				AddDistanceConstraint(index(x + 1, y), index(x, y + 1), stiffness);
+			}
+			if (x + 2 < columns)
+				AddBendingConstraint(index(x, y), index(x + 1, y), index(x + 2, y), bendStiffness);
+			if (y + 2 < rows)
+				AddBendingConstraint(index(x, y), index(x, y + 1), index(x, y + 2), bendStiffness);
+		}
+	}
+	return first;
+}
+
+// Rest shapes are taken from the current particle positions
+void ConstraintSolver::AddDistanceConstraint(uint32_t a, uint32_t b, float stiffness)
+{
+	const std::vector<Particle>& particles = m_Pool.GetParticles();
+	float restLength = glm::distance(particles[a].Position, particles[b].Position);
+	m_DistanceConstraints.push_back({ a, b, restLength, glm::clamp(stiffness, 0.0f, 1.0f) });
+	m_BatchesDirty = true;
+}
+
+void ConstraintSolver::AddBendingConstraint(uint32_t a, uint32_t b, uint32_t c, float stiffness)
+{
+	const std::vector<Particle>& particles = m_Pool.GetParticles();
+	glm::vec2 centroid = (particles[a].Position + particles[b].Position + particles[c].Position) / 3.0f;
+	float restLength = glm::distance(particles[b].Position, centroid);
+	m_BendingConstraints.push_back({ a, b, c, restLength, glm::clamp(stiffness, 0.0f, 1.0f) });
+	m_BatchesDirty = true;
+}
+
+void ConstraintSolver::AddCircleCollider(const glm::vec2& center, float radius)
+{
+	m_Circles.push_back({ center, radius });
+}
+
+void ConstraintSolver::SetInverseMass(uint32_t particle, float inverseMass)
+{
+	if (particle < m_InverseMass.size())
+		m_InverseMass[particle] = inverseMass;
+}
+
+void ConstraintSolver::Clear()
+{
+	m_Pool.ReleaseReserved();
+	m_DistanceConstraints.clear();
+	m_BendingConstraints.clear();
+	m_Predicted.clear();
+	m_InverseMass.clear();
+	m_Batches.clear();
+	m_ColorCount = 0;
+	m_JacobiDistanceCount = m_JacobiBendingCount = 0;
+	m_BatchesDirty = false;
+}
+
+uint32_t ConstraintSolver::GetParticles(const DistanceConstraint& constraint, uint32_t* particles)
+{
+	particles[0] = constraint.A;
+	particles[1] = constraint.B;
+	return 2;
+}
+
+uint32_t ConstraintSolver::GetParticles(const BendingConstraint& constraint, uint32_t* particles)
+{
+	particles[0] = constraint.A;
+	particles[1] = constraint.B;
+	particles[2] = constraint.C;
+	return 3;
+}
+
+// Greedy coloring: each constraint takes the lowest color none of its particles
+// has used yet. Constraints are then counting-sorted by color so every batch is
+// a contiguous range; the ones that found no free color end up last.
+// Returns the number of uncolored (Jacobi) constraints.
+template<typename Constraint>
+uint32_t ConstraintSolver::ColorConstraints(std::vector<Constraint>& constraints, bool bending)
+{
+	std::vector<uint64_t> usedColors(m_Predicted.size(), 0);
+	std::vector<uint8_t> colors(constraints.size());
+	uint32_t counts[MaxColors + 1] = {};
+
+	for (size_t i = 0; i < constraints.size(); i++)
+	{
+		uint32_t particles[3];
+		uint32_t particleCount = GetParticles(constraints[i], particles);
+
+		uint64_t used = 0;
+		for (uint32_t p = 0; p < particleCount; p++)
+			used |= usedColors[particles[p]];
+
+		uint32_t color = 0;
+		if (m_Props.ForceJacobi)
+			color = MaxColors;
+		while (color < MaxColors && (used & (1ull << color)))
+			color++;
+
+		if (color < MaxColors)
+		{
+			for (uint32_t p = 0; p < particleCount; p++)
+				usedColors[particles[p]] |= 1ull << color;
+		}
+		colors[i] = (uint8_t)color;
+		counts[color]++;
+	}
+
+	uint32_t offsets[MaxColors + 1];
+	uint32_t offset = 0;
+	for (uint32_t color = 0; color <= MaxColors; color++)
+	{
+		offsets[color] = offset;
+		if (color < MaxColors && counts[color] > 0)
+		{
+			m_Batches.push_back({ bending, offset, offset + counts[color] });
+			m_ColorCount = std::max(m_ColorCount, color + 1);
+		}
+		offset += counts[color];
+	}
+
+	std::vector<Constraint> sorted(constraints.size());
+	for (size_t i = 0; i < constraints.size(); i++)
+		sorted[offsets[colors[i]]++] = constraints[i];
+	constraints.swap(sorted);
+
+	return counts[MaxColors];
+}
+
+void ConstraintSolver::BuildBatches()
+{
+	m_Batches.clear();
+	m_ColorCount = 0;
+	// Batches run one after another, so the two constraint types are colored independently
+	m_JacobiDistanceCount = ColorConstraints(m_DistanceConstraints, false);
+	m_JacobiBendingCount = ColorConstraints(m_BendingConstraints, true);
+	m_BatchesDirty = false;
+	m_BatchedForceJacobi = m_Props.ForceJacobi;
+}
+
+bool ConstraintSolver::ComputeCorrection(const DistanceConstraint& constraint, glm::vec2* corrections) const
+{
+	float wa = m_InverseMass[constraint.A], wb = m_InverseMass[constraint.B];
+	float weight = wa + wb;
+	if (weight <= 0.0f)
+		return false;
+
+	glm::vec2 delta = m_Predicted[constraint.B] - m_Predicted[constraint.A];
+	float length = glm::length(delta);
+	if (length < 1e-6f)
+		return false;
+
+	glm::vec2 correction = delta * ((length - constraint.RestLength) / (length * weight) * constraint.Stiffness);
+	corrections[0] = correction * wa;
+	corrections[1] = -correction * wb;
+	return true;
+}
+
+bool ConstraintSolver::ComputeCorrection(const BendingConstraint& constraint, glm::vec2* corrections) const
+{
+	float wa = m_InverseMass[constraint.A], wb = m_InverseMass[constraint.B], wc = m_InverseMass[constraint.C];
+	float weight = wa + 2.0f * wb + wc;
+	if (weight <= 0.0f)
+		return false;
+
+	const glm::vec2& a = m_Predicted[constraint.A];
+	const glm::vec2& b = m_Predicted[constraint.B];
+	const glm::vec2& c = m_Predicted[constraint.C];
+	glm::vec2 offset = b - (a + b + c) / 3.0f;
+	float length = glm::length(offset);
+	if (length < 1e-6f)
+		return false;
+
+	glm::vec2 correction = offset * ((1.0f - constraint.RestLength / length) * constraint.Stiffness / weight);
+	corrections[0] = correction * (2.0f * wa);
+	corrections[1] = correction * (-4.0f * wb);
+	corrections[2] = correction * (2.0f * wc);
+	return true;
+}
+
+// No two constraints of a batch share a particle, so corrections are stored directly
+template<typename Constraint>
+void ConstraintSolver::SolveBatch(const std::vector<Constraint>& constraints, uint32_t begin, uint32_t end)
+{
+	JobSystem::ParallelFor(end - begin, 512, [&](uint32_t first, uint32_t last, uint32_t)
+	{
+		for (uint32_t i = begin + first; i < begin + last; i++)
+		{
+			glm::vec2 corrections[3];
+			if (!ComputeCorrection(constraints[i], corrections))
+				continue;
+
+			uint32_t particles[3];
+			uint32_t particleCount = GetParticles(constraints[i], particles);
+			for (uint32_t p = 0; p < particleCount; p++)
+				m_Predicted[particles[p]] += corrections[p];
+		}
+	});
+}
+
+template<typename Constraint>
+void ConstraintSolver::AccumulateJacobi(const std::vector<Constraint>& constraints, uint32_t begin, uint32_t end)
+{
+	JobSystem::ParallelFor(end - begin, 512, [&](uint32_t first, uint32_t last, uint32_t threadIndex)
+	{
+		std::vector<glm::vec3>& accumulated = m_ThreadCorrections[threadIndex];
+		for (uint32_t i = begin + first; i < begin + last; i++)
+		{
+			glm::vec2 corrections[3];
+			if (!ComputeCorrection(constraints[i], corrections))
+				continue;
+
+			uint32_t particles[3];
+			uint32_t particleCount = GetParticles(constraints[i], particles);
+			for (uint32_t p = 0; p < particleCount; p++)
+				accumulated[particles[p]] += glm::vec3(corrections[p], 1.0f);
+		}
+	});
+}
+
+// Every Jacobi constraint reads the same predicted positions; the per-particle
+// average of their corrections is applied afterwards, over-relaxed.
+void ConstraintSolver::SolveJacobi()
+{
+	if (m_JacobiDistanceCount + m_JacobiBendingCount == 0)
+		return;
+
+	uint32_t particleCount = (uint32_t)m_Predicted.size();
+	uint32_t threadCount = JobSystem::GetThreadCount();
+	if (m_ThreadCorrections.size() != threadCount)
+		m_ThreadCorrections.resize(threadCount);
+	for (std::vector<glm::vec3>& accumulated : m_ThreadCorrections)
+	{
+		if (accumulated.size() != particleCount)
+			accumulated.assign(particleCount, glm::vec3(0.0f));
+	}
+
+	uint32_t distanceCount = (uint32_t)m_DistanceConstraints.size();
+	uint32_t bendingCount = (uint32_t)m_BendingConstraints.size();
+	AccumulateJacobi(m_DistanceConstraints, distanceCount - m_JacobiDistanceCount, distanceCount);
+	AccumulateJacobi(m_BendingConstraints, bendingCount - m_JacobiBendingCount, bendingCount);
+
+	float relaxation = m_Props.JacobiRelaxation;
+	JobSystem::ParallelFor(particleCount, 2048, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			glm::vec3 sum(0.0f);
+			for (std::vector<glm::vec3>& accumulated : m_ThreadCorrections)
+			{
+				sum += accumulated[i];
+				accumulated[i] = glm::vec3(0.0f);
+			}
+			if (sum.z > 0.0f)
+				m_Predicted[i] += glm::vec2(sum) * (relaxation / sum.z);
+		}
+	});
+}
+
+void ConstraintSolver::SolveCollisions()
+{
+	const std::vector<Particle>& particles = m_Pool.GetParticles();
+	float radius = m_Props.ParticleRadius;
+	float floor = m_Props.FloorY + radius;
+	JobSystem::ParallelFor((uint32_t)m_Predicted.size(), 2048, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			if (m_InverseMass[i] <= 0.0f)
+				continue;
+
+			glm::vec2& predicted = m_Predicted[i];
+			if (predicted.y < floor)
+			{
+				predicted.y = floor;
+				// Friction: cancel part of this step's tangential motion
+				predicted.x = glm::mix(predicted.x, particles[i].Position.x, m_Props.Friction);
+			}
+
+			for (const Circle& circle : m_Circles)
+			{
+				glm::vec2 offset = predicted - circle.Center;
+				float minDistance = circle.Radius + radius;
+				float distance2 = glm::dot(offset, offset);
+				if (distance2 >= minDistance * minDistance || distance2 < 1e-12f)
+					continue;
+				predicted = circle.Center + offset * (minDistance / std::sqrt(distance2));
+			}
+		}
+	});
+}
+
+void ConstraintSolver::Step(float ts)
+{
+	if (m_Predicted.empty() || ts <= 0.0f)
+		return;
+
+	if (m_BatchesDirty || m_BatchedForceJacobi != m_Props.ForceJacobi)
+		BuildBatches();
+
+	std::vector<Particle>& particles = m_Pool.GetParticles();
+	uint32_t particleCount = (uint32_t)m_Predicted.size();
+	float damping = 1.0f / (1.0f + m_Props.Damping * ts);
+	JobSystem::ParallelFor(particleCount, 2048, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Particle& particle = particles[i];
+			if (m_InverseMass[i] > 0.0f)
+				particle.Velocity = (particle.Velocity + m_Props.Gravity * ts) * damping;
+			else
+				particle.Velocity = { 0.0f, 0.0f };
+			m_Predicted[i] = particle.Position + particle.Velocity * ts;
+		}
+	});
+
+	for (uint32_t iteration = 0; iteration < m_Props.Iterations; iteration++)
+	{
+		for (const Batch& batch : m_Batches)
+		{
+			if (batch.Bending)
+				SolveBatch(m_BendingConstraints, batch.Begin, batch.End);
+			else
+				SolveBatch(m_DistanceConstraints, batch.Begin, batch.End);
+		}
+		SolveJacobi();
+		SolveCollisions();
+	}
+
+	// The pool integrates position += velocity * ts, landing exactly on the solved positions
+	float inverseTs = 1.0f / ts;
+	JobSystem::ParallelFor(particleCount, 2048, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			particles[i].Velocity = (m_Predicted[i] - particles[i].Position) * inverseTs;
+	});
+}
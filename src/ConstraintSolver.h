@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct ConstraintSolverProps
+{
+	uint32_t Iterations = 8;
+	glm::vec2 Gravity = { 0.0f, -9.8f };
+	float Damping = 0.5f; // fraction of velocity lost per second
+	float ParticleRadius = 0.02f;
+	float FloorY = -1.0f;
+	float Friction = 0.3f;
+
+	bool ForceJacobi = false;      // solve every constraint with the Jacobi path instead of colored batches
+	float JacobiRelaxation = 1.5f; // over-relaxation for averaged Jacobi corrections
+};
+
+// Position-based dynamics for ropes, hair and soft bodies built from pool
+// particles. Bodies take their particles out of the pool's emission ring
+// (ParticlePool::Reserve) and are drawn by the normal particle renderer.
+//
+// Distance and bending constraints are greedily graph-colored so no two
+// constraints of a color share a particle; each color is solved in parallel
+// with plain stores. Constraints that run out of colors go to a Jacobi batch
+// accumulated in per-thread buffers. Collisions are per particle.
+//
+// Step() writes the PBD velocity (predicted - position) / ts and leaves the
+// position to ParticlePool::Update, so it must run before the pool update and
+// after anything else that moves the bodies' particles (force volumes, fluid);
+// ColliderSet skips them, given the reserved count.
+class ConstraintSolver
+{
+public:
+	static constexpr uint32_t MaxColors = 64;
+
+	ConstraintSolver(ParticlePool& pool);
+
+	ConstraintSolverProps& GetProps() { return m_Props; }
+
+	// Stiffness is in [0, 1]. Both return the first particle index, or UINT32_MAX when the pool is full.
+	uint32_t AddRope(const glm::vec2& start, const glm::vec2& end, uint32_t segments, const ParticleProps& look,
+		bool pinStart = true, float stiffness = 1.0f, float bendStiffness = 0.2f);
+	uint32_t AddSoftBody(const glm::vec2& center, const glm::vec2& size, uint32_t columns, uint32_t rows, const ParticleProps& look,
+		float stiffness = 0.8f, float bendStiffness = 0.1f);
+
+	void AddDistanceConstraint(uint32_t a, uint32_t b, float stiffness);
+	void AddBendingConstraint(uint32_t a, uint32_t b, uint32_t c, float stiffness);
+	void AddCircleCollider(const glm::vec2& center, float radius);
+	void SetInverseMass(uint32_t particle, float inverseMass);
+
+	// Releases every body back to the pool
+	void Clear();
+
+	void Step(float ts);
+
+	uint32_t GetConstraintCount() const { return (uint32_t)(m_DistanceConstraints.size() + m_BendingConstraints.size()); }
+	uint32_t GetColorCount() const { return m_ColorCount; }
+	uint32_t GetJacobiCount() const { return m_JacobiDistanceCount + m_JacobiBendingCount; }
+private:
+	struct DistanceConstraint
+	{
+		uint32_t A, B;
+		float RestLength, Stiffness;
+	};
+
+	// Triangle bending (Kelager et al.): keeps the middle particle B at its rest distance from the triangle centroid
+	struct BendingConstraint
+	{
+		uint32_t A, B, C;
+		float RestLength, Stiffness;
+	};
+
+	struct Batch
+	{
+		bool Bending;
+		uint32_t Begin, End;
+	};
+
+	struct Circle
+	{
+		glm::vec2 Center;
+		float Radius;
+	};
+
+	static uint32_t GetParticles(const DistanceConstraint& constraint, uint32_t* particles);
+	static uint32_t GetParticles(const BendingConstraint& constraint, uint32_t* particles);
+
+	uint32_t ReserveBody(uint32_t count, const ParticleProps& look);
+	void BuildBatches();
+	template<typename Constraint>
+	uint32_t ColorConstraints(std::vector<Constraint>& constraints, bool bending);
+
+	// Corrections for the current predicted positions; false when there is nothing to do
+	bool ComputeCorrection(const DistanceConstraint& constraint, glm::vec2* corrections) const;
+	bool ComputeCorrection(const BendingConstraint& constraint, glm::vec2* corrections) const;
+	template<typename Constraint>
+	void SolveBatch(const std::vector<Constraint>& constraints, uint32_t begin, uint32_t end);
+	template<typename Constraint>
+	void AccumulateJacobi(const std::vector<Constraint>& constraints, uint32_t begin, uint32_t end);
+	void SolveJacobi();
+	void SolveCollisions();
+private:
+	ParticlePool& m_Pool;
+	ConstraintSolverProps m_Props;
+
+	std::vector<DistanceConstraint> m_DistanceConstraints;
+	std::vector<BendingConstraint> m_BendingConstraints;
+	std::vector<Circle> m_Circles;
+
+	// Indexed by pool particle, covering the reserved range
+	std::vector<glm::vec2> m_Predicted;
+	std::vector<float> m_InverseMass;
+
+	// Constraints are sorted by color with the uncolorable ones last
+	bool m_BatchesDirty = false;
+	bool m_BatchedForceJacobi = false;
+	std::vector<Batch> m_Batches;
+	uint32_t m_ColorCount = 0;
+	uint32_t m_JacobiDistanceCount = 0, m_JacobiBendingCount = 0;
+	std::vector<std::vector<glm::vec3>> m_ThreadCorrections; // (delta.xy, count)
+};
@@ -0,0 +1,220 @@
+#include "DensityField.h"
+
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+	#include <xmmintrin.h>
+	#define DENSITY_FIELD_SSE 1
+#endif
+
+DensityField::DensityField()
+{
+}
+
+DensityField::~DensityField()
+{
+	if (!m_Initialized)
+		return;
+
+	RenderThread::GetCommandList().Execute([texture = m_Texture, vertexArray = m_VertexArray, shader = m_Shader.release()]()
+	{
+		glDeleteTextures(1, &texture);
+		glDeleteVertexArrays(1, &vertexArray);
+		delete shader;
+	});
+}
+
+void DensityField::Prepare()
+{
+	m_Props.Width = std::max(1u, m_Props.Width);
+	m_Props.Height = std::max(1u, m_Props.Height);
+	m_Props.BlurRadius = std::max(0, m_Props.BlurRadius);
+
+	uint32_t threads = JobSystem::GetThreadCount();
+	size_t gridSize = (size_t)m_Props.Width * m_Props.Height * 4;
+	if (m_Width != m_Props.Width || m_Height != m_Props.Height || m_ThreadGrids.size() != threads)
+	{
+		m_Width = m_Props.Width;
+		m_Height = m_Props.Height;
+		m_ThreadGrids.assign(threads, std::vector<float>(gridSize));
+		m_Scratch.resize(gridSize);
+	}
+
+	JobSystem::ParallelFor(threads, 1, [this](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			std::fill(m_ThreadGrids[i].begin(), m_ThreadGrids[i].end(), 0.0f);
+	});
+
+	int radius = m_Props.BlurRadius;
+	if (m_BlurKernel.size() != (size_t)radius * 2 + 1)
+	{
+		m_BlurKernel.resize((size_t)radius * 2 + 1);
+
+		float sigma = std::max(0.5f, radius * 0.5f);
+		float sum = 0.0f;
+		for (int i = -radius; i <= radius; i++)
+			sum += m_BlurKernel[i + radius] = std::exp(-(float)(i * i) / (2.0f * sigma * sigma));
+		for (float& weight : m_BlurKernel)
+			weight /= sum;
+	}
+}
+
+void DensityField::Merge()
+{
+	if (m_ThreadGrids.size() < 2)
+		return;
+
+	// Reduce all private grids into grid 0, split by cell range
+	uint32_t cellCount = m_Width * m_Height;
+	JobSystem::ParallelFor(cellCount, 1024, [this](uint32_t begin, uint32_t end, uint32_t)
+	{
+		float* dst = m_ThreadGrids[0].data();
+		for (size_t t = 1; t < m_ThreadGrids.size(); t++)
+		{
+			const float* src = m_ThreadGrids[t].data();
+			for (size_t i = (size_t)begin * 4; i < (size_t)end * 4; i += 4)
+			{
+#if DENSITY_FIELD_SSE
+				_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+#else
+				dst[i + 0] += src[i + 0];
+				dst[i + 1] += src[i + 1];
+				dst[i + 2] += src[i + 2];
+				dst[i + 3] += src[i + 3];
+#endif
+			}
+		}
+	});
+}
+
+void DensityField::Blur()
+{
+	int radius = m_Props.BlurRadius;
+	if (radius == 0)
+		return;
+
+	int width = (int)m_Width, height = (int)m_Height;
+	float* grid = m_ThreadGrids[0].data();
+	float* scratch = m_Scratch.data();
+	const float* kernel = m_BlurKernel.data();
+
+	// Horizontal pass: grid -> scratch, edges clamp
+	JobSystem::ParallelFor(height, 8, [=](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (int y = (int)begin; y < (int)end; y++)
+		{
+			const float* src = grid + (size_t)y * width * 4;
+			float* dst = scratch + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++)
+			{
+#if DENSITY_FIELD_SSE
+				__m128 sum = _mm_setzero_ps();
+				for (int k = -radius; k <= radius; k++)
+				{
+					int sx = std::min(std::max(x + k, 0), width - 1);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + sx * 4), _mm_set1_ps(kernel[k + radius])));
+				}
+				_mm_storeu_ps(dst + x * 4, sum);
+#else
+				float sum[4] = {};
+				for (int k = -radius; k <= radius; k++)
+				{
+					int sx = std::min(std::max(x + k, 0), width - 1);
+					for (int c = 0; c < 4; c++)
+						sum[c] += src[sx * 4 + c] * kernel[k + radius];
+				}
+				std::copy(sum, sum + 4, dst + x * 4);
+#endif
+			}
+		}
+	});
+
+	// Vertical pass: scratch -> grid, walking whole rows to stay cache friendly
+	JobSystem::ParallelFor(height, 8, [=](uint32_t begin, uint32_t end, uint32_t)
+	{
+		size_t rowFloats = (size_t)width * 4;
+		for (int y = (int)begin; y < (int)end; y++)
+		{
+			float* dst = grid + (size_t)y * rowFloats;
+			std::fill(dst, dst + rowFloats, 0.0f);
+			for (int k = -radius; k <= radius; k++)
+			{
+				int sy = std::min(std::max(y + k, 0), height - 1);
+				const float* src = scratch + (size_t)sy * rowFloats;
+				float weight = kernel[k + radius];
+#if DENSITY_FIELD_SSE
+				__m128 w = _mm_set1_ps(weight);
+				for (size_t i = 0; i < rowFloats; i += 4)
+					_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), w)));
+#else
+				for (size_t i = 0; i < rowFloats; i++)
+					dst[i] += src[i] * weight;
+#endif
+			}
+		}
+	});
+}
+
+void DensityField::Render()
+{
+	RenderCommandList& commands = RenderThread::GetCommandList();
+
+	if (!m_Initialized)
+	{
+		commands.Execute([this]()
+		{
+			glCreateVertexArrays(1, &m_VertexArray);
+
+			m_Shader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/density.glsl.vert", "assets/density.glsl.frag"));
+			m_ShaderProgram = m_Shader->GetRendererID();
+			m_ShaderTransfer = glGetUniformLocation(m_ShaderProgram, "u_Transfer");
+			m_ShaderDensityScale = glGetUniformLocation(m_ShaderProgram, "u_DensityScale");
+			m_ShaderThreshold = glGetUniformLocation(m_ShaderProgram, "u_Threshold");
+			m_ShaderSoftness = glGetUniformLocation(m_ShaderProgram, "u_Softness");
+			m_ShaderAbsorption = glGetUniformLocation(m_ShaderProgram, "u_Absorption");
+		});
+		m_Initialized = true;
+	}
+
+	if (m_ThreadGrids.empty())
+		return;
+
+	if (m_TextureWidth != m_Width || m_TextureHeight != m_Height)
+	{
+		commands.Execute([this, width = m_Width, height = m_Height]()
+		{
+			if (m_Texture)
+				glDeleteTextures(1, &m_Texture);
+
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_Texture);
+			glTextureStorage2D(m_Texture, 1, GL_RGBA32F, width, height);
+			glTextureParameteri(m_Texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTextureParameteri(m_Texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTextureParameteri(m_Texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(m_Texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		});
+		m_TextureWidth = m_Width;
+		m_TextureHeight = m_Height;
+	}
+
+	// The grid is rebuilt next frame while this one may still be replaying, so upload a copy
+	size_t gridBytes = m_ThreadGrids[0].size() * sizeof(float);
+	void* grid = commands.Allocate(gridBytes);
+	std::memcpy(grid, m_ThreadGrids[0].data(), gridBytes);
+	commands.UploadTexture2D(&m_Texture, m_Width, m_Height, GL_RGBA, GL_FLOAT, grid);
+
+	commands.UseProgram(&m_ShaderProgram);
+	commands.Uniform1i(&m_ShaderTransfer, (int)m_Props.Transfer);
+	commands.Uniform1f(&m_ShaderDensityScale, m_Props.DensityScale);
+	commands.Uniform1f(&m_ShaderThreshold, m_Props.Threshold);
+	commands.Uniform1f(&m_ShaderSoftness, m_Props.Softness);
+	commands.Uniform1f(&m_ShaderAbsorption, m_Props.Absorption);
+
+	commands.BindTexture(0, &m_Texture);
+	commands.DrawArrays(&m_VertexArray, 0, 3);
+}
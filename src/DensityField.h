@@ -0,0 +1,119 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <GLCoreUtils.h>
+
+#include "JobSystem.h"
+
+#include <memory>
+#include <vector>
+
+enum class DensityTransfer
+{
+	Threshold = 0, Volumetric
+};
+
+struct DensityFieldProps
+{
+	uint32_t Width = 320, Height = 180;
+	int BlurRadius = 2;
+	DensityTransfer Transfer = DensityTransfer::Volumetric;
+	float DensityScale = 1.0f;
+	float Threshold = 0.5f, Softness = 0.25f; // Threshold (metaball) transfer
+	float Absorption = 1.5f;                  // Volumetric transfer
+};
+
+// Splats particles into a low-resolution RGBA grid on the CPU and draws it as a single
+// full-screen texture, so the GPU cost does not depend on the particle count.
+// Each cell holds premultiplied color in rgb and accumulated density in a.
+class DensityField
+{
+public:
+	DensityField();
+	~DensityField();
+
+	DensityFieldProps& GetProps() { return m_Props; }
+
+	// fetch(index, position, color) fills in a particle and returns false to skip it
+	template<typename FetchFunc>
+	void Splat(const glm::mat4& viewProjection, uint32_t count, FetchFunc&& fetch);
+
+	// Records the upload and full-screen draw into the current render command list
+	void Render();
+private:
+	void Prepare();
+	void Merge();
+	void Blur();
+
+	void SplatPoint(float* grid, const glm::vec2& cell, const glm::vec4& color);
+private:
+	DensityFieldProps m_Props;
+
+	uint32_t m_Width = 0, m_Height = 0;
+	std::vector<std::vector<float>> m_ThreadGrids;
+	std::vector<float> m_Scratch;
+	std::vector<float> m_BlurKernel;
+
+	// Recorded on the main thread, GL objects live on the render thread
+	bool m_Initialized = false;
+	uint32_t m_TextureWidth = 0, m_TextureHeight = 0;
+
+	GLuint m_Texture = 0, m_VertexArray = 0;
+	std::unique_ptr<GLCore::Utils::Shader> m_Shader;
+	GLuint m_ShaderProgram = 0;
+	GLint m_ShaderTransfer, m_ShaderDensityScale, m_ShaderThreshold, m_ShaderSoftness, m_ShaderAbsorption;
+};
+
+template<typename FetchFunc>
+void DensityField::Splat(const glm::mat4& viewProjection, uint32_t count, FetchFunc&& fetch)
+{
+	Prepare();
+
+	// Orthographic 2D camera: world -> grid is an affine map
+	glm::vec2 scale = { m_Width * 0.5f, m_Height * 0.5f };
+	glm::vec2 axisX = glm::vec2(viewProjection[0]) * scale;
+	glm::vec2 axisY = glm::vec2(viewProjection[1]) * scale;
+	glm::vec2 origin = (glm::vec2(viewProjection[3]) + 1.0f) * scale - 0.5f;
+
+	JobSystem::ParallelFor(count, 4096, [&](uint32_t begin, uint32_t end, uint32_t threadIndex)
+	{
+		float* grid = m_ThreadGrids[threadIndex].data();
+		glm::vec2 position;
+		glm::vec4 color;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			if (!fetch(i, position, color))
+				continue;
+
+			SplatPoint(grid, origin + axisX * position.x + axisY * position.y, color);
+		}
+	});
+
+	Merge();
+	Blur();
+}
+
+inline void DensityField::SplatPoint(float* grid, const glm::vec2& cell, const glm::vec4& color)
+{
+	int x0 = (int)glm::floor(cell.x), y0 = (int)glm::floor(cell.y);
+	if (x0 < -1 || y0 < -1 || x0 >= (int)m_Width || y0 >= (int)m_Height)
+		return;
+
+	float fx = cell.x - (float)x0, fy = cell.y - (float)y0;
+	glm::vec4 value = { glm::vec3(color) * color.a, color.a };
+	float weights[4] = { (1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy };
+	for (int i = 0; i < 4; i++)
+	{
+		int x = x0 + (i & 1), y = y0 + (i >> 1);
+		if (x < 0 || y < 0 || x >= (int)m_Width || y >= (int)m_Height)
+			continue;
+
+		float* dst = grid + ((size_t)y * m_Width + x) * 4;
+		dst[0] += value.r * weights[i];
+		dst[1] += value.g * weights[i];
+		dst[2] += value.b * weights[i];
+		dst[3] += value.a * weights[i];
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// On-disk layout of a compiled effect library (.pfx). Every section is a
+// flat array addressed by a byte offset from the start of the file, so a
+// mapped file is used in place: records are read through these structs and
+// never copied or parsed. Only 4-byte scalars, little-endian, 4-byte aligned.
+//
+//     header | index | effects | emitters | curve keys | gradient keys | timelines | cues | names
+//
+// The index is an open-addressing hash table (linear probing) keyed by the
+// FNV-1a hash of the effect name. Timelines are few and looked up by a scan.
+// Written by EffectCompiler, read by EffectLibrary.
+
+static constexpr uint32_t EffectFileMagic = 0x4c584650; // "PFXL"
+static constexpr uint32_t EffectFileVersion = 2;
+static constexpr uint32_t EffectIndexEmpty = UINT32_MAX;
+
+inline uint32_t HashEffectName(const char* name, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+	return hash;
+}
+
+inline uint32_t HashEffectName(const std::string& name)
+{
+	return HashEffectName(name.data(), name.size());
+}
+
+struct EffectFileHeader
+{
+	uint32_t Magic, Version;
+	uint32_t FileSize;
+	uint32_t EffectCount;
+	uint32_t IndexCapacity; // power of two, at least twice EffectCount
+	uint32_t IndexOffset, EffectOffset;
+	uint32_t EmitterOffset, EmitterCount;
+	uint32_t CurveKeyOffset, CurveKeyCount;
+	uint32_t GradientKeyOffset, GradientKeyCount;
+	uint32_t TimelineOffset, TimelineCount;
+	uint32_t CueOffset, CueCount;
+	uint32_t NameOffset, NameSize; // NUL-terminated UTF-8
+};
+
+struct EffectIndexSlot
+{
+	uint32_t NameHash;
+	uint32_t Effect; // EffectIndexEmpty when unused
+};
+
+enum EffectFlags : uint32_t
+{
+	EffectFlagLoop = 1 << 0
+};
+
+struct EffectRecord
+{
+	uint32_t NameHash;
+	uint32_t Name; // byte offset into the name section
+	uint32_t FirstEmitter, EmitterCount;
+	float Duration; // seconds of continuous emission; 0 = forever
+	uint32_t Flags;
+};
+
+enum class EmitterShape : uint32_t
+{
+	Point = 0,
+	Circle, // Params.x = radius
+	Box,    // Params = half extents
+	Cone    // velocity direction spread by up to Params.x radians either side
+};
+
+struct EmitterRecord
+{
+	EmitterShape Shape;
+	float ShapeParams[2];
+	float Rate;     // particles per second
+	uint32_t Burst; // particles at the start of each loop
+	float Delay;    // seconds after the effect starts
+
+	float LifeTime;
+	float Velocity[2], VelocityVariation[2];
+	float SizeVariation;
+	uint32_t Sampling; // EmissionSampling
+	uint32_t Flipbook;
+
+	// Key ranges over the whole particle life, time in [0, 1]
+	uint32_t FirstSizeKey, SizeKeyCount;
+	uint32_t FirstColorKey, ColorKeyCount;
+};
+
+struct CurveKey
+{
+	float Time, Value;
+};
+
+struct GradientKey
+{
+	float Time;
+	float Color[4];
+};
+
+// A composite effect: cues that start effects at fixed offsets, sorted by time
+// so a player only ever looks at the next one
+struct TimelineRecord
+{
+	uint32_t NameHash;
+	uint32_t Name; // byte offset into the name section
+	uint32_t FirstCue, CueCount;
+	float Length; // time of the last cue
+};
+
+struct TimelineCue
+{
+	float Time;      // seconds after the timeline starts
+	uint32_t Effect; // effect index
+	float Duration;  // seconds the effect plays; 0 = its own duration, or until stopped
+	float Offset[2]; // from the timeline position
+};
+
+static_assert(sizeof(EffectFileHeader) == 76, "EffectFileHeader layout");
+static_assert(sizeof(EffectRecord) == 24, "EffectRecord layout");
+static_assert(sizeof(EmitterRecord) == 72, "EmitterRecord layout");
+static_assert(sizeof(GradientKey) == 20, "GradientKey layout");
+static_assert(sizeof(TimelineRecord) == 20, "TimelineRecord layout");
+static_assert(sizeof(TimelineCue) == 20, "TimelineCue layout");
@@ -0,0 +1,422 @@
+#include "EffectCompiler.h"
+
+#include "EmissionSampler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+static bool ReadNumbers(std::istringstream& words, std::vector<float>& values)
+{
+	values.clear();
+	float value;
+	while (words >> value)
+		values.push_back(value);
+	return words.eof();
+}
+
+bool EffectCompiler::AddSource(const std::string& source, const std::string& sourceName, std::string& error)
+{
+	std::vector<Effect> effects;
+	std::vector<Timeline> timelines;
+	std::unordered_set<std::string> names;
+	std::unordered_map<std::string, uint32_t> effectIndices;
+	bool inTimeline = false;
+	uint32_t lineNumber = 0;
+	auto fail = [&](const std::string& message)
+	{
+		error = sourceName + ":" + std::to_string(lineNumber) + ": " + message;
+		return false;
+	};
+
+	// Emitters without keys get a white fade-out of shrinking quads
+	auto finishEmitter = [](Effect& effect)
+	{
+		if (effect.SizeKeys.back().empty())
+			effect.SizeKeys.back() = { { 0.0f, 0.3f }, { 1.0f, 0.0f } };
+		if (effect.ColorKeys.back().empty())
+			effect.ColorKeys.back() = { { 0.0f, { 1.0f, 1.0f, 1.0f, 1.0f } }, { 1.0f, { 1.0f, 1.0f, 1.0f, 0.0f } } };
+	};
+
+	std::istringstream lines(source);
+	std::string line;
+	std::vector<float> values;
+	while (std::getline(lines, line))
+	{
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+		for (char& c : line)
+		{
+			if (c == '(' || c == ')' || c == ',')
+				c = ' ';
+		}
+
+		std::istringstream words(line);
+		std::string key;
+		if (!(words >> key))
+			continue;
+
+		if (key == "effect")
+		{
+			std::string name;
+			if (!(words >> name))
+				return fail("expected an effect name");
+			if (m_Names.count(name) || names.count(name))
+				return fail("duplicate effect '" + name + "'");
+			if (!effects.empty() && effects.back().Emitters.empty())
+				return fail("effect '" + effects.back().Name + "' has no emitters");
+			if (!timelines.empty() && timelines.back().Cues.empty())
+				return fail("timeline '" + timelines.back().Name + "' has no cues");
+			if (!effects.empty())
+				finishEmitter(effects.back());
+
+			names.insert(name);
+			effectIndices[name] = (uint32_t)(m_Effects.size() + effects.size());
+			Effect& effect = effects.emplace_back();
+			effect.Name = name;
+			effect.Record = {};
+			inTimeline = false;
+			continue;
+		}
+		if (key == "timeline")
+		{
+			std::string name;
+			if (!(words >> name))
+				return fail("expected a timeline name");
+			if (m_Names.count(name) || names.count(name))
+				return fail("duplicate timeline '" + name + "'");
+			if (!effects.empty() && effects.back().Emitters.empty())
+				return fail("effect '" + effects.back().Name + "' has no emitters");
+			if (!timelines.empty() && timelines.back().Cues.empty())
+				return fail("timeline '" + timelines.back().Name + "' has no cues");
+			if (!effects.empty())
+				finishEmitter(effects.back());
+
+			names.insert(name);
+			timelines.emplace_back().Name = name;
+			inTimeline = true;
+			continue;
+		}
+		if (inTimeline)
+		{
+			TimelineCue cue = {};
+			std::string effectName;
+			if (key != "at" || !(words >> cue.Time >> effectName) || cue.Time < 0.0f)
+				return fail("expected 'at seconds effect'");
+
+			auto local = effectIndices.find(effectName);
+			auto earlier = m_EffectIndices.find(effectName);
+			if (local != effectIndices.end())
+				cue.Effect = local->second;
+			else if (earlier != m_EffectIndices.end())
+				cue.Effect = earlier->second;
+			else
+				return fail("unknown effect '" + effectName + "'");
+
+			std::string option;
+			while (words >> option)
+			{
+				if (option == "for" && words >> cue.Duration && cue.Duration > 0.0f)
+					continue;
+				if (option == "offset" && words >> cue.Offset[0] >> cue.Offset[1])
+					continue;
+				return fail("expected 'for seconds' or 'offset x y' after the effect");
+			}
+			timelines.back().Cues.push_back(cue);
+			continue;
+		}
+		if (effects.empty())
+			return fail("'" + key + "' outside of an effect");
+
+		Effect& effect = effects.back();
+		if (key == "emitter")
+		{
+			if (!effect.Emitters.empty())
+				finishEmitter(effect);
+
+			EmitterRecord emitter = {};
+			emitter.Shape = EmitterShape::Point;
+			emitter.LifeTime = 1.0f;
+			effect.Emitters.push_back(emitter);
+			effect.SizeKeys.emplace_back();
+			effect.ColorKeys.emplace_back();
+			continue;
+		}
+		if (key == "loop")
+		{
+			effect.Record.Flags |= EffectFlagLoop;
+			continue;
+		}
+		if (key == "duration")
+		{
+			if (!ReadNumbers(words, values) || values.size() != 1 || values[0] < 0.0f)
+				return fail("expected 'duration seconds'");
+			effect.Record.Duration = values[0];
+			continue;
+		}
+
+		if (effect.Emitters.empty())
+			return fail("'" + key + "' before the first emitter");
+		EmitterRecord& emitter = effect.Emitters.back();
+
+		if (key == "shape")
+		{
+			std::string shape;
+			words >> shape;
+			if (!ReadNumbers(words, values))
+				return fail("invalid shape parameters");
+
+			if (shape == "point" && values.empty())
+				emitter.Shape = EmitterShape::Point;
+			else if (shape == "circle" && values.size() == 1)
+			{
+				emitter.Shape = EmitterShape::Circle;
+				emitter.ShapeParams[0] = values[0];
+			}
+			else if (shape == "box" && values.size() == 2)
+			{
+				emitter.Shape = EmitterShape::Box;
+				emitter.ShapeParams[0] = values[0] * 0.5f;
+				emitter.ShapeParams[1] = values[1] * 0.5f;
+			}
+			else if (shape == "cone" && values.size() == 1)
+			{
+				emitter.Shape = EmitterShape::Cone;
+				emitter.ShapeParams[0] = values[0] * 0.5f * 3.14159265f / 180.0f;
+			}
+			else
+				return fail("expected 'shape point', 'shape circle radius', 'shape box width height' or 'shape cone degrees'");
+		}
+		else if (key == "sampling")
+		{
+			std::string sampling;
+			words >> sampling;
+			const char* samplings[] = { "random", "r2", "sobol", "bluenoise" };
+			uint32_t i = 0;
+			while (i < 4 && sampling != samplings[i])
+				i++;
+			if (i == 4)
+				return fail("unknown sampling '" + sampling + "'");
+			emitter.Sampling = (uint32_t)(EmissionSampling)i;
+		}
+		else if (key == "size" || key == "color")
+		{
+			if (!ReadNumbers(words, values))
+				return fail("invalid " + key + " keys");
+
+			uint32_t stride = key == "size" ? 2 : 5;
+			// A single value without a time is a constant
+			if (values.size() == stride - 1)
+				values.insert(values.begin(), 0.0f);
+			if (values.empty() || values.size() % stride != 0)
+				return fail("expected '" + key + (key == "size" ? " time value, ...'" : " time (r, g, b, a), ...'"));
+
+			for (size_t i = 0; i < values.size(); i += stride)
+			{
+				if (values[i] < 0.0f || values[i] > 1.0f || (i > 0 && values[i] < values[i - stride]))
+					return fail(key + " key times must be increasing and within [0, 1]");
+				if (key == "size")
+					effect.SizeKeys.back().push_back({ values[i], values[i + 1] });
+				else
+					effect.ColorKeys.back().push_back({ values[i], { values[i + 1], values[i + 2], values[i + 3], values[i + 4] } });
+			}
+		}
+		else
+		{
+			struct Field
+			{
+				const char* Key;
+				uint32_t Count;
+				float* Values;
+			};
+			float burst = 0.0f, flipbook = 0.0f;
+			const Field fields[] = {
+				{ "rate", 1, &emitter.Rate },
+				{ "burst", 1, &burst },
+				{ "delay", 1, &emitter.Delay },
+				{ "lifetime", 1, &emitter.LifeTime },
+				{ "velocity", 2, emitter.Velocity },
+				{ "variation", 2, emitter.VelocityVariation },
+				{ "size_variation", 1, &emitter.SizeVariation },
+				{ "flipbook", 1, &flipbook },
+			};
+
+			const Field* field = nullptr;
+			for (const Field& candidate : fields)
+			{
+				if (key == candidate.Key)
+					field = &candidate;
+			}
+			if (!field)
+				return fail("unknown key '" + key + "'");
+			if (!ReadNumbers(words, values) || values.size() != field->Count)
+				return fail("'" + key + "' takes " + std::to_string(field->Count) + (field->Count == 1 ? " number" : " numbers"));
+			for (uint32_t i = 0; i < field->Count; i++)
+			{
+				if (values[i] < 0.0f && key != "velocity")
+					return fail("'" + key + "' cannot be negative");
+				field->Values[i] = values[i];
+			}
+
+			if (key == "burst")
+				emitter.Burst = (uint32_t)burst;
+			else if (key == "flipbook")
+				emitter.Flipbook = (uint32_t)flipbook;
+		}
+	}
+
+	if (!effects.empty() && effects.back().Emitters.empty())
+		return fail("effect '" + effects.back().Name + "' has no emitters");
+	if (!timelines.empty() && timelines.back().Cues.empty())
+		return fail("timeline '" + timelines.back().Name + "' has no cues");
+	if (!effects.empty())
+		finishEmitter(effects.back());
+
+	for (Effect& effect : effects)
+	{
+		m_Names.insert(effect.Name);
+		m_EffectIndices[effect.Name] = (uint32_t)m_Effects.size();
+		m_Effects.push_back(std::move(effect));
+	}
+	for (Timeline& timeline : timelines)
+	{
+		std::stable_sort(timeline.Cues.begin(), timeline.Cues.end(), [](const TimelineCue& a, const TimelineCue& b) { return a.Time < b.Time; });
+		m_Names.insert(timeline.Name);
+		m_Timelines.push_back(std::move(timeline));
+	}
+	return true;
+}
+
+bool EffectCompiler::AddFile(const std::string& filepath, std::string& error)
+{
+	std::ifstream stream(filepath);
+	if (!stream)
+	{
+		error = "could not open " + filepath;
+		return false;
+	}
+
+	std::stringstream source;
+	source << stream.rdbuf();
+	return AddSource(source.str(), filepath, error);
+}
+
+std::vector<uint8_t> EffectCompiler::Build() const
+{
+	EffectFileHeader header = {};
+	header.Magic = EffectFileMagic;
+	header.Version = EffectFileVersion;
+	header.EffectCount = (uint32_t)m_Effects.size();
+	header.IndexCapacity = 2;
+	while (header.IndexCapacity < header.EffectCount * 2)
+		header.IndexCapacity *= 2;
+
+	for (const Effect& effect : m_Effects)
+	{
+		header.EmitterCount += (uint32_t)effect.Emitters.size();
+		for (size_t i = 0; i < effect.Emitters.size(); i++)
+		{
+			header.CurveKeyCount += (uint32_t)effect.SizeKeys[i].size();
+			header.GradientKeyCount += (uint32_t)effect.ColorKeys[i].size();
+		}
+		header.NameSize += (uint32_t)effect.Name.size() + 1;
+	}
+	header.TimelineCount = (uint32_t)m_Timelines.size();
+	for (const Timeline& timeline : m_Timelines)
+	{
+		header.CueCount += (uint32_t)timeline.Cues.size();
+		header.NameSize += (uint32_t)timeline.Name.size() + 1;
+	}
+
+	header.IndexOffset = sizeof(EffectFileHeader);
+	header.EffectOffset = header.IndexOffset + header.IndexCapacity * (uint32_t)sizeof(EffectIndexSlot);
+	header.EmitterOffset = header.EffectOffset + header.EffectCount * (uint32_t)sizeof(EffectRecord);
+	header.CurveKeyOffset = header.EmitterOffset + header.EmitterCount * (uint32_t)sizeof(EmitterRecord);
+	header.GradientKeyOffset = header.CurveKeyOffset + header.CurveKeyCount * (uint32_t)sizeof(CurveKey);
+	header.TimelineOffset = header.GradientKeyOffset + header.GradientKeyCount * (uint32_t)sizeof(GradientKey);
+	header.CueOffset = header.TimelineOffset + header.TimelineCount * (uint32_t)sizeof(TimelineRecord);
+	header.NameOffset = header.CueOffset + header.CueCount * (uint32_t)sizeof(TimelineCue);
+	header.FileSize = (header.NameOffset + header.NameSize + 3) & ~3u;
+
+	std::vector<uint8_t> data(header.FileSize, 0);
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	EffectIndexSlot* index = (EffectIndexSlot*)(data.data() + header.IndexOffset);
+	EffectRecord* effects = (EffectRecord*)(data.data() + header.EffectOffset);
+	EmitterRecord* emitters = (EmitterRecord*)(data.data() + header.EmitterOffset);
+	CurveKey* curveKeys = (CurveKey*)(data.data() + header.CurveKeyOffset);
+	GradientKey* gradientKeys = (GradientKey*)(data.data() + header.GradientKeyOffset);
+	TimelineRecord* timelines = (TimelineRecord*)(data.data() + header.TimelineOffset);
+	TimelineCue* cues = (TimelineCue*)(data.data() + header.CueOffset);
+	char* names = (char*)(data.data() + header.NameOffset);
+
+	for (uint32_t slot = 0; slot < header.IndexCapacity; slot++)
+		index[slot] = { 0, EffectIndexEmpty };
+
+	uint32_t emitterCount = 0, curveKeyCount = 0, gradientKeyCount = 0, nameSize = 0;
+	for (uint32_t i = 0; i < header.EffectCount; i++)
+	{
+		const Effect& effect = m_Effects[i];
+		EffectRecord& record = effects[i];
+		record = effect.Record;
+		record.NameHash = HashEffectName(effect.Name);
+		record.Name = nameSize;
+		record.FirstEmitter = emitterCount;
+		record.EmitterCount = (uint32_t)effect.Emitters.size();
+
+		std::memcpy(names + nameSize, effect.Name.c_str(), effect.Name.size() + 1);
+		nameSize += (uint32_t)effect.Name.size() + 1;
+
+		for (size_t e = 0; e < effect.Emitters.size(); e++)
+		{
+			EmitterRecord& emitter = emitters[emitterCount++];
+			emitter = effect.Emitters[e];
+			emitter.FirstSizeKey = curveKeyCount;
+			emitter.SizeKeyCount = (uint32_t)effect.SizeKeys[e].size();
+			emitter.FirstColorKey = gradientKeyCount;
+			emitter.ColorKeyCount = (uint32_t)effect.ColorKeys[e].size();
+			for (const CurveKey& key : effect.SizeKeys[e])
+				curveKeys[curveKeyCount++] = key;
+			for (const GradientKey& key : effect.ColorKeys[e])
+				gradientKeys[gradientKeyCount++] = key;
+		}
+
+		uint32_t mask = header.IndexCapacity - 1;
+		uint32_t slot = record.NameHash & mask;
+		while (index[slot].Effect != EffectIndexEmpty)
+			slot = (slot + 1) & mask;
+		index[slot] = { record.NameHash, i };
+	}
+
+	uint32_t cueCount = 0;
+	for (uint32_t i = 0; i < header.TimelineCount; i++)
+	{
+		const Timeline& timeline = m_Timelines[i];
+		TimelineRecord& record = timelines[i];
+		record.NameHash = HashEffectName(timeline.Name);
+		record.Name = nameSize;
+		record.FirstCue = cueCount;
+		record.CueCount = (uint32_t)timeline.Cues.size();
+		record.Length = timeline.Cues.back().Time;
+
+		std::memcpy(names + nameSize, timeline.Name.c_str(), timeline.Name.size() + 1);
+		nameSize += (uint32_t)timeline.Name.size() + 1;
+
+		for (const TimelineCue& cue : timeline.Cues)
+			cues[cueCount++] = cue;
+	}
+	return data;
+}
+
+bool EffectCompiler::Write(const std::string& filepath, std::string& error) const
+{
+	std::vector<uint8_t> data = Build();
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream || !stream.write((const char*)data.data(), data.size()))
+	{
+		error = "could not write " + filepath;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "EffectAsset.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Builds a .pfx effect library from text sources, e.g.
+//
+//     effect campfire
+//     duration 2
+//     loop
+//     emitter
+//         shape circle 0.1
+//         rate 60
+//         lifetime 1.5
+//         velocity 0 1.2
+//         variation 0.6 0.4
+//         size 0 0.3, 1 0.05
+//         color 0 (1, 0.9, 0.55, 1), 0.4 (1, 0.45, 0.15, 0.9), 1 (0.25, 0.22, 0.2, 0)
+//
+// Effect keys: duration, loop. Emitter keys: shape (point | circle r | box w h |
+// cone degrees), rate, burst, delay, lifetime, velocity, variation,
+// size_variation, sampling (random | r2 | sobol | bluenoise), flipbook,
+// size (constant or `time value` keys), color (constant or `time (r, g, b, a)` keys).
+//
+// Timelines sequence effects defined above them, in this or an earlier source:
+//
+//     timeline impact
+//     at 0 flash
+//     at 0.05 sparks offset 0 0.1
+//     at 0.05 smoke for 2
+//
+// Each cue is `at seconds effect`, optionally followed by `for seconds` and
+// `offset x y`; cues are sorted by time when compiled.
+// '#' starts a comment. A source may hold any number of effects and timelines.
+class EffectCompiler
+{
+public:
+	// Fills `error` (with the source name and line) on failure and adds nothing from that source
+	bool AddSource(const std::string& source, const std::string& sourceName, std::string& error);
+	bool AddFile(const std::string& filepath, std::string& error);
+
+	uint32_t GetEffectCount() const { return (uint32_t)m_Effects.size(); }
+	uint32_t GetTimelineCount() const { return (uint32_t)m_Timelines.size(); }
+
+	std::vector<uint8_t> Build() const;
+	bool Write(const std::string& filepath, std::string& error) const;
+private:
+	struct Effect
+	{
+		std::string Name;
+		EffectRecord Record;
+		std::vector<EmitterRecord> Emitters;
+		std::vector<std::vector<CurveKey>> SizeKeys;
+		std::vector<std::vector<GradientKey>> ColorKeys;
+	};
+
+	struct Timeline
+	{
+		std::string Name;
+		std::vector<TimelineCue> Cues; // Effect is an index into m_Effects
+	};
+private:
+	std::vector<Effect> m_Effects;
+	std::vector<Timeline> m_Timelines;
+	std::unordered_set<std::string> m_Names;
+	std::unordered_map<std::string, uint32_t> m_EffectIndices;
+};
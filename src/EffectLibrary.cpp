@@ -0,0 +1,366 @@
+#include "EffectLibrary.h"
+
+#include "Random.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+EffectLibrary::~EffectLibrary()
+{
+	Unload();
+}
+
+bool EffectLibrary::Load(const std::string& filepath, std::string& error)
+{
+	Unload();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		error = "could not open " + filepath;
+		return false;
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	// The view keeps the mapping alive on its own
+	const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (mapping)
+		CloseHandle(mapping);
+	CloseHandle(file);
+	m_Size = (size_t)size.QuadPart;
+#else
+	int file = open(filepath.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		error = "could not open " + filepath;
+		return false;
+	}
+	struct stat status;
+	fstat(file, &status);
+	const void* data = status.st_size > 0 ? mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0) : nullptr;
+	if (data == MAP_FAILED)
+		data = nullptr;
+	close(file);
+	m_Size = (size_t)status.st_size;
+#endif
+
+	if (!data)
+	{
+		m_Size = 0;
+		error = "could not map " + filepath;
+		return false;
+	}
+
+	m_Data = (const uint8_t*)data;
+	m_Mapped = true;
+	if (!Validate(error))
+	{
+		error = filepath + ": " + error;
+		Unload();
+		return false;
+	}
+	return true;
+}
+
+bool EffectLibrary::Load(std::vector<uint8_t> data, std::string& error)
+{
+	Unload();
+
+	m_Buffer = std::move(data);
+	m_Data = m_Buffer.data();
+	m_Size = m_Buffer.size();
+	if (!Validate(error))
+	{
+		Unload();
+		return false;
+	}
+	return true;
+}
+
+void EffectLibrary::Unload()
+{
+	if (m_Mapped)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(m_Data);
+#else
+		munmap((void*)m_Data, m_Size);
+#endif
+	}
+	m_Mapped = false;
+	m_Buffer.clear();
+	m_Data = nullptr;
+	m_Size = 0;
+
+	m_Header = nullptr;
+	m_Index = nullptr;
+	m_Effects = nullptr;
+	m_Emitters = nullptr;
+	m_CurveKeys = nullptr;
+	m_GradientKeys = nullptr;
+	m_Timelines = nullptr;
+	m_Cues = nullptr;
+	m_Names = nullptr;
+}
+
+// Range checks only, so a corrupt or truncated file can't send lookups out of
+// bounds. Cost is one pass over the effect, emitter, timeline and cue records.
+bool EffectLibrary::Validate(std::string& error)
+{
+	if (m_Size < sizeof(EffectFileHeader))
+	{
+		error = "not an effect library";
+		return false;
+	}
+
+	const EffectFileHeader& header = *(const EffectFileHeader*)m_Data;
+	if (header.Magic != EffectFileMagic)
+	{
+		error = "not an effect library";
+		return false;
+	}
+	if (header.Version != EffectFileVersion)
+	{
+		error = "effect library version " + std::to_string(header.Version) + ", expected " + std::to_string(EffectFileVersion);
+		return false;
+	}
+
+	auto fits = [&](uint32_t offset, uint64_t count, size_t stride)
+	{
+		return offset % 4 == 0 && offset + count * stride <= header.FileSize;
+	};
+	bool valid = header.FileSize <= m_Size
+		&& header.IndexCapacity > header.EffectCount && (header.IndexCapacity & (header.IndexCapacity - 1)) == 0
+		&& fits(header.IndexOffset, header.IndexCapacity, sizeof(EffectIndexSlot))
+		&& fits(header.EffectOffset, header.EffectCount, sizeof(EffectRecord))
+		&& fits(header.EmitterOffset, header.EmitterCount, sizeof(EmitterRecord))
+		&& fits(header.CurveKeyOffset, header.CurveKeyCount, sizeof(CurveKey))
+		&& fits(header.GradientKeyOffset, header.GradientKeyCount, sizeof(GradientKey))
+		&& fits(header.TimelineOffset, header.TimelineCount, sizeof(TimelineRecord))
+		&& fits(header.CueOffset, header.CueCount, sizeof(TimelineCue))
+		&& (uint64_t)header.NameOffset + header.NameSize <= header.FileSize
+		&& (header.NameSize == 0 || m_Data[header.NameOffset + header.NameSize - 1] == '\0');
+	if (!valid)
+	{
+		error = "corrupt effect library header";
+		return false;
+	}
+
+	const EffectIndexSlot* index = (const EffectIndexSlot*)(m_Data + header.IndexOffset);
+	const EffectRecord* effects = (const EffectRecord*)(m_Data + header.EffectOffset);
+	const EmitterRecord* emitters = (const EmitterRecord*)(m_Data + header.EmitterOffset);
+	const TimelineRecord* timelines = (const TimelineRecord*)(m_Data + header.TimelineOffset);
+	const TimelineCue* cues = (const TimelineCue*)(m_Data + header.CueOffset);
+
+	for (uint32_t slot = 0; slot < header.IndexCapacity; slot++)
+		valid &= index[slot].Effect == EffectIndexEmpty || index[slot].Effect < header.EffectCount;
+	for (uint32_t i = 0; i < header.EffectCount; i++)
+	{
+		const EffectRecord& effect = effects[i];
+		valid &= effect.Name < header.NameSize && (uint64_t)effect.FirstEmitter + effect.EmitterCount <= header.EmitterCount;
+	}
+	for (uint32_t i = 0; i < header.EmitterCount; i++)
+	{
+		const EmitterRecord& emitter = emitters[i];
+		valid &= emitter.Shape <= EmitterShape::Cone && emitter.Sampling <= (uint32_t)EmissionSampling::BlueNoise
+			&& emitter.SizeKeyCount > 0 && (uint64_t)emitter.FirstSizeKey + emitter.SizeKeyCount <= header.CurveKeyCount
+			&& emitter.ColorKeyCount > 0 && (uint64_t)emitter.FirstColorKey + emitter.ColorKeyCount <= header.GradientKeyCount;
+	}
+	for (uint32_t i = 0; i < header.TimelineCount; i++)
+	{
+		const TimelineRecord& timeline = timelines[i];
+		valid &= timeline.Name < header.NameSize && timeline.CueCount > 0 && (uint64_t)timeline.FirstCue + timeline.CueCount <= header.CueCount;
+	}
+	for (uint32_t i = 0; i < header.CueCount; i++)
+		valid &= cues[i].Effect < header.EffectCount;
+	if (!valid)
+	{
+		error = "corrupt effect library records";
+		return false;
+	}
+
+	m_Header = &header;
+	m_Index = index;
+	m_Effects = effects;
+	m_Emitters = emitters;
+	m_CurveKeys = (const CurveKey*)(m_Data + header.CurveKeyOffset);
+	m_GradientKeys = (const GradientKey*)(m_Data + header.GradientKeyOffset);
+	m_Timelines = timelines;
+	m_Cues = cues;
+	m_Names = (const char*)(m_Data + header.NameOffset);
+	return true;
+}
+
+const EffectRecord* EffectLibrary::Find(const std::string& name) const
+{
+	if (!m_Header)
+		return nullptr;
+
+	// Linear probing; names are compared so colliding hashes still resolve
+	uint32_t hash = HashEffectName(name);
+	uint32_t mask = m_Header->IndexCapacity - 1;
+	for (uint32_t probe = 0, slot = hash & mask; probe <= mask; probe++, slot = (slot + 1) & mask)
+	{
+		const EffectIndexSlot& entry = m_Index[slot];
+		if (entry.Effect == EffectIndexEmpty)
+			return nullptr;
+		if (entry.NameHash == hash && name == GetName(m_Effects[entry.Effect]))
+			return &m_Effects[entry.Effect];
+	}
+	return nullptr;
+}
+
+const EffectRecord* EffectLibrary::Find(uint32_t nameHash) const
+{
+	if (!m_Header)
+		return nullptr;
+
+	uint32_t mask = m_Header->IndexCapacity - 1;
+	for (uint32_t probe = 0, slot = nameHash & mask; probe <= mask; probe++, slot = (slot + 1) & mask)
+	{
+		const EffectIndexSlot& entry = m_Index[slot];
+		if (entry.Effect == EffectIndexEmpty)
+			return nullptr;
+		if (entry.NameHash == nameHash)
+			return &m_Effects[entry.Effect];
+	}
+	return nullptr;
+}
+
+const TimelineRecord* EffectLibrary::FindTimeline(const std::string& name) const
+{
+	uint32_t hash = HashEffectName(name);
+	for (uint32_t i = 0; i < GetTimelineCount(); i++)
+	{
+		if (m_Timelines[i].NameHash == hash && name == GetName(m_Timelines[i]))
+			return &m_Timelines[i];
+	}
+	return nullptr;
+}
+
+float EffectLibrary::EvaluateSize(const EmitterRecord& emitter, float t) const
+{
+	const CurveKey* keys = m_CurveKeys + emitter.FirstSizeKey;
+	uint32_t last = emitter.SizeKeyCount - 1;
+	if (t <= keys[0].Time)
+		return keys[0].Value;
+
+	for (uint32_t i = 0; i < last; i++)
+	{
+		if (t <= keys[i + 1].Time)
+		{
+			float span = keys[i + 1].Time - keys[i].Time;
+			return glm::mix(keys[i].Value, keys[i + 1].Value, span > 0.0f ? (t - keys[i].Time) / span : 1.0f);
+		}
+	}
+	return keys[last].Value;
+}
+
+glm::vec4 EffectLibrary::EvaluateColor(const EmitterRecord& emitter, float t) const
+{
+	const GradientKey* keys = m_GradientKeys + emitter.FirstColorKey;
+	uint32_t last = emitter.ColorKeyCount - 1;
+	auto color = [](const GradientKey& key) { return glm::vec4(key.Color[0], key.Color[1], key.Color[2], key.Color[3]); };
+	if (t <= keys[0].Time)
+		return color(keys[0]);
+
+	for (uint32_t i = 0; i < last; i++)
+	{
+		if (t <= keys[i + 1].Time)
+		{
+			float span = keys[i + 1].Time - keys[i].Time;
+			return glm::mix(color(keys[i]), color(keys[i + 1]), span > 0.0f ? (t - keys[i].Time) / span : 1.0f);
+		}
+	}
+	return color(keys[last]);
+}
+
+void EffectLibrary::Emit(const EffectRecord& effect, ParticlePool& pool, const glm::vec2& position, float time, float ts) const
+{
+	double duration = effect.Duration;
+	bool loop = (effect.Flags & EffectFlagLoop) && duration > 0.0;
+
+	for (uint32_t e = 0; e < effect.EmitterCount; e++)
+	{
+		const EmitterRecord& emitter = m_Emitters[effect.FirstEmitter + e];
+		double end = (double)time - emitter.Delay, begin = end - ts;
+		if (end <= 0.0)
+			continue;
+
+		// Bursts fire at the start of every loop, i.e. at each k * duration in [begin, end)
+		uint64_t count = 0;
+		if (emitter.Burst > 0)
+		{
+			uint64_t starts = begin <= 0.0 ? 1 : 0;
+			if (loop)
+				starts = (uint64_t)(std::ceil(end / duration) - std::ceil(std::max(begin, 0.0) / duration));
+			count += starts * emitter.Burst;
+		}
+
+		double activeEnd = loop || duration <= 0.0 ? end : std::min(end, duration);
+		double activeBegin = std::max(begin, 0.0);
+		if (activeEnd > activeBegin)
+			count += (uint64_t)(std::floor(activeEnd * emitter.Rate) - std::floor(activeBegin * emitter.Rate));
+		if (count == 0)
+			continue;
+
+		const CurveKey* sizeKeys = m_CurveKeys + emitter.FirstSizeKey;
+		const GradientKey* colorKeys = m_GradientKeys + emitter.FirstColorKey;
+		const GradientKey& firstColor = colorKeys[0];
+		const GradientKey& lastColor = colorKeys[emitter.ColorKeyCount - 1];
+
+		ParticleProps props;
+		props.ColorBegin = { firstColor.Color[0], firstColor.Color[1], firstColor.Color[2], firstColor.Color[3] };
+		props.ColorEnd = { lastColor.Color[0], lastColor.Color[1], lastColor.Color[2], lastColor.Color[3] };
+		props.SizeBegin = sizeKeys[0].Value;
+		props.SizeEnd = sizeKeys[emitter.SizeKeyCount - 1].Value;
+		props.SizeVariation = emitter.SizeVariation;
+		props.LifeTime = emitter.LifeTime;
+		props.Flipbook = emitter.Flipbook;
+		props.Sampling = (EmissionSampling)emitter.Sampling;
+		props.VelocityVariation = { emitter.VelocityVariation[0], emitter.VelocityVariation[1] };
+		glm::vec2 velocity = { emitter.Velocity[0], emitter.Velocity[1] };
+
+		for (uint64_t i = 0; i < count; i++)
+		{
+			props.Position = position;
+			props.Velocity = velocity;
+			switch (emitter.Shape)
+			{
+				case EmitterShape::Circle:
+				{
+					float angle = Random::Float() * 6.2831853f, radius = emitter.ShapeParams[0] * std::sqrt(Random::Float());
+					props.Position += glm::vec2(std::cos(angle), std::sin(angle)) * radius;
+					break;
+				}
+				case EmitterShape::Box:
+					props.Position += glm::vec2(Random::Float() * 2.0f - 1.0f, Random::Float() * 2.0f - 1.0f)
+						* glm::vec2(emitter.ShapeParams[0], emitter.ShapeParams[1]);
+					break;
+				case EmitterShape::Cone:
+				{
+					float angle = (Random::Float() * 2.0f - 1.0f) * emitter.ShapeParams[0];
+					float c = std::cos(angle), s = std::sin(angle);
+					props.Velocity = { velocity.x * c - velocity.y * s, velocity.x * s + velocity.y * c };
+					break;
+				}
+				default:
+					break;
+			}
+			pool.Emit(props);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "EffectAsset.h"
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a compiled effect library (.pfx, see EffectAsset.h).
+// Load() memory-maps the file and checks the header and record ranges once;
+// after that every lookup and emission reads the mapped records in place.
+class EffectLibrary
+{
+public:
+	EffectLibrary() = default;
+	~EffectLibrary();
+
+	EffectLibrary(const EffectLibrary&) = delete;
+	EffectLibrary& operator=(const EffectLibrary&) = delete;
+
+	bool Load(const std::string& filepath, std::string& error);
+	// Takes ownership of an in-memory image, e.g. fresh from EffectCompiler::Build()
+	bool Load(std::vector<uint8_t> data, std::string& error);
+	void Unload();
+
+	// O(1) through the name-hash index; nullptr when missing
+	const EffectRecord* Find(const std::string& name) const;
+	const EffectRecord* Find(uint32_t nameHash) const;
+
+	uint32_t GetEffectCount() const { return m_Header ? m_Header->EffectCount : 0; }
+	const EffectRecord& GetEffect(uint32_t index) const { return m_Effects[index]; }
+	const char* GetName(const EffectRecord& effect) const { return m_Names + effect.Name; }
+	const EmitterRecord* GetEmitters(const EffectRecord& effect) const { return m_Emitters + effect.FirstEmitter; }
+
+	// Scans the timelines, of which there are few; nullptr when missing
+	const TimelineRecord* FindTimeline(const std::string& name) const;
+
+	uint32_t GetTimelineCount() const { return m_Header ? m_Header->TimelineCount : 0; }
+	const TimelineRecord& GetTimeline(uint32_t index) const { return m_Timelines[index]; }
+	const char* GetName(const TimelineRecord& timeline) const { return m_Names + timeline.Name; }
+	const TimelineCue* GetCues(const TimelineRecord& timeline) const { return m_Cues + timeline.FirstCue; }
+
+	// t is the normalized particle age in [0, 1]
+	float EvaluateSize(const EmitterRecord& emitter, float t) const;
+	glm::vec4 EvaluateColor(const EmitterRecord& emitter, float t) const;
+
+	// Emits what the effect's emitters produce over [time - ts, time), time being
+	// seconds since the effect started. The pool lerps between the first and last
+	// size and color keys; inner keys are there for behaviors and tools.
+	void Emit(const EffectRecord& effect, ParticlePool& pool, const glm::vec2& position, float time, float ts) const;
+private:
+	bool Validate(std::string& error);
+private:
+	const uint8_t* m_Data = nullptr;
+	size_t m_Size = 0;
+	std::vector<uint8_t> m_Buffer;
+	bool m_Mapped = false;
+
+	const EffectFileHeader* m_Header = nullptr;
+	const EffectIndexSlot* m_Index = nullptr;
+	const EffectRecord* m_Effects = nullptr;
+	const EmitterRecord* m_Emitters = nullptr;
+	const CurveKey* m_CurveKeys = nullptr;
+	const GradientKey* m_GradientKeys = nullptr;
+	const TimelineRecord* m_Timelines = nullptr;
+	const TimelineCue* m_Cues = nullptr;
+	const char* m_Names = nullptr;
+};
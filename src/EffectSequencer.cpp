@@ -0,0 +1,165 @@
+#include "EffectSequencer.h"
+
+#include <algorithm>
+#include <limits>
+
+// How long a cue plays its effect. Looping and endless effects play until the
+// instance is stopped unless the cue gives a duration.
+static double PlayLength(const EffectLibrary& library, const EffectRecord& effect, const TimelineCue& cue)
+{
+	if (cue.Duration > 0.0f)
+		return cue.Duration;
+	if ((effect.Flags & EffectFlagLoop) || effect.Duration <= 0.0f)
+		return std::numeric_limits<double>::infinity();
+
+	float delay = 0.0f;
+	const EmitterRecord* emitters = library.GetEmitters(effect);
+	for (uint32_t i = 0; i < effect.EmitterCount; i++)
+		delay = std::max(delay, emitters[i].Delay);
+	return (double)effect.Duration + delay;
+}
+
+void EffectSequencer::SetLibrary(const EffectLibrary* library)
+{
+	Clear();
+	m_Library = library;
+}
+
+EffectSequencer::Handle EffectSequencer::Play(const TimelineRecord& timeline, const glm::vec2& position)
+{
+	if (!m_Library)
+		return 0;
+
+	uint32_t index;
+	if (!m_FreeInstances.empty())
+	{
+		index = m_FreeInstances.back();
+		m_FreeInstances.pop_back();
+	}
+	else
+	{
+		index = (uint32_t)m_Instances.size();
+		m_Instances.emplace_back();
+	}
+
+	// Generations start at 1, so 0 is never a valid handle
+	Instance& instance = m_Instances[index];
+	instance.Timeline = &timeline;
+	instance.Position = position;
+	instance.StartTime = m_Time;
+	instance.Cursor = 0;
+	instance.Playbacks = 0;
+	instance.Generation++;
+	instance.Active = true;
+
+	m_Due.push({ m_Time + m_Library->GetCues(timeline)[0].Time, index, instance.Generation });
+	return ((Handle)instance.Generation << 32) | index;
+}
+
+void EffectSequencer::Stop(Handle handle)
+{
+	uint32_t index = (uint32_t)handle, generation = (uint32_t)(handle >> 32);
+	if (index >= m_Instances.size() || !m_Instances[index].Active || m_Instances[index].Generation != generation)
+		return;
+
+	// Its entry in the heap goes stale and is skipped when it comes up
+	Instance& instance = m_Instances[index];
+	instance.Cursor = instance.Timeline->CueCount;
+	if (instance.Playbacks == 0)
+	{
+		Release(index);
+		return;
+	}
+	for (Playback& playback : m_Playbacks)
+	{
+		if (playback.Instance == index)
+			playback.EndTime = std::min(playback.EndTime, m_Time);
+	}
+}
+
+void EffectSequencer::Clear()
+{
+	m_Playbacks.clear();
+	m_Due = {};
+	for (uint32_t i = 0; i < m_Instances.size(); i++)
+	{
+		if (m_Instances[i].Active)
+			Release(i);
+	}
+}
+
+void EffectSequencer::OnUpdate(ParticlePool& pool, float ts)
+{
+	if (!m_Library)
+		return;
+
+	double previous = m_Time;
+	m_Time += ts;
+
+	// Only instances with a cue due come off the heap
+	while (!m_Due.empty() && m_Due.top().Time <= m_Time)
+	{
+		Due due = m_Due.top();
+		m_Due.pop();
+		const Instance& instance = m_Instances[due.Instance];
+		if (instance.Active && instance.Generation == due.Generation)
+			Fire(due.Instance);
+	}
+
+	for (size_t i = 0; i < m_Playbacks.size();)
+	{
+		Playback& playback = m_Playbacks[i];
+		// Clipped to the playback, so a cue due mid-frame starts at its own time 0
+		double begin = std::max(previous, playback.StartTime);
+		double end = std::min(m_Time, playback.EndTime);
+		if (end > begin)
+			m_Library->Emit(*playback.Effect, pool, playback.Position, (float)(end - playback.StartTime), (float)(end - begin));
+
+		if (m_Time < playback.EndTime)
+		{
+			i++;
+			continue;
+		}
+
+		Instance& instance = m_Instances[playback.Instance];
+		playback = m_Playbacks.back();
+		m_Playbacks.pop_back();
+		if (--instance.Playbacks == 0 && instance.Cursor == instance.Timeline->CueCount)
+			Release((uint32_t)(&instance - m_Instances.data()));
+	}
+}
+
+void EffectSequencer::Fire(uint32_t index)
+{
+	Instance& instance = m_Instances[index];
+	const TimelineCue* cues = m_Library->GetCues(*instance.Timeline);
+	uint32_t cueCount = instance.Timeline->CueCount;
+
+	// Cues are sorted, so everything due is a run from the cursor
+	while (instance.Cursor < cueCount && instance.StartTime + cues[instance.Cursor].Time <= m_Time)
+	{
+		const TimelineCue& cue = cues[instance.Cursor++];
+		const EffectRecord& effect = m_Library->GetEffect(cue.Effect);
+
+		Playback playback;
+		playback.Effect = &effect;
+		playback.Position = instance.Position + glm::vec2(cue.Offset[0], cue.Offset[1]);
+		playback.StartTime = instance.StartTime + cue.Time;
+		playback.EndTime = playback.StartTime + PlayLength(*m_Library, effect, cue);
+		playback.Instance = index;
+		m_Playbacks.push_back(playback);
+		instance.Playbacks++;
+		m_FiredCount++;
+	}
+
+	if (instance.Cursor < cueCount)
+		m_Due.push({ instance.StartTime + cues[instance.Cursor].Time, index, instance.Generation });
+}
+
+void EffectSequencer::Release(uint32_t index)
+{
+	Instance& instance = m_Instances[index];
+	instance.Active = false;
+	instance.Timeline = nullptr;
+	m_FreeInstances.push_back(index);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "EffectLibrary.h"
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+// Plays timelines of an EffectLibrary: each Play() is an instance with a
+// cursor into its timeline's sorted cues. Instances wait in a min-heap keyed
+// on the time of their next cue, so a frame only pops the instances that have
+// something due and walks their cursors forward; scheduling costs
+// O(cues fired * log instances), not a timer per cue per instance.
+// Started cues become playbacks that emit their effect each frame until they
+// end, like a hand-held EffectLibrary::Emit() call would.
+class EffectSequencer
+{
+public:
+	using Handle = uint64_t;
+
+	// The library must stay loaded while anything plays; Clear() before reloading it
+	void SetLibrary(const EffectLibrary* library);
+
+	Handle Play(const TimelineRecord& timeline, const glm::vec2& position);
+	// Drops the cues still to come and ends the playbacks already started
+	void Stop(Handle instance);
+	void Clear();
+
+	// Fires the cues due by now and emits every playback over [now - ts, now)
+	void OnUpdate(ParticlePool& pool, float ts);
+
+	uint32_t GetInstanceCount() const { return (uint32_t)(m_Instances.size() - m_FreeInstances.size()); }
+	uint32_t GetPlaybackCount() const { return (uint32_t)m_Playbacks.size(); }
+	uint64_t GetFiredCount() const { return m_FiredCount; }
+private:
+	struct Instance
+	{
+		const TimelineRecord* Timeline = nullptr;
+		glm::vec2 Position;
+		double StartTime = 0.0;
+		uint32_t Cursor = 0;
+		uint32_t Playbacks = 0;
+		uint32_t Generation = 0;
+		bool Active = false;
+	};
+
+	struct Playback
+	{
+		const EffectRecord* Effect;
+		glm::vec2 Position;
+		double StartTime, EndTime;
+		uint32_t Instance;
+	};
+
+	struct Due
+	{
+		double Time;
+		uint32_t Instance, Generation;
+
+		bool operator>(const Due& other) const { return Time > other.Time; }
+	};
+
+	void Fire(uint32_t index);
+	void Release(uint32_t index);
+private:
+	const EffectLibrary* m_Library = nullptr;
+	double m_Time = 0.0;
+
+	std::vector<Instance> m_Instances;
+	std::vector<uint32_t> m_FreeInstances;
+	std::vector<Playback> m_Playbacks;
+	std::priority_queue<Due, std::vector<Due>, std::greater<Due>> m_Due;
+	uint64_t m_FiredCount = 0;
+};
@@ -0,0 +1,272 @@
+#include "EmissionSampler.h"
+
+#include "Random.h"
+
+#include <cfloat>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+// Fractional parts of 1/g^k, g = 1.1673... (root of x^5 = x + 1), as 0.32 fixed point.
+// Fixed point keeps the recurrence exact however many particles are emitted.
+static const uint32_t s_R2Steps[4] = { 0xdb4f0b91, 0xbbe05633, 0xa0f2ec75, 0x89e18285 };
+
+// Joe & Kuo primitive polynomials (degree, coefficients, initial direction numbers); dimension 0 is van der Corput
+struct SobolPolynomial
+{
+	uint32_t Degree, Coefficients;
+	uint32_t Initial[3];
+};
+
+static const SobolPolynomial s_SobolPolynomials[3] = {
+	{ 1, 0, { 1 } },
+	{ 2, 1, { 1, 3 } },
+	{ 3, 1, { 1, 3, 1 } },
+};
+
+struct SobolDirections
+{
+	uint32_t V[4][32];
+
+	SobolDirections()
+	{
+		for (uint32_t k = 0; k < 32; k++)
+			V[0][k] = 1u << (31 - k);
+
+		for (uint32_t d = 1; d < 4; d++)
+		{
+			const SobolPolynomial& polynomial = s_SobolPolynomials[d - 1];
+			uint32_t s = polynomial.Degree;
+			for (uint32_t k = 0; k < 32; k++)
+			{
+				if (k < s)
+				{
+					V[d][k] = polynomial.Initial[k] << (31 - k);
+					continue;
+				}
+
+				V[d][k] = V[d][k - s] ^ (V[d][k - s] >> s);
+				for (uint32_t j = 1; j < s; j++)
+				{
+					if ((polynomial.Coefficients >> (s - 1 - j)) & 1)
+						V[d][k] ^= V[d][k - j];
+				}
+			}
+		}
+	}
+};
+
+static const SobolDirections s_Sobol;
+
+static uint32_t CountTrailingZeros(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctz(value);
+#endif
+}
+
+static uint32_t RandomBits()
+{
+	return (uint32_t)(Random::Float() * 4294967295.0);
+}
+
+// Top 24 bits, so the result is exactly representable and never rounds up to 1.0
+static float ToUnitFloat(uint32_t bits)
+{
+	return (float)(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+EmissionSampler::EmissionSampler()
+{
+	// Random starting points decorrelate emitters sharing a source
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		m_R2State[i] = RandomBits();
+		m_SobolShift[i] = RandomBits();
+	}
+	m_BlueNoiseIndex = RandomBits() % BlueNoiseTableSize;
+	m_BlueNoiseShift[0] = RandomBits();
+	m_BlueNoiseShift[1] = RandomBits();
+}
+
+glm::vec4 EmissionSampler::Next(EmissionSampling sampling)
+{
+	switch (sampling)
+	{
+		case EmissionSampling::R2:
+		{
+			for (uint32_t i = 0; i < 4; i++)
+				m_R2State[i] += s_R2Steps[i];
+			return { ToUnitFloat(m_R2State[0]), ToUnitFloat(m_R2State[1]), ToUnitFloat(m_R2State[2]), ToUnitFloat(m_R2State[3]) };
+		}
+		case EmissionSampling::Sobol:
+		{
+			// Gray-code order: each point differs from the previous one by a single direction number per dimension
+			if (++m_SobolIndex == 0)
+				m_SobolIndex = 1;
+			uint32_t bit = CountTrailingZeros(m_SobolIndex);
+			for (uint32_t i = 0; i < 4; i++)
+				m_SobolState[i] ^= s_Sobol.V[i][bit];
+			return { ToUnitFloat(m_SobolState[0] ^ m_SobolShift[0]), ToUnitFloat(m_SobolState[1] ^ m_SobolShift[1]),
+				ToUnitFloat(m_SobolState[2] ^ m_SobolShift[2]), ToUnitFloat(m_SobolState[3] ^ m_SobolShift[3]) };
+		}
+		case EmissionSampling::BlueNoise:
+		{
+			static const std::vector<glm::uvec2>& table = GetBlueNoiseTable();
+			glm::uvec2 point = table[m_BlueNoiseIndex++ & (BlueNoiseTableSize - 1)];
+
+			m_R2State[0] += s_R2Steps[0];
+			m_R2State[3] += s_R2Steps[3];
+			// Toroidal shift in 0.32 fixed point keeps the table's tiling seamless
+			return { ToUnitFloat(m_R2State[0]), ToUnitFloat(point.x + m_BlueNoiseShift[0]), ToUnitFloat(point.y + m_BlueNoiseShift[1]), ToUnitFloat(m_R2State[3]) };
+		}
+		default:
+			return { Random::Float(), Random::Float(), Random::Float(), Random::Float() };
+	}
+}
+
+// Wellons' lowbias32: full avalanche for a multiply-xorshift hash
+uint32_t EmissionSampler::Hash(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352d;
+	value ^= value >> 15;
+	value *= 0x846ca68b;
+	value ^= value >> 16;
+	return value;
+}
+
+glm::vec4 EmissionSampler::At(EmissionSampling sampling, uint32_t index, uint32_t seed)
+{
+	return EmissionSequence(sampling, index, seed).Next();
+}
+
+EmissionSequence::EmissionSequence(EmissionSampling sampling, uint32_t index, uint32_t seed)
+	: m_Sampling(sampling), m_Index(index)
+{
+	// Per-dimension offsets play the part of the random starting points in the EmissionSampler constructor
+	for (uint32_t i = 0; i < 4; i++)
+		m_Offsets[i] = EmissionSampler::Hash(seed + i * 0x9e3779b9);
+
+	switch (sampling)
+	{
+		case EmissionSampling::R2:
+		case EmissionSampling::BlueNoise:
+		{
+			// Point n is offset + n * step; the state holds the one before `index`
+			for (uint32_t i = 0; i < 4; i++)
+				m_State[i] = index * s_R2Steps[i];
+			// Blue noise starts the table at its own hash, like the constructor's m_BlueNoiseIndex, so no two dimensions share an offset
+			if (sampling == EmissionSampling::BlueNoise)
+				m_TableStart = EmissionSampler::Hash(seed + 4 * 0x9e3779b9);
+			break;
+		}
+		case EmissionSampling::Sobol:
+		{
+			// Point n of the gray-code order is the xor of the direction numbers of gray(n)'s set bits
+			for (uint32_t gray = index ^ (index >> 1); gray; gray &= gray - 1)
+			{
+				uint32_t bit = CountTrailingZeros(gray);
+				for (uint32_t i = 0; i < 4; i++)
+					m_State[i] ^= s_Sobol.V[i][bit];
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+glm::vec4 EmissionSequence::Next()
+{
+	uint32_t index = m_Index++;
+	uint32_t n = index + 1;
+	switch (m_Sampling)
+	{
+		case EmissionSampling::R2:
+		{
+			for (uint32_t i = 0; i < 4; i++)
+				m_State[i] += s_R2Steps[i];
+			return { ToUnitFloat(m_Offsets[0] + m_State[0]), ToUnitFloat(m_Offsets[1] + m_State[1]),
+				ToUnitFloat(m_Offsets[2] + m_State[2]), ToUnitFloat(m_Offsets[3] + m_State[3]) };
+		}
+		case EmissionSampling::Sobol:
+		{
+			// gray(n) and gray(n - 1) differ in bit ctz(n) alone, and in the top bit when n wraps to 0
+			uint32_t bit = n ? CountTrailingZeros(n) : 31;
+			for (uint32_t i = 0; i < 4; i++)
+				m_State[i] ^= s_Sobol.V[i][bit];
+			return { ToUnitFloat(m_State[0] ^ m_Offsets[0]), ToUnitFloat(m_State[1] ^ m_Offsets[1]),
+				ToUnitFloat(m_State[2] ^ m_Offsets[2]), ToUnitFloat(m_State[3] ^ m_Offsets[3]) };
+		}
+		case EmissionSampling::BlueNoise:
+		{
+			static const std::vector<glm::uvec2>& table = EmissionSampler::GetBlueNoiseTable();
+			glm::uvec2 point = table[(index + m_TableStart) & (EmissionSampler::BlueNoiseTableSize - 1)];
+			m_State[0] += s_R2Steps[0];
+			m_State[3] += s_R2Steps[3];
+			return { ToUnitFloat(m_Offsets[0] + m_State[0]), ToUnitFloat(point.x + m_Offsets[2]), ToUnitFloat(point.y + m_Offsets[3]),
+				ToUnitFloat(m_Offsets[1] + m_State[3]) };
+		}
+		default:
+		{
+			uint32_t state = EmissionSampler::Hash(index ^ m_Offsets[0]);
+			return { ToUnitFloat(EmissionSampler::Hash(state + m_Offsets[0])), ToUnitFloat(EmissionSampler::Hash(state + m_Offsets[1])),
+				ToUnitFloat(EmissionSampler::Hash(state + m_Offsets[2])), ToUnitFloat(EmissionSampler::Hash(state + m_Offsets[3])) };
+		}
+	}
+}
+
+// Mitchell's best-candidate on the unit torus, measured against a sliding
+// window of the previous points rather than all of them: any run of
+// consecutive entries is well spread, which is what an emitter sees.
+// Stored in 0.32 fixed point, like the R2 state.
+const std::vector<glm::uvec2>& EmissionSampler::GetBlueNoiseTable()
+{
+	static const std::vector<glm::uvec2> table = []()
+	{
+		const uint32_t window = 128, candidates = 64;
+
+		// Fixed seed: the table is the same every run
+		std::mt19937 engine(0x5eed);
+		std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+		// A discarded lead-in gives the first entries a full window to be spaced against
+		std::vector<glm::vec2> points;
+		points.reserve(BlueNoiseTableSize + window);
+		points.push_back({ distribution(engine), distribution(engine) });
+		while (points.size() < BlueNoiseTableSize + window)
+		{
+			glm::vec2 best;
+			float bestDistance = -1.0f;
+			for (uint32_t candidate = 0; candidate < candidates; candidate++)
+			{
+				glm::vec2 point = { distribution(engine), distribution(engine) };
+				float nearest = FLT_MAX;
+				for (size_t other = points.size() > window ? points.size() - window : 0; other < points.size(); other++)
+				{
+					glm::vec2 delta = glm::abs(point - points[other]);
+					delta = glm::min(delta, 1.0f - delta);
+					nearest = glm::min(nearest, glm::dot(delta, delta));
+				}
+				if (nearest > bestDistance)
+				{
+					bestDistance = nearest;
+					best = point;
+				}
+			}
+			points.push_back(best);
+		}
+
+		std::vector<glm::uvec2> fixedPoint;
+		for (size_t i = window; i < points.size(); i++)
+			fixedPoint.push_back(glm::uvec2(glm::min(glm::dvec2(points[i]), 0.99999999) * 4294967296.0));
+		return fixedPoint;
+	}();
+	return table;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Where an emitter draws the jitter for rotation, velocity and size from.
+// The low-discrepancy sources spread consecutive emissions evenly instead of
+// letting them clump, so low emission rates still look smooth.
+enum class EmissionSampling
+{
+	Random = 0, // independent Random::Float() draws
+	R2,         // additive recurrence on the plastic-constant generalization of the golden ratio
+	Sobol,      // 4D Sobol sequence with a random digital shift
+	BlueNoise   // progressive tiled blue-noise table for velocity, R2 for rotation and size
+};
+
+// Per-emitter sequence state. Every non-random source costs a few integer
+// adds/xors per sample, less than one draw from the Mersenne Twister.
+class EmissionSampler
+{
+public:
+	static constexpr uint32_t BlueNoiseTableSize = 1024;
+
+	EmissionSampler();
+
+	// Four uniforms in [0, 1) for one emission: (rotation, velocity x, velocity y, size)
+	glm::vec4 Next(EmissionSampling sampling);
+
+	// Stateless counterpart of Next(): element `index` of the sequence chosen by
+	// `seed`. Any slot can be drawn on any thread in any order, so parallel
+	// bursts come out the same however the work is split.
+	static glm::vec4 At(EmissionSampling sampling, uint32_t index, uint32_t seed);
+	static uint32_t Hash(uint32_t value);
+private:
+	static const std::vector<glm::uvec2>& GetBlueNoiseTable();
+private:
+	uint32_t m_R2State[4];
+	uint32_t m_SobolIndex = 0;
+	uint32_t m_SobolState[4] = {};
+	uint32_t m_SobolShift[4];
+	uint32_t m_BlueNoiseIndex;
+	uint32_t m_BlueNoiseShift[2];
+
+	friend class EmissionSequence;
+};
+
+// Walks the sequence EmissionSampler::At() draws from, one index after the
+// next: Next() returns At(sampling, index++, seed). The seed is hashed once and
+// Sobol and R2 step incrementally, so a worker takes its share of a burst for
+// a few xors or adds per point instead of a full lookup each.
+class EmissionSequence
+{
+public:
+	EmissionSequence(EmissionSampling sampling, uint32_t index, uint32_t seed);
+
+	glm::vec4 Next();
+private:
+	EmissionSampling m_Sampling;
+	uint32_t m_Index;
+	uint32_t m_Offsets[4];
+	uint32_t m_State[4] = {};
+	uint32_t m_TableStart = 0; // blue noise
+};
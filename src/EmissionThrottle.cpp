@@ -0,0 +1,128 @@
+#include "EmissionThrottle.h"
+
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t MaxGridSize = 256;
+// Points along a new particle's life checked for how much it shows through, evenly spaced from birth to death.
+// Only the earlier ones need a grid: by the last every older layer has died.
+static constexpr uint32_t PathSamples = 4;
+static constexpr uint32_t GridCount = PathSamples - 1;
+
+void EmissionThrottle::SetView(const glm::vec2& min, const glm::vec2& max)
+{
+	m_ViewMin = min;
+	m_ViewMax = max;
+}
+
+void EmissionThrottle::Begin()
+{
+	m_Stats.Emitted = m_Emitted;
+	m_Stats.Dropped = m_Dropped;
+	m_Emitted = m_Dropped = 0;
+
+	// Emission between accumulations reads m_Settled, which keeps the previous grid size until End()
+	uint32_t columns = std::clamp(m_Props.Columns, 1u, MaxGridSize);
+	uint32_t rows = std::clamp(m_Props.Rows, 1u, MaxGridSize);
+	if (columns != m_Columns || rows != m_Rows)
+		m_Settled.clear();
+	m_Columns = columns;
+	m_Rows = rows;
+	m_Min = m_ViewMin;
+	m_CellScale = glm::vec2((float)m_Columns, (float)m_Rows) / glm::max(m_ViewMax - m_ViewMin, glm::vec2(1e-6f));
+	m_Transmittance.assign((size_t)m_Columns * m_Rows * GridCount, 1.0f);
+	m_Fill = 0.0f;
+}
+
+void EmissionThrottle::Add(const glm::vec2& position, const glm::vec2& velocity, float lifeTime, float life, const glm::vec2& size, const glm::vec2& alpha)
+{
+	size_t gridSize = (size_t)m_Columns * m_Rows;
+	for (uint32_t sample = 0; sample < GridCount; sample++)
+	{
+		// Where the quad will be once a particle emitted now has lived this far, if it is still alive
+		float elapsed = (float)sample / (PathSamples - 1);
+		float later = life - elapsed;
+		if (later <= 0.0f)
+			break;
+
+		glm::vec2 center = position + velocity * (elapsed * lifeTime);
+		float laterSize = size.x + (size.y - size.x) * later;
+		if (sample == 0)
+		{
+			glm::vec2 half = std::abs(laterSize) * 0.5f * m_CellScale;
+			glm::vec2 low = glm::max((center - m_Min) * m_CellScale - half, glm::vec2(0.0f));
+			glm::vec2 high = glm::min((center - m_Min) * m_CellScale + half, glm::vec2((float)m_Columns, (float)m_Rows));
+			if (low.x < high.x && low.y < high.y)
+				m_Fill += (high.x - low.x) * (high.y - low.y);
+		}
+		Splat(&m_Transmittance[gridSize * sample], center, laterSize, alpha.x + (alpha.y - alpha.x) * later);
+	}
+}
+
+void EmissionThrottle::Splat(float* grid, const glm::vec2& position, float size, float alpha)
+{
+	// Axis-aligned footprint in cell units; rotation does not matter at this resolution
+	alpha = std::clamp(alpha, 0.0f, 1.0f);
+	if (alpha == 0.0f)
+		return;
+	glm::vec2 center = (position - m_Min) * m_CellScale;
+	glm::vec2 half = std::abs(size) * 0.5f * m_CellScale;
+	glm::vec2 low = glm::max(center - half, glm::vec2(0.0f));
+	glm::vec2 high = glm::min(center + half, glm::vec2((float)m_Columns, (float)m_Rows));
+	if (!(low.x < high.x && low.y < high.y))
+		return;
+
+	uint32_t x0 = (uint32_t)low.x, x1 = std::min((uint32_t)std::ceil(high.x), m_Columns);
+	uint32_t y0 = (uint32_t)low.y, y1 = std::min((uint32_t)std::ceil(high.y), m_Rows);
+	for (uint32_t y = y0; y < y1; y++)
+	{
+		float coverageY = alpha * (std::min(high.y, y + 1.0f) - std::max(low.y, (float)y));
+		float* row = &grid[(size_t)y * m_Columns];
+		for (uint32_t x = x0; x < x1; x++)
+			row[x] *= 1.0f - coverageY * (std::min(high.x, x + 1.0f) - std::max(low.x, (float)x));
+	}
+}
+
+void EmissionThrottle::End()
+{
+	std::swap(m_Settled, m_Transmittance);
+
+	float hidden = 1.0f - m_Props.Opacity;
+	size_t gridSize = (size_t)m_Columns * m_Rows;
+	m_Stats.SaturatedCells = (uint32_t)std::count_if(m_Settled.begin(), m_Settled.begin() + gridSize, [hidden](float transmittance) { return transmittance <= hidden; });
+	m_Stats.Overdraw = m_Fill / (float)gridSize;
+}
+
+float EmissionThrottle::GetTransmittance(uint32_t sample, const glm::vec2& position) const
+{
+	glm::vec2 cell = (position - m_Min) * m_CellScale;
+	if (!(cell.x >= 0.0f && cell.y >= 0.0f && cell.x < (float)m_Columns && cell.y < (float)m_Rows))
+		return 1.0f;
+	return m_Settled[((size_t)sample * m_Rows + (size_t)cell.y) * m_Columns + (uint32_t)cell.x];
+}
+
+bool EmissionThrottle::ShouldEmit(const glm::vec2& position, const glm::vec2& velocity, float lifeTime, float alphaBegin, float alphaEnd)
+{
+	// The end of its life shows through unless it has faded out, whatever was over it before
+	float hidden = std::max(1.0f - m_Props.Opacity, 1e-6f);
+	float shown = std::clamp(alphaEnd, 0.0f, 1.0f);
+	if (m_Settled.empty())
+		shown = 1.0f;
+	for (uint32_t sample = 0; sample < GridCount && shown < hidden; sample++)
+	{
+		float elapsed = (float)sample / (PathSamples - 1);
+		float alpha = std::clamp(alphaBegin + (alphaEnd - alphaBegin) * elapsed, 0.0f, 1.0f);
+		shown = std::max(shown, alpha * GetTransmittance(sample, position + velocity * (elapsed * lifeTime)));
+	}
+
+	float probability = std::max(shown / hidden, std::clamp(m_Props.MinProbability, 0.0f, 1.0f));
+	if (probability >= 1.0f || Random::Float() < probability)
+	{
+		m_Emitted++;
+		return true;
+	}
+	m_Dropped++;
+	return false;
+}
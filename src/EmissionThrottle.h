@@ -0,0 +1,79 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct EmissionThrottleProps
+{
+	bool Enabled = false;
+	uint32_t Columns = 64, Rows = 36; // cells across the view, at most 256 each
+	float Opacity = 0.99f;            // opacity over a new particle past which it counts as hidden
+	float MinProbability = 0.05f;     // spawn chance left for a particle nothing shows through
+};
+
+struct EmissionThrottleStats
+{
+	uint32_t Emitted = 0, Dropped = 0; // Emit() calls between the last two accumulations
+	uint32_t SaturatedCells = 0;       // cells a particle emitted now would be hidden in at birth
+	float Overdraw = 0.0f;             // quad area drawn in view over the view's area
+};
+
+// Coarse screen-space occupancy grid for density-aware emission.
+// A new particle is drawn under the ones already alive (the pool emits into
+// lower slots), so it only stays hidden while the older layers over it are
+// opaque, and those die before it does. ParticlePool splats every live quad
+// into one grid per point of a new particle's life (birth, a third, two
+// thirds): each cell keeps the transmittance left after alpha-blending the
+// quads still alive at that point, where they will be then, as the product of
+// (1 - alpha * covered fraction). ShouldEmit() takes the most a new particle
+// would show through along its straight path, its own alpha times that
+// transmittance, and at the end of its life nothing older is left over it.
+// Particles that would show through more than 1 - Opacity are always emitted;
+// fainter ones in proportion, so dropping one changes no pixel by more than
+// about that much. The grid covers the view passed to SetView(); emission
+// outside it is never throttled. No GL dependency.
+class EmissionThrottle
+{
+public:
+	EmissionThrottleProps& GetProps() { return m_Props; }
+	const EmissionThrottleProps& GetProps() const { return m_Props; }
+	bool IsEnabled() const { return m_Props.Enabled; }
+
+	// World rectangle the next accumulation covers
+	void SetView(const glm::vec2& min, const glm::vec2& max);
+
+	// One Add() per live particle between Begin() and End(). `life` is the fraction of its lifetime left;
+	// size and alpha are (end, begin) as ParticlePool lerps them. A new particle is assumed to live as long.
+	void Begin();
+	void Add(const glm::vec2& position, const glm::vec2& velocity, float lifeTime, float life, const glm::vec2& size, const glm::vec2& alpha);
+	void End();
+
+	// Draws against how much a particle emitted now would show through, and counts the outcome.
+	// Always true before anything was accumulated.
+	bool ShouldEmit(const glm::vec2& position, const glm::vec2& velocity, float lifeTime, float alphaBegin, float alphaEnd);
+	// Opacity over a particle born in the cell, from the last End()
+	float GetOpacity(uint32_t column, uint32_t row) const { return m_Settled.empty() ? 0.0f : 1.0f - m_Settled[(size_t)row * m_Columns + column]; }
+
+	const EmissionThrottleStats& GetStats() const { return m_Stats; }
+	uint32_t GetColumns() const { return m_Columns; }
+	uint32_t GetRows() const { return m_Rows; }
+private:
+	void Splat(float* grid, const glm::vec2& position, float size, float alpha);
+	// 1 outside the view
+	float GetTransmittance(uint32_t sample, const glm::vec2& position) const;
+private:
+	EmissionThrottleProps m_Props;
+	glm::vec2 m_ViewMin = { -1.0f, -1.0f }, m_ViewMax = { 1.0f, 1.0f };
+
+	// Grid of the last Begin()
+	glm::vec2 m_Min = { 0.0f, 0.0f }, m_CellScale = { 0.0f, 0.0f }; // cells per world unit
+	uint32_t m_Columns = 0, m_Rows = 0;
+	std::vector<float> m_Transmittance; // one grid per path sample but the last, being accumulated
+	std::vector<float> m_Settled;       // the same, from the last End(); empty until then
+	float m_Fill = 0.0f;                // quad area accumulated, in cells
+
+	uint32_t m_Emitted = 0, m_Dropped = 0;
+	EmissionThrottleStats m_Stats;
+};
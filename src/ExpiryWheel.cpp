@@ -0,0 +1,84 @@
+#include "ExpiryWheel.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Farthest a range can be placed; later ticks wait at the top level and are placed again
+static constexpr uint64_t Horizon = (1ull << 32) - 1;
+
+uint64_t ExpiryWheel::GetTick(float seconds) const
+{
+	// Rounding down retires a particle up to a tick early, never after its life has run out
+	double ticks = std::floor(((double)m_Fraction + seconds) / TickDuration);
+	if (!(ticks < (double)(1ull << 62)))
+		return NoTick - 1;
+	return m_Tick + std::max<uint64_t>(ticks > 0.0 ? (uint64_t)ticks : 0, 1);
+}
+
+void ExpiryWheel::Schedule(uint64_t tick, uint32_t first, uint32_t count)
+{
+	if (count == 0)
+		return;
+	Insert({ tick, first, count });
+	m_EntryCount++;
+}
+
+void ExpiryWheel::Insert(const Entry& entry)
+{
+	uint64_t placed = std::min(entry.Tick, m_Tick + Horizon);
+	uint64_t delta = placed > m_Tick ? placed - m_Tick : 0;
+	uint32_t level = 0;
+	while (level + 1 < LevelCount && delta >> (LevelBits * (level + 1)))
+		level++;
+
+	std::vector<Entry>& slot = m_Slots[level][(placed >> (LevelBits * level)) & (SlotCount - 1)];
+	if (!slot.empty())
+	{
+		// Emission walks the ring downwards, so a run usually extends the previous range
+		Entry& last = slot.back();
+		if (last.Tick == entry.Tick && last.First == entry.First + entry.Count)
+		{
+			last.First = entry.First;
+			last.Count += entry.Count;
+			m_EntryCount--;
+			return;
+		}
+		if (last.Tick == entry.Tick && last.First + last.Count == entry.First)
+		{
+			last.Count += entry.Count;
+			m_EntryCount--;
+			return;
+		}
+	}
+	slot.push_back(entry);
+}
+
+void ExpiryWheel::Cascade(uint64_t tick)
+{
+	// Coarsest wheel that wraps on this tick first, so its ranges can fall further in the same tick
+	uint32_t level = 0;
+	while (level + 1 < LevelCount && (tick & ((1ull << (LevelBits * (level + 1))) - 1)) == 0)
+		level++;
+
+	for (; level > 0; level--)
+	{
+		std::vector<Entry>& slot = m_Slots[level][(tick >> (LevelBits * level)) & (SlotCount - 1)];
+		if (slot.empty())
+			continue;
+
+		m_Cascading.swap(slot);
+		for (const Entry& entry : m_Cascading)
+			Insert(entry);
+		m_Cascading.clear();
+	}
+}
+
+void ExpiryWheel::Clear()
+{
+	for (auto& level : m_Slots)
+	{
+		for (std::vector<Entry>& slot : level)
+			slot.clear();
+	}
+	m_EntryCount = 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timing wheel of slot ranges keyed by the tick they expire on.
+// Four levels of 256 slots cover 2^32 ticks (over 200 days at 240 Hz); a
+// range sits in the coarsest level its distance needs and drops a level each
+// time the finer wheel wraps, so scheduling is O(1) and Advance() touches only
+// the ranges that are due plus the few that cascade. Consecutive ranges with
+// the same tick are merged as they are scheduled.
+// Entries are never cancelled: owners keep the tick each slot is due on and
+// ignore ranges whose slots have been rescheduled since.
+class ExpiryWheel
+{
+public:
+	static constexpr float TickDuration = 1.0f / 240.0f;
+	static constexpr uint64_t NoTick = UINT64_MAX;
+
+	// Last tick at or before `seconds` from now, and always after the current one
+	uint64_t GetTick(float seconds) const;
+	void Schedule(uint64_t tick, uint32_t first, uint32_t count);
+
+	// Moves the clock by `ts` and calls func(tick, first, count) for every range due by then
+	template<typename Func>
+	void Advance(float ts, Func&& func);
+
+	void Clear();
+	uint64_t GetCurrentTick() const { return m_Tick; }
+	uint32_t GetScheduledCount() const { return m_EntryCount; }
+private:
+	static constexpr uint32_t LevelCount = 4, LevelBits = 8, SlotCount = 1 << LevelBits;
+
+	struct Entry
+	{
+		uint64_t Tick;
+		uint32_t First, Count;
+	};
+
+	void Insert(const Entry& entry);
+	void Cascade(uint64_t tick);
+private:
+	std::vector<Entry> m_Slots[LevelCount][SlotCount];
+	std::vector<Entry> m_Cascading;
+	uint64_t m_Tick = 0;
+	float m_Fraction = 0.0f; // seconds since the current tick
+	uint32_t m_EntryCount = 0;
+};
+
+template<typename Func>
+void ExpiryWheel::Advance(float ts, Func&& func)
+{
+	m_Fraction += ts;
+	uint64_t ticks = (uint64_t)(m_Fraction / TickDuration);
+	m_Fraction = ticks ? std::max(m_Fraction - ticks * TickDuration, 0.0f) : m_Fraction;
+
+	uint64_t target = m_Tick + ticks;
+	if (m_EntryCount == 0)
+	{
+		m_Tick = target;
+		return;
+	}
+
+	while (m_Tick < target)
+	{
+		m_Tick++;
+		Cascade(m_Tick);
+
+		std::vector<Entry>& slot = m_Slots[0][m_Tick & (SlotCount - 1)];
+		for (const Entry& entry : slot)
+			func(entry.Tick, entry.First, entry.Count);
+		m_EntryCount -= (uint32_t)slot.size();
+		slot.clear();
+	}
+}
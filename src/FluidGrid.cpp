@@ -0,0 +1,258 @@
+#include "FluidGrid.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+void FluidGrid::AddSplat(const glm::vec2& position, const glm::vec2& force, float dye, float radius)
+{
+	std::lock_guard<std::mutex> lock(m_SplatMutex);
+	m_Splats.push_back({ position, force, dye, radius });
+}
+
+void FluidGrid::Resize()
+{
+	m_Props.Width = std::max(4u, m_Props.Width);
+	m_Props.Height = std::max(4u, m_Props.Height);
+	m_CellSize = m_Props.Size / glm::vec2(m_Props.Width, m_Props.Height);
+
+	if (m_Width == m_Props.Width && m_Height == m_Props.Height)
+		return;
+
+	m_Width = m_Props.Width;
+	m_Height = m_Props.Height;
+	size_t cellCount = (size_t)m_Width * m_Height;
+	for (std::vector<float>* field : { &m_VelocityX, &m_VelocityY, &m_Dye, &m_Scratch[0], &m_Scratch[1], &m_Pressure, &m_Divergence, &m_Curl })
+		field->assign(cellCount, 0.0f);
+}
+
+void FluidGrid::Step(float ts)
+{
+	Resize();
+
+	ApplySplats(ts);
+	ConfineVorticity(ts);
+
+	Advect(m_VelocityX, m_Scratch[0], ts, m_Props.VelocityDissipation);
+	Advect(m_VelocityY, m_Scratch[1], ts, m_Props.VelocityDissipation);
+	m_VelocityX.swap(m_Scratch[0]);
+	m_VelocityY.swap(m_Scratch[1]);
+	SetBoundary();
+
+	Project();
+
+	// Dye rides on the divergence-free field
+	Advect(m_Dye, m_Scratch[0], ts, m_Props.DyeDissipation);
+	m_Dye.swap(m_Scratch[0]);
+}
+
+void FluidGrid::ApplySplats(float ts)
+{
+	std::vector<Splat> splats;
+	{
+		std::lock_guard<std::mutex> lock(m_SplatMutex);
+		splats.swap(m_Splats);
+	}
+	if (splats.empty())
+		return;
+
+	glm::vec2 origin = m_Props.Center - m_Props.Size * 0.5f;
+	JobSystem::ParallelFor(m_Height, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			for (uint32_t x = 0; x < m_Width; x++)
+			{
+				glm::vec2 position = origin + (glm::vec2(x, y) + 0.5f) * m_CellSize;
+				size_t i = Index(x, y);
+				for (const Splat& splat : splats)
+				{
+					glm::vec2 delta = position - splat.Position;
+					float weight = std::exp(-glm::dot(delta, delta) / (splat.Radius * splat.Radius));
+					m_VelocityX[i] += splat.Force.x * weight * ts;
+					m_VelocityY[i] += splat.Force.y * weight * ts;
+					m_Dye[i] += splat.Dye * weight;
+				}
+			}
+		}
+	});
+}
+
+// Adds back the small-scale swirl that semi-Lagrangian advection smears out:
+// pushes along N x w, where N points up the gradient of |curl|.
+void FluidGrid::ConfineVorticity(float ts)
+{
+	if (m_Props.Vorticity <= 0.0f)
+		return;
+
+	int width = (int)m_Width, height = (int)m_Height;
+	JobSystem::ParallelFor(m_Height, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (int y = (int)begin; y < (int)end; y++)
+		{
+			int down = std::max(y - 1, 0), up = std::min(y + 1, height - 1);
+			for (int x = 0; x < width; x++)
+			{
+				int left = std::max(x - 1, 0), right = std::min(x + 1, width - 1);
+				m_Curl[Index(x, y)] = (m_VelocityY[Index(right, y)] - m_VelocityY[Index(left, y)]) / (2.0f * m_CellSize.x)
+					- (m_VelocityX[Index(x, up)] - m_VelocityX[Index(x, down)]) / (2.0f * m_CellSize.y);
+			}
+		}
+	});
+
+	float scale = m_Props.Vorticity * std::min(m_CellSize.x, m_CellSize.y) * ts;
+	JobSystem::ParallelFor(m_Height - 2, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (int y = (int)begin + 1; y < (int)end + 1; y++)
+		{
+			for (int x = 1; x < width - 1; x++)
+			{
+				glm::vec2 gradient = {
+					(std::abs(m_Curl[Index(x + 1, y)]) - std::abs(m_Curl[Index(x - 1, y)])) / (2.0f * m_CellSize.x),
+					(std::abs(m_Curl[Index(x, y + 1)]) - std::abs(m_Curl[Index(x, y - 1)])) / (2.0f * m_CellSize.y)
+				};
+				float length = glm::length(gradient);
+				if (length < 1e-5f)
+					continue;
+
+				glm::vec2 normal = gradient / length;
+				float curl = m_Curl[Index(x, y)];
+				m_VelocityX[Index(x, y)] += normal.y * curl * scale;
+				m_VelocityY[Index(x, y)] -= normal.x * curl * scale;
+			}
+		}
+	});
+}
+
+// Semi-Lagrangian: trace each cell centre back along the velocity and sample there
+void FluidGrid::Advect(const std::vector<float>& source, std::vector<float>& destination, float ts, float dissipation)
+{
+	glm::vec2 step = ts / m_CellSize;
+	float decay = 1.0f / (1.0f + dissipation * ts);
+	JobSystem::ParallelFor(m_Height, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t y = begin; y < end; y++)
+		{
+			for (uint32_t x = 0; x < m_Width; x++)
+			{
+				size_t i = Index(x, y);
+				float fromX = (float)x - m_VelocityX[i] * step.x;
+				float fromY = (float)y - m_VelocityY[i] * step.y;
+				destination[i] = Sample(source, fromX, fromY) * decay;
+			}
+		}
+	});
+}
+
+void FluidGrid::Project()
+{
+	int width = (int)m_Width, height = (int)m_Height;
+	JobSystem::ParallelFor(m_Height, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (int y = (int)begin; y < (int)end; y++)
+		{
+			int down = std::max(y - 1, 0), up = std::min(y + 1, height - 1);
+			for (int x = 0; x < width; x++)
+			{
+				int left = std::max(x - 1, 0), right = std::min(x + 1, width - 1);
+				m_Divergence[Index(x, y)] = (m_VelocityX[Index(right, y)] - m_VelocityX[Index(left, y)]) / (2.0f * m_CellSize.x)
+					+ (m_VelocityY[Index(x, up)] - m_VelocityY[Index(x, down)]) / (2.0f * m_CellSize.y);
+			}
+		}
+	});
+
+	// Jacobi on the pressure Poisson equation, warm-started from last frame's pressure.
+	// Clamped neighbours give the zero-gradient (solid wall) boundary.
+	float weightX = 1.0f / (m_CellSize.x * m_CellSize.x), weightY = 1.0f / (m_CellSize.y * m_CellSize.y);
+	float inverseDiagonal = 1.0f / (2.0f * weightX + 2.0f * weightY);
+	std::vector<float>& next = m_Scratch[0];
+	for (uint32_t iteration = 0; iteration < m_Props.PressureIterations; iteration++)
+	{
+		JobSystem::ParallelFor(m_Height, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+		{
+			for (int y = (int)begin; y < (int)end; y++)
+			{
+				int down = std::max(y - 1, 0), up = std::min(y + 1, height - 1);
+				for (int x = 0; x < width; x++)
+				{
+					int left = std::max(x - 1, 0), right = std::min(x + 1, width - 1);
+					next[Index(x, y)] = ((m_Pressure[Index(left, y)] + m_Pressure[Index(right, y)]) * weightX
+						+ (m_Pressure[Index(x, down)] + m_Pressure[Index(x, up)]) * weightY - m_Divergence[Index(x, y)]) * inverseDiagonal;
+				}
+			}
+		});
+		m_Pressure.swap(next);
+	}
+
+	JobSystem::ParallelFor(m_Height, 8, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (int y = (int)begin; y < (int)end; y++)
+		{
+			int down = std::max(y - 1, 0), up = std::min(y + 1, height - 1);
+			for (int x = 0; x < width; x++)
+			{
+				int left = std::max(x - 1, 0), right = std::min(x + 1, width - 1);
+				m_VelocityX[Index(x, y)] -= (m_Pressure[Index(right, y)] - m_Pressure[Index(left, y)]) / (2.0f * m_CellSize.x);
+				m_VelocityY[Index(x, y)] -= (m_Pressure[Index(x, up)] - m_Pressure[Index(x, down)]) / (2.0f * m_CellSize.y);
+			}
+		}
+	});
+	SetBoundary();
+}
+
+// Solid walls: no flow through the border cells
+void FluidGrid::SetBoundary()
+{
+	for (uint32_t y = 0; y < m_Height; y++)
+		m_VelocityX[Index(0, y)] = m_VelocityX[Index(m_Width - 1, y)] = 0.0f;
+	for (uint32_t x = 0; x < m_Width; x++)
+		m_VelocityY[Index(x, 0)] = m_VelocityY[Index(x, m_Height - 1)] = 0.0f;
+}
+
+float FluidGrid::Sample(const std::vector<float>& field, float x, float y) const
+{
+	x = glm::clamp(x, 0.0f, (float)(m_Width - 1));
+	y = glm::clamp(y, 0.0f, (float)(m_Height - 1));
+	int x0 = std::min((int)x, (int)m_Width - 2), y0 = std::min((int)y, (int)m_Height - 2);
+	float fx = x - (float)x0, fy = y - (float)y0;
+
+	float bottom = glm::mix(field[Index(x0, y0)], field[Index(x0 + 1, y0)], fx);
+	float top = glm::mix(field[Index(x0, y0 + 1)], field[Index(x0 + 1, y0 + 1)], fx);
+	return glm::mix(bottom, top, fy);
+}
+
+bool FluidGrid::ToCell(const glm::vec2& position, glm::vec2& cell) const
+{
+	cell = (position - (m_Props.Center - m_Props.Size * 0.5f)) / m_CellSize - 0.5f;
+	return m_Width > 0 && cell.x >= -0.5f && cell.y >= -0.5f && cell.x <= m_Width - 0.5f && cell.y <= m_Height - 0.5f;
+}
+
+glm::vec2 FluidGrid::SampleVelocity(const glm::vec2& position) const
+{
+	glm::vec2 cell;
+	if (!ToCell(position, cell))
+		return { 0.0f, 0.0f };
+	return { Sample(m_VelocityX, cell.x, cell.y), Sample(m_VelocityY, cell.x, cell.y) };
+}
+
+void FluidGrid::AdvectParticles(std::vector<Particle>& particles, float ts) const
+{
+	if (m_Width == 0)
+		return;
+
+	float blend = std::min(1.0f, m_Props.Coupling * ts);
+	JobSystem::ParallelFor((uint32_t)particles.size(), 4096, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Particle& particle = particles[i];
+			glm::vec2 cell;
+			if (!particle.Active || !ToCell(particle.Position, cell))
+				continue;
+
+			glm::vec2 flow = { Sample(m_VelocityX, cell.x, cell.y), Sample(m_VelocityY, cell.x, cell.y) };
+			particle.Velocity += (flow - particle.Velocity) * blend;
+		}
+	});
+}
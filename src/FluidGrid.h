@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <mutex>
+#include <vector>
+
+struct FluidGridProps
+{
+	uint32_t Width = 128, Height = 72;
+	glm::vec2 Center = { 0.0f, 0.0f }, Size = { 4.0f, 2.25f }; // world-space rectangle the grid covers
+	uint32_t PressureIterations = 30;
+	float Vorticity = 1.5f;
+	float VelocityDissipation = 0.2f, DyeDissipation = 0.5f; // fraction lost per second
+	float Coupling = 6.0f;                                   // how fast particle velocities follow the flow, per second
+	glm::vec4 DyeColor = { 0.55f, 0.65f, 0.9f, 0.8f };
+};
+
+// Stam-style stable fluids on a cell-centred grid: splats, vorticity
+// confinement, semi-Lagrangian advection and a Jacobi pressure projection.
+// Every pass is split by rows across the JobSystem and never looks at
+// particles, so the solver cost depends only on the resolution.
+// Velocities are in world units per second. No GL dependency.
+class FluidGrid
+{
+public:
+	FluidGridProps& GetProps() { return m_Props; }
+
+	// Gaussian splat of force (world units/s^2) and dye, applied on the next Step. Safe to call from any thread.
+	void AddSplat(const glm::vec2& position, const glm::vec2& force, float dye, float radius);
+
+	void Step(float ts);
+
+	// Bilinear; zero outside the grid
+	glm::vec2 SampleVelocity(const glm::vec2& position) const;
+	// Pulls the velocity of every live particle inside the grid toward the local flow
+	void AdvectParticles(std::vector<Particle>& particles, float ts) const;
+
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+	const std::vector<float>& GetDye() const { return m_Dye; }
+private:
+	struct Splat
+	{
+		glm::vec2 Position, Force;
+		float Dye, Radius;
+	};
+
+	void Resize();
+	void ApplySplats(float ts);
+	void ConfineVorticity(float ts);
+	void Advect(const std::vector<float>& source, std::vector<float>& destination, float ts, float dissipation);
+	void Project();
+	void SetBoundary();
+
+	bool ToCell(const glm::vec2& position, glm::vec2& cell) const;
+	float Sample(const std::vector<float>& field, float x, float y) const;
+	size_t Index(int x, int y) const { return (size_t)y * m_Width + x; }
+private:
+	FluidGridProps m_Props;
+
+	uint32_t m_Width = 0, m_Height = 0;
+	glm::vec2 m_CellSize = { 1.0f, 1.0f };
+
+	std::vector<float> m_VelocityX, m_VelocityY, m_Dye;
+	std::vector<float> m_Scratch[2];
+	std::vector<float> m_Pressure, m_Divergence, m_Curl;
+
+	std::mutex m_SplatMutex;
+	std::vector<Splat> m_Splats;
+};
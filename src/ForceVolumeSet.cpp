@@ -0,0 +1,327 @@
+#include "ForceVolumeSet.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t MaxGridSize = 256;
+static constexpr uint32_t NoCell = UINT32_MAX;
+// Particles per pass over a bin's volumes; positions and accelerations stay on the stack
+static constexpr uint32_t BlockSize = 64;
+
+ForceVolumeSet::ForceVolumeSet()
+{
+	SetGrid({ -32.0f, -32.0f }, { 32.0f, 32.0f }, 1.0f);
+}
+
+void ForceVolumeSet::SetGrid(const glm::vec2& min, const glm::vec2& max, float cellSize)
+{
+	glm::vec2 extent = glm::max(max - min, glm::vec2(1e-4f));
+	cellSize = std::max({ cellSize, extent.x / MaxGridSize, extent.y / MaxGridSize, 1e-4f });
+	if (min == m_Min && max == m_Max && cellSize == m_CellSize)
+		return;
+
+	m_Min = min;
+	m_Max = max;
+	m_CellSize = cellSize;
+	m_InverseCellSize = 1.0f / cellSize;
+	m_Width = std::clamp((uint32_t)std::ceil(extent.x * m_InverseCellSize), 1u, MaxGridSize);
+	m_Height = std::clamp((uint32_t)std::ceil(extent.y * m_InverseCellSize), 1u, MaxGridSize);
+	m_Cells.assign((size_t)m_Width * m_Height, {});
+
+	for (uint32_t id = 0; id < (uint32_t)m_Slots.size(); id++)
+	{
+		Slot& slot = m_Slots[id];
+		if (!slot.Alive)
+			continue;
+		slot.Cells = { 0, 0, -1, -1 };
+		Bin(id, GetCellRange(slot.Volume));
+	}
+}
+
+uint32_t ForceVolumeSet::Add(const ForceVolume& volume)
+{
+	uint32_t id;
+	if (!m_FreeIds.empty())
+	{
+		id = m_FreeIds.back();
+		m_FreeIds.pop_back();
+	}
+	else
+	{
+		id = (uint32_t)m_Slots.size();
+		m_Slots.emplace_back();
+		m_Evaluators.emplace_back();
+	}
+
+	m_Slots[id].Alive = true;
+	m_VolumeCount++;
+	Set(id, volume);
+	return id;
+}
+
+void ForceVolumeSet::Set(uint32_t id, const ForceVolume& volume)
+{
+	Slot& slot = m_Slots[id];
+	slot.Volume = volume;
+
+	Evaluator& evaluator = m_Evaluators[id];
+	evaluator.Shape = volume.Shape;
+	evaluator.Center = volume.Position;
+	evaluator.Axis = { std::cos(volume.Rotation), std::sin(volume.Rotation) };
+	if (volume.Shape == ForceVolumeShape::Box)
+		evaluator.InverseExtents = 1.0f / glm::max(volume.HalfExtents, glm::vec2(1e-6f));
+	else
+		evaluator.InverseExtents = { 1.0f / std::max(volume.Radius, 1e-6f), 0.0f };
+	evaluator.RadiusSquared = volume.Radius * volume.Radius;
+	evaluator.CosAngle = std::cos(volume.Angle);
+	evaluator.Force = volume.Force;
+	evaluator.Radial = volume.Radial;
+	evaluator.Falloff = volume.Falloff;
+
+	glm::ivec4 cells = GetCellRange(volume);
+	if (cells != slot.Cells)
+	{
+		Unbin(id);
+		Bin(id, cells);
+		m_Rebinned++;
+	}
+}
+
+void ForceVolumeSet::Remove(uint32_t id)
+{
+	Unbin(id);
+	m_Slots[id].Alive = false;
+	m_FreeIds.push_back(id);
+	m_VolumeCount--;
+}
+
+void ForceVolumeSet::Clear()
+{
+	for (std::vector<uint32_t>& cell : m_Cells)
+		cell.clear();
+	m_Slots.clear();
+	m_Evaluators.clear();
+	m_FreeIds.clear();
+	m_VolumeCount = 0;
+}
+
+glm::ivec4 ForceVolumeSet::GetCellRange(const ForceVolume& volume) const
+{
+	glm::vec2 min, max;
+	switch (volume.Shape)
+	{
+		case ForceVolumeShape::Box:
+		{
+			glm::vec2 axis = { std::cos(volume.Rotation), std::sin(volume.Rotation) };
+			glm::vec2 half = {
+				std::abs(axis.x) * volume.HalfExtents.x + std::abs(axis.y) * volume.HalfExtents.y,
+				std::abs(axis.y) * volume.HalfExtents.x + std::abs(axis.x) * volume.HalfExtents.y
+			};
+			min = volume.Position - half;
+			max = volume.Position + half;
+			break;
+		}
+		case ForceVolumeShape::Cone:
+		{
+			// Apex, both edge ends, and the axis-aligned extremes of the arc inside the cone
+			auto extend = [&](float angle)
+			{
+				glm::vec2 p = volume.Position + volume.Radius * glm::vec2(std::cos(angle), std::sin(angle));
+				min = glm::min(min, p);
+				max = glm::max(max, p);
+			};
+			min = max = volume.Position;
+			extend(volume.Rotation - volume.Angle);
+			extend(volume.Rotation + volume.Angle);
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				float direction = i * 1.5707963f;
+				float difference = std::remainder(direction - volume.Rotation, 6.2831853f);
+				if (std::abs(difference) <= volume.Angle)
+					extend(direction);
+			}
+			break;
+		}
+		default:
+			min = volume.Position - glm::vec2(volume.Radius);
+			max = volume.Position + glm::vec2(volume.Radius);
+			break;
+	}
+
+	auto toCell = [&](float value, float origin, uint32_t size)
+	{
+		return std::clamp((int)std::floor((value - origin) * m_InverseCellSize), 0, (int)size - 1);
+	};
+	return { toCell(min.x, m_Min.x, m_Width), toCell(min.y, m_Min.y, m_Height),
+		toCell(max.x, m_Min.x, m_Width), toCell(max.y, m_Min.y, m_Height) };
+}
+
+void ForceVolumeSet::Bin(uint32_t id, const glm::ivec4& cells)
+{
+	m_Slots[id].Cells = cells;
+	for (int y = cells.y; y <= cells.w; y++)
+	{
+		for (int x = cells.x; x <= cells.z; x++)
+			m_Cells[(size_t)y * m_Width + x].push_back(id);
+	}
+}
+
+void ForceVolumeSet::Unbin(uint32_t id)
+{
+	glm::ivec4& cells = m_Slots[id].Cells;
+	for (int y = cells.y; y <= cells.w; y++)
+	{
+		for (int x = cells.x; x <= cells.z; x++)
+		{
+			std::vector<uint32_t>& cell = m_Cells[(size_t)y * m_Width + x];
+			auto it = std::find(cell.begin(), cell.end(), id);
+			*it = cell.back();
+			cell.pop_back();
+		}
+	}
+	cells = { 0, 0, -1, -1 };
+}
+
+void ForceVolumeSet::Apply(std::vector<Particle>& particles, float ts)
+{
+	m_Stats = {};
+	m_Stats.Volumes = m_VolumeCount;
+	m_Stats.Rebinned = m_Rebinned;
+	m_Rebinned = 0;
+	if (m_VolumeCount == 0)
+		return;
+
+	// Cell of every live particle whose cell holds a volume
+	uint32_t particleCount = (uint32_t)particles.size();
+	m_ParticleCells.resize(particleCount);
+	JobSystem::ParallelFor(particleCount, 8192, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Particle& particle = particles[i];
+			uint32_t cell = NoCell;
+			if (particle.Active)
+			{
+				glm::vec2 local = (particle.Position - m_Min) * m_InverseCellSize;
+				uint32_t x = (uint32_t)std::clamp((int)std::floor(local.x), 0, (int)m_Width - 1);
+				uint32_t y = (uint32_t)std::clamp((int)std::floor(local.y), 0, (int)m_Height - 1);
+				cell = y * m_Width + x;
+				if (m_Cells[cell].empty())
+					cell = NoCell;
+			}
+			m_ParticleCells[i] = cell;
+		}
+	});
+
+	// Counting sort into bins, keeping particle order within each
+	uint32_t cellCount = m_Width * m_Height;
+	m_BinStart.assign(cellCount + 1, 0);
+	for (uint32_t cell : m_ParticleCells)
+	{
+		if (cell != NoCell)
+			m_BinStart[cell + 1]++;
+	}
+	m_Bins.clear();
+	for (uint32_t cell = 0; cell < cellCount; cell++)
+	{
+		uint32_t count = m_BinStart[cell + 1];
+		if (count)
+		{
+			m_Bins.push_back(cell);
+			m_Stats.Tests += (uint64_t)count * m_Cells[cell].size();
+		}
+		m_BinStart[cell + 1] += m_BinStart[cell];
+	}
+	m_Stats.Bins = (uint32_t)m_Bins.size();
+	m_Stats.BinnedParticles = m_BinStart[cellCount];
+
+	// Scattering advances each start to the next bin's, so bin c ends up as [start[c - 1], start[c])
+	m_BinParticles.resize(m_Stats.BinnedParticles);
+	for (uint32_t i = 0; i < particleCount; i++)
+	{
+		uint32_t cell = m_ParticleCells[i];
+		if (cell != NoCell)
+			m_BinParticles[m_BinStart[cell]++] = i;
+	}
+
+	JobSystem::ParallelFor((uint32_t)m_Bins.size(), 4, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t b = begin; b < end; b++)
+		{
+			uint32_t cell = m_Bins[b];
+			uint32_t first = cell ? m_BinStart[cell - 1] : 0;
+			EvaluateBin(particles, &m_BinParticles[first], m_BinStart[cell] - first, m_Cells[cell], ts);
+		}
+	});
+}
+
+void ForceVolumeSet::EvaluateBin(std::vector<Particle>& particles, const uint32_t* indices, uint32_t count, const std::vector<uint32_t>& volumes, float ts) const
+{
+	glm::vec2 positions[BlockSize], accelerations[BlockSize];
+	for (uint32_t blockStart = 0; blockStart < count; blockStart += BlockSize)
+	{
+		uint32_t blockCount = std::min(BlockSize, count - blockStart);
+		for (uint32_t k = 0; k < blockCount; k++)
+		{
+			positions[k] = particles[indices[blockStart + k]].Position;
+			accelerations[k] = { 0.0f, 0.0f };
+		}
+
+		// Shape dispatch once per volume and block; `t` is 0 at the centre (apex) and 1 at the edge
+		for (uint32_t id : volumes)
+		{
+			const Evaluator& e = m_Evaluators[id];
+			auto accumulate = [&e](glm::vec2& acceleration, const glm::vec2& d, float distance, float t)
+			{
+				glm::vec2 a = e.Force;
+				if (distance > 0.0f)
+					a += d * (e.Radial / distance);
+				acceleration += a * (1.0f - e.Falloff * std::min(t, 1.0f));
+			};
+
+			switch (e.Shape)
+			{
+				case ForceVolumeShape::Sphere:
+					for (uint32_t k = 0; k < blockCount; k++)
+					{
+						glm::vec2 d = positions[k] - e.Center;
+						float distanceSquared = glm::dot(d, d);
+						if (distanceSquared > e.RadiusSquared)
+							continue;
+						float distance = std::sqrt(distanceSquared);
+						accumulate(accelerations[k], d, distance, distance * e.InverseExtents.x);
+					}
+					break;
+				case ForceVolumeShape::Box:
+					for (uint32_t k = 0; k < blockCount; k++)
+					{
+						glm::vec2 d = positions[k] - e.Center;
+						float tx = std::abs(d.x * e.Axis.x + d.y * e.Axis.y) * e.InverseExtents.x;
+						float ty = std::abs(d.y * e.Axis.x - d.x * e.Axis.y) * e.InverseExtents.y;
+						if (tx > 1.0f || ty > 1.0f)
+							continue;
+						accumulate(accelerations[k], d, glm::length(d), std::max(tx, ty));
+					}
+					break;
+				case ForceVolumeShape::Cone:
+					for (uint32_t k = 0; k < blockCount; k++)
+					{
+						glm::vec2 d = positions[k] - e.Center;
+						float distanceSquared = glm::dot(d, d);
+						if (distanceSquared > e.RadiusSquared)
+							continue;
+						float distance = std::sqrt(distanceSquared);
+						if (glm::dot(d, e.Axis) < e.CosAngle * distance)
+							continue;
+						accumulate(accelerations[k], d, distance, distance * e.InverseExtents.x);
+					}
+					break;
+			}
+		}
+
+		for (uint32_t k = 0; k < blockCount; k++)
+			particles[indices[blockStart + k]].Velocity += accelerations[k] * ts;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+enum class ForceVolumeShape : uint32_t
+{
+	Sphere = 0, // Position, Radius
+	Box,        // centre Position, HalfExtents, Rotation
+	Cone        // apex Position, length Radius, direction Rotation, half-angle Angle
+};
+
+struct ForceVolume
+{
+	ForceVolumeShape Shape = ForceVolumeShape::Sphere;
+	glm::vec2 Position = { 0.0f, 0.0f };
+	glm::vec2 HalfExtents = { 0.0f, 0.0f };
+	float Radius = 0.0f;
+	float Rotation = 0.0f; // radians
+	float Angle = 0.5f;    // radians
+
+	glm::vec2 Force = { 0.0f, 0.0f }; // acceleration in world units per second squared
+	float Radial = 0.0f;              // acceleration away from Position; negative pulls in
+	float Falloff = 0.0f;             // 0 = uniform, 1 = fades to nothing at the edge
+};
+
+struct ForceVolumeStats
+{
+	uint32_t Volumes = 0;
+	uint32_t Rebinned = 0;        // volumes whose cells changed since the previous Apply()
+	uint32_t Bins = 0;            // cells holding both particles and volumes
+	uint32_t BinnedParticles = 0;
+	uint64_t Tests = 0;           // particle-volume pairs evaluated
+};
+
+// Wind zones, fans and shockwaves that push the particles inside them.
+// Volumes live in a fixed uniform grid; Set() moves a volume between cell
+// lists only when the cells it covers change, so static and slow volumes cost
+// nothing to keep indexed. Apply() bins the live particles that fall into
+// cells holding volumes with a counting sort, then runs each bin against its
+// cell's volumes only, a block of particles per volume at a time. A volume
+// with no particles in its cells is never visited. Positions outside the
+// grid are clamped to its edge cells. No GL dependency.
+class ForceVolumeSet
+{
+public:
+	ForceVolumeSet();
+
+	// Re-bins every volume when the grid changes; at most 256 cells per axis
+	void SetGrid(const glm::vec2& min, const glm::vec2& max, float cellSize);
+
+	// Ids are reused after Remove()
+	uint32_t Add(const ForceVolume& volume);
+	void Set(uint32_t id, const ForceVolume& volume);
+	void Remove(uint32_t id);
+	void Clear();
+
+	const ForceVolume& Get(uint32_t id) const { return m_Slots[id].Volume; }
+	uint32_t GetVolumeCount() const { return m_VolumeCount; }
+
+	// Adds the volumes' accelerations to the velocities of live particles
+	void Apply(std::vector<Particle>& particles, float ts);
+
+	const ForceVolumeStats& GetStats() const { return m_Stats; }
+	uint32_t GetGridWidth() const { return m_Width; }
+	uint32_t GetGridHeight() const { return m_Height; }
+private:
+	// What the inner loop reads, precomputed by Set()
+	struct Evaluator
+	{
+		ForceVolumeShape Shape;
+		glm::vec2 Center, Axis;
+		glm::vec2 InverseExtents; // box: 1 / HalfExtents, otherwise 1 / Radius in x
+		float RadiusSquared, CosAngle;
+		glm::vec2 Force;
+		float Radial, Falloff;
+	};
+
+	struct Slot
+	{
+		ForceVolume Volume;
+		glm::ivec4 Cells = { 0, 0, -1, -1 }; // first and last cell covered; empty when not binned
+		bool Alive = false;
+	};
+
+	glm::ivec4 GetCellRange(const ForceVolume& volume) const;
+	void Bin(uint32_t id, const glm::ivec4& cells);
+	void Unbin(uint32_t id);
+	void EvaluateBin(std::vector<Particle>& particles, const uint32_t* indices, uint32_t count, const std::vector<uint32_t>& volumes, float ts) const;
+private:
+	std::vector<Slot> m_Slots;
+	std::vector<Evaluator> m_Evaluators; // by id
+	std::vector<uint32_t> m_FreeIds;
+	uint32_t m_VolumeCount = 0;
+
+	glm::vec2 m_Min = { 0.0f, 0.0f }, m_Max = { 0.0f, 0.0f };
+	float m_CellSize = 0.0f, m_InverseCellSize = 0.0f;
+	uint32_t m_Width = 0, m_Height = 0;
+	std::vector<std::vector<uint32_t>> m_Cells; // volume ids per cell
+
+	// Apply() scratch
+	std::vector<uint32_t> m_ParticleCells;
+	std::vector<uint32_t> m_BinStart;
+	std::vector<uint32_t> m_Bins; // occupied cells
+	std::vector<uint32_t> m_BinParticles;
+
+	uint32_t m_Rebinned = 0;
+	ForceVolumeStats m_Stats;
+};
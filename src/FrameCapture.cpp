@@ -0,0 +1,222 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+FrameCapture::FrameCapture()
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+	// Queued frames are still written; buffers left mapped die with the context
+	JoinWorker();
+}
+
+bool FrameCapture::Start(const FrameCaptureProps& props, uint32_t width, uint32_t height, std::string& error)
+{
+	if (IsBusy())
+	{
+		error = "the previous capture is still being written";
+		return false;
+	}
+	if (width == 0 || height == 0)
+	{
+		error = "nothing to capture";
+		return false;
+	}
+	JoinWorker();
+
+	m_Props = props;
+	m_Props.Latency = std::max(m_Props.Latency, 1u);
+	m_Props.QueueFrames = std::max(m_Props.QueueFrames, 1u);
+	m_Width = width;
+	m_Height = height;
+
+	std::time_t time = std::time(nullptr);
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "capture-%Y%m%d-%H%M%S", std::localtime(&time));
+	m_Path = (std::filesystem::path(m_Props.Directory) / stamp).string();
+	if (m_Props.Format == CaptureFormat::Y4M)
+		m_Path += ".y4m";
+
+	if (!m_Encoder.Open(m_Path, m_Props.Format, width, height, m_Props.FrameRate, error))
+		return false;
+
+	m_CapturedCount.store(0, std::memory_order_relaxed);
+	m_EncodedCount.store(0, std::memory_order_relaxed);
+	m_DroppedCount.store(0, std::memory_order_relaxed);
+	m_WriteError.store(false, std::memory_order_relaxed);
+	m_Queue.clear();
+	m_StopWorker = false;
+
+	m_Capturing = true;
+	m_Busy.store(true, std::memory_order_release);
+	m_Worker = std::thread(&FrameCapture::WorkerMain, this);
+	return true;
+}
+
+void FrameCapture::Stop()
+{
+	m_Capturing = false;
+}
+
+void FrameCapture::OnRender(RenderCommandList& commands)
+{
+	if (!IsBusy())
+		return;
+
+	commands.Execute([this, capture = m_Capturing]() { RenderFrame(capture); });
+}
+
+void FrameCapture::RenderFrame(bool capture)
+{
+	GLsizeiptr frameSize = (GLsizeiptr)m_Width * m_Height * 4;
+	if (!m_Slots)
+	{
+		m_SlotCount = m_Props.Latency + m_Props.QueueFrames;
+		m_Slots = std::make_unique<Slot[]>(m_SlotCount);
+		for (uint32_t i = 0; i < m_SlotCount; i++)
+		{
+			glGenBuffers(1, &m_Slots[i].Buffer);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_Slots[i].Buffer);
+			glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		m_Issued = m_Resolved = m_Released = 0;
+	}
+
+	Release();
+	Resolve();
+
+	if (capture)
+	{
+		// Every buffer is waiting on the encoder
+		if (m_Issued - m_Released == m_SlotCount)
+		{
+			m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Slot& slot = m_Slots[m_Issued % m_SlotCount];
+		slot.Encoded.store(false, std::memory_order_relaxed);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer);
+		glReadPixels(0, 0, (GLsizei)m_Width, (GLsizei)m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_Issued++;
+		m_CapturedCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	// Stopped: tear down once the encoder has handed every buffer back
+	if (m_Released < m_Issued)
+		return;
+
+	for (uint32_t i = 0; i < m_SlotCount; i++)
+		glDeleteBuffers(1, &m_Slots[i].Buffer);
+	m_Slots.reset();
+	m_SlotCount = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_StopWorker = true;
+	}
+	m_Wake.notify_one();
+	m_Busy.store(false, std::memory_order_release);
+}
+
+void FrameCapture::Release()
+{
+	while (m_Released < m_Resolved)
+	{
+		Slot& slot = m_Slots[m_Released % m_SlotCount];
+		if (!slot.Encoded.load(std::memory_order_acquire))
+			break;
+
+		if (slot.Mapped)
+		{
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			slot.Mapped = nullptr;
+		}
+		m_Released++;
+	}
+}
+
+void FrameCapture::Resolve()
+{
+	while (m_Resolved < m_Issued)
+	{
+		Slot& slot = m_Slots[m_Resolved % m_SlotCount];
+
+		// Readbacks are mapped as soon as they land, and waited for only once they are Latency frames old
+		bool late = m_Issued - m_Resolved >= m_Props.Latency;
+		GLenum status = glClientWaitSync(slot.Fence, late ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, late ? 1000000000ull : 0);
+		if (!late && status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+		glDeleteSync(slot.Fence);
+		slot.Fence = nullptr;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.Buffer);
+		slot.Mapped = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)m_Width * m_Height * 4, GL_MAP_READ_BIT);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		m_Resolved++;
+
+		if (!slot.Mapped)
+		{
+			m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+			slot.Encoded.store(true, std::memory_order_relaxed);
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Queue.push_back((uint32_t)((m_Resolved - 1) % m_SlotCount));
+		}
+		m_Wake.notify_one();
+	}
+}
+
+void FrameCapture::WorkerMain()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_Wake.wait(lock, [this]() { return !m_Queue.empty() || m_StopWorker; });
+		if (m_Queue.empty())
+			break;
+
+		Slot& slot = m_Slots[m_Queue.front()];
+		m_Queue.pop_front();
+		lock.unlock();
+
+		if (m_Encoder.Encode(slot.Mapped))
+			m_EncodedCount.fetch_add(1, std::memory_order_relaxed);
+		else
+			m_WriteError.store(true, std::memory_order_relaxed);
+		slot.Encoded.store(true, std::memory_order_release);
+
+		lock.lock();
+	}
+	lock.unlock();
+
+	m_Encoder.Close();
+}
+
+void FrameCapture::JoinWorker()
+{
+	if (!m_Worker.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_StopWorker = true;
+	}
+	m_Wake.notify_one();
+	m_Worker.join();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "FrameEncoder.h"
+#include "RenderCommandList.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct FrameCaptureProps
+{
+	std::string Directory = "captures";
+	CaptureFormat Format = CaptureFormat::PNG;
+	uint32_t FrameRate = 60;  // only recorded in Y4M headers
+	uint32_t Latency = 3;     // frames between a readback and mapping its buffer
+	uint32_t QueueFrames = 8; // frames the encoder may fall behind before new ones are dropped
+};
+
+// Streams rendered frames to disk without stalling the GL pipeline.
+//
+// Each captured frame is read into one pixel-pack buffer of a ring and fenced.
+// Once the fence has signaled (or Latency frames later, at the latest) the
+// buffer is mapped and handed to a worker thread, which encodes straight out
+// of the mapping; the buffer is unmapped and reused after that. When the
+// encoder falls QueueFrames behind, frames are dropped and counted rather
+// than blocking the frame loop.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	// Main thread. The size is fixed for the whole capture; false while a previous capture is still being written
+	bool Start(const FrameCaptureProps& props, uint32_t width, uint32_t height, std::string& error);
+	// Remaining frames keep encoding in the background; IsBusy() drops once they are on disk
+	void Stop();
+
+	// Call every frame after the scene has been drawn: reads back the default
+	// framebuffer at this point in the list and services earlier readbacks
+	void OnRender(RenderCommandList& commands);
+
+	bool IsCapturing() const { return m_Capturing; }
+	bool IsBusy() const { return m_Busy.load(std::memory_order_acquire); }
+	const std::string& GetPath() const { return m_Path; }
+
+	uint64_t GetCapturedCount() const { return m_CapturedCount.load(std::memory_order_relaxed); }
+	uint64_t GetEncodedCount() const { return m_EncodedCount.load(std::memory_order_relaxed); }
+	uint64_t GetDroppedCount() const { return m_DroppedCount.load(std::memory_order_relaxed); }
+	bool HasWriteError() const { return m_WriteError.load(std::memory_order_relaxed); }
+private:
+	struct Slot
+	{
+		GLuint Buffer = 0;
+		GLsync Fence = nullptr;
+		const uint8_t* Mapped = nullptr;
+		std::atomic<bool> Encoded{ false }; // set by the worker when it is done with Mapped
+	};
+
+	void RenderFrame(bool capture);
+	void Release();
+	void Resolve();
+	void WorkerMain();
+	void JoinWorker();
+private:
+	FrameCaptureProps m_Props;
+	uint32_t m_Width = 0, m_Height = 0;
+	std::string m_Path;
+	bool m_Capturing = false;
+	std::atomic<bool> m_Busy{ false };
+
+	FrameEncoder m_Encoder;
+	std::thread m_Worker;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::deque<uint32_t> m_Queue; // slot indices in frame order
+	bool m_StopWorker = false;
+
+	// Render thread state. Slots are used in ring order:
+	// released <= resolved <= issued, and issued - released <= slot count
+	std::unique_ptr<Slot[]> m_Slots;
+	uint32_t m_SlotCount = 0;
+	uint64_t m_Issued = 0, m_Resolved = 0, m_Released = 0;
+
+	std::atomic<uint64_t> m_CapturedCount{ 0 }, m_EncodedCount{ 0 }, m_DroppedCount{ 0 };
+	std::atomic<bool> m_WriteError{ false };
+};
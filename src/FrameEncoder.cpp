@@ -0,0 +1,429 @@
+#include "FrameEncoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace {
+
+	uint32_t ReverseBits(uint32_t value, uint32_t count)
+	{
+		uint32_t result = 0;
+		for (uint32_t i = 0; i < count; i++, value >>= 1)
+			result = (result << 1) | (value & 1);
+		return result;
+	}
+
+	// RFC 1951 fixed Huffman codes, bit-reversed for LSB-first output. Length and
+	// distance entries hold the code and its extra bits as one value.
+	struct DeflateTables
+	{
+		uint16_t Literal[288];
+		uint8_t LiteralBits[288];
+		uint32_t Length[259];
+		uint8_t LengthBits[259];
+		uint32_t Distance[32769];
+		uint8_t DistanceBits[32769];
+
+		DeflateTables()
+		{
+			for (uint32_t v = 0; v < 288; v++)
+			{
+				uint32_t code, bits;
+				if (v < 144)
+					code = 0x30 + v, bits = 8;
+				else if (v < 256)
+					code = 0x190 + v - 144, bits = 9;
+				else if (v < 280)
+					code = v - 256, bits = 7;
+				else
+					code = 0xc0 + v - 280, bits = 8;
+				Literal[v] = (uint16_t)ReverseBits(code, bits);
+				LiteralBits[v] = (uint8_t)bits;
+			}
+
+			static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			for (uint32_t code = 0; code < 29; code++)
+			{
+				uint32_t end = code == 28 ? 259 : lengthBase[code + 1];
+				for (uint32_t length = lengthBase[code]; length < end; length++)
+				{
+					uint32_t symbol = 257 + code;
+					Length[length] = Literal[symbol] | ((length - lengthBase[code]) << LiteralBits[symbol]);
+					LengthBits[length] = (uint8_t)(LiteralBits[symbol] + lengthExtra[code]);
+				}
+			}
+
+			static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+				1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			for (uint32_t code = 0; code < 30; code++)
+			{
+				uint32_t extra = code < 4 ? 0 : code / 2 - 1;
+				uint32_t end = code == 29 ? 32769 : distanceBase[code + 1];
+				for (uint32_t distance = distanceBase[code]; distance < end; distance++)
+				{
+					Distance[distance] = ReverseBits(code, 5) | ((distance - distanceBase[code]) << 5);
+					DistanceBits[distance] = (uint8_t)(5 + extra);
+				}
+			}
+		}
+	};
+
+	struct CrcTable
+	{
+		uint32_t Values[256];
+
+		CrcTable()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				Values[i] = c;
+			}
+		}
+	};
+
+	const DeflateTables s_Deflate;
+	const CrcTable s_Crc;
+
+	uint32_t Crc32(const uint8_t* data, size_t size)
+	{
+		uint32_t crc = 0xffffffffu;
+		for (size_t i = 0; i < size; i++)
+			crc = s_Crc.Values[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return crc ^ 0xffffffffu;
+	}
+
+	uint32_t Adler32(const uint8_t* data, size_t size)
+	{
+		uint32_t a = 1, b = 0;
+		while (size > 0)
+		{
+			// Largest run before b can overflow 32 bits. Within it, 8 bytes add
+			// 8a plus a weighted sum to b, which breaks the serial dependency on a.
+			size_t run = std::min<size_t>(size, 5552);
+			size_t i = 0;
+			for (; i + 8 <= run; i += 8)
+			{
+				const uint8_t* d = data + i;
+				b += 8 * a + 8 * d[0] + 7 * d[1] + 6 * d[2] + 5 * d[3] + 4 * d[4] + 3 * d[5] + 2 * d[6] + d[7];
+				a += d[0] + d[1] + d[2] + d[3] + d[4] + d[5] + d[6] + d[7];
+			}
+			for (; i < run; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+			data += run;
+			size -= run;
+		}
+		return (b << 16) | a;
+	}
+
+	void PutBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+		out.insert(out.end(), bytes, bytes + 4);
+	}
+
+	uint32_t Load32(const uint8_t* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t Load64(const uint8_t* data)
+	{
+		uint64_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	size_t MatchLength(const uint8_t* a, const uint8_t* b, size_t maxLength)
+	{
+		size_t length = 0;
+		for (; length + 8 <= maxLength; length += 8)
+		{
+			uint64_t difference = Load64(a + length) ^ Load64(b + length);
+			if (difference)
+			{
+#ifdef _MSC_VER
+				unsigned long bit;
+				_BitScanForward64(&bit, difference);
+				return length + bit / 8;
+#else
+				return length + (size_t)__builtin_ctzll(difference) / 8;
+#endif
+			}
+		}
+		while (length < maxLength && a[length] == b[length])
+			length++;
+		return length;
+	}
+
+	class BitWriter
+	{
+	public:
+		BitWriter(std::vector<uint8_t>& out)
+			: m_Out(out) {}
+
+		void Put(uint32_t value, uint32_t count)
+		{
+			m_Bits |= (uint64_t)value << m_Count;
+			m_Count += count;
+			if (m_Count >= 32)
+			{
+				uint8_t bytes[4] = { (uint8_t)m_Bits, (uint8_t)(m_Bits >> 8), (uint8_t)(m_Bits >> 16), (uint8_t)(m_Bits >> 24) };
+				m_Out.insert(m_Out.end(), bytes, bytes + 4);
+				m_Bits >>= 32;
+				m_Count -= 32;
+			}
+		}
+
+		void Flush()
+		{
+			for (; m_Count > 0; m_Count = m_Count > 8 ? m_Count - 8 : 0, m_Bits >>= 8)
+				m_Out.push_back((uint8_t)m_Bits);
+		}
+	private:
+		std::vector<uint8_t>& m_Out;
+		uint64_t m_Bits = 0;
+		uint32_t m_Count = 0;
+	};
+
+	// One fixed-Huffman block. Each position probes a single hash slot for a
+	// 4-byte match; flat runs come out as distance-1 copies of up to 258 bytes.
+	void Deflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+	{
+		constexpr uint32_t HashBits = 15;
+		constexpr size_t Window = 32768;
+		std::vector<int64_t> table(1u << HashBits, -1);
+
+		BitWriter writer(out);
+		writer.Put(1, 1); // final block
+		writer.Put(1, 2); // fixed codes
+
+		size_t pos = 0;
+		while (pos + 4 <= size)
+		{
+			uint32_t value = Load32(data + pos);
+			uint32_t hash = (value * 2654435761u) >> (32 - HashBits);
+			int64_t candidate = table[hash];
+			table[hash] = (int64_t)pos;
+
+			if (candidate >= 0 && pos - (size_t)candidate <= Window && Load32(data + candidate) == value)
+			{
+				size_t length = 4 + MatchLength(data + candidate + 4, data + pos + 4, std::min<size_t>(258, size - pos) - 4);
+
+				size_t distance = pos - (size_t)candidate;
+				writer.Put(s_Deflate.Length[length], s_Deflate.LengthBits[length]);
+				writer.Put(s_Deflate.Distance[distance], s_Deflate.DistanceBits[distance]);
+				pos += length;
+			}
+			else
+			{
+				writer.Put(s_Deflate.Literal[data[pos]], s_Deflate.LiteralBits[data[pos]]);
+				pos++;
+			}
+		}
+		for (; pos < size; pos++)
+			writer.Put(s_Deflate.Literal[data[pos]], s_Deflate.LiteralBits[data[pos]]);
+
+		writer.Put(s_Deflate.Literal[256], s_Deflate.LiteralBits[256]);
+		writer.Flush();
+	}
+
+	void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, uint32_t size)
+	{
+		PutBigEndian(out, size);
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+		PutBigEndian(out, Crc32(out.data() + start, size + 4));
+	}
+
+}
+
+FrameEncoder::~FrameEncoder()
+{
+	Close();
+}
+
+bool FrameEncoder::Open(const std::string& path, CaptureFormat format, uint32_t width, uint32_t height, uint32_t frameRate, std::string& error)
+{
+	Close();
+	m_Path = path;
+	m_Format = format;
+	m_Width = width;
+	m_Height = height;
+	m_FrameCount = 0;
+	m_BytesWritten = 0;
+
+	std::error_code ec;
+	std::filesystem::path directory = format == CaptureFormat::PNG ? std::filesystem::path(path) : std::filesystem::path(path).parent_path();
+	if (!directory.empty())
+		std::filesystem::create_directories(directory, ec);
+	if (ec)
+	{
+		error = "could not create " + directory.string() + ": " + ec.message();
+		return false;
+	}
+
+	if (format == CaptureFormat::Y4M)
+	{
+		m_Stream = std::fopen(path.c_str(), "wb");
+		if (!m_Stream)
+		{
+			error = "could not open " + path;
+			return false;
+		}
+		m_BytesWritten += std::fprintf(m_Stream, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", width, height, frameRate);
+	}
+	return true;
+}
+
+bool FrameEncoder::Encode(const uint8_t* rgba)
+{
+	if (m_Format == CaptureFormat::Y4M)
+	{
+		if (!m_Stream)
+			return false;
+
+		ConvertYUV420(rgba, m_Width, m_Height, m_Scratch);
+		bool written = std::fwrite("FRAME\n", 6, 1, m_Stream) == 1 && std::fwrite(m_Scratch.data(), m_Scratch.size(), 1, m_Stream) == 1;
+		if (!written)
+			return false;
+		m_BytesWritten += 6 + m_Scratch.size();
+		m_FrameCount++;
+		return true;
+	}
+
+	EncodePNG(rgba, m_Width, m_Height, m_Scratch);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%06llu.png", (unsigned long long)m_FrameCount);
+	std::string filepath = (std::filesystem::path(m_Path) / name).string();
+	FILE* file = std::fopen(filepath.c_str(), "wb");
+	if (!file)
+		return false;
+	bool written = std::fwrite(m_Scratch.data(), m_Scratch.size(), 1, file) == 1;
+	written = std::fclose(file) == 0 && written;
+	if (!written)
+		return false;
+
+	m_BytesWritten += m_Scratch.size();
+	m_FrameCount++;
+	return true;
+}
+
+void FrameEncoder::Close()
+{
+	if (m_Stream)
+	{
+		std::fclose(m_Stream);
+		m_Stream = nullptr;
+	}
+}
+
+void FrameEncoder::EncodePNG(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out)
+{
+	// Sub filter on RGB rows, top row first
+	// Kept per thread so steady-state captures don't fault in a fresh buffer every frame
+	thread_local std::vector<uint8_t> filtered;
+	size_t stride = 1 + (size_t)width * 3;
+	filtered.resize(stride * height);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t* src = rgba + (size_t)(height - 1 - y) * width * 4;
+		uint8_t* dst = filtered.data() + y * stride;
+		*dst++ = 1;
+		uint8_t previous[3] = {};
+		for (uint32_t x = 0; x < width; x++, src += 4, dst += 3)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				dst[c] = (uint8_t)(src[c] - previous[c]);
+				previous[c] = src[c];
+			}
+		}
+	}
+
+	out.clear();
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	out.insert(out.end(), signature, signature + 8);
+
+	uint8_t header[13] = {};
+	for (int i = 0; i < 4; i++)
+	{
+		header[i] = (uint8_t)(width >> (24 - 8 * i));
+		header[4 + i] = (uint8_t)(height >> (24 - 8 * i));
+	}
+	header[8] = 8; // bits per channel
+	header[9] = 2; // RGB
+	PutChunk(out, "IHDR", header, sizeof(header));
+
+	// IDAT is compressed in place and its length patched afterwards
+	size_t lengthOffset = out.size();
+	PutBigEndian(out, 0);
+	out.insert(out.end(), { 'I', 'D', 'A', 'T', 0x78, 0x01 });
+	Deflate(filtered.data(), filtered.size(), out);
+	PutBigEndian(out, Adler32(filtered.data(), filtered.size()));
+
+	uint32_t idatSize = (uint32_t)(out.size() - lengthOffset - 8);
+	for (int i = 0; i < 4; i++)
+		out[lengthOffset + i] = (uint8_t)(idatSize >> (24 - 8 * i));
+	PutBigEndian(out, Crc32(out.data() + lengthOffset + 4, idatSize + 4));
+
+	PutChunk(out, "IEND", nullptr, 0);
+}
+
+void FrameEncoder::ConvertYUV420(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out)
+{
+	uint32_t chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	size_t lumaSize = (size_t)width * height, chromaSize = (size_t)chromaWidth * chromaHeight;
+	out.resize(lumaSize + 2 * chromaSize);
+	uint8_t* yPlane = out.data();
+	uint8_t* uPlane = yPlane + lumaSize;
+	uint8_t* vPlane = uPlane + chromaSize;
+
+	auto row = [&](uint32_t y) { return rgba + (size_t)(height - 1 - y) * width * 4; };
+	auto luma = [](const uint8_t* p) { return (uint8_t)(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16); };
+
+	// One pass over each pair of rows; odd edges reuse the last row or column
+	for (uint32_t cy = 0; cy < chromaHeight; cy++)
+	{
+		uint32_t y0 = 2 * cy, y1 = std::min(y0 + 1, height - 1);
+		const uint8_t* top = row(y0);
+		const uint8_t* bottom = row(y1);
+		uint8_t* lumaTop = yPlane + (size_t)y0 * width;
+		uint8_t* lumaBottom = yPlane + (size_t)y1 * width;
+		for (uint32_t cx = 0; cx < chromaWidth; cx++)
+		{
+			uint32_t x0 = 2 * cx, x1 = std::min(x0 + 1, width - 1);
+			const uint8_t* a = top + x0 * 4;
+			const uint8_t* b = top + x1 * 4;
+			const uint8_t* c = bottom + x0 * 4;
+			const uint8_t* d = bottom + x1 * 4;
+			lumaTop[x0] = luma(a);
+			lumaTop[x1] = luma(b);
+			lumaBottom[x0] = luma(c);
+			lumaBottom[x1] = luma(d);
+
+			int r = (a[0] + b[0] + c[0] + d[0] + 2) >> 2;
+			int g = (a[1] + b[1] + c[1] + d[1] + 2) >> 2;
+			int bl = (a[2] + b[2] + c[2] + d[2] + 2) >> 2;
+			uPlane[(size_t)cy * chromaWidth + cx] = (uint8_t)(((-38 * r - 74 * g + 112 * bl + 128) >> 8) + 128);
+			vPlane[(size_t)cy * chromaWidth + cx] = (uint8_t)(((112 * r - 94 * g - 18 * bl + 128) >> 8) + 128);
+		}
+	}
+}
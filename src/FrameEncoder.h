@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum class CaptureFormat
+{
+	PNG = 0, // one numbered file per frame
+	Y4M      // a single raw 4:2:0 stream, BT.601 limited range
+};
+
+// Writes captured frames to disk. Input is tightly packed RGBA8 with the
+// bottom row first, the way glReadPixels returns it; alpha is dropped.
+// GL-free, so it runs on the capture worker and in the headless benchmark.
+class FrameEncoder
+{
+public:
+	~FrameEncoder();
+
+	// `path` is a directory for PNG (created if needed) and a file for Y4M
+	bool Open(const std::string& path, CaptureFormat format, uint32_t width, uint32_t height, uint32_t frameRate, std::string& error);
+	bool Encode(const uint8_t* rgba);
+	void Close();
+
+	uint64_t GetFrameCount() const { return m_FrameCount; }
+	uint64_t GetBytesWritten() const { return m_BytesWritten; }
+
+	// Filtered rows + fixed-Huffman deflate with a single-probe LZ77 matcher:
+	// a fraction of zlib's best ratio at a far higher speed, which is what
+	// mostly-black particle frames need
+	static void EncodePNG(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out);
+	// Y plane, then U, then V; chroma is averaged over 2x2 blocks
+	static void ConvertYUV420(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out);
+private:
+	std::string m_Path;
+	CaptureFormat m_Format = CaptureFormat::PNG;
+	uint32_t m_Width = 0, m_Height = 0;
+	FILE* m_Stream = nullptr;
+	uint64_t m_FrameCount = 0, m_BytesWritten = 0;
+	std::vector<uint8_t> m_Scratch;
+};
@@ -0,0 +1,241 @@
+#include "FrameLatency.h"
+
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+	float ToMs(FrameLatency::Clock::duration duration)
+	{
+		return std::chrono::duration<float, std::milli>(duration).count();
+	}
+
+	int64_t ToNs(FrameLatency::Clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	}
+
+	void SleepUntil(FrameLatency::Clock::time_point target)
+	{
+		// Coarse sleep, then spin out the last millisecond for precision
+		auto remaining = target - FrameLatency::Clock::now();
+		if (remaining > std::chrono::milliseconds(2))
+			std::this_thread::sleep_for(remaining - std::chrono::milliseconds(1));
+		while (FrameLatency::Clock::now() < target)
+			std::this_thread::yield();
+	}
+
+	float Percentile(std::vector<float>& sorted, float p)
+	{
+		return sorted[std::min(sorted.size() - 1, (size_t)(p * (float)sorted.size()))];
+	}
+
+}
+
+FrameLatency::FrameLatency()
+{
+	for (auto& history : m_History)
+		history.reserve(s_HistorySize);
+	m_WorkHistory.reserve(64);
+}
+
+void FrameLatency::BeginFrame()
+{
+	// With a render thread, recording can start while the previous frame is still being replayed;
+	// pacing instead starts from its present, like a host that swaps on this thread
+	if (PacingEnabled && RenderThread::IsThreaded())
+		RenderThread::WaitIdle();
+	Clock::time_point now = Clock::now();
+
+	for (FrameRecord& record : m_Frames)
+	{
+		RenderThread::FrameTimes times;
+		if (!record.Open || record.HasWork || !RenderThread::GetFrameTimes(record.RenderFrame, times))
+			continue;
+
+		// Work up to the swap: recording, the UI and the handover, then the replay. Waiting for the
+		// render thread to go idle and the swap blocking on vsync are what pacing removes, so neither counts.
+		AddWorkSample(ToMs(times.Submitted - record.Input) + ToMs(times.Replayed - times.ReplayStart));
+		record.HasWork = true;
+		if (times.Presented != Clock::time_point())
+		{
+			record.Swapped = times.Presented;
+			record.HasSwap = true;
+		}
+	}
+
+	// Replayed inline: getting here means the host returned from the previous frame's swap
+	FrameRecord& previous = m_Frames[m_FrameIndex % s_FramesInFlight];
+	if (previous.Open && !previous.HasSwap && !RenderThread::IsThreaded())
+	{
+		previous.Swapped = now;
+		previous.HasSwap = true;
+	}
+
+	if (m_LastFrameStart != Clock::time_point())
+	{
+		float period = ToMs(now - m_LastFrameStart);
+		m_FramePeriodMs = m_FramePeriodMs == 0.0f ? period : m_FramePeriodMs * 0.9f + period * 0.1f;
+	}
+	m_LastFrameStart = now;
+
+	for (FrameRecord& record : m_Frames)
+	{
+		if (record.Open && record.HasSwap && record.GpuReady.load(std::memory_order_acquire))
+			Finalize(record);
+	}
+
+	m_LastDelayMs = 0.0f;
+	if (PacingEnabled)
+		Pace(now);
+
+	m_FrameIndex++;
+}
+
+void FrameLatency::AddWorkSample(float work)
+{
+	// Predict the next frame's cost from the 90th percentile of recent ones
+	if (m_WorkHistory.size() < 64)
+		m_WorkHistory.push_back(work);
+	else
+		m_WorkHistory[m_WorkCursor++ % 64] = work;
+
+	std::vector<float> sorted = m_WorkHistory;
+	std::sort(sorted.begin(), sorted.end());
+	m_PredictedWorkMs = Percentile(sorted, 0.9f);
+}
+
+void FrameLatency::Pace(Clock::time_point frameStart)
+{
+	if (m_FramePeriodMs <= 0.0f || m_WorkHistory.empty())
+		return;
+
+	float delay = m_FramePeriodMs - m_PredictedWorkMs - PacingMarginMs;
+	if (delay <= 0.0f)
+		return;
+
+	SleepUntil(frameStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(delay)));
+	m_LastDelayMs = delay;
+}
+
+void FrameLatency::MarkInputSampled()
+{
+	FrameRecord& record = m_Frames[m_FrameIndex % s_FramesInFlight];
+	record.Input = Clock::now();
+	record.Serial = m_FrameIndex;
+	record.Open = true;
+	record.HasSwap = record.HasWork = false;
+}
+
+void FrameLatency::MarkSimulated()
+{
+	m_Frames[m_FrameIndex % s_FramesInFlight].Simulated = Clock::now();
+}
+
+void FrameLatency::MarkSubmitted(RenderCommandList& commands)
+{
+	FrameRecord& record = m_Frames[m_FrameIndex % s_FramesInFlight];
+	record.Submitted = Clock::now();
+	record.RenderFrame = RenderThread::GetFrameIndex();
+
+	commands.Execute([this, &record, serial = record.Serial]()
+	{
+		if (!m_GpuInitialized)
+			InitGpu();
+
+		PollGpu();
+
+		// A fence that never got polled belongs to a frame we gave up on
+		if (record.Fence)
+			glDeleteSync(record.Fence);
+
+		if (m_HasTimerQuery)
+			glQueryCounter(record.Query, GL_TIMESTAMP);
+		record.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		record.GpuSerial = serial;
+	});
+}
+
+void FrameLatency::InitGpu()
+{
+	m_HasTimerQuery = GLAD_GL_VERSION_3_3;
+	if (m_HasTimerQuery)
+	{
+		for (FrameRecord& record : m_Frames)
+			glGenQueries(1, &record.Query);
+	}
+	m_GpuInitialized = true;
+}
+
+void FrameLatency::PollGpu()
+{
+	Clock::time_point now = Clock::now();
+	if (m_HasTimerQuery && now - m_LastCalibration > std::chrono::seconds(1))
+	{
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		m_GpuToCpuOffsetNs = ToNs(now) - gpuNow;
+		m_LastCalibration = now;
+	}
+
+	for (FrameRecord& record : m_Frames)
+	{
+		if (!record.Fence)
+			continue;
+
+		GLenum status = glClientWaitSync(record.Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+
+		glDeleteSync(record.Fence);
+		record.Fence = nullptr;
+
+		if (m_HasTimerQuery)
+		{
+			GLuint64 gpuTime = 0;
+			glGetQueryObjectui64v(record.Query, GL_QUERY_RESULT, &gpuTime);
+			record.GpuDone = Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds((int64_t)gpuTime + m_GpuToCpuOffsetNs)));
+		}
+		else
+			record.GpuDone = now;
+
+		record.GpuReady.store(true, std::memory_order_release);
+	}
+}
+
+void FrameLatency::Finalize(FrameRecord& record)
+{
+	record.Open = false;
+	record.GpuReady.store(false, std::memory_order_relaxed);
+	if (record.GpuSerial != record.Serial)
+		return;
+
+	// Presentation is no earlier than both the swap returning and the GPU finishing the frame
+	Clock::time_point photon = std::max(record.GpuDone, record.Swapped);
+	float samples[] = { ToMs(record.Simulated - record.Input), ToMs(record.Submitted - record.Input), ToMs(photon - record.Input) };
+
+	for (size_t i = 0; i < m_History.size(); i++)
+	{
+		if (m_History[i].size() < s_HistorySize)
+			m_History[i].push_back(samples[i]);
+		else
+			m_History[i][m_HistoryCursor % s_HistorySize] = samples[i];
+	}
+	m_HistoryCursor++;
+}
+
+FrameLatency::Percentiles FrameLatency::GetPercentiles(Stage stage) const
+{
+	Percentiles result;
+	std::vector<float> sorted = m_History[(size_t)stage];
+	if (sorted.empty())
+		return result;
+
+	std::sort(sorted.begin(), sorted.end());
+	result.P50 = Percentile(sorted, 0.50f);
+	result.P95 = Percentile(sorted, 0.95f);
+	result.P99 = Percentile(sorted, 0.99f);
+	return result;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "RenderCommandList.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// Measures input-to-photon latency per frame and optionally paces the frame so
+// input is sampled as late as possible before the swap.
+//
+// Per frame: BeginFrame() (paces, closes earlier frames at their swap) ->
+// MarkInputSampled() -> MarkSimulated() -> MarkSubmitted(commands).
+// Swap times and the work predicted for pacing come from RenderThread's frame
+// times, so they include the replay and, with a render thread, the UI.
+// GPU completion comes from a GL_TIMESTAMP query + fence recorded after the
+// frame's draws and polled a few frames later, so nothing ever stalls.
+// Without timer queries the fence signal time is used instead.
+class FrameLatency
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Stage
+	{
+		Simulated = 0, Submitted, Photon, Count
+	};
+
+	struct Percentiles
+	{
+		float P50 = 0.0f, P95 = 0.0f, P99 = 0.0f;
+	};
+
+	FrameLatency();
+
+	void BeginFrame();
+	void MarkInputSampled();
+	void MarkSimulated();
+	void MarkSubmitted(RenderCommandList& commands);
+
+	// Latency from input sampling to `stage`, in milliseconds, over the recent history
+	Percentiles GetPercentiles(Stage stage) const;
+
+	bool PacingEnabled = false;
+	float PacingMarginMs = 1.5f;
+
+	float GetPredictedWorkMs() const { return m_PredictedWorkMs; }
+	float GetFramePeriodMs() const { return m_FramePeriodMs; }
+	float GetLastPacingDelayMs() const { return m_LastDelayMs; }
+private:
+	struct FrameRecord
+	{
+		Clock::time_point Input, Simulated, Submitted, Swapped;
+		uint64_t Serial = 0, RenderFrame = 0;
+		bool Open = false, HasSwap = false, HasWork = false;
+
+		// Written by the thread that replays commands, published through GpuReady
+		GLuint Query = 0;
+		GLsync Fence = nullptr;
+		uint64_t GpuSerial = 0;
+		Clock::time_point GpuDone;
+		std::atomic<bool> GpuReady{ false };
+	};
+
+	void InitGpu();
+	void PollGpu();
+	void Finalize(FrameRecord& record);
+	void AddWorkSample(float work);
+	void Pace(Clock::time_point frameStart);
+private:
+	static constexpr uint32_t s_FramesInFlight = 4;
+	static constexpr uint32_t s_HistorySize = 256;
+
+	std::array<FrameRecord, s_FramesInFlight> m_Frames;
+	uint32_t m_FrameIndex = 0;
+	Clock::time_point m_LastFrameStart;
+
+	// Render thread state
+	bool m_HasTimerQuery = false;
+	bool m_GpuInitialized = false;
+	int64_t m_GpuToCpuOffsetNs = 0;
+	Clock::time_point m_LastCalibration;
+
+	std::array<std::vector<float>, (size_t)Stage::Count> m_History;
+	uint32_t m_HistoryCursor = 0;
+
+	std::vector<float> m_WorkHistory;
+	uint32_t m_WorkCursor = 0;
+	float m_PredictedWorkMs = 0.0f, m_FramePeriodMs = 0.0f, m_LastDelayMs = 0.0f;
+};
@@ -0,0 +1,313 @@
+#include "GpuProfiler.h"
+
+#include "RenderThread.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+namespace {
+
+	// The main thread records frame F into slot F % FramesInFlight while the render
+	// thread may still be replaying F - 1, so a slot is only polled on the replays
+	// of F + 1 .. F + ResolveWindow and the ring keeps clear of the one being recorded
+	constexpr uint32_t FramesInFlight = 5;
+	constexpr uint32_t ResolveWindow = FramesInFlight - 2;
+	constexpr uint32_t QueriesPerFrame = 2 + 2 * GpuProfiler::MaxZones; // frame start and end, then a pair per zone
+	constexpr uint32_t HistorySize = 240;
+	constexpr uint32_t NoZone = ~0u;
+
+	const char* const s_FrameName = "Frame";
+	const char* const s_OutsideName = "ImGui + present";
+
+	struct FrameSlot
+	{
+		GLuint Queries[QueriesPerFrame] = {};
+
+		// Written while recording the frame
+		uint64_t Frame = ~0ull;
+		const char* Names[GpuProfiler::MaxZones];
+		uint32_t Depths[GpuProfiler::MaxZones];
+		uint32_t ZoneCount = 0;
+		bool Recorded = false;
+
+		// Render thread
+		bool Resolved = false;
+	};
+
+	struct TraceZone
+	{
+		const char* Name;
+		uint32_t Depth;
+		uint64_t BeginNs, EndNs;
+	};
+
+	struct TraceFrame
+	{
+		uint64_t Frame = 0;
+		uint64_t StartNs = 0, EndNs = 0;
+		uint64_t PreviousEndNs = 0; // end of the frame before, 0 if it was dropped
+		uint32_t ZoneCount = 0;
+		TraceZone Zones[GpuProfiler::MaxZones];
+	};
+
+	struct GpuProfilerState
+	{
+		std::array<FrameSlot, FramesInFlight> Slots;
+		std::atomic<bool> Supported{ false };
+
+		// Main thread
+		bool Initialized = false;
+		bool Recording = false;
+		uint64_t Frame = 0;
+		uint32_t OpenZones = 0;
+
+		// Render thread
+		uint64_t LastEndNs = 0, LastResolvedFrame = ~0ull;
+		std::atomic<uint64_t> Dropped{ 0 };
+
+		std::mutex Mutex;
+		std::array<TraceFrame, HistorySize> History;
+		uint64_t HistoryCount = 0;
+	};
+
+	GpuProfilerState s_Profiler;
+
+	void InitQueries()
+	{
+		// Timestamp queries are core since 3.3
+		if (!GLAD_GL_VERSION_3_3)
+			return;
+
+		for (FrameSlot& slot : s_Profiler.Slots)
+			glGenQueries(QueriesPerFrame, slot.Queries);
+		s_Profiler.Supported.store(true, std::memory_order_release);
+	}
+
+	void Publish(const FrameSlot& slot, const GLuint64* timestamps)
+	{
+		std::lock_guard<std::mutex> lock(s_Profiler.Mutex);
+		TraceFrame& frame = s_Profiler.History[s_Profiler.HistoryCount++ % HistorySize];
+		frame.Frame = slot.Frame;
+		frame.StartNs = timestamps[0];
+		frame.EndNs = timestamps[1];
+		frame.PreviousEndNs = s_Profiler.LastResolvedFrame + 1 == slot.Frame ? s_Profiler.LastEndNs : 0;
+		frame.ZoneCount = slot.ZoneCount;
+		for (uint32_t i = 0; i < slot.ZoneCount; i++)
+			frame.Zones[i] = { slot.Names[i], slot.Depths[i], timestamps[2 + 2 * i], timestamps[3 + 2 * i] };
+	}
+
+	void Resolve(uint64_t frame)
+	{
+		if (!s_Profiler.Supported.load(std::memory_order_relaxed))
+			return;
+
+		GLuint64 timestamps[QueriesPerFrame];
+		for (uint64_t g = frame > ResolveWindow ? frame - ResolveWindow : 0; g < frame; g++)
+		{
+			FrameSlot& slot = s_Profiler.Slots[g % FramesInFlight];
+			if (slot.Frame != g || !slot.Recorded || slot.Resolved)
+				continue;
+
+			// Queries complete in order, so the frame's last one stands for all of them
+			GLint available = 0;
+			glGetQueryObjectiv(slot.Queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+			{
+				if (g + ResolveWindow == frame)
+				{
+					slot.Resolved = true;
+					s_Profiler.Dropped.fetch_add(1, std::memory_order_relaxed);
+					continue;
+				}
+				break;
+			}
+
+			uint32_t queryCount = 2 + 2 * slot.ZoneCount;
+			for (uint32_t i = 0; i < queryCount; i++)
+				glGetQueryObjectui64v(slot.Queries[i], GL_QUERY_RESULT, &timestamps[i]);
+			Publish(slot, timestamps);
+
+			s_Profiler.LastEndNs = timestamps[1];
+			s_Profiler.LastResolvedFrame = g;
+			slot.Resolved = true;
+		}
+	}
+
+	float ToMs(uint64_t begin, uint64_t end)
+	{
+		return end > begin ? (float)((end - begin) * 1e-6) : 0.0f;
+	}
+
+}
+
+void GpuProfiler::BeginFrame()
+{
+	RenderCommandList& commands = RenderThread::GetCommandList();
+	if (!s_Profiler.Initialized)
+	{
+		commands.Execute(InitQueries);
+		s_Profiler.Initialized = true;
+	}
+	commands.Execute([frame = s_Profiler.Frame]() { Resolve(frame); });
+
+	s_Profiler.Recording = s_Profiler.Supported.load(std::memory_order_acquire);
+	if (!s_Profiler.Recording)
+		return;
+
+	FrameSlot& slot = s_Profiler.Slots[s_Profiler.Frame % FramesInFlight];
+	slot.Frame = s_Profiler.Frame;
+	slot.ZoneCount = 0;
+	slot.Recorded = false;
+	slot.Resolved = false;
+	s_Profiler.OpenZones = 0;
+	commands.QueryCounter(&slot.Queries[0]);
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (s_Profiler.Recording)
+	{
+		FrameSlot& slot = s_Profiler.Slots[s_Profiler.Frame % FramesInFlight];
+		RenderThread::GetCommandList().QueryCounter(&slot.Queries[1]);
+		slot.Recorded = true;
+		s_Profiler.Recording = false;
+	}
+	s_Profiler.Frame++;
+}
+
+uint32_t GpuProfiler::BeginZone(const char* name)
+{
+	if (!s_Profiler.Recording)
+		return NoZone;
+
+	FrameSlot& slot = s_Profiler.Slots[s_Profiler.Frame % FramesInFlight];
+	if (slot.ZoneCount == MaxZones)
+		return NoZone;
+
+	uint32_t zone = slot.ZoneCount++;
+	slot.Names[zone] = name;
+	slot.Depths[zone] = s_Profiler.OpenZones++;
+	RenderThread::GetCommandList().QueryCounter(&slot.Queries[2 + 2 * zone]);
+	return zone;
+}
+
+void GpuProfiler::EndZone(uint32_t zone)
+{
+	if (zone == NoZone || !s_Profiler.Recording)
+		return;
+
+	FrameSlot& slot = s_Profiler.Slots[s_Profiler.Frame % FramesInFlight];
+	RenderThread::GetCommandList().QueryCounter(&slot.Queries[3 + 2 * zone]);
+	s_Profiler.OpenZones--;
+}
+
+bool GpuProfiler::IsSupported()
+{
+	return s_Profiler.Supported.load(std::memory_order_relaxed);
+}
+
+uint64_t GpuProfiler::GetDroppedCount()
+{
+	return s_Profiler.Dropped.load(std::memory_order_relaxed);
+}
+
+std::vector<GpuZoneStats> GpuProfiler::GetZoneStats(uint32_t frames)
+{
+	std::vector<GpuZoneStats> stats;
+	std::lock_guard<std::mutex> lock(s_Profiler.Mutex);
+	if (s_Profiler.HistoryCount == 0)
+		return stats;
+
+	// Layout comes from the latest frame; zones it doesn't have are left out
+	const TraceFrame& latest = s_Profiler.History[(s_Profiler.HistoryCount - 1) % HistorySize];
+	stats.push_back({ s_FrameName, 0, ToMs(latest.StartNs, latest.EndNs), 0.0f, 0.0f });
+	for (uint32_t i = 0; i < latest.ZoneCount; i++)
+		stats.push_back({ latest.Zones[i].Name, latest.Zones[i].Depth + 1, ToMs(latest.Zones[i].BeginNs, latest.Zones[i].EndNs), 0.0f, 0.0f });
+	stats.push_back({ s_OutsideName, 0, latest.PreviousEndNs ? ToMs(latest.PreviousEndNs, latest.StartNs) : 0.0f, 0.0f, 0.0f });
+
+	std::vector<uint32_t> samples(stats.size(), 0);
+	uint64_t count = std::min<uint64_t>({ frames, s_Profiler.HistoryCount, HistorySize });
+	for (uint64_t n = 0; n < count; n++)
+	{
+		const TraceFrame& frame = s_Profiler.History[(s_Profiler.HistoryCount - 1 - n) % HistorySize];
+		auto add = [&](const char* name, float ms)
+		{
+			for (size_t i = 0; i < stats.size(); i++)
+			{
+				if (stats[i].Name != name)
+					continue;
+				stats[i].AverageMs += ms;
+				stats[i].MaxMs = std::max(stats[i].MaxMs, ms);
+				samples[i]++;
+				return;
+			}
+		};
+
+		add(s_FrameName, ToMs(frame.StartNs, frame.EndNs));
+		for (uint32_t i = 0; i < frame.ZoneCount; i++)
+			add(frame.Zones[i].Name, ToMs(frame.Zones[i].BeginNs, frame.Zones[i].EndNs));
+		if (frame.PreviousEndNs)
+			add(s_OutsideName, ToMs(frame.PreviousEndNs, frame.StartNs));
+	}
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		if (samples[i])
+			stats[i].AverageMs /= (float)samples[i];
+	}
+	return stats;
+}
+
+bool GpuProfiler::ExportTrace(const std::string& filepath, std::string& error)
+{
+	std::vector<TraceFrame> frames;
+	{
+		std::lock_guard<std::mutex> lock(s_Profiler.Mutex);
+		uint64_t count = std::min<uint64_t>(s_Profiler.HistoryCount, HistorySize);
+		for (uint64_t n = count; n > 0; n--)
+			frames.push_back(s_Profiler.History[(s_Profiler.HistoryCount - n) % HistorySize]);
+	}
+	if (frames.empty())
+	{
+		error = "no GPU frames recorded yet";
+		return false;
+	}
+
+	FILE* file = std::fopen(filepath.c_str(), "w");
+	if (!file)
+	{
+		error = "could not write " + filepath;
+		return false;
+	}
+
+	// Complete ("X") events in microseconds from the first exported frame
+	uint64_t origin = frames.front().PreviousEndNs ? frames.front().PreviousEndNs : frames.front().StartNs;
+	auto event = [&](const char* name, uint64_t frame, uint64_t begin, uint64_t end)
+	{
+		std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%llu}}",
+			name, (double)(int64_t)(begin - origin) * 1e-3, (end > begin ? end - begin : 0) * 1e-3, (unsigned long long)frame);
+	};
+
+	std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}");
+	for (const TraceFrame& frame : frames)
+	{
+		if (frame.PreviousEndNs)
+			event(s_OutsideName, frame.Frame, frame.PreviousEndNs, frame.StartNs);
+		event(s_FrameName, frame.Frame, frame.StartNs, frame.EndNs);
+		for (uint32_t i = 0; i < frame.ZoneCount; i++)
+			event(frame.Zones[i].Name, frame.Frame, frame.Zones[i].BeginNs, frame.Zones[i].EndNs);
+	}
+	std::fprintf(file, "\n]}\n");
+
+	if (std::fclose(file) != 0)
+	{
+		error = "could not write " + filepath;
+		return false;
+	}
+	return true;
+}
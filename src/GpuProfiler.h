@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GpuZoneStats
+{
+	const char* Name;
+	uint32_t Depth;
+	float LastMs, AverageMs, MaxMs;
+};
+
+// GPU time of named zones of the render command list. Every zone boundary is
+// a GL_TIMESTAMP query, so zones can nest, which GL_TIME_ELAPSED cannot.
+// Each frame's queries come from one slot of a ring and are read back a few
+// frames later, only once GL_QUERY_RESULT_AVAILABLE is set; a frame whose
+// results are still missing when its slot is needed again is dropped.
+// Time spent between EndFrame() and the next BeginFrame() (ImGui and the swap
+// in GLCore) is reported as its own zone.
+//
+// Main thread: BeginFrame() -> zones -> EndFrame(), just before RenderThread::EndFrame().
+class GpuProfiler
+{
+public:
+	static constexpr uint32_t MaxZones = 32;
+
+	static void BeginFrame();
+	static void EndFrame();
+
+	// `name` must outlive the profiler (a string literal); zones are matched across frames by it
+	static uint32_t BeginZone(const char* name);
+	static void EndZone(uint32_t zone);
+
+	// False until the context reported timer query support
+	static bool IsSupported();
+	static uint64_t GetDroppedCount();
+
+	// Zones of the latest resolved frame, in recording order, over the last `frames` resolved frames.
+	// The first entry is the whole frame.
+	static std::vector<GpuZoneStats> GetZoneStats(uint32_t frames = 120);
+
+	// Chrome trace event JSON (chrome://tracing, ui.perfetto.dev) of the recent resolved frames
+	static bool ExportTrace(const std::string& filepath, std::string& error);
+};
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(const char* name)
+		: m_Zone(GpuProfiler::BeginZone(name)) {}
+	~GpuProfileScope() { GpuProfiler::EndZone(m_Zone); }
+private:
+	uint32_t m_Zone;
+};
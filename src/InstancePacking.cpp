@@ -0,0 +1,165 @@
+#include "InstancePacking.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+	#include <emmintrin.h>
+	#define INSTANCE_PACKING_SSE2 1
+#endif
+
+// Half conversion for particle attributes: rounds to nearest, clamps to the
+// largest finite half and flushes values below the smallest normal to zero.
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t magnitude = std::min(bits & 0x7FFFFFFFu, 0x477FE000u);
+	if (magnitude < 0x38800000u)
+		return (uint16_t)sign;
+
+	return (uint16_t)(sign | ((magnitude - 0x38000000u + 0xFFFu + ((magnitude >> 13) & 1u)) >> 13));
+}
+
+ParticleBounds ComputeInstanceBounds(const ParticleInstance* instances, uint32_t count)
+{
+	ParticleBounds bounds;
+	if (count == 0)
+		return bounds;
+
+	bounds.Min = bounds.Max = instances[0].Position;
+	for (uint32_t i = 1; i < count; i++)
+	{
+		bounds.Min = glm::min(bounds.Min, instances[i].Position);
+		bounds.Max = glm::max(bounds.Max, instances[i].Position);
+	}
+	return bounds;
+}
+
+static void PackInstance(const ParticleInstance& instance, const glm::vec2& offset, const glm::vec2& scale, PackedParticleInstance& packed)
+{
+	glm::vec2 position = glm::clamp((instance.Position - offset) * scale, 0.0f, 65535.0f) + 0.5f;
+	packed.Position[0] = (uint16_t)position.x;
+	packed.Position[1] = (uint16_t)position.y;
+	packed.RotationSize[0] = FloatToHalf(instance.Rotation);
+	packed.RotationSize[1] = FloatToHalf(instance.Size);
+
+	glm::vec4 color = glm::clamp(instance.Color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	packed.Color = (uint32_t)color.r | ((uint32_t)color.g << 8) | ((uint32_t)color.b << 16) | ((uint32_t)color.a << 24);
+}
+
+#if INSTANCE_PACKING_SSE2
+static __m128i FloatToHalf4(__m128 value)
+{
+	__m128i bits = _mm_castps_si128(value);
+	__m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+	__m128i magnitude = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+
+	// min(magnitude, largest half) without SSE4.1
+	__m128i limit = _mm_set1_epi32(0x477FE000);
+	__m128i overflow = _mm_cmpgt_epi32(magnitude, limit);
+	magnitude = _mm_or_si128(_mm_and_si128(overflow, limit), _mm_andnot_si128(overflow, magnitude));
+
+	__m128i normal = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x38800000 - 1));
+	__m128i roundBit = _mm_and_si128(_mm_srli_epi32(magnitude, 13), _mm_set1_epi32(1));
+	__m128i half = _mm_add_epi32(_mm_sub_epi32(magnitude, _mm_set1_epi32(0x38000000)), _mm_add_epi32(_mm_set1_epi32(0xFFF), roundBit));
+	half = _mm_and_si128(_mm_srli_epi32(half, 13), normal);
+	return _mm_or_si128(half, sign);
+}
+
+// Packs 32-bit lanes holding values in [0, 65535] to 16 bits (SSE2 only has a signed saturating pack)
+static __m128i PackUnsigned16(__m128i a, __m128i b)
+{
+	__m128i bias = _mm_set1_epi32(0x8000);
+	__m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias), _mm_sub_epi32(b, bias));
+	return _mm_xor_si128(packed, _mm_set1_epi16((short)0x8000));
+}
+#endif
+
+void PackInstances(const ParticleInstance* instances, uint32_t count, const ParticleBounds& bounds, PackedParticleInstance* packed)
+{
+	glm::vec2 extent = glm::max(bounds.Max - bounds.Min, glm::vec2(1e-6f));
+	glm::vec2 scale = 65535.0f / extent;
+
+	uint32_t i = 0;
+#if INSTANCE_PACKING_SSE2
+	__m128 offset = _mm_setr_ps(bounds.Min.x, bounds.Min.y, bounds.Min.x, bounds.Min.y);
+	__m128 positionScale = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+	__m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+	__m128 maxPosition = _mm_set1_ps(65535.0f), colorScale = _mm_set1_ps(255.0f), rounding = _mm_set1_ps(0.5f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const float* src = (const float*)(instances + i);
+
+		// Each instance is 8 floats: color rgba, position xy, rotation, size
+		__m128 c0 = _mm_loadu_ps(src + 0), m0 = _mm_loadu_ps(src + 4);
+		__m128 c1 = _mm_loadu_ps(src + 8), m1 = _mm_loadu_ps(src + 12);
+		__m128 c2 = _mm_loadu_ps(src + 16), m2 = _mm_loadu_ps(src + 20);
+		__m128 c3 = _mm_loadu_ps(src + 24), m3 = _mm_loadu_ps(src + 28);
+
+		// Colors: 4 x RGBA8 in one register
+		auto toByte = [&](__m128 c) { return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(c, zero), one), colorScale), rounding)); };
+		__m128i colors16 = _mm_packs_epi32(toByte(c0), toByte(c1));
+		__m128i colors16b = _mm_packs_epi32(toByte(c2), toByte(c3));
+		__m128i colors = _mm_packus_epi16(colors16, colors16b);
+
+		// Positions: xy of instances 0,1 and 2,3
+		__m128 p01 = _mm_movelh_ps(m0, m1), p23 = _mm_movelh_ps(m2, m3);
+		auto toUnorm = [&](__m128 p)
+		{
+			p = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p, offset), positionScale), zero), maxPosition);
+			return _mm_cvttps_epi32(_mm_add_ps(p, rounding));
+		};
+		__m128i positions = PackUnsigned16(toUnorm(p01), toUnorm(p23));
+
+		// Rotation and size: zw of each instance
+		__m128i halves01 = FloatToHalf4(_mm_movehl_ps(m1, m0));
+		__m128i halves23 = FloatToHalf4(_mm_movehl_ps(m3, m2));
+		__m128i halves = PackUnsigned16(halves01, halves23);
+
+		// Interleave into 4 x (position, rotation/size) 8-byte pairs, then add the colors
+		__m128i lo = _mm_unpacklo_epi32(positions, halves);
+		__m128i hi = _mm_unpackhi_epi32(positions, halves);
+
+		alignas(16) uint32_t words[12];
+		alignas(16) uint32_t colorWords[4];
+		_mm_store_si128((__m128i*)words, lo);
+		_mm_store_si128((__m128i*)(words + 4), hi);
+		_mm_store_si128((__m128i*)colorWords, colors);
+		for (int k = 0; k < 4; k++)
+		{
+			uint32_t* dst = (uint32_t*)(packed + i + k);
+			dst[0] = words[k * 2 + 0];
+			dst[1] = words[k * 2 + 1];
+			dst[2] = colorWords[k];
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		PackInstance(instances[i], bounds.Min, scale, packed[i]);
+}
+
+ParticleTraffic EstimateMultiPassTraffic(uint32_t capacity, uint32_t live, bool packed)
+{
+	ParticleTraffic traffic;
+	traffic.ReadBytes = 2ull * capacity * sizeof(Particle);
+	traffic.WrittenBytes = (uint64_t)live * (sizeof(Particle) + sizeof(ParticleInstance));
+	if (packed)
+	{
+		traffic.ReadBytes += 2ull * live * sizeof(ParticleInstance);
+		traffic.WrittenBytes += (uint64_t)live * sizeof(PackedParticleInstance);
+	}
+	return traffic;
+}
+
+ParticleTraffic EstimateFusedTraffic(uint32_t capacity, uint32_t live, uint32_t instances)
+{
+	ParticleTraffic traffic;
+	traffic.ReadBytes = (uint64_t)capacity * sizeof(Particle);
+	traffic.WrittenBytes = (uint64_t)live * sizeof(Particle) + (uint64_t)instances * sizeof(PackedParticleInstance);
+	return traffic;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Compact upload format, 12 bytes instead of the 32 of ParticleInstance:
+// position as 16-bit unorm relative to the frame's bounds, rotation and size
+// as half floats, color as RGBA8. The vertex fetch decodes everything except
+// the position, which the shader rescales with the bounds.
+struct PackedParticleInstance
+{
+	uint16_t Position[2];
+	uint16_t RotationSize[2]; // half floats
+	uint32_t Color;           // RGBA8, r in the lowest byte
+};
+
+static_assert(sizeof(PackedParticleInstance) == 12, "PackedParticleInstance must stay 12 bytes");
+
+struct ParticleBounds
+{
+	glm::vec2 Min = { 0.0f, 0.0f };
+	glm::vec2 Max = { 0.0f, 0.0f };
+};
+
+ParticleBounds ComputeInstanceBounds(const ParticleInstance* instances, uint32_t count);
+
+// SSE2 when available, 4 instances per iteration
+void PackInstances(const ParticleInstance* instances, uint32_t count, const ParticleBounds& bounds, PackedParticleInstance* packed);
+
+uint16_t FloatToHalf(float value);
+
+// CPU memory a frame's particle passes walk, estimated from their footprints:
+// each walk over the pool reads every slot, integration writes back the live
+// ones, and each instance array is written once and read by every later pass.
+struct ParticleTraffic
+{
+	uint64_t ReadBytes = 0;
+	uint64_t WrittenBytes = 0;
+};
+
+// Update() and BuildInstances(), then ComputeInstanceBounds() and PackInstances() when `packed`
+ParticleTraffic EstimateMultiPassTraffic(uint32_t capacity, uint32_t live, bool packed);
+// ParticlePool::UpdateAndPack()
+ParticleTraffic EstimateFusedTraffic(uint32_t capacity, uint32_t live, uint32_t instances);
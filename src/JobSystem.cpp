@@ -0,0 +1,152 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	struct JobState
+	{
+		std::vector<std::thread> Workers;
+
+		std::mutex SubmitMutex;
+		std::mutex Mutex;
+		std::condition_variable WakeCondition;
+		std::condition_variable DoneCondition;
+
+		const JobSystem::RangeFunc* Func = nullptr;
+		uint32_t Count = 0;
+		uint32_t ChunkSize = 0;
+		uint32_t ChunkCount = 0;
+		std::atomic<uint32_t> NextChunk{ 0 };
+		std::atomic<uint32_t> FinishedChunks{ 0 };
+		uint32_t ActiveWorkers = 0;
+
+		uint64_t Generation = 0;
+		bool Running = false;
+	};
+
+	JobState s_Jobs;
+	thread_local bool s_InsideJob = false;
+
+	void RunChunks(uint32_t threadIndex)
+	{
+		uint32_t finished = 0;
+		for (;;)
+		{
+			uint32_t chunk = s_Jobs.NextChunk.fetch_add(1);
+			if (chunk >= s_Jobs.ChunkCount)
+				break;
+
+			uint32_t begin = chunk * s_Jobs.ChunkSize;
+			uint32_t end = std::min(begin + s_Jobs.ChunkSize, s_Jobs.Count);
+			(*s_Jobs.Func)(begin, end, threadIndex);
+			finished++;
+		}
+
+		if (finished && s_Jobs.FinishedChunks.fetch_add(finished) + finished == s_Jobs.ChunkCount)
+		{
+			std::lock_guard<std::mutex> lock(s_Jobs.Mutex);
+			s_Jobs.DoneCondition.notify_all();
+		}
+	}
+
+	void WorkerMain(uint32_t threadIndex)
+	{
+		s_InsideJob = true;
+
+		uint64_t seenGeneration = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(s_Jobs.Mutex);
+				s_Jobs.WakeCondition.wait(lock, [&] { return !s_Jobs.Running || s_Jobs.Generation != seenGeneration; });
+				if (!s_Jobs.Running)
+					return;
+				seenGeneration = s_Jobs.Generation;
+				s_Jobs.ActiveWorkers++;
+			}
+
+			RunChunks(threadIndex);
+
+			std::lock_guard<std::mutex> lock(s_Jobs.Mutex);
+			if (--s_Jobs.ActiveWorkers == 0)
+				s_Jobs.DoneCondition.notify_all();
+		}
+	}
+
+}
+
+void JobSystem::Init(uint32_t threadCount)
+{
+	if (s_Jobs.Running)
+		return;
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	s_Jobs.Running = true;
+	for (uint32_t i = 1; i < threadCount; i++)
+		s_Jobs.Workers.emplace_back(WorkerMain, i);
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_Jobs.Mutex);
+		s_Jobs.Running = false;
+	}
+	s_Jobs.WakeCondition.notify_all();
+
+	for (auto& worker : s_Jobs.Workers)
+		worker.join();
+	s_Jobs.Workers.clear();
+}
+
+uint32_t JobSystem::GetThreadCount()
+{
+	return (uint32_t)s_Jobs.Workers.size() + 1;
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain, const RangeFunc& func)
+{
+	if (count == 0)
+		return;
+
+	grain = std::max(1u, grain);
+	if (s_InsideJob || s_Jobs.Workers.empty() || count <= grain)
+	{
+		func(0, count, 0);
+		return;
+	}
+
+	std::lock_guard<std::mutex> submitLock(s_Jobs.SubmitMutex);
+
+	uint32_t threads = GetThreadCount();
+	uint32_t chunkSize = std::max(grain, (count + threads * 4 - 1) / (threads * 4));
+	{
+		// Workers that woke up late for the previous job must leave RunChunks before its state is reused
+		std::unique_lock<std::mutex> lock(s_Jobs.Mutex);
+		s_Jobs.DoneCondition.wait(lock, [] { return s_Jobs.ActiveWorkers == 0; });
+
+		s_Jobs.Func = &func;
+		s_Jobs.Count = count;
+		s_Jobs.ChunkSize = chunkSize;
+		s_Jobs.ChunkCount = (count + chunkSize - 1) / chunkSize;
+		s_Jobs.NextChunk = 0;
+		s_Jobs.FinishedChunks = 0;
+		s_Jobs.Generation++;
+	}
+	s_Jobs.WakeCondition.notify_all();
+
+	s_InsideJob = true;
+	RunChunks(0);
+	s_InsideJob = false;
+
+	std::unique_lock<std::mutex> lock(s_Jobs.Mutex);
+	s_Jobs.DoneCondition.wait(lock, [] { return s_Jobs.FinishedChunks.load() == s_Jobs.ChunkCount; });
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Fixed pool of worker threads for data-parallel particle work.
+// The calling thread always takes part as thread index 0, so per-thread
+// scratch data can be indexed with [0, GetThreadCount()).
+class JobSystem
+{
+public:
+	using RangeFunc = std::function<void(uint32_t begin, uint32_t end, uint32_t threadIndex)>;
+
+	// threadCount includes the calling thread; 0 picks hardware_concurrency()
+	static void Init(uint32_t threadCount = 0);
+	static void Shutdown();
+
+	static uint32_t GetThreadCount();
+
+	// Splits [0, count) into chunks of at least `grain` items and blocks until all of them ran.
+	// Calls made from inside a job run inline on the current thread.
+	static void ParallelFor(uint32_t count, uint32_t grain, const RangeFunc& func);
+};
@@ -0,0 +1,1071 @@
+#include "ParticleBehavior.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+enum class TokenType
+{
+	Number, Identifier, Symbol, Assign, Newline, End
+};
+
+struct Token
+{
+	TokenType Type;
+	std::string Text;
+	float Number = 0.0f;
+	uint32_t Line = 1;
+};
+
+static bool Tokenize(const std::string& source, std::vector<Token>& tokens, std::string& error)
+{
+	uint32_t line = 1;
+	size_t i = 0;
+	while (i < source.size())
+	{
+		char c = source[i];
+		char next = i + 1 < source.size() ? source[i + 1] : '\0';
+
+		if (c == '#' || (c == '/' && next == '/'))
+		{
+			while (i < source.size() && source[i] != '\n')
+				i++;
+		}
+		else if (c == '\n' || c == ';')
+		{
+			tokens.push_back({ TokenType::Newline, "", 0.0f, line });
+			if (c == '\n')
+				line++;
+			i++;
+		}
+		else if (std::isspace((unsigned char)c))
+			i++;
+		else if (std::isdigit((unsigned char)c) || (c == '.' && std::isdigit((unsigned char)next)))
+		{
+			char* end;
+			float value = std::strtof(source.c_str() + i, &end);
+			size_t length = end - (source.c_str() + i);
+			tokens.push_back({ TokenType::Number, source.substr(i, length), value, line });
+			i += length;
+		}
+		else if (std::isalpha((unsigned char)c) || c == '_')
+		{
+			size_t start = i;
+			while (i < source.size() && (std::isalnum((unsigned char)source[i]) || source[i] == '_'))
+				i++;
+			tokens.push_back({ TokenType::Identifier, source.substr(start, i - start), 0.0f, line });
+		}
+		else if (std::strchr("+-*/", c) && next == '=')
+		{
+			tokens.push_back({ TokenType::Assign, source.substr(i, 2), 0.0f, line });
+			i += 2;
+		}
+		else if (std::strchr("+-*/(),.=", c))
+		{
+			tokens.push_back({ TokenType::Symbol, std::string(1, c), 0.0f, line });
+			i++;
+		}
+		else
+		{
+			error = "line " + std::to_string(line) + ": unexpected character '" + c + "'";
+			return false;
+		}
+	}
+	tokens.push_back({ TokenType::End, "", 0.0f, line });
+	return true;
+}
+
+struct StreamName
+{
+	const char* Name;
+	uint8_t First, Width;
+	bool Writable;
+};
+
+static const StreamName s_StreamNames[] = {
+	{ "pos", ParticleBehavior::PosX, 2, true },
+	{ "vel", ParticleBehavior::VelX, 2, true },
+	{ "color", ParticleBehavior::ColorR, 4, true },
+	{ "size", ParticleBehavior::Size, 1, true },
+	{ "rotation", ParticleBehavior::Rotation, 1, true },
+	{ "age", ParticleBehavior::Age, 1, false },
+	{ "life", ParticleBehavior::Life, 1, false },
+	{ "lifetime", ParticleBehavior::LifeTime, 1, false },
+	{ "dt", ParticleBehavior::Dt, 1, false },
+	{ "time", ParticleBehavior::Time, 1, false },
+};
+
+static constexpr uint32_t s_PositionStreams = (1u << ParticleBehavior::PosX) | (1u << ParticleBehavior::PosY);
+static constexpr uint32_t s_VelocityStreams = (1u << ParticleBehavior::VelX) | (1u << ParticleBehavior::VelY);
+static constexpr uint32_t s_ColorStreams = (1u << ParticleBehavior::ColorR) | (1u << ParticleBehavior::ColorG) | (1u << ParticleBehavior::ColorB) | (1u << ParticleBehavior::ColorA);
+static constexpr uint32_t s_LifeStreams = (1u << ParticleBehavior::Age) | (1u << ParticleBehavior::Life) | (1u << ParticleBehavior::LifeTime);
+
+static const StreamName* FindStream(const std::string& name)
+{
+	for (const StreamName& stream : s_StreamNames)
+	{
+		if (name == stream.Name)
+			return &stream;
+	}
+	return nullptr;
+}
+
+static uint32_t SourceCount(ParticleBehavior::Op op)
+{
+	using Op = ParticleBehavior::Op;
+	switch (op)
+	{
+		case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Min: case Op::Max:
+			return 2;
+		case Op::Mix: case Op::Clamp:
+			return 3;
+		default:
+			return 1;
+	}
+}
+
+// Recursive descent straight to bytecode. Vector expressions are scalarized:
+// every component gets its own register, so the VM only ever sees scalar ops.
+// Instructions that only read uniform registers go to the prologue.
+class BehaviorCompiler
+{
+public:
+	using Op = ParticleBehavior::Op;
+
+	BehaviorCompiler(ParticleBehavior& behavior, const std::vector<Token>& tokens)
+		: m_Behavior(behavior), m_Tokens(tokens)
+	{
+		m_Uniform[ParticleBehavior::Dt] = m_Uniform[ParticleBehavior::Time] = true;
+	}
+
+	bool Compile(std::string& error)
+	{
+		while (Peek().Type != TokenType::End)
+		{
+			if (Accept(TokenType::Newline))
+				continue;
+
+			if (!ParseStatement() || (Peek().Type != TokenType::Newline && Peek().Type != TokenType::End && !Fail("expected end of statement")))
+			{
+				error = m_Error;
+				return false;
+			}
+		}
+		return true;
+	}
+private:
+	struct Value
+	{
+		uint8_t Width = 0;
+		uint8_t Regs[4] = {};
+
+		uint8_t Component(uint32_t index) const { return Regs[Width == 1 ? 0 : index]; }
+	};
+
+	const Token& Peek() const { return m_Tokens[m_Cursor]; }
+	const Token& Next() { return m_Tokens[m_Cursor < m_Tokens.size() - 1 ? m_Cursor++ : m_Cursor]; }
+
+	bool Accept(TokenType type, const char* text = nullptr)
+	{
+		if (Peek().Type != type || (text && Peek().Text != text))
+			return false;
+		m_Cursor++;
+		return true;
+	}
+
+	bool Expect(const char* symbol)
+	{
+		return Accept(TokenType::Symbol, symbol) || Fail(std::string("expected '") + symbol + "'");
+	}
+
+	bool Fail(const std::string& message)
+	{
+		if (m_Error.empty())
+			m_Error = "line " + std::to_string(Peek().Line) + ": " + message;
+		return false;
+	}
+
+	bool Allocate(uint32_t count, uint8_t& reg)
+	{
+		if (m_Behavior.m_RegisterCount + count > ParticleBehavior::MaxRegisters)
+			return Fail("behavior is too large");
+		reg = (uint8_t)m_Behavior.m_RegisterCount;
+		m_Behavior.m_RegisterCount += count;
+		return true;
+	}
+
+	bool Constant(float value, uint8_t& reg)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		auto it = m_Literals.find(bits);
+		if (it != m_Literals.end())
+		{
+			reg = it->second;
+			return true;
+		}
+
+		if (!Allocate(1, reg))
+			return false;
+		m_Behavior.m_Constants.push_back({ reg, value });
+		m_Literals[bits] = reg;
+		m_Uniform[reg] = true;
+		return true;
+	}
+
+	void Push(const ParticleBehavior::Instruction& instruction)
+	{
+		const uint8_t sources[] = { instruction.A, instruction.B, instruction.C };
+		bool uniform = instruction.Dst >= ParticleBehavior::StreamCount;
+		for (uint32_t i = 0; i < SourceCount(instruction.Opcode); i++)
+			uniform &= m_Uniform[sources[i]];
+
+		if (uniform)
+		{
+			uint32_t width = instruction.Opcode == Op::Gradient ? 4 : 1;
+			for (uint32_t i = 0; i < width; i++)
+				m_Uniform[instruction.Dst + i] = true;
+			m_Behavior.m_Prologue.push_back(instruction);
+		}
+		else
+			m_Behavior.m_Code.push_back(instruction);
+	}
+
+	bool Emit(Op op, uint8_t& dst, uint8_t a, uint8_t b = 0, uint8_t c = 0)
+	{
+		if (!Allocate(1, dst))
+			return false;
+		Push({ op, dst, a, b, c });
+		return true;
+	}
+
+	bool Unary(Op op, const Value& a, Value& result)
+	{
+		Value out;
+		out.Width = a.Width;
+		for (uint32_t c = 0; c < out.Width; c++)
+		{
+			if (!Emit(op, out.Regs[c], a.Regs[c]))
+				return false;
+		}
+		result = out;
+		return true;
+	}
+
+	bool Binary(Op op, const Value& a, const Value& b, Value& result)
+	{
+		if (a.Width != b.Width && a.Width != 1 && b.Width != 1)
+			return Fail("mismatched vector sizes");
+
+		Value out;
+		out.Width = std::max(a.Width, b.Width);
+		for (uint32_t c = 0; c < out.Width; c++)
+		{
+			if (!Emit(op, out.Regs[c], a.Component(c), b.Component(c)))
+				return false;
+		}
+		result = out;
+		return true;
+	}
+
+	bool Ternary(Op op, const Value& a, const Value& b, const Value& t, Value& result)
+	{
+		uint8_t width = std::max({ a.Width, b.Width, t.Width });
+		for (const Value* value : { &a, &b, &t })
+		{
+			if (value->Width != 1 && value->Width != width)
+				return Fail("mismatched vector sizes");
+		}
+
+		Value out;
+		out.Width = width;
+		for (uint32_t c = 0; c < width; c++)
+		{
+			if (!Emit(op, out.Regs[c], a.Component(c), b.Component(c), t.Component(c)))
+				return false;
+		}
+		result = out;
+		return true;
+	}
+
+	bool Swizzle(Value& value, const std::string& components)
+	{
+		if (components.empty() || components.size() > 4)
+			return Fail("invalid component access '." + components + "'");
+
+		Value out;
+		out.Width = (uint8_t)components.size();
+		for (size_t i = 0; i < components.size(); i++)
+		{
+			size_t index = std::string("xyzw").find(components[i]);
+			if (index == std::string::npos)
+				index = std::string("rgba").find(components[i]);
+			if (index == std::string::npos || index >= value.Width)
+				return Fail("invalid component access '." + components + "'");
+			out.Regs[i] = value.Regs[index];
+		}
+		value = out;
+		return true;
+	}
+
+	bool ParseNumber(float& value)
+	{
+		bool negative = Accept(TokenType::Symbol, "-");
+		if (Peek().Type != TokenType::Number)
+			return Fail("expected a number");
+		value = negative ? -Next().Number : Next().Number;
+		return true;
+	}
+
+	// number | vec2(n, n) | vec4(n, n, n, n)
+	bool ParseConstant(float* values, uint8_t& width)
+	{
+		if (Peek().Type != TokenType::Identifier)
+		{
+			width = 1;
+			return ParseNumber(values[0]);
+		}
+
+		std::string name = Next().Text;
+		width = name == "vec2" ? 2 : name == "vec4" ? 4 : 0;
+		if (width == 0)
+			return Fail("expected a constant");
+		if (!Expect("("))
+			return false;
+		for (uint32_t c = 0; c < width; c++)
+		{
+			if ((c > 0 && !Expect(",")) || !ParseNumber(values[c]))
+				return false;
+		}
+		return Expect(")");
+	}
+
+	bool ParseStatement()
+	{
+		if (Peek().Type != TokenType::Identifier)
+			return Fail("expected a statement");
+
+		if (Peek().Text == "param")
+			return ParseParam();
+		if (Peek().Text == "gradient" && m_Tokens[m_Cursor + 1].Type == TokenType::Identifier)
+			return ParseGradient();
+		return ParseAssignment();
+	}
+
+	bool IsNameTaken(const std::string& name) const
+	{
+		return FindStream(name) || m_Behavior.m_Params.count(name) || m_Locals.count(name) || m_Gradients.count(name);
+	}
+
+	// param name = constant
+	bool ParseParam()
+	{
+		Next();
+		if (Peek().Type != TokenType::Identifier)
+			return Fail("expected a param name");
+		std::string name = Next().Text;
+		if (IsNameTaken(name))
+			return Fail("'" + name + "' is already defined");
+
+		float values[4];
+		uint8_t width = 0, reg = 0;
+		if (!Expect("=") || !ParseConstant(values, width) || !Allocate(width, reg))
+			return false;
+
+		for (uint32_t c = 0; c < width; c++)
+		{
+			m_Behavior.m_Constants.push_back({ (uint8_t)(reg + c), values[c] });
+			m_Uniform[reg + c] = true;
+		}
+		m_Behavior.m_Params[name] = { reg, width };
+		return true;
+	}
+
+	// gradient name = t (r, g, b[, a]), t (r, g, b[, a]), ...
+	bool ParseGradient()
+	{
+		Next();
+		std::string name = Next().Text;
+		if (IsNameTaken(name))
+			return Fail("'" + name + "' is already defined");
+		if (!Expect("="))
+			return false;
+
+		ParticleBehavior::Gradient gradient;
+		do
+		{
+			float stop;
+			glm::vec4 color(1.0f);
+			if (!ParseNumber(stop) || !Expect("("))
+				return false;
+			if (!gradient.Stops.empty() && stop < gradient.Stops.back())
+				return Fail("gradient stops must be in increasing order");
+
+			uint32_t count = 0;
+			do
+			{
+				if (count == 4)
+					return Fail("gradient colors have at most 4 components");
+				if (!ParseNumber(color[count++]))
+					return false;
+			} while (Accept(TokenType::Symbol, ","));
+			if (count < 3)
+				return Fail("gradient colors need at least 3 components");
+			if (!Expect(")"))
+				return false;
+
+			gradient.Stops.push_back(stop);
+			gradient.Colors.push_back(color);
+		} while (Accept(TokenType::Symbol, ","));
+
+		if (m_Behavior.m_Gradients.size() == 256)
+			return Fail("too many gradients");
+		m_Gradients[name] = (uint8_t)m_Behavior.m_Gradients.size();
+		m_Behavior.m_Gradients.push_back(std::move(gradient));
+		return true;
+	}
+
+	// target [.components] (= | += | -= | *= | /=) expression
+	bool ParseAssignment()
+	{
+		std::string name = Next().Text;
+		std::string components;
+		if (Accept(TokenType::Symbol, "."))
+		{
+			if (Peek().Type != TokenType::Identifier)
+				return Fail("expected components after '.'");
+			components = Next().Text;
+		}
+
+		bool compound = Peek().Type == TokenType::Assign;
+		Op op = Op::Move;
+		if (compound)
+		{
+			const char* ops = "+-*/";
+			const Op compoundOps[] = { Op::Add, Op::Sub, Op::Mul, Op::Div };
+			op = compoundOps[std::strchr(ops, Peek().Text[0]) - ops];
+			Next();
+		}
+		else if (!Expect("="))
+			return false;
+
+		uint32_t firstTemp = m_Behavior.m_RegisterCount;
+		Value value;
+		if (!ParseExpression(value))
+			return false;
+
+		if (const StreamName* stream = FindStream(name))
+		{
+			if (!stream->Writable)
+				return Fail("'" + name + "' is read-only");
+
+			Value target;
+			target.Width = stream->Width;
+			for (uint32_t c = 0; c < target.Width; c++)
+				target.Regs[c] = stream->First + c;
+			if (!components.empty() && !Swizzle(target, components))
+				return false;
+			return Store(target, value, op, firstTemp);
+		}
+
+		if (m_Behavior.m_Params.count(name))
+			return Fail("param '" + name + "' is read-only");
+		if (m_Gradients.count(name))
+			return Fail("'" + name + "' is a gradient");
+		if (!components.empty())
+			return Fail("cannot assign components of local '" + name + "'");
+
+		if (compound)
+		{
+			auto it = m_Locals.find(name);
+			if (it == m_Locals.end())
+				return Fail("unknown name '" + name + "'");
+			if (!Binary(op, it->second, value, value))
+				return false;
+		}
+
+		// Locals must not follow later writes to the streams they were read from
+		for (uint32_t c = 0; c < value.Width; c++)
+		{
+			if (value.Regs[c] < ParticleBehavior::StreamCount && !Emit(Op::Move, value.Regs[c], value.Regs[c]))
+				return false;
+		}
+		m_Locals[name] = value;
+		return true;
+	}
+
+	// `firstTemp`: registers from here on were allocated by the statement being stored
+	bool Store(const Value& target, Value value, Op op, uint32_t firstTemp)
+	{
+		if (value.Width != target.Width && value.Width != 1)
+			return Fail("cannot assign a vec" + std::to_string(value.Width) + " to a " +
+				(target.Width == 1 ? std::string("float") : "vec" + std::to_string(target.Width)));
+
+		// A component written first must not feed a later one (vel = vel.yx)
+		bool overlaps = false;
+		for (uint32_t c = 0; c < target.Width; c++)
+		{
+			for (uint32_t d = c + 1; d < target.Width; d++)
+				overlaps |= value.Component(d) == target.Regs[c];
+		}
+		if (overlaps && !Unary(Op::Move, value, value))
+			return false;
+
+		bool retargeted = op == Op::Move && !overlaps && Retarget(target, value, firstTemp);
+		for (uint32_t c = 0; c < target.Width; c++)
+		{
+			uint8_t dst = target.Regs[c];
+			if (retargeted)
+				;
+			else if (op == Op::Move)
+				Push({ Op::Move, dst, value.Component(c), 0, 0 });
+			else
+				Push({ op, dst, dst, value.Component(c), 0 });
+			m_Behavior.m_WrittenStreams |= 1u << dst;
+		}
+		return true;
+	}
+
+	// Lets the instructions that computed a fresh value write the stream directly instead of going
+	// through one Move per component. Only when nothing after them reads the value again or touches
+	// the stream, so every component still sees the stream as it was before the statement.
+	bool Retarget(const Value& target, const Value& value, uint32_t firstTemp)
+	{
+		std::vector<ParticleBehavior::Instruction>& code = m_Behavior.m_Code;
+		if (value.Width != target.Width)
+			return false;
+
+		size_t producers[4];
+		for (uint32_t c = 0; c < value.Width; c++)
+		{
+			uint8_t reg = value.Regs[c];
+			if (reg < firstTemp)
+				return false;
+			for (uint32_t d = 0; d < c; d++)
+			{
+				if (value.Regs[d] == reg)
+					return false;
+			}
+
+			// Temporaries are written once; uniform ones sit in the prologue and stay there
+			size_t i = code.size();
+			while (i > 0 && !(code[i - 1].Dst == reg || (code[i - 1].Opcode == Op::Gradient && reg > code[i - 1].Dst && reg < code[i - 1].Dst + 4)))
+				i--;
+			if (i == 0)
+				return false;
+			const ParticleBehavior::Instruction& producer = code[i - 1];
+			if (producer.Opcode == Op::Gradient && (target.Width != 4 || reg != producer.Dst + c || target.Regs[c] != target.Regs[0] + c))
+				return false;
+			producers[c] = i - 1;
+		}
+
+		for (uint32_t c = 0; c < value.Width; c++)
+		{
+			for (size_t j = producers[c] + 1; j < code.size(); j++)
+			{
+				const ParticleBehavior::Instruction& instruction = code[j];
+				const uint8_t sources[] = { instruction.A, instruction.B, instruction.C };
+				for (uint32_t k = 0; k < SourceCount(instruction.Opcode); k++)
+				{
+					if (sources[k] == value.Regs[c] || sources[k] == target.Regs[c])
+						return false;
+				}
+				uint32_t width = instruction.Opcode == Op::Gradient ? 4 : 1;
+				if (target.Regs[c] >= instruction.Dst && target.Regs[c] < instruction.Dst + width)
+					return false;
+			}
+		}
+
+		for (uint32_t c = 0; c < value.Width; c++)
+			code[producers[c]].Dst = code[producers[c]].Opcode == Op::Gradient ? target.Regs[0] : target.Regs[c];
+		return true;
+	}
+
+	bool ParseExpression(Value& result)
+	{
+		if (!ParseTerm(result))
+			return false;
+		while (true)
+		{
+			Op op;
+			if (Accept(TokenType::Symbol, "+"))
+				op = Op::Add;
+			else if (Accept(TokenType::Symbol, "-"))
+				op = Op::Sub;
+			else
+				return true;
+
+			Value rhs;
+			if (!ParseTerm(rhs) || !Binary(op, result, rhs, result))
+				return false;
+		}
+	}
+
+	bool ParseTerm(Value& result)
+	{
+		if (!ParseUnary(result))
+			return false;
+		while (true)
+		{
+			Op op;
+			if (Accept(TokenType::Symbol, "*"))
+				op = Op::Mul;
+			else if (Accept(TokenType::Symbol, "/"))
+				op = Op::Div;
+			else
+				return true;
+
+			Value rhs;
+			if (!ParseUnary(rhs) || !Binary(op, result, rhs, result))
+				return false;
+		}
+	}
+
+	bool ParseUnary(Value& result)
+	{
+		if (!Accept(TokenType::Symbol, "-"))
+			return ParsePostfix(result);
+
+		// Fold negative literals instead of negating at runtime
+		if (Peek().Type == TokenType::Number)
+		{
+			result.Width = 1;
+			return Constant(-Next().Number, result.Regs[0]);
+		}
+		return ParseUnary(result) && Unary(Op::Neg, result, result);
+	}
+
+	bool ParsePostfix(Value& result)
+	{
+		if (!ParsePrimary(result))
+			return false;
+		while (Accept(TokenType::Symbol, "."))
+		{
+			if (Peek().Type != TokenType::Identifier)
+				return Fail("expected components after '.'");
+			if (!Swizzle(result, Next().Text))
+				return false;
+		}
+		return true;
+	}
+
+	bool ParsePrimary(Value& result)
+	{
+		if (Peek().Type == TokenType::Number)
+		{
+			result.Width = 1;
+			return Constant(Next().Number, result.Regs[0]);
+		}
+
+		if (Accept(TokenType::Symbol, "("))
+			return ParseExpression(result) && Expect(")");
+
+		if (Peek().Type != TokenType::Identifier)
+			return Fail(Peek().Type == TokenType::End || Peek().Type == TokenType::Newline ? "unexpected end of statement" : "unexpected '" + Peek().Text + "'");
+
+		std::string name = Next().Text;
+		if (Accept(TokenType::Symbol, "("))
+			return ParseCall(name, result);
+
+		if (const StreamName* stream = FindStream(name))
+		{
+			result.Width = stream->Width;
+			for (uint32_t c = 0; c < result.Width; c++)
+				result.Regs[c] = stream->First + c;
+			return true;
+		}
+
+		auto local = m_Locals.find(name);
+		if (local != m_Locals.end())
+		{
+			result = local->second;
+			return true;
+		}
+
+		auto param = m_Behavior.m_Params.find(name);
+		if (param != m_Behavior.m_Params.end())
+		{
+			result.Width = param->second.Width;
+			for (uint32_t c = 0; c < result.Width; c++)
+				result.Regs[c] = param->second.Register + c;
+			return true;
+		}
+		return Fail("unknown name '" + name + "'");
+	}
+
+	bool ParseCall(const std::string& name, Value& result)
+	{
+		if (name == "gradient")
+			return ParseGradientCall(result);
+
+		std::vector<Value> args;
+		if (!Accept(TokenType::Symbol, ")"))
+		{
+			do
+			{
+				if (!ParseExpression(args.emplace_back()))
+					return false;
+			} while (Accept(TokenType::Symbol, ","));
+			if (!Expect(")"))
+				return false;
+		}
+
+		auto expectArgs = [&](size_t count)
+		{
+			return args.size() == count || Fail(name + "() takes " + std::to_string(count) + " argument" + (count > 1 ? "s" : ""));
+		};
+
+		if (name == "vec2" || name == "vec4")
+		{
+			uint32_t width = name == "vec2" ? 2 : 4;
+			Value out;
+			for (const Value& arg : args)
+			{
+				for (uint32_t c = 0; c < arg.Width; c++)
+				{
+					if (out.Width == width)
+						return Fail("too many components for " + name);
+					out.Regs[out.Width++] = arg.Regs[c];
+				}
+			}
+			// vec4(x) splats like GLSL
+			if (out.Width == 1)
+			{
+				out.Width = (uint8_t)width;
+				for (uint32_t c = 1; c < width; c++)
+					out.Regs[c] = out.Regs[0];
+			}
+			if (out.Width != width)
+				return Fail("too few components for " + name);
+			result = out;
+			return true;
+		}
+
+		struct UnaryFunction
+		{
+			const char* Name;
+			Op Opcode;
+		};
+		static const UnaryFunction unaryFunctions[] = {
+			{ "sin", Op::Sin }, { "cos", Op::Cos }, { "abs", Op::Abs },
+			{ "sqrt", Op::Sqrt }, { "floor", Op::Floor }, { "fract", Op::Fract },
+		};
+		for (const UnaryFunction& function : unaryFunctions)
+		{
+			if (name == function.Name)
+				return expectArgs(1) && Unary(function.Opcode, args[0], result);
+		}
+
+		if (name == "min" || name == "max")
+			return expectArgs(2) && Binary(name == "min" ? Op::Min : Op::Max, args[0], args[1], result);
+		if (name == "mix" || name == "clamp")
+			return expectArgs(3) && Ternary(name == "mix" ? Op::Mix : Op::Clamp, args[0], args[1], args[2], result);
+
+		if (name == "length")
+		{
+			if (!expectArgs(1))
+				return false;
+			Value squared, sum;
+			if (!Binary(Op::Mul, args[0], args[0], squared))
+				return false;
+			sum.Width = 1;
+			sum.Regs[0] = squared.Regs[0];
+			for (uint32_t c = 1; c < squared.Width; c++)
+			{
+				if (!Emit(Op::Add, sum.Regs[0], sum.Regs[0], squared.Regs[c]))
+					return false;
+			}
+			return Unary(Op::Sqrt, sum, result);
+		}
+		return Fail("unknown function '" + name + "'");
+	}
+
+	// gradient(name, t), or gradient(t) for the most recently declared gradient
+	bool ParseGradientCall(Value& result)
+	{
+		if (m_Behavior.m_Gradients.empty())
+			return Fail("no gradient declared");
+
+		uint8_t index = (uint8_t)(m_Behavior.m_Gradients.size() - 1);
+		if (Peek().Type == TokenType::Identifier && m_Tokens[m_Cursor + 1].Type == TokenType::Symbol && m_Tokens[m_Cursor + 1].Text == ",")
+		{
+			auto it = m_Gradients.find(Peek().Text);
+			if (it == m_Gradients.end())
+				return Fail("unknown gradient '" + Peek().Text + "'");
+			index = it->second;
+			Next();
+			Next();
+		}
+
+		Value t;
+		if (!ParseExpression(t) || !Expect(")"))
+			return false;
+		if (t.Width != 1)
+			return Fail("gradient() takes a float position");
+
+		uint8_t reg = 0;
+		if (!Allocate(4, reg))
+			return false;
+		Push({ Op::Gradient, reg, t.Regs[0], index, 0 });
+
+		result.Width = 4;
+		for (uint32_t c = 0; c < 4; c++)
+			result.Regs[c] = reg + c;
+		return true;
+	}
+private:
+	ParticleBehavior& m_Behavior;
+	const std::vector<Token>& m_Tokens;
+	size_t m_Cursor = 0;
+	std::string m_Error;
+
+	std::unordered_map<std::string, Value> m_Locals;
+	std::unordered_map<std::string, uint8_t> m_Gradients;
+	std::unordered_map<uint32_t, uint8_t> m_Literals;
+	bool m_Uniform[ParticleBehavior::MaxRegisters] = {};
+};
+
+std::shared_ptr<ParticleBehavior> ParticleBehavior::Compile(const std::string& source, std::string& error)
+{
+	std::vector<Token> tokens;
+	if (!Tokenize(source, tokens, error))
+		return nullptr;
+
+	auto behavior = std::make_shared<ParticleBehavior>();
+	BehaviorCompiler compiler(*behavior, tokens);
+	if (!compiler.Compile(error))
+		return nullptr;
+
+	// Only streams the program reads are gathered, plus the components of partially written vectors
+	// that Scatter() stores back unchanged
+	for (const Instruction& instruction : behavior->m_Code)
+	{
+		const uint8_t operands[] = { instruction.A, instruction.B, instruction.C };
+		for (uint32_t i = 0; i < SourceCount(instruction.Opcode); i++)
+		{
+			if (operands[i] < StreamCount)
+				behavior->m_ReadStreams |= 1u << operands[i];
+		}
+	}
+	const uint32_t written = behavior->m_WrittenStreams;
+	for (uint32_t vector : { s_PositionStreams, s_VelocityStreams, s_ColorStreams })
+	{
+		if (written & vector)
+			behavior->m_ReadStreams |= vector & ~written;
+	}
+	return behavior;
+}
+
+std::shared_ptr<ParticleBehavior> ParticleBehavior::FromFile(const std::string& filepath, std::string& error)
+{
+	std::ifstream stream(filepath);
+	if (!stream)
+	{
+		error = "could not open " + filepath;
+		return nullptr;
+	}
+
+	std::stringstream source;
+	source << stream.rdbuf();
+	auto behavior = Compile(source.str(), error);
+	if (!behavior)
+		error = filepath + ": " + error;
+	return behavior;
+}
+
+bool ParticleBehavior::SetParam(const std::string& name, const glm::vec4& value)
+{
+	auto it = m_Params.find(name);
+	if (it == m_Params.end())
+		return false;
+
+	for (auto& [reg, constant] : m_Constants)
+	{
+		if (reg >= it->second.Register && reg < it->second.Register + it->second.Width)
+			constant = value[reg - it->second.Register];
+	}
+	return true;
+}
+
+void ParticleBehavior::Gather(const std::vector<Particle>& particles, const uint32_t* indices, uint32_t lanes, float (*registers)[BatchSize]) const
+{
+	const uint32_t read = m_ReadStreams;
+	for (uint32_t lane = 0; lane < lanes; lane++)
+	{
+		const Particle& particle = particles[indices[lane]];
+		float life = particle.LifeRemaining / particle.LifeTime;
+
+		if (read & s_PositionStreams)
+		{
+			registers[PosX][lane] = particle.Position.x;
+			registers[PosY][lane] = particle.Position.y;
+		}
+		if (read & s_VelocityStreams)
+		{
+			registers[VelX][lane] = particle.Velocity.x;
+			registers[VelY][lane] = particle.Velocity.y;
+		}
+		if (read & s_ColorStreams)
+		{
+			glm::vec4 color = glm::mix(particle.ColorEnd, particle.ColorBegin, life);
+			registers[ColorR][lane] = color.r;
+			registers[ColorG][lane] = color.g;
+			registers[ColorB][lane] = color.b;
+			registers[ColorA][lane] = color.a;
+		}
+		if (read & (1u << Size))
+			registers[Size][lane] = glm::mix(particle.SizeEnd, particle.SizeBegin, life);
+		if (read & (1u << Rotation))
+			registers[Rotation][lane] = particle.Rotation;
+		if (read & s_LifeStreams)
+		{
+			registers[Age][lane] = 1.0f - life;
+			registers[Life][lane] = particle.LifeRemaining;
+			registers[LifeTime][lane] = particle.LifeTime;
+		}
+	}
+}
+
+void ParticleBehavior::Scatter(std::vector<Particle>& particles, const uint32_t* indices, uint32_t lanes, float (*registers)[BatchSize]) const
+{
+	// Local copy: stores to particles could otherwise alias the member and force a reload per lane
+	const uint32_t written = m_WrittenStreams;
+	for (uint32_t lane = 0; lane < lanes; lane++)
+	{
+		Particle& particle = particles[indices[lane]];
+		if (written & s_PositionStreams)
+			particle.Position = { registers[PosX][lane], registers[PosY][lane] };
+		if (written & s_VelocityStreams)
+			particle.Velocity = { registers[VelX][lane], registers[VelY][lane] };
+		if (written & s_ColorStreams)
+			particle.ColorBegin = particle.ColorEnd = { registers[ColorR][lane], registers[ColorG][lane], registers[ColorB][lane], registers[ColorA][lane] };
+		if (written & (1u << Size))
+			particle.SizeBegin = particle.SizeEnd = registers[Size][lane];
+		if (written & (1u << Rotation))
+			particle.Rotation = registers[Rotation][lane];
+	}
+}
+
+// Evaluates into a local array so the compiler can vectorize without alias checks (dst may be a source)
+template<typename Func>
+static inline void Lanes(float* dst, Func func)
+{
+	alignas(64) float result[ParticleBehavior::BatchSize];
+	for (uint32_t i = 0; i < ParticleBehavior::BatchSize; i++)
+		result[i] = func(i);
+	std::memcpy(dst, result, sizeof(result));
+}
+
+void ParticleBehavior::Run(const std::vector<Instruction>& code, float (*registers)[BatchSize]) const
+{
+	for (const Instruction& instruction : code)
+	{
+		float* dst = registers[instruction.Dst];
+		const float* a = registers[instruction.A];
+		const float* b = registers[instruction.B];
+		const float* c = registers[instruction.C];
+
+		switch (instruction.Opcode)
+		{
+			case Op::Move:  Lanes(dst, [=](uint32_t i) { return a[i]; }); break;
+			case Op::Add:   Lanes(dst, [=](uint32_t i) { return a[i] + b[i]; }); break;
+			case Op::Sub:   Lanes(dst, [=](uint32_t i) { return a[i] - b[i]; }); break;
+			case Op::Mul:   Lanes(dst, [=](uint32_t i) { return a[i] * b[i]; }); break;
+			case Op::Div:   Lanes(dst, [=](uint32_t i) { return a[i] / b[i]; }); break;
+			case Op::Neg:   Lanes(dst, [=](uint32_t i) { return -a[i]; }); break;
+			case Op::Min:   Lanes(dst, [=](uint32_t i) { return b[i] < a[i] ? b[i] : a[i]; }); break;
+			case Op::Max:   Lanes(dst, [=](uint32_t i) { return a[i] < b[i] ? b[i] : a[i]; }); break;
+			case Op::Sin:   Lanes(dst, [=](uint32_t i) { return std::sin(a[i]); }); break;
+			case Op::Cos:   Lanes(dst, [=](uint32_t i) { return std::cos(a[i]); }); break;
+			case Op::Abs:   Lanes(dst, [=](uint32_t i) { return std::fabs(a[i]); }); break;
+			case Op::Sqrt:  Lanes(dst, [=](uint32_t i) { return std::sqrt(a[i]); }); break;
+			case Op::Floor: Lanes(dst, [=](uint32_t i) { return std::floor(a[i]); }); break;
+			case Op::Fract: Lanes(dst, [=](uint32_t i) { return a[i] - std::floor(a[i]); }); break;
+			case Op::Mix:   Lanes(dst, [=](uint32_t i) { return a[i] + (b[i] - a[i]) * c[i]; }); break;
+			case Op::Clamp: Lanes(dst, [=](uint32_t i) { float x = a[i] < b[i] ? b[i] : a[i]; return c[i] < x ? c[i] : x; }); break;
+			case Op::Gradient:
+			{
+				// Branch-free per lane: the segment is the number of inner stops t is past, and clamped
+				// lanes blend with weight 0, which gives the stop's color exactly as the branchy lookup did
+				const Gradient& gradient = m_Gradients[instruction.B];
+				const float* stops = gradient.Stops.data();
+				const glm::vec4* colors = gradient.Colors.data();
+				const uint32_t last = (uint32_t)gradient.Stops.size() - 1;
+
+				alignas(64) uint32_t segment[BatchSize];
+				for (uint32_t i = 0; i < BatchSize; i++)
+				{
+					uint32_t k = 0;
+					for (uint32_t j = 1; j <= last; j++)
+						k += a[i] > stops[j];
+					segment[i] = k;
+				}
+
+				alignas(64) float weight[BatchSize];
+				alignas(64) float channels[4][BatchSize];
+				for (uint32_t i = 0; i < BatchSize; i++)
+				{
+					uint32_t k = segment[i], next = k < last ? k + 1 : k;
+					float t = a[i];
+					weight[i] = k == last || t <= stops[k] ? 0.0f : (t - stops[k]) / (stops[next] - stops[k]);
+					for (uint32_t channel = 0; channel < 4; channel++)
+						channels[channel][i] = colors[k][channel] * (1.0f - weight[i]) + colors[next][channel] * weight[i];
+				}
+				for (uint32_t channel = 0; channel < 4; channel++)
+					std::memcpy(registers[instruction.Dst + channel], channels[channel], sizeof(channels[channel]));
+				break;
+			}
+		}
+	}
+}
+
+void ParticleBehavior::Execute(std::vector<Particle>& particles, float ts, float time) const
+{
+	if (m_Code.empty())
+		return;
+
+	JobSystem::ParallelFor((uint32_t)particles.size(), 4096, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		alignas(64) float registers[MaxRegisters][BatchSize];
+
+		// Lanes past the end of a partial batch keep computing on whatever the last full batch left behind
+		std::memset(registers, 0, sizeof(float) * BatchSize * Dt);
+		std::fill_n(registers[LifeTime], BatchSize, 1.0f);
+		std::fill_n(registers[Dt], BatchSize, ts);
+		std::fill_n(registers[Time], BatchSize, time);
+		for (const auto& [reg, value] : m_Constants)
+			std::fill_n(registers[reg], BatchSize, value);
+		Run(m_Prologue, registers);
+
+		uint32_t indices[BatchSize];
+		uint32_t lanes = 0;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const Particle& particle = particles[i];
+			if (!particle.Active)
+				continue;
+
+			indices[lanes++] = i;
+			if (lanes == BatchSize)
+			{
+				Gather(particles, indices, lanes, registers);
+				Run(m_Code, registers);
+				Scatter(particles, indices, lanes, registers);
+				lanes = 0;
+			}
+		}
+
+		if (lanes > 0)
+		{
+			Gather(particles, indices, lanes, registers);
+			Run(m_Code, registers);
+			Scatter(particles, indices, lanes, registers);
+		}
+	});
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-particle behavior written as a small expression language, e.g.
+//
+//     param gravity = vec2(0, -9.8)
+//     gradient fade = 0.0 (1, 0.8, 0.5, 1), 1.0 (0.2, 0.2, 0.2, 0)
+//     vel += gravity * dt
+//     color = gradient(fade, age)
+//     size = mix(0.5, 0.0, age)
+//
+// Programs compile to a register bytecode where every register holds one
+// scalar for a whole batch of particles. Live particles are gathered into
+// SoA batches of BatchSize, so instruction dispatch is paid once per batch.
+//
+// Particle streams: pos, vel (vec2), color (vec4), size, rotation.
+// Read-only: age (0..1), life (seconds left), lifetime, dt, time.
+// Writing color or size pins both the begin and end values, so the lerp in
+// render prep returns what the program wrote.
+// Functions: vec2, vec4, sin, cos, abs, sqrt, floor, fract, min, max, mix,
+// clamp, length, gradient(name, t). Components: .x .y .z .w / .r .g .b .a
+class ParticleBehavior
+{
+public:
+	static constexpr uint32_t BatchSize = 16;
+	static constexpr uint32_t MaxRegisters = 256;
+
+	// Returns nullptr and fills `error` (with a line number) on failure
+	static std::shared_ptr<ParticleBehavior> Compile(const std::string& source, std::string& error);
+	static std::shared_ptr<ParticleBehavior> FromFile(const std::string& filepath, std::string& error);
+
+	// Params keep their declared width; extra components are ignored
+	bool SetParam(const std::string& name, const glm::vec4& value);
+
+	// Runs on every Active particle; the pool's expiry wheel has already retired the ones out of life
+	void Execute(std::vector<Particle>& particles, float ts, float time) const;
+
+	// Per-batch instructions; uniform work is hoisted out and not counted
+	uint32_t GetInstructionCount() const { return (uint32_t)m_Code.size(); }
+public:
+	enum class Op : uint8_t
+	{
+		Move, Add, Sub, Mul, Div, Neg,
+		Min, Max, Sin, Cos, Abs, Sqrt, Floor, Fract,
+		Mix, Clamp, Gradient
+	};
+
+	struct Instruction
+	{
+		Op Opcode;
+		uint8_t Dst, A, B, C;
+	};
+
+	// Register file layout: streams first, then constants/params, then temporaries
+	enum Stream : uint8_t
+	{
+		PosX = 0, PosY, VelX, VelY, ColorR, ColorG, ColorB, ColorA, Size, Rotation,
+		Age, Life, LifeTime, Dt, Time,
+		StreamCount
+	};
+
+	struct Gradient
+	{
+		std::vector<float> Stops;
+		std::vector<glm::vec4> Colors;
+	};
+private:
+	friend class BehaviorCompiler;
+
+	void Gather(const std::vector<Particle>& particles, const uint32_t* indices, uint32_t lanes, float (*registers)[BatchSize]) const;
+	void Scatter(std::vector<Particle>& particles, const uint32_t* indices, uint32_t lanes, float (*registers)[BatchSize]) const;
+	void Run(const std::vector<Instruction>& code, float (*registers)[BatchSize]) const;
+private:
+	std::vector<Instruction> m_Code;
+	std::vector<Instruction> m_Prologue; // only reads params/constants/dt/time: run once per Execute, not per batch
+	std::vector<Gradient> m_Gradients;
+	uint32_t m_RegisterCount = StreamCount;
+
+	// Constant registers and their values, filled once per Execute
+	std::vector<std::pair<uint8_t, float>> m_Constants;
+	struct Param
+	{
+		uint8_t Register;
+		uint8_t Width;
+	};
+	std::unordered_map<std::string, Param> m_Params;
+
+	uint32_t m_ReadStreams = 0, m_WrittenStreams = 0; // bit per Stream
+};
@@ -0,0 +1,160 @@
+#include "ParticleCanvas.h"
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t MaxCanvasSize = 4096;
+
+ParticleCanvas::ParticleCanvas()
+{
+	SetProps(m_Props);
+}
+
+void ParticleCanvas::SetProps(const ParticleCanvasProps& props)
+{
+	m_Props = props;
+	m_TileSize = std::clamp(props.TileSize, 8u, 256u);
+	m_TexelsPerUnit = std::max(props.TexelsPerUnit, 1e-3f);
+
+	glm::vec2 tiles = glm::ceil(glm::max(props.Max - props.Min, glm::vec2(0.0f)) * m_TexelsPerUnit / (float)m_TileSize);
+	m_TilesX = std::clamp((uint32_t)tiles.x, 1u, MaxCanvasSize / m_TileSize);
+	m_TilesY = std::clamp((uint32_t)tiles.y, 1u, MaxCanvasSize / m_TileSize);
+	m_Min = props.Min;
+	m_Max = m_Min + glm::vec2((float)GetWidth(), (float)GetHeight()) / m_TexelsPerUnit;
+
+	m_Texels.assign((size_t)GetWidth() * GetHeight() * 4, 0);
+	m_TileDirty.assign(GetTileCount(), 0);
+	m_DirtyTiles.clear();
+	for (uint32_t tile = 0; tile < GetTileCount(); tile++)
+		MarkDirty(tile);
+	m_StampedCount = 0;
+}
+
+void ParticleCanvas::Clear()
+{
+	std::fill(m_Texels.begin(), m_Texels.end(), (uint8_t)0);
+	for (uint32_t tile = 0; tile < GetTileCount(); tile++)
+		MarkDirty(tile);
+}
+
+void ParticleCanvas::MarkDirty(uint32_t tile)
+{
+	if (m_TileDirty[tile])
+		return;
+	m_TileDirty[tile] = 1;
+	m_DirtyTiles.push_back(tile);
+}
+
+void ParticleCanvas::ClearDirtyTiles()
+{
+	for (uint32_t tile : m_DirtyTiles)
+		m_TileDirty[tile] = 0;
+	m_DirtyTiles.clear();
+}
+
+void ParticleCanvas::Stamp(const ParticleInstance* instances, uint32_t count)
+{
+	if (count == 0)
+		return;
+	m_StampedCount += count;
+
+	// Tiles under each quad's rotated bounds, counted per tile
+	uint32_t tileCount = GetTileCount();
+	float tilesPerUnit = m_TexelsPerUnit / m_TileSize;
+	m_QuadTiles.resize(count);
+	m_TileStart.assign(tileCount + 1, 0);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const ParticleInstance& instance = instances[i];
+		float reach = std::abs(instance.Size) * 0.5f * (std::abs(std::cos(instance.Rotation)) + std::abs(std::sin(instance.Rotation)));
+		glm::vec2 low = (instance.Position - reach - m_Min) * tilesPerUnit;
+		glm::vec2 high = (instance.Position + reach - m_Min) * tilesPerUnit;
+
+		glm::ivec4& range = m_QuadTiles[i];
+		if (!(high.x >= 0.0f && high.y >= 0.0f && low.x < (float)m_TilesX && low.y < (float)m_TilesY) || instance.Color.a <= 0.0f)
+		{
+			range = { 0, 0, -1, -1 };
+			continue;
+		}
+		range = { std::max((int)low.x, 0), std::max((int)low.y, 0),
+			std::min((int)high.x, (int)m_TilesX - 1), std::min((int)high.y, (int)m_TilesY - 1) };
+		for (int y = range.y; y <= range.w; y++)
+		{
+			for (int x = range.x; x <= range.z; x++)
+				m_TileStart[(size_t)y * m_TilesX + x + 1]++;
+		}
+	}
+
+	m_Touched.clear();
+	for (uint32_t tile = 0; tile < tileCount; tile++)
+	{
+		if (m_TileStart[tile + 1])
+		{
+			m_Touched.push_back(tile);
+			MarkDirty(tile);
+		}
+		m_TileStart[tile + 1] += m_TileStart[tile];
+	}
+
+	// In quad order, so every tile blends its quads as they were given; tile t ends up as [start[t - 1], start[t])
+	m_TileQuads.resize(m_TileStart[tileCount]);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const glm::ivec4& range = m_QuadTiles[i];
+		for (int y = range.y; y <= range.w; y++)
+		{
+			for (int x = range.x; x <= range.z; x++)
+				m_TileQuads[m_TileStart[(size_t)y * m_TilesX + x]++] = i;
+		}
+	}
+
+	JobSystem::ParallelFor((uint32_t)m_Touched.size(), 1, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		for (uint32_t t = begin; t < end; t++)
+		{
+			uint32_t tile = m_Touched[t];
+			uint32_t first = tile ? m_TileStart[tile - 1] : 0;
+			StampTile(tile, instances, &m_TileQuads[first], m_TileStart[tile] - first);
+		}
+	});
+}
+
+void ParticleCanvas::StampTile(uint32_t tile, const ParticleInstance* instances, const uint32_t* indices, uint32_t count)
+{
+	uint8_t* texels = &m_Texels[(size_t)tile * m_TileSize * m_TileSize * 4];
+	glm::vec2 origin = GetTileOrigin(tile);
+	int size = (int)m_TileSize;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const ParticleInstance& instance = instances[indices[i]];
+
+		// Quad in texels relative to the tile; a texel is covered when its centre is inside
+		glm::vec2 center = (instance.Position - m_Min) * m_TexelsPerUnit - origin;
+		float half = std::abs(instance.Size) * 0.5f * m_TexelsPerUnit;
+		float c = std::cos(instance.Rotation), s = std::sin(instance.Rotation);
+		float reach = half * (std::abs(c) + std::abs(s));
+		int x0 = std::max((int)std::floor(center.x - reach), 0), x1 = std::min((int)std::ceil(center.x + reach), size);
+		int y0 = std::max((int)std::floor(center.y - reach), 0), y1 = std::min((int)std::ceil(center.y + reach), size);
+
+		glm::vec4 color = glm::clamp(instance.Color, 0.0f, 1.0f);
+		float source[4] = { color.r * color.a * 255.0f, color.g * color.a * 255.0f, color.b * color.a * 255.0f, color.a * 255.0f };
+		float keep = 1.0f - color.a;
+
+		for (int y = y0; y < y1; y++)
+		{
+			float dy = y + 0.5f - center.y;
+			uint8_t* texel = texels + ((size_t)y * size + x0) * 4;
+			for (int x = x0; x < x1; x++, texel += 4)
+			{
+				float dx = x + 0.5f - center.x;
+				if (std::abs(dx * c + dy * s) > half || std::abs(dy * c - dx * s) > half)
+					continue;
+				for (int k = 0; k < 4; k++)
+					texel[k] = (uint8_t)(source[k] + texel[k] * keep + 0.5f);
+			}
+		}
+	}
+}
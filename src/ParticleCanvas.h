@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ParticlePool.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct ParticleCanvasProps
+{
+	glm::vec2 Min = { -16.0f, -9.0f }, Max = { 16.0f, 9.0f }; // world rectangle, grown to whole tiles
+	float TexelsPerUnit = 64.0f;
+	uint32_t TileSize = 64; // texels per tile side
+};
+
+// Persistent RGBA8 image that settled particles are stamped into, so they can
+// be freed and drawn as one textured quad from then on. Texels are stored
+// premultiplied, tile by tile: every tile is a contiguous TileSize x TileSize
+// block with rows bottom-up, ready for a sub-image upload. Stamp() bins a
+// batch of quads into the tiles they touch with a counting sort and draws
+// each tile's quads in order across the JobSystem. Tiles touched since the
+// last ClearDirtyTiles() are listed, so the renderer only re-uploads those.
+// No GL dependency.
+class ParticleCanvas
+{
+public:
+	ParticleCanvas();
+
+	// Reallocates and clears the canvas; at most 4096 texels per axis
+	void SetProps(const ParticleCanvasProps& props);
+	const ParticleCanvasProps& GetProps() const { return m_Props; }
+
+	// Alpha-blends the quads over the canvas in order; parts outside it are dropped
+	void Stamp(const ParticleInstance* instances, uint32_t count);
+	// Transparent again, every tile dirty
+	void Clear();
+
+	const std::vector<uint32_t>& GetDirtyTiles() const { return m_DirtyTiles; }
+	void ClearDirtyTiles();
+	const uint8_t* GetTile(uint32_t tile) const { return &m_Texels[(size_t)tile * m_TileSize * m_TileSize * 4]; }
+	// Texel offset of the tile's bottom-left corner
+	glm::uvec2 GetTileOrigin(uint32_t tile) const { return { tile % m_TilesX * m_TileSize, tile / m_TilesX * m_TileSize }; }
+
+	glm::vec2 GetMin() const { return m_Min; }
+	glm::vec2 GetMax() const { return m_Max; }
+	uint32_t GetWidth() const { return m_TilesX * m_TileSize; }
+	uint32_t GetHeight() const { return m_TilesY * m_TileSize; }
+	uint32_t GetTileSize() const { return m_TileSize; }
+	uint32_t GetTileCount() const { return m_TilesX * m_TilesY; }
+	uint64_t GetStampedCount() const { return m_StampedCount; }
+private:
+	void MarkDirty(uint32_t tile);
+	void StampTile(uint32_t tile, const ParticleInstance* instances, const uint32_t* indices, uint32_t count);
+private:
+	ParticleCanvasProps m_Props;
+	glm::vec2 m_Min = { 0.0f, 0.0f }, m_Max = { 0.0f, 0.0f };
+	float m_TexelsPerUnit = 0.0f;
+	uint32_t m_TileSize = 0, m_TilesX = 0, m_TilesY = 0;
+	std::vector<uint8_t> m_Texels; // tile-major, premultiplied RGBA
+	uint64_t m_StampedCount = 0;
+
+	std::vector<uint8_t> m_TileDirty;
+	std::vector<uint32_t> m_DirtyTiles;
+
+	// Stamp() scratch
+	std::vector<glm::ivec4> m_QuadTiles; // first and last tile covered; empty when off the canvas
+	std::vector<uint32_t> m_TileStart;
+	std::vector<uint32_t> m_TileQuads;
+	std::vector<uint32_t> m_Touched;
+};
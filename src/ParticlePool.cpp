@@ -0,0 +1,348 @@
+#include "ParticlePool.h"
+
+#include "ParticleBehavior.h"
+#include "InstancePacking.h"
+#include "JobSystem.h"
+#include "Random.h"
+
+#include <glm/gtc/constants.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/compatibility.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+ParticlePool::ParticlePool(uint32_t capacity)
+{
+	m_Particles.resize(capacity);
+	m_DeathTicks.assign(capacity, ExpiryWheel::NoTick);
+	m_PoolIndex.store(capacity - 1, std::memory_order_relaxed);
+	m_BurstSeed = (uint32_t)(Random::Float() * 4294967295.0);
+}
+
+void ParticlePool::Update(float ts)
+{
+	bool throttle = m_Throttle.IsEnabled();
+	if (throttle)
+		m_Throttle.Begin();
+
+	float restSpeedSquared = m_RestSpeed * m_RestSpeed;
+	uint32_t live = 0;
+	for (auto& particle : m_Particles)
+	{
+		if (!particle.Active)
+			continue;
+		if ((particle.Stamp & ParticleStampAtRest) && glm::dot(particle.Velocity, particle.Velocity) < restSpeedSquared)
+		{
+			Settle(particle);
+			continue;
+		}
+
+		live++;
+		particle.LifeRemaining -= ts;
+		particle.Position += particle.Velocity * ts;
+		particle.Rotation += 0.01f * ts;
+
+		// Particles out of life are retired below
+		if (throttle && particle.LifeRemaining > 0.0f)
+		{
+			m_Throttle.Add(particle.Position, particle.Velocity, particle.LifeTime, particle.LifeRemaining / particle.LifeTime,
+				{ particle.SizeEnd, particle.SizeBegin }, { particle.ColorEnd.a, particle.ColorBegin.a });
+		}
+	}
+
+	Retire(ts);
+	m_LiveCount = live - m_ExpiredCount;
+	if (throttle)
+		m_Throttle.End();
+	m_Time += ts;
+	if (m_Behavior)
+		m_Behavior->Execute(m_Particles, ts, m_Time);
+}
+
+void ParticlePool::Retire(float ts)
+{
+	// Only the ranges due by now; slots emitted into again since carry a later tick
+	m_ExpiredCount = 0;
+	m_Expiry.Advance(ts, [this](uint64_t tick, uint32_t first, uint32_t count)
+	{
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			if (m_DeathTicks[i] != tick)
+				continue;
+			if (m_Particles[i].Stamp & ParticleStampOnDeath)
+				AddStamp(m_Particles[i]);
+			m_Particles[i].Active = false;
+			m_DeathTicks[i] = ExpiryWheel::NoTick;
+			m_ExpiredCount++;
+		}
+	});
+}
+
+void ParticlePool::AddStamp(const Particle& particle)
+{
+	float life = std::max(particle.LifeRemaining / particle.LifeTime, 0.0f);
+	m_Stamps.push_back({ glm::lerp(particle.ColorEnd, particle.ColorBegin, life), particle.Position, particle.Rotation,
+		glm::lerp(particle.SizeEnd, particle.SizeBegin, life) });
+}
+
+void ParticlePool::Settle(Particle& particle)
+{
+	// The slot's wheel entry goes stale, as it would on re-emission
+	AddStamp(particle);
+	particle.Active = false;
+	m_DeathTicks[&particle - m_Particles.data()] = ExpiryWheel::NoTick;
+}
+
+FusedUpdateStats ParticlePool::UpdateAndPack(float ts, const glm::vec2& viewMin, const glm::vec2& viewMax, PackedParticleInstance* packed)
+{
+	Retire(ts);
+	m_Time += ts;
+	bool throttle = m_Throttle.IsEnabled();
+	if (throttle)
+		m_Throttle.Begin();
+
+	// Visible particles gather in a block small enough for L1, then go through the SSE packer.
+	// Positions are packed relative to the view grown by the furthest a quad can reach, so the
+	// centres of quads that only overlap the view are not clamped onto its edge.
+	constexpr uint32_t BlockSize = 64;
+	ParticleInstance block[BlockSize];
+	uint32_t blockCount = 0;
+	float margin = m_MaxReach;
+	ParticleBounds bounds = { viewMin - margin, viewMax + margin };
+	bool overflow = false;
+
+	FusedUpdateStats stats;
+	auto pack = [&](const Particle& particle, float life, float size)
+	{
+		// A rotated quad reaches at most half its diagonal from the centre
+		float reach = std::abs(size) * 0.70711f;
+		if (particle.Position.x + reach < viewMin.x || particle.Position.x - reach > viewMax.x
+			|| particle.Position.y + reach < viewMin.y || particle.Position.y - reach > viewMax.y)
+			return;
+		overflow |= reach > margin;
+
+		block[blockCount++] = { glm::lerp(particle.ColorEnd, particle.ColorBegin, life), particle.Position, particle.Rotation, size };
+		if (blockCount == BlockSize)
+		{
+			PackInstances(block, blockCount, bounds, packed + stats.InstanceCount);
+			stats.InstanceCount += blockCount;
+			blockCount = 0;
+		}
+	};
+
+	glm::vec2 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+	float restSpeedSquared = m_RestSpeed * m_RestSpeed;
+	float maxSize = 0.0f;
+	for (auto& particle : m_Particles)
+	{
+		if (!particle.Active)
+			continue;
+		if ((particle.Stamp & ParticleStampAtRest) && glm::dot(particle.Velocity, particle.Velocity) < restSpeedSquared)
+		{
+			Settle(particle);
+			continue;
+		}
+
+		particle.LifeRemaining -= ts;
+		particle.Position += particle.Velocity * ts;
+		particle.Rotation += 0.01f * ts;
+		stats.LiveCount++;
+		boundsMin = glm::min(boundsMin, particle.Position);
+		boundsMax = glm::max(boundsMax, particle.Position);
+		maxSize = std::max(maxSize, std::max(std::abs(particle.SizeBegin), std::abs(particle.SizeEnd)));
+
+		float life = particle.LifeRemaining / particle.LifeTime;
+		float size = glm::lerp(particle.SizeEnd, particle.SizeBegin, life);
+		if (throttle)
+			m_Throttle.Add(particle.Position, particle.Velocity, particle.LifeTime, life, { particle.SizeEnd, particle.SizeBegin }, { particle.ColorEnd.a, particle.ColorBegin.a });
+		pack(particle, life, size);
+	}
+	PackInstances(block, blockCount, bounds, packed + stats.InstanceCount);
+	stats.InstanceCount += blockCount;
+	if (throttle)
+		m_Throttle.End();
+
+	// Sizes only move between SizeBegin and SizeEnd, so this bounds the next frame until something new is emitted
+	m_MaxReach = maxSize * 0.70711f;
+	if (overflow)
+	{
+		// A visible quad reached past the margin (reserved bodies, or sizes written from outside): pack again
+		margin = m_MaxReach;
+		bounds = { viewMin - margin, viewMax + margin };
+		stats.InstanceCount = blockCount = 0;
+		for (const auto& particle : m_Particles)
+		{
+			if (!particle.Active)
+				continue;
+			float life = particle.LifeRemaining / particle.LifeTime;
+			pack(particle, life, glm::lerp(particle.SizeEnd, particle.SizeBegin, life));
+		}
+		PackInstances(block, blockCount, bounds, packed + stats.InstanceCount);
+		stats.InstanceCount += blockCount;
+	}
+
+	m_LiveCount = stats.LiveCount;
+	stats.PackMin = bounds.Min;
+	stats.PackMax = bounds.Max;
+	if (stats.LiveCount)
+	{
+		stats.BoundsMin = boundsMin;
+		stats.BoundsMax = boundsMax;
+	}
+	return stats;
+}
+
+uint32_t ParticlePool::BuildInstances(std::vector<ParticleInstance>& instances, std::vector<ParticleSpriteInstance>* spriteInstances) const
+{
+	if (instances.size() < m_Particles.size())
+		instances.resize(m_Particles.size());
+	if (spriteInstances && spriteInstances->size() < m_Particles.size())
+		spriteInstances->resize(m_Particles.size());
+
+	uint32_t count = 0;
+	for (auto& particle : m_Particles)
+	{
+		if (!particle.Active)
+			continue;
+
+		// Fade away particles
+		float life = particle.LifeRemaining / particle.LifeTime;
+
+		if (spriteInstances)
+			(*spriteInstances)[count] = { 1.0f - life, particle.Flipbook };
+
+		ParticleInstance& instance = instances[count++];
+		instance.Color = glm::lerp(particle.ColorEnd, particle.ColorBegin, life);
+		//instance.Color.a = instance.Color.a * life;
+		instance.Position = particle.Position;
+		instance.Rotation = particle.Rotation;
+		instance.Size = glm::lerp(particle.SizeEnd, particle.SizeBegin, life);
+	}
+	return count;
+}
+
+static void InitParticle(Particle& particle, const ParticleProps& particleProps, const glm::vec4& jitter)
+{
+	particle.Active = true;
+	particle.Position = particleProps.Position;
+	particle.Rotation = jitter.x * 2.0f * glm::pi<float>();
+
+	// Velocity
+	particle.Velocity = particleProps.Velocity;
+	particle.Velocity.x += particleProps.VelocityVariation.x * (jitter.y - 0.5f);
+	particle.Velocity.y += particleProps.VelocityVariation.y * (jitter.z - 0.5f);
+
+	// Color
+	particle.ColorBegin = particleProps.ColorBegin;
+	particle.ColorEnd = particleProps.ColorEnd;
+
+	particle.LifeTime = particleProps.LifeTime;
+	particle.LifeRemaining = particleProps.LifeTime;
+	particle.SizeBegin = particleProps.SizeBegin + particleProps.SizeVariation * (jitter.w - 0.5f);
+	particle.SizeEnd = particleProps.SizeEnd;
+	particle.Flipbook = particleProps.Flipbook;
+	particle.Stamp = (uint8_t)particleProps.Stamp;
+}
+
+// Half the diagonal of the largest quad InitParticle() can size from these props
+static float GetMaxReach(const ParticleProps& particleProps)
+{
+	float size = std::max(std::abs(particleProps.SizeBegin) + 0.5f * std::abs(particleProps.SizeVariation), std::abs(particleProps.SizeEnd));
+	return size * 0.70711f;
+}
+
+void ParticlePool::Emit(const ParticleProps& particleProps)
+{
+	glm::vec4 jitter = m_Sampler.Next(particleProps.Sampling);
+	// The throttle relies on new particles being drawn under older ones, which the slots emitted
+	// into since the last wrap are not until the particles from before it have died
+	if (m_Throttle.IsEnabled() && m_Time - m_WrapTime >= particleProps.LifeTime)
+	{
+		glm::vec2 velocity = particleProps.Velocity + particleProps.VelocityVariation * (glm::vec2(jitter.y, jitter.z) - 0.5f);
+		if (!m_Throttle.ShouldEmit(particleProps.Position, velocity, particleProps.LifeTime, particleProps.ColorBegin.a, particleProps.ColorEnd.a))
+			return;
+	}
+
+	uint32_t index = m_PoolIndex.load(std::memory_order_relaxed);
+	InitParticle(m_Particles[index], particleProps, jitter);
+	m_MaxReach = std::max(m_MaxReach, GetMaxReach(particleProps));
+	m_DeathTicks[index] = m_Expiry.GetTick(particleProps.LifeTime);
+	m_Expiry.Schedule(m_DeathTicks[index], index, 1);
+	if (index == m_ReservedCount)
+		m_WrapTime = m_Time;
+	m_PoolIndex.store((index == m_ReservedCount ? (uint32_t)m_Particles.size() : index) - 1, std::memory_order_relaxed);
+}
+
+uint32_t ParticlePool::EmitBurst(const ParticleProps& particleProps, uint32_t count)
+{
+	// Anything past one full ring would only overwrite the burst's own particles
+	uint32_t ringSize = (uint32_t)m_Particles.size() - m_ReservedCount;
+	count = std::min(count, ringSize);
+	if (count == 0)
+		return 0;
+
+	// One CAS claims the whole block: slots start, start - 1, ... wrapping to the top of the ring
+	uint32_t start = m_PoolIndex.load(std::memory_order_relaxed), next;
+	do
+	{
+		uint32_t offset = start - m_ReservedCount;
+		next = m_ReservedCount + (offset + ringSize - count) % ringSize;
+	} while (!m_PoolIndex.compare_exchange_weak(start, next, std::memory_order_relaxed));
+
+	uint32_t seed = EmissionSampler::Hash(m_BurstSeed + m_BurstCount.fetch_add(1, std::memory_order_relaxed) * 0x9e3779b9);
+	uint64_t deathTick = m_Expiry.GetTick(particleProps.LifeTime);
+	JobSystem::ParallelFor(count, 8192, [&](uint32_t begin, uint32_t end, uint32_t)
+	{
+		// Randomness comes from the burst-local index, never from the slot or the thread
+		EmissionSequence sequence(particleProps.Sampling, begin, seed);
+		for (uint32_t i = begin; i < end; i++)
+		{
+			uint32_t index = start >= m_ReservedCount + i ? start - i : start + ringSize - i;
+			InitParticle(m_Particles[index], particleProps, sequence.Next());
+			m_DeathTicks[index] = deathTick;
+		}
+	});
+
+	// The whole burst dies together: at most two ranges, the second after wrapping to the top of the ring
+	uint32_t low = std::min(count, start - m_ReservedCount + 1);
+	std::lock_guard<std::mutex> lock(m_ExpiryMutex);
+	m_MaxReach = std::max(m_MaxReach, GetMaxReach(particleProps));
+	// Reaching the bottom slot wraps the ring, as in Emit()
+	if (low == start - m_ReservedCount + 1)
+		m_WrapTime = m_Time;
+	m_Expiry.Schedule(deathTick, start + 1 - low, low);
+	m_Expiry.Schedule(deathTick, m_ReservedCount + ringSize - (count - low), count - low);
+	return count;
+}
+
+void ParticlePool::SetSeed(uint32_t seed)
+{
+	m_BurstSeed = seed;
+	m_BurstCount.store(0, std::memory_order_relaxed);
+}
+
+uint32_t ParticlePool::Reserve(uint32_t count)
+{
+	if (count >= (uint32_t)m_Particles.size() - m_ReservedCount)
+		return UINT32_MAX;
+
+	uint32_t first = m_ReservedCount;
+	m_ReservedCount += count;
+	if (m_PoolIndex.load(std::memory_order_relaxed) < m_ReservedCount)
+		m_PoolIndex.store((uint32_t)m_Particles.size() - 1, std::memory_order_relaxed);
+
+	for (uint32_t i = first; i < m_ReservedCount; i++)
+	{
+		m_Particles[i] = Particle();
+		m_DeathTicks[i] = ExpiryWheel::NoTick;
+	}
+	return first;
+}
+
+void ParticlePool::ReleaseReserved()
+{
+	for (uint32_t i = 0; i < m_ReservedCount; i++)
+		m_Particles[i].Active = false;
+	m_ReservedCount = 0;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "EmissionSampler.h"
+#include "EmissionThrottle.h"
+#include "ExpiryWheel.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ParticleBehavior;
+struct PackedParticleInstance;
+
+// When a particle leaves the simulation for a ParticleCanvas (ParticleProps::Stamp)
+enum ParticleStampFlags : uint32_t
+{
+	ParticleStampOnDeath = 1 << 0, // as its lifetime runs out
+	ParticleStampAtRest = 1 << 1   // once slower than the pool's rest speed
+};
+
+// vec4 members lead so the layout has no padding when GLM_FORCE_DEFAULT_ALIGNED_GENTYPES makes them 16-byte aligned
+struct ParticleProps
+{
+	glm::vec4 ColorBegin, ColorEnd;
+	glm::vec2 Position;
+	glm::vec2 Velocity, VelocityVariation;
+	float SizeBegin, SizeEnd, SizeVariation;
+	float LifeTime = 1.0f;
+	uint32_t Flipbook = 0; // index into the system's SpriteAtlas flipbook table
+	EmissionSampling Sampling = EmissionSampling::Random; // source of the rotation, velocity and size jitter
+	uint32_t Stamp = 0; // ParticleStampFlags
+};
+
+struct Particle
+{
+	glm::vec4 ColorBegin, ColorEnd;
+	glm::vec2 Position;
+	glm::vec2 Velocity;
+	float Rotation = 0.0f;
+	float SizeBegin, SizeEnd;
+
+	float LifeTime = 1.0f;
+	float LifeRemaining = 0.0f;
+
+	uint32_t Flipbook = 0;
+	bool Active = false;
+	uint8_t Stamp = 0;
+};
+
+// What the renderer needs for one live particle (32 bytes)
+struct ParticleInstance
+{
+	glm::vec4 Color;
+	glm::vec2 Position;
+	float Rotation;
+	float Size;
+};
+
+// Extra per-instance stream for textured particles; the vertex shader picks
+// the flipbook frame from the normalized age
+struct ParticleSpriteInstance
+{
+	float Age;
+	uint32_t Flipbook;
+};
+
+// What UpdateAndPack() produced
+struct FusedUpdateStats
+{
+	uint32_t LiveCount = 0;
+	uint32_t InstanceCount = 0;
+	glm::vec2 BoundsMin = { 0.0f, 0.0f }, BoundsMax = { 0.0f, 0.0f }; // every live particle, culled or not
+	glm::vec2 PackMin = { 0.0f, 0.0f }, PackMax = { 0.0f, 0.0f };     // rectangle the packed positions are relative to
+};
+
+// Simulation half of the particle system. Has no GL dependency so it can
+// run in headless benchmarks and training workloads.
+// Emission schedules each particle's death in an ExpiryWheel, so Update()
+// integrates without a lifetime test and retires only the particles due this
+// step. Particles activated by other code (ConstraintSolver bodies) are never
+// scheduled and stay alive until their owner deactivates them.
+// Particles flagged with ParticleStampFlags leave as stamps (GetStamps()) when
+// they die or settle, so static splatter stops costing update and draw time.
+class ParticlePool
+{
+public:
+	ParticlePool(uint32_t capacity = 1000);
+
+	void Update(float ts);
+	// Skipped, when the throttle is enabled, as often as its spawn probability at the position says
+	void Emit(const ParticleProps& particleProps);
+
+	// Emits `count` particles at once: claims a contiguous run of ring slots with
+	// one atomic update, then fills it across the JobSystem with counter-based
+	// jitter (one EmissionSequence per chunk, seeded at its first index). The
+	// result does not depend on the thread count.
+	// Concurrent EmitBurst calls get disjoint slots; Emit must not run alongside them.
+	// Bursts are never throttled. Returns the number emitted (at most the ring size).
+	uint32_t EmitBurst(const ParticleProps& particleProps, uint32_t count);
+	// Bursts after this are reproducible: the n-th burst always draws the same jitter
+	void SetSeed(uint32_t seed);
+
+	// Render prep: evaluates color and size for every live particle.
+	// Returns the number of instances written to the front of `instances`
+	// (and of `spriteInstances`, when given).
+	uint32_t BuildInstances(std::vector<ParticleInstance>& instances, std::vector<ParticleSpriteInstance>* spriteInstances = nullptr) const;
+
+	// Update(), BuildInstances(), ComputeInstanceBounds() and PackInstances() in one walk over
+	// the particles: each is integrated, colored and sized, culled against [viewMin, viewMax]
+	// and packed while still in cache, relative to that rectangle grown by the largest quad's
+	// reach (FusedUpdateStats::PackMin/PackMax). `packed` needs room for every
+	// live particle. Retirement comes first, so particles dying this step are never packed.
+	// Scripted behaviors run as their own pass; use Update() when one is set.
+	FusedUpdateStats UpdateAndPack(float ts, const glm::vec2& viewMin, const glm::vec2& viewMax, PackedParticleInstance* packed);
+
+	// Scripted per-particle behavior, run after the built-in integration. nullptr = none.
+	void SetBehavior(const std::shared_ptr<ParticleBehavior>& behavior) { m_Behavior = behavior; }
+	const std::shared_ptr<ParticleBehavior>& GetBehavior() const { return m_Behavior; }
+
+	// Takes particles [0, GetReservedCount()) out of the emission ring so another
+	// simulation (ConstraintSolver) can own them. Returns the first new index, or
+	// UINT32_MAX when the ring would be left empty.
+	uint32_t Reserve(uint32_t count);
+	void ReleaseReserved();
+	uint32_t GetReservedCount() const { return m_ReservedCount; }
+
+	// Density-aware emission: Update() and UpdateAndPack() fill its occupancy grid while enabled
+	EmissionThrottle& GetThrottle() { return m_Throttle; }
+	const EmissionThrottle& GetThrottle() const { return m_Throttle; }
+
+	// Particles flagged through ParticleProps::Stamp, as they looked when they died or came to rest.
+	// They are freed as they are added; hand them to a ParticleCanvas, then ClearStamps().
+	const std::vector<ParticleInstance>& GetStamps() const { return m_Stamps; }
+	void ClearStamps() { m_Stamps.clear(); }
+	// Speed below which ParticleStampAtRest particles are stamped, in world units per second
+	void SetRestSpeed(float speed) { m_RestSpeed = speed; }
+	float GetRestSpeed() const { return m_RestSpeed; }
+
+	// Particles retired by the last Update()
+	uint32_t GetExpiredCount() const { return m_ExpiredCount; }
+	// Particles still active after the last Update() or UpdateAndPack()
+	uint32_t GetLiveCount() const { return m_LiveCount; }
+	const ExpiryWheel& GetExpiry() const { return m_Expiry; }
+
+	uint32_t GetCapacity() const { return (uint32_t)m_Particles.size(); }
+	std::vector<Particle>& GetParticles() { return m_Particles; }
+	const std::vector<Particle>& GetParticles() const { return m_Particles; }
+private:
+	void Retire(float ts);
+	void AddStamp(const Particle& particle);
+	void Settle(Particle& particle);
+private:
+	std::vector<Particle> m_Particles;
+	std::atomic<uint32_t> m_PoolIndex{ 0 };
+	uint32_t m_ReservedCount = 0;
+	EmissionSampler m_Sampler;
+	uint32_t m_BurstSeed = 0;
+	std::atomic<uint32_t> m_BurstCount{ 0 };
+
+	ExpiryWheel m_Expiry;
+	std::vector<uint64_t> m_DeathTicks; // per slot; ExpiryWheel::NoTick when not scheduled
+	std::mutex m_ExpiryMutex;           // concurrent EmitBurst calls
+	uint32_t m_ExpiredCount = 0;
+	uint32_t m_LiveCount = 0;
+
+	EmissionThrottle m_Throttle;
+	float m_WrapTime = -1e30f; // m_Time when Emit() or EmitBurst() last wrapped to the top of the ring
+	float m_MaxReach = 0.0f;   // at least half the diagonal of any active emitted quad, for UpdateAndPack()
+
+	std::vector<ParticleInstance> m_Stamps;
+	float m_RestSpeed = 0.05f;
+
+	std::shared_ptr<ParticleBehavior> m_Behavior;
+	float m_Time = 0.0f;
+};
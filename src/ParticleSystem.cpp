@@ -1,117 +1,386 @@
 #include "ParticleSystem.h"
 
-#include "Random.h"
+#include "GpuProfiler.h"
+#include "RenderThread.h"
 
-#include <glm/gtc/constants.hpp>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/compatibility.hpp>
+#include <array>
+#include <cfloat>
+#include <cstddef>
+#include <cstring>
 
-ParticleSystem::ParticleSystem()
+ParticleSystem::ParticleSystem(uint32_t maxParticles)
+	: m_Pool(maxParticles)
 {
-	m_ParticlePool.resize(1000);
 }
 
-void ParticleSystem::OnUpdate(GLCore::Timestep ts)
+ParticleSystem::~ParticleSystem()
 {
-	for (auto& particle : m_ParticlePool)
+	if (!m_Initialized)
+		return;
+
+	RenderThread::GetCommandList().Execute([vertexArrays = std::array<GLuint, 4>{ m_QuadVA, m_SpriteVA, m_PackedVA, m_DyeVA },
+		buffers = std::array<GLuint, 5>{ m_QuadVB, m_QuadIB, m_InstanceVB, m_SpriteInstanceVB, m_PackedInstanceVB },
+		shaders = std::array<GLCore::Utils::Shader*, 5>{ m_ParticleShader.release(), m_SpriteShader.release(), m_PackedShader.release(), m_DyeShader.release(), m_CanvasShader.release() },
+		textures = std::array<GLuint, 2>{ m_DyeTexture, m_CanvasTexture }]()
 	{
-		if (!particle.Active)
-			continue;
+		glDeleteVertexArrays((GLsizei)vertexArrays.size(), vertexArrays.data());
+		glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+		glDeleteTextures((GLsizei)textures.size(), textures.data());
+		for (auto shader : shaders)
+			delete shader;
+	});
+}
 
-		if (particle.LifeRemaining <= 0.0f)
-		{
-			particle.Active = false;
-			continue;
-		}
+void ParticleSystem::OnUpdate(GLCore::Timestep ts)
+{
+	if (m_FluidEnabled)
+	{
+		m_Fluid.Step(ts);
+		m_Fluid.AdvectParticles(m_Pool.GetParticles(), ts);
+	}
+	// Forces are inputs to the constraint solve: it predicts from the velocities they leave and sets
+	// the velocity that lands its bodies on the solved positions, which nothing may change after it
+	m_ForceVolumes.Apply(m_Pool.GetParticles(), ts);
+	m_Constraints.Step(ts);
 
-		particle.LifeRemaining -= ts;
-		particle.Position += particle.Velocity * (float)ts;
-		particle.Rotation += 0.01f * ts;
+	// The fused path integrates while packing
+	if (CanFuse())
+	{
+		m_PendingStep = (m_StepPending ? m_PendingStep : 0.0f) + (float)ts;
+		m_StepPending = true;
+		return;
 	}
+	m_Pool.Update(ts);
+	m_Colliders.CollideParticles(m_Pool.GetParticles(), m_Pool.GetReservedCount());
+}
+
+bool ParticleSystem::CanFuse() const
+{
+	return m_FusedUpdate && m_PackedInstances && m_RenderMode == ParticleRenderMode::Sprites && !m_SpriteAtlas
+		&& !m_Pool.GetBehavior() && m_Colliders.GetColliders().empty() && m_Pool.GetReservedCount() == 0;
+}
+
+void ParticleSystem::InitRenderer()
+{
+	float vertices[] = {
+		 -0.5f, -0.5f, 0.0f,
+		  0.5f, -0.5f, 0.0f,
+		  0.5f,  0.5f, 0.0f,
+		 -0.5f,  0.5f, 0.0f
+	};
+
+	uint32_t indices[] = {
+		0, 1, 2, 2, 3, 0
+	};
+
+	glCreateBuffers(1, &m_QuadVB);
+	glNamedBufferData(m_QuadVB, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glCreateBuffers(1, &m_QuadIB);
+	glNamedBufferData(m_QuadIB, sizeof(indices), indices, GL_STATIC_DRAW);
+	glCreateBuffers(1, &m_InstanceVB);
+	glCreateBuffers(1, &m_SpriteInstanceVB);
+	glCreateBuffers(1, &m_PackedInstanceVB);
+
+	// Quad corners plus per-instance color and (position.xy, rotation, size)
+	auto createQuadVertexArray = [this](GLuint& vertexArray)
+	{
+		glCreateVertexArrays(1, &vertexArray);
+		glBindVertexArray(vertexArray);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_QuadVB);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVB);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (const void*)offsetof(ParticleInstance, Color));
+		glVertexAttribDivisor(1, 1);
+
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (const void*)offsetof(ParticleInstance, Position));
+		glVertexAttribDivisor(2, 1);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_QuadIB);
+	};
+
+	createQuadVertexArray(m_QuadVA);
+
+	// Sprites add normalized age and flipbook index
+	createQuadVertexArray(m_SpriteVA);
+	glBindBuffer(GL_ARRAY_BUFFER, m_SpriteInstanceVB);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleSpriteInstance), (const void*)offsetof(ParticleSpriteInstance, Age));
+	glVertexAttribDivisor(3, 1);
+	glEnableVertexAttribArray(4);
+	glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(ParticleSpriteInstance), (const void*)offsetof(ParticleSpriteInstance, Flipbook));
+	glVertexAttribDivisor(4, 1);
+
+	// Packed instances: unorm16 position, half rotation/size and RGBA8 color are decoded by the vertex fetch
+	glCreateVertexArrays(1, &m_PackedVA);
+	glBindVertexArray(m_PackedVA);
+	glBindBuffer(GL_ARRAY_BUFFER, m_QuadVB);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+	glBindBuffer(GL_ARRAY_BUFFER, m_PackedInstanceVB);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedParticleInstance), (const void*)offsetof(PackedParticleInstance, Color));
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedParticleInstance), (const void*)offsetof(PackedParticleInstance, Position));
+	glVertexAttribDivisor(2, 1);
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedParticleInstance), (const void*)offsetof(PackedParticleInstance, RotationSize));
+	glVertexAttribDivisor(3, 1);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_QuadIB);
+
+	m_ParticleShader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/particle.glsl.vert", "assets/particle.glsl.frag"));
+	m_ParticleShaderProgram = m_ParticleShader->GetRendererID();
+	m_ParticleShaderViewProj = glGetUniformLocation(m_ParticleShaderProgram, "u_ViewProj");
+
+	m_SpriteShader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/particle_sprite.glsl.vert", "assets/particle_sprite.glsl.frag"));
+	m_SpriteShaderProgram = m_SpriteShader->GetRendererID();
+	m_SpriteShaderViewProj = glGetUniformLocation(m_SpriteShaderProgram, "u_ViewProj");
+
+	m_PackedShader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/particle_packed.glsl.vert", "assets/particle.glsl.frag"));
+	m_PackedShaderProgram = m_PackedShader->GetRendererID();
+	m_PackedShaderViewProj = glGetUniformLocation(m_PackedShaderProgram, "u_ViewProj");
+	m_PackedShaderBounds = glGetUniformLocation(m_PackedShaderProgram, "u_Bounds");
+
+	glCreateVertexArrays(1, &m_DyeVA);
+	m_DyeShader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/fluid_dye.glsl.vert", "assets/fluid_dye.glsl.frag"));
+	m_DyeShaderProgram = m_DyeShader->GetRendererID();
+	m_DyeShaderViewProj = glGetUniformLocation(m_DyeShaderProgram, "u_ViewProj");
+	m_DyeShaderBounds = glGetUniformLocation(m_DyeShaderProgram, "u_Bounds");
+	m_DyeShaderColor = glGetUniformLocation(m_DyeShaderProgram, "u_Color");
+
+	// Same rectangle as the dye, so it shares the empty vertex array
+	m_CanvasShader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/fluid_dye.glsl.vert", "assets/particle_canvas.glsl.frag"));
+	m_CanvasShaderProgram = m_CanvasShader->GetRendererID();
+	m_CanvasShaderViewProj = glGetUniformLocation(m_CanvasShaderProgram, "u_ViewProj");
+	m_CanvasShaderBounds = glGetUniformLocation(m_CanvasShaderProgram, "u_Bounds");
 }
 
 void ParticleSystem::OnRender(GLCore::Utils::OrthographicCamera& camera)
 {
-	if (!m_QuadVA)
+	GpuProfileScope zone("Particles");
+	RenderCommandList& commands = RenderThread::GetCommandList();
+
+	if (!m_Initialized)
+	{
+		commands.Execute([this]() { InitRenderer(); });
+		m_Initialized = true;
+	}
+
+	// World rectangle the view shows: the fused path culls against it (and packs relative to it grown
+	// by the largest quad), and the emission throttle lays its grid over it
+	glm::mat4 inverse = glm::inverse(camera.GetViewProjectionMatrix());
+	glm::vec2 viewMin(FLT_MAX), viewMax(-FLT_MAX);
+	for (glm::vec2 corner : { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(-1.0f, 1.0f), glm::vec2(1.0f, 1.0f) })
 	{
-		float vertices[] = {
-			 -0.5f, -0.5f, 0.0f,
-			  0.5f, -0.5f, 0.0f,
-			  0.5f,  0.5f, 0.0f,
-			 -0.5f,  0.5f, 0.0f
-		};
+		glm::vec2 world = inverse * glm::vec4(corner, 0.0f, 1.0f);
+		viewMin = glm::min(viewMin, world);
+		viewMax = glm::max(viewMax, world);
+	}
+	m_Pool.GetThrottle().SetView(viewMin, viewMax);
 
-		glCreateVertexArrays(1, &m_QuadVA);
-		glBindVertexArray(m_QuadVA);
+	uint32_t buffer = RenderThread::GetFrameIndex() & 1;
+	m_Fusing = m_StepPending && CanFuse();
+	if (m_Fusing)
+	{
+		std::vector<PackedParticleInstance>& packed = m_PackedInstanceData[buffer];
+		if (packed.size() < m_Pool.GetCapacity())
+			packed.resize(m_Pool.GetCapacity());
+		m_FusedStats = m_Pool.UpdateAndPack(m_PendingStep, viewMin, viewMax, packed.data());
+		m_StepPending = false;
+		m_InstanceCount = m_FusedStats.InstanceCount;
+		m_Traffic = EstimateFusedTraffic(m_Pool.GetCapacity(), m_FusedStats.LiveCount, m_InstanceCount);
 
-		GLuint quadVB, quadIB;
-		glCreateBuffers(1, &quadVB);
-		glBindBuffer(GL_ARRAY_BUFFER, quadVB);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		if (m_FluidEnabled)
+			RenderFluidDye(camera);
+		RenderCanvas(camera);
+		if (m_InstanceCount == 0)
+			return;
 
-		glEnableVertexArrayAttrib(quadVB, 0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+		commands.UploadBuffer(&m_PackedInstanceVB, packed.data(), m_InstanceCount * sizeof(PackedParticleInstance));
+		commands.UseProgram(&m_PackedShaderProgram);
+		commands.UniformMat4(&m_PackedShaderViewProj, camera.GetViewProjectionMatrix());
+		commands.Uniform4f(&m_PackedShaderBounds, { m_FusedStats.PackMin, m_FusedStats.PackMax });
+		commands.DrawElementsInstanced(&m_PackedVA, 6, m_InstanceCount);
+		m_UploadedBytes += m_InstanceCount * sizeof(PackedParticleInstance);
+		return;
+	}
 
-		uint32_t indices[] = {
-			0, 1, 2, 2, 3, 0
-		};
+	// Settings changed since OnUpdate(): catch up on the step it left
+	if (m_StepPending)
+	{
+		m_Pool.Update(m_PendingStep);
+		m_Colliders.CollideParticles(m_Pool.GetParticles(), m_Pool.GetReservedCount());
+		m_StepPending = false;
+	}
+
+	std::vector<ParticleInstance>& instances = m_Instances[buffer];
+	std::vector<ParticleSpriteInstance>& spriteInstances = m_SpriteInstances[buffer];
+	bool textured = m_SpriteAtlas && m_RenderMode == ParticleRenderMode::Sprites;
+	m_InstanceCount = m_Pool.BuildInstances(instances, textured ? &spriteInstances : nullptr);
+	m_Traffic = EstimateMultiPassTraffic(m_Pool.GetCapacity(), m_InstanceCount, !textured && m_PackedInstances && m_RenderMode == ParticleRenderMode::Sprites);
+
+	if (m_FluidEnabled)
+		RenderFluidDye(camera);
+	RenderCanvas(camera);
+
+	if (m_RenderMode == ParticleRenderMode::DensityField)
+	{
+		RenderDensityField(camera);
+		return;
+	}
+
+	if (m_InstanceCount == 0)
+		return;
+
+	if (textured)
+	{
+		m_SpriteAtlas->Bind();
+		commands.UploadBuffer(&m_InstanceVB, instances.data(), m_InstanceCount * sizeof(ParticleInstance));
+		commands.UploadBuffer(&m_SpriteInstanceVB, spriteInstances.data(), m_InstanceCount * sizeof(ParticleSpriteInstance));
+		m_UploadedBytes += m_InstanceCount * (sizeof(ParticleInstance) + sizeof(ParticleSpriteInstance));
+		commands.UseProgram(&m_SpriteShaderProgram);
+		commands.UniformMat4(&m_SpriteShaderViewProj, camera.GetViewProjectionMatrix());
+		commands.DrawElementsInstanced(&m_SpriteVA, 6, m_InstanceCount);
+	}
+	else if (m_PackedInstances)
+	{
+		std::vector<PackedParticleInstance>& packed = m_PackedInstanceData[buffer];
+		if (packed.size() < m_InstanceCount)
+			packed.resize(m_InstanceCount);
+
+		ParticleBounds bounds = ComputeInstanceBounds(instances.data(), m_InstanceCount);
+		PackInstances(instances.data(), m_InstanceCount, bounds, packed.data());
+
+		commands.UploadBuffer(&m_PackedInstanceVB, packed.data(), m_InstanceCount * sizeof(PackedParticleInstance));
+		commands.UseProgram(&m_PackedShaderProgram);
+		commands.UniformMat4(&m_PackedShaderViewProj, camera.GetViewProjectionMatrix());
+		commands.Uniform4f(&m_PackedShaderBounds, { bounds.Min, bounds.Max });
+		commands.DrawElementsInstanced(&m_PackedVA, 6, m_InstanceCount);
+		m_UploadedBytes += m_InstanceCount * sizeof(PackedParticleInstance);
+	}
+	else
+	{
+		commands.UploadBuffer(&m_InstanceVB, instances.data(), m_InstanceCount * sizeof(ParticleInstance));
+		commands.UseProgram(&m_ParticleShaderProgram);
+		commands.UniformMat4(&m_ParticleShaderViewProj, camera.GetViewProjectionMatrix());
+		commands.DrawElementsInstanced(&m_QuadVA, 6, m_InstanceCount);
+		m_UploadedBytes += m_InstanceCount * sizeof(ParticleInstance);
+	}
+}
+
+void ParticleSystem::RenderDensityField(GLCore::Utils::OrthographicCamera& camera)
+{
+	GpuProfileScope zone("Density field");
+	const std::vector<ParticleInstance>& instances = m_Instances[RenderThread::GetFrameIndex() & 1];
+	m_DensityField.Splat(camera.GetViewProjectionMatrix(), m_InstanceCount, [&instances](uint32_t index, glm::vec2& position, glm::vec4& color)
+	{
+		position = instances[index].Position;
+		color = instances[index].Color;
+		return true;
+	});
+	m_DensityField.Render();
+}
+
+void ParticleSystem::RenderFluidDye(GLCore::Utils::OrthographicCamera& camera)
+{
+	GpuProfileScope zone("Fluid dye");
+	uint32_t width = m_Fluid.GetWidth(), height = m_Fluid.GetHeight();
+	if (width == 0)
+		return;
+
+	RenderCommandList& commands = RenderThread::GetCommandList();
+	if (m_DyeTextureWidth != width || m_DyeTextureHeight != height)
+	{
+		commands.Execute([this, width, height]()
+		{
+			if (m_DyeTexture)
+				glDeleteTextures(1, &m_DyeTexture);
+
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_DyeTexture);
+			glTextureStorage2D(m_DyeTexture, 1, GL_R32F, width, height);
+			glTextureParameteri(m_DyeTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTextureParameteri(m_DyeTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTextureParameteri(m_DyeTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(m_DyeTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		});
+		m_DyeTextureWidth = width;
+		m_DyeTextureHeight = height;
+	}
+
+	// The solver steps again next frame while this one may still be replaying, so upload a copy
+	const std::vector<float>& dye = m_Fluid.GetDye();
+	void* data = commands.Allocate(dye.size() * sizeof(float));
+	std::memcpy(data, dye.data(), dye.size() * sizeof(float));
+	commands.UploadTexture2D(&m_DyeTexture, width, height, GL_RED, GL_FLOAT, data);
 
-		glCreateBuffers(1, &quadIB);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIB);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	const FluidGridProps& props = m_Fluid.GetProps();
+	commands.UseProgram(&m_DyeShaderProgram);
+	commands.UniformMat4(&m_DyeShaderViewProj, camera.GetViewProjectionMatrix());
+	commands.Uniform4f(&m_DyeShaderBounds, { props.Center - props.Size * 0.5f, props.Center + props.Size * 0.5f });
+	commands.Uniform4f(&m_DyeShaderColor, props.DyeColor);
+	commands.BindTexture(0, &m_DyeTexture);
+	commands.DrawArrays(&m_DyeVA, 0, 6);
+}
+
+void ParticleSystem::RenderCanvas(GLCore::Utils::OrthographicCamera& camera)
+{
+	// Particles that settled since the last frame go onto the canvas in one batch
+	const std::vector<ParticleInstance>& stamps = m_Pool.GetStamps();
+	if (!stamps.empty())
+	{
+		m_Canvas.Stamp(stamps.data(), (uint32_t)stamps.size());
+		m_Pool.ClearStamps();
+	}
+	if (m_Canvas.GetStampedCount() == 0)
+		return;
 
-		m_ParticleShader = std::unique_ptr<GLCore::Utils::Shader>(GLCore::Utils::Shader::FromGLSLTextFiles("assets/shader.glsl.vert", "assets/shader.glsl.frag"));
-		m_ParticleShaderViewProj = glGetUniformLocation(m_ParticleShader->GetRendererID(), "u_ViewProj");
-		m_ParticleShaderTransform = glGetUniformLocation(m_ParticleShader->GetRendererID(), "u_Transform");
-		m_ParticleShaderColor = glGetUniformLocation(m_ParticleShader->GetRendererID(), "u_Color");
+	GpuProfileScope zone("Canvas");
+	RenderCommandList& commands = RenderThread::GetCommandList();
+	uint32_t width = m_Canvas.GetWidth(), height = m_Canvas.GetHeight();
+	if (m_CanvasTextureWidth != width || m_CanvasTextureHeight != height)
+	{
+		commands.Execute([this, width, height]()
+		{
+			if (m_CanvasTexture)
+				glDeleteTextures(1, &m_CanvasTexture);
+
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_CanvasTexture);
+			glTextureStorage2D(m_CanvasTexture, 1, GL_RGBA8, width, height);
+			glTextureParameteri(m_CanvasTexture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTextureParameteri(m_CanvasTexture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTextureParameteri(m_CanvasTexture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(m_CanvasTexture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		});
+		m_CanvasTextureWidth = width;
+		m_CanvasTextureHeight = height;
 	}
 
-	glUseProgram(m_ParticleShader->GetRendererID());
-	glUniformMatrix4fv(m_ParticleShaderViewProj, 1, GL_FALSE, glm::value_ptr(camera.GetViewProjectionMatrix()));
-
-	for (auto& particle : m_ParticlePool)
-	{
-		if (!particle.Active)
-			continue;
-
-		// Fade away particles
-		float life = particle.LifeRemaining / particle.LifeTime;
-		glm::vec4 color = glm::lerp(particle.ColorEnd, particle.ColorBegin, life);
-		//color.a = color.a * life;
-
-		float size = glm::lerp(particle.SizeEnd, particle.SizeBegin, life);
-		
-		// Render
-		glm::mat4 transform = glm::translate(glm::mat4(1.0f), { particle.Position.x, particle.Position.y, 0.0f })
-			* glm::rotate(glm::mat4(1.0f), particle.Rotation, { 0.0f, 0.0f, 1.0f })
-			* glm::scale(glm::mat4(1.0f), { size, size, 1.0f });
-		glUniformMatrix4fv(m_ParticleShaderTransform, 1, GL_FALSE, glm::value_ptr(transform));
-		glUniform4fv(m_ParticleShaderColor, 1, glm::value_ptr(color));
-		glBindVertexArray(m_QuadVA);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+	// Only tiles stamped since the last upload; new textures start with every tile dirty
+	uint32_t tileSize = m_Canvas.GetTileSize();
+	size_t tileBytes = (size_t)tileSize * tileSize * 4;
+	for (uint32_t tile : m_Canvas.GetDirtyTiles())
+	{
+		void* data = commands.Allocate(tileBytes);
+		std::memcpy(data, m_Canvas.GetTile(tile), tileBytes);
+		glm::uvec2 origin = m_Canvas.GetTileOrigin(tile);
+		commands.UploadTextureRegion(&m_CanvasTexture, origin.x, origin.y, tileSize, tileSize, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		m_CanvasUploadedBytes += tileBytes;
 	}
+	m_Canvas.ClearDirtyTiles();
+
+	commands.UseProgram(&m_CanvasShaderProgram);
+	commands.UniformMat4(&m_CanvasShaderViewProj, camera.GetViewProjectionMatrix());
+	commands.Uniform4f(&m_CanvasShaderBounds, { m_Canvas.GetMin(), m_Canvas.GetMax() });
+	commands.BindTexture(0, &m_CanvasTexture);
+	commands.DrawArrays(&m_DyeVA, 0, 6);
 }
 
 void ParticleSystem::Emit(const ParticleProps& particleProps)
 {
-	Particle& particle = m_ParticlePool[m_PoolIndex];
-	particle.Active = true;
-	particle.Position = particleProps.Position;
-	particle.Rotation = Random::Float() * 2.0f * glm::pi<float>();
-
-	// Velocity
-	particle.Velocity = particleProps.Velocity;
-	particle.Velocity.x += particleProps.VelocityVariation.x * (Random::Float() - 0.5f);
-	particle.Velocity.y += particleProps.VelocityVariation.y * (Random::Float() - 0.5f);
-
-	// Color
-	particle.ColorBegin = particleProps.ColorBegin;
-	particle.ColorEnd = particleProps.ColorEnd;
-
-	particle.LifeTime = particleProps.LifeTime;
-	particle.LifeRemaining = particleProps.LifeTime;
-	particle.SizeBegin = particleProps.SizeBegin + particleProps.SizeVariation * (Random::Float() - 0.5f);
-	particle.SizeEnd = particleProps.SizeEnd;
-
-	m_PoolIndex = --m_PoolIndex % m_ParticlePool.size();
+	m_Pool.Emit(particleProps);
 }
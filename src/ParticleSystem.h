@@ -12,42 +12,132 @@
 #include "GLCore/Core/MouseButtonCodes.h"
 #include <GLCoreUtils.h>
 
-struct ParticleProps
+#include "ColliderSet.h"
+#include "ConstraintSolver.h"
+#include "DensityField.h"
+#include "FluidGrid.h"
+#include "ForceVolumeSet.h"
+#include "ParticleCanvas.h"
+#include "ParticlePool.h"
+#include "InstancePacking.h"
+#include "SpriteAtlas.h"
+
+enum class ParticleRenderMode
 {
-	glm::vec2 Position;
-	glm::vec2 Velocity, VelocityVariation;
-	glm::vec4 ColorBegin, ColorEnd;
-	float SizeBegin, SizeEnd, SizeVariation;
-	float LifeTime = 1.0f;
+	Sprites = 0, DensityField
 };
 
 class ParticleSystem
 {
 public:
-	ParticleSystem();
+	ParticleSystem(uint32_t maxParticles = 1000);
+	~ParticleSystem();
 
 	void OnUpdate(GLCore::Timestep ts);
 	void OnRender(GLCore::Utils::OrthographicCamera& camera);
 
 	void Emit(const ParticleProps& particleProps);
+	uint32_t EmitBurst(const ParticleProps& particleProps, uint32_t count) { return m_Pool.EmitBurst(particleProps, count); }
+
+	void SetRenderMode(ParticleRenderMode mode) { m_RenderMode = mode; }
+	ParticleRenderMode GetRenderMode() const { return m_RenderMode; }
+	DensityField& GetDensityField() { return m_DensityField; }
+	ParticlePool& GetPool() { return m_Pool; }
+
+	// Textured particles: flipbook frames are chosen per particle from ParticleProps::Flipbook. nullptr = flat quads.
+	void SetSpriteAtlas(const std::shared_ptr<SpriteAtlas>& atlas) { m_SpriteAtlas = atlas; }
+	const std::shared_ptr<SpriteAtlas>& GetSpriteAtlas() const { return m_SpriteAtlas; }
+
+	// Upload flat quads as 12-byte PackedParticleInstance records instead of 32-byte ParticleInstance
+	void SetPackedInstances(bool packed) { m_PackedInstances = packed; }
+	bool GetPackedInstances() const { return m_PackedInstances; }
+	uint64_t GetUploadedBytes() const { return m_UploadedBytes; }
+	uint32_t GetInstanceCount() const { return m_InstanceCount; }
+
+	// Integrate, cull and pack packed flat quads in one pass in OnRender() (ParticlePool::UpdateAndPack).
+	// Scripted behaviors, colliders, constraint bodies, sprites and the density field fall back to the separate passes.
+	void SetFusedUpdate(bool fused) { m_FusedUpdate = fused; }
+	bool GetFusedUpdate() const { return m_FusedUpdate; }
+	bool IsFusing() const { return m_Fusing; }
+	// Estimated CPU memory traffic of the last frame's update and render prep
+	const ParticleTraffic& GetTraffic() const { return m_Traffic; }
+	const FusedUpdateStats& GetFusedStats() const { return m_FusedStats; }
+
+	// Advects particles through a stable-fluids velocity grid and draws its dye under them
+	void SetFluidEnabled(bool enabled) { m_FluidEnabled = enabled; }
+	bool GetFluidEnabled() const { return m_FluidEnabled; }
+	FluidGrid& GetFluid() { return m_Fluid; }
+
+	// Ropes and soft bodies made of particles reserved from the pool
+	ConstraintSolver& GetConstraints() { return m_Constraints; }
+
+	// Moving obstacles particles bounce off after every update; call Build() on it after changing them
+	ColliderSet& GetColliders() { return m_Colliders; }
+
+	// Local wind zones, fans and shockwaves, applied before integration
+	ForceVolumeSet& GetForceVolumes() { return m_ForceVolumes; }
+
+	// Where particles flagged with ParticleStampFlags end up; drawn under the live particles
+	ParticleCanvas& GetCanvas() { return m_Canvas; }
+	uint64_t GetCanvasUploadedBytes() const { return m_CanvasUploadedBytes; }
+private:
+	bool CanFuse() const;
+	void InitRenderer();
+	void RenderDensityField(GLCore::Utils::OrthographicCamera& camera);
+	void RenderFluidDye(GLCore::Utils::OrthographicCamera& camera);
+	void RenderCanvas(GLCore::Utils::OrthographicCamera& camera);
 private:
-	struct Particle
-	{
-		glm::vec2 Position;
-		glm::vec2 Velocity;
-		glm::vec4 ColorBegin, ColorEnd;
-		float Rotation = 0.0f;
-		float SizeBegin, SizeEnd;
-
-		float LifeTime = 1.0f;
-		float LifeRemaining = 0.0f;
-
-		bool Active = false;
-	};
-	std::vector<Particle> m_ParticlePool;
-	uint32_t m_PoolIndex = 999;
-
-	GLuint m_QuadVA = 0;
+	ParticlePool m_Pool;
+	ConstraintSolver m_Constraints{ m_Pool };
+	ColliderSet m_Colliders;
+	ForceVolumeSet m_ForceVolumes;
+	// Double-buffered by frame parity: the render thread may still upload last frame's instances
+	std::vector<ParticleInstance> m_Instances[2];
+	std::vector<ParticleSpriteInstance> m_SpriteInstances[2];
+	std::vector<PackedParticleInstance> m_PackedInstanceData[2];
+	uint32_t m_InstanceCount = 0;
+	bool m_PackedInstances = true;
+	uint64_t m_UploadedBytes = 0;
+
+	bool m_FusedUpdate = false, m_Fusing = false;
+	bool m_StepPending = false; // OnUpdate() left integration to OnRender()
+	float m_PendingStep = 0.0f;
+	ParticleTraffic m_Traffic;
+	FusedUpdateStats m_FusedStats;
+
+	bool m_Initialized = false;
+	GLuint m_QuadVA = 0, m_QuadVB = 0, m_QuadIB = 0, m_InstanceVB = 0;
 	std::unique_ptr<GLCore::Utils::Shader> m_ParticleShader;
-	GLint m_ParticleShaderViewProj, m_ParticleShaderTransform, m_ParticleShaderColor;
+	GLuint m_ParticleShaderProgram = 0;
+	GLint m_ParticleShaderViewProj;
+
+	GLuint m_PackedVA = 0, m_PackedInstanceVB = 0;
+	std::unique_ptr<GLCore::Utils::Shader> m_PackedShader;
+	GLuint m_PackedShaderProgram = 0;
+	GLint m_PackedShaderViewProj, m_PackedShaderBounds;
+
+	std::shared_ptr<SpriteAtlas> m_SpriteAtlas;
+	GLuint m_SpriteVA = 0, m_SpriteInstanceVB = 0;
+	std::unique_ptr<GLCore::Utils::Shader> m_SpriteShader;
+	GLuint m_SpriteShaderProgram = 0;
+	GLint m_SpriteShaderViewProj;
+
+	ParticleRenderMode m_RenderMode = ParticleRenderMode::Sprites;
+	DensityField m_DensityField;
+
+	FluidGrid m_Fluid;
+	bool m_FluidEnabled = false;
+	uint32_t m_DyeTextureWidth = 0, m_DyeTextureHeight = 0;
+	GLuint m_DyeVA = 0, m_DyeTexture = 0;
+	std::unique_ptr<GLCore::Utils::Shader> m_DyeShader;
+	GLuint m_DyeShaderProgram = 0;
+	GLint m_DyeShaderViewProj, m_DyeShaderBounds, m_DyeShaderColor;
+
+	ParticleCanvas m_Canvas;
+	uint32_t m_CanvasTextureWidth = 0, m_CanvasTextureHeight = 0;
+	GLuint m_CanvasTexture = 0;
+	std::unique_ptr<GLCore::Utils::Shader> m_CanvasShader;
+	GLuint m_CanvasShaderProgram = 0;
+	GLint m_CanvasShaderViewProj, m_CanvasShaderBounds;
+	uint64_t m_CanvasUploadedBytes = 0;
 };
@@ -1,4 +1,4 @@
 #include "Random.h"
 
 std::mt19937 Random::s_RandomEngine;
-std::uniform_int_distribution<std::mt19937::result_type> Random::s_Distribution;
+std::uniform_int_distribution<uint32_t> Random::s_Distribution;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <random>
 
 class Random
@@ -17,5 +19,5 @@ public:
 
 private:
 	static std::mt19937 s_RandomEngine;
-	static std::uniform_int_distribution<std::mt19937::result_type> s_Distribution;
+	static std::uniform_int_distribution<uint32_t> s_Distribution;
 };
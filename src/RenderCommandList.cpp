@@ -0,0 +1,195 @@
+#include "RenderCommandList.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+RenderCommand& RenderCommandList::Push(RenderCommandType type)
+{
+	RenderCommand& command = m_Commands.emplace_back();
+	command.Type = type;
+	return command;
+}
+
+void RenderCommandList::Clear(const glm::vec4& color, GLbitfield mask)
+{
+	RenderCommand& command = Push(RenderCommandType::Clear);
+	std::memcpy(command.Clear.Color, glm::value_ptr(color), sizeof(command.Clear.Color));
+	command.Clear.Mask = mask;
+}
+
+void RenderCommandList::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	RenderCommand& command = Push(RenderCommandType::Viewport);
+	command.Viewport = { x, y, width, height };
+}
+
+void RenderCommandList::UseProgram(const GLuint* program)
+{
+	Push(RenderCommandType::UseProgram).UseProgram.Program = program;
+}
+
+void RenderCommandList::UniformMat4(const GLint* location, const glm::mat4& value)
+{
+	RenderCommand& command = Push(RenderCommandType::UniformMat4);
+	command.UniformMat4.Location = location;
+	std::memcpy(command.UniformMat4.Value, glm::value_ptr(value), sizeof(command.UniformMat4.Value));
+}
+
+void RenderCommandList::Uniform4f(const GLint* location, const glm::vec4& value)
+{
+	RenderCommand& command = Push(RenderCommandType::Uniform4f);
+	command.Uniform4f.Location = location;
+	std::memcpy(command.Uniform4f.Value, glm::value_ptr(value), sizeof(command.Uniform4f.Value));
+}
+
+void RenderCommandList::Uniform1f(const GLint* location, float value)
+{
+	RenderCommand& command = Push(RenderCommandType::Uniform1f);
+	command.Uniform1f = { location, value };
+}
+
+void RenderCommandList::Uniform1i(const GLint* location, GLint value)
+{
+	RenderCommand& command = Push(RenderCommandType::Uniform1i);
+	command.Uniform1i = { location, value };
+}
+
+void RenderCommandList::BindTexture(GLuint unit, const GLuint* texture)
+{
+	RenderCommand& command = Push(RenderCommandType::BindTexture);
+	command.BindTexture = { unit, texture };
+}
+
+void RenderCommandList::UploadBuffer(const GLuint* buffer, const void* data, GLsizeiptr size)
+{
+	RenderCommand& command = Push(RenderCommandType::UploadBuffer);
+	command.UploadBuffer = { buffer, data, size };
+}
+
+void RenderCommandList::UploadTexture2D(const GLuint* texture, GLsizei width, GLsizei height, GLenum format, GLenum dataType, const void* data)
+{
+	RenderCommand& command = Push(RenderCommandType::UploadTexture2D);
+	command.UploadTexture2D = { texture, width, height, format, dataType, data };
+}
+
+void RenderCommandList::UploadTextureRegion(const GLuint* texture, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum dataType, const void* data)
+{
+	RenderCommand& command = Push(RenderCommandType::UploadTextureRegion);
+	command.UploadTextureRegion = { texture, x, y, width, height, format, dataType, data };
+}
+
+void RenderCommandList::DrawElementsInstanced(const GLuint* vertexArray, GLsizei indexCount, GLsizei instanceCount)
+{
+	RenderCommand& command = Push(RenderCommandType::DrawElementsInstanced);
+	command.DrawElementsInstanced = { vertexArray, indexCount, instanceCount };
+}
+
+void RenderCommandList::DrawArrays(const GLuint* vertexArray, GLint first, GLsizei count)
+{
+	RenderCommand& command = Push(RenderCommandType::DrawArrays);
+	command.DrawArrays = { vertexArray, first, count };
+}
+
+void RenderCommandList::QueryCounter(const GLuint* query)
+{
+	Push(RenderCommandType::QueryCounter).QueryCounter.Query = query;
+}
+
+void RenderCommandList::Execute(std::function<void()> func)
+{
+	Push(RenderCommandType::Execute).Execute.Index = (uint32_t)m_Functions.size();
+	m_Functions.push_back(std::move(func));
+}
+
+void* RenderCommandList::Allocate(size_t size)
+{
+	size = (size + 15) & ~(size_t)15;
+
+	while (m_CurrentBlock < m_Blocks.size() && m_Blocks[m_CurrentBlock].Size - m_Blocks[m_CurrentBlock].Used < size)
+		m_CurrentBlock++;
+
+	if (m_CurrentBlock == m_Blocks.size())
+	{
+		Block& block = m_Blocks.emplace_back();
+		block.Size = std::max(s_BlockSize, size);
+		block.Data = std::make_unique<uint8_t[]>(block.Size);
+	}
+
+	Block& block = m_Blocks[m_CurrentBlock];
+	void* memory = block.Data.get() + block.Used;
+	block.Used += size;
+	return memory;
+}
+
+void RenderCommandList::Replay()
+{
+	for (const RenderCommand& command : m_Commands)
+	{
+		switch (command.Type)
+		{
+			case RenderCommandType::Clear:
+				glClearColor(command.Clear.Color[0], command.Clear.Color[1], command.Clear.Color[2], command.Clear.Color[3]);
+				glClear(command.Clear.Mask);
+				break;
+			case RenderCommandType::Viewport:
+				glViewport(command.Viewport.X, command.Viewport.Y, command.Viewport.Width, command.Viewport.Height);
+				break;
+			case RenderCommandType::UseProgram:
+				glUseProgram(*command.UseProgram.Program);
+				break;
+			case RenderCommandType::UniformMat4:
+				glUniformMatrix4fv(*command.UniformMat4.Location, 1, GL_FALSE, command.UniformMat4.Value);
+				break;
+			case RenderCommandType::Uniform4f:
+				glUniform4fv(*command.Uniform4f.Location, 1, command.Uniform4f.Value);
+				break;
+			case RenderCommandType::Uniform1f:
+				glUniform1f(*command.Uniform1f.Location, command.Uniform1f.Value);
+				break;
+			case RenderCommandType::Uniform1i:
+				glUniform1i(*command.Uniform1i.Location, command.Uniform1i.Value);
+				break;
+			case RenderCommandType::BindTexture:
+				glBindTextureUnit(command.BindTexture.Unit, *command.BindTexture.Texture);
+				break;
+			case RenderCommandType::UploadBuffer:
+				// Orphan and refill so the driver never waits on the previous frame's draw
+				glNamedBufferData(*command.UploadBuffer.Buffer, command.UploadBuffer.Size, command.UploadBuffer.Data, GL_STREAM_DRAW);
+				break;
+			case RenderCommandType::UploadTexture2D:
+				glTextureSubImage2D(*command.UploadTexture2D.Texture, 0, 0, 0, command.UploadTexture2D.Width, command.UploadTexture2D.Height,
+					command.UploadTexture2D.Format, command.UploadTexture2D.DataType, command.UploadTexture2D.Data);
+				break;
+			case RenderCommandType::UploadTextureRegion:
+				glTextureSubImage2D(*command.UploadTextureRegion.Texture, 0, command.UploadTextureRegion.X, command.UploadTextureRegion.Y,
+					command.UploadTextureRegion.Width, command.UploadTextureRegion.Height,
+					command.UploadTextureRegion.Format, command.UploadTextureRegion.DataType, command.UploadTextureRegion.Data);
+				break;
+			case RenderCommandType::DrawElementsInstanced:
+				glBindVertexArray(*command.DrawElementsInstanced.VertexArray);
+				glDrawElementsInstanced(GL_TRIANGLES, command.DrawElementsInstanced.IndexCount, GL_UNSIGNED_INT, nullptr, command.DrawElementsInstanced.InstanceCount);
+				break;
+			case RenderCommandType::DrawArrays:
+				glBindVertexArray(*command.DrawArrays.VertexArray);
+				glDrawArrays(GL_TRIANGLES, command.DrawArrays.First, command.DrawArrays.Count);
+				break;
+			case RenderCommandType::QueryCounter:
+				glQueryCounter(*command.QueryCounter.Query, GL_TIMESTAMP);
+				break;
+			case RenderCommandType::Execute:
+				m_Functions[command.Execute.Index]();
+				break;
+		}
+	}
+}
+
+void RenderCommandList::Reset()
+{
+	m_Commands.clear();
+	m_Functions.clear();
+	for (Block& block : m_Blocks)
+		block.Used = 0;
+	m_CurrentBlock = 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// GL handles and uniform locations are passed by address: they are created by
+// Execute() callbacks on the render thread and only read back during replay.
+enum class RenderCommandType : uint8_t
+{
+	Clear, Viewport, UseProgram, UniformMat4, Uniform4f, Uniform1f, Uniform1i,
+	BindTexture, UploadBuffer, UploadTexture2D, UploadTextureRegion, DrawElementsInstanced, DrawArrays, QueryCounter, Execute
+};
+
+struct RenderCommand
+{
+	RenderCommandType Type;
+	union
+	{
+		struct { float Color[4]; GLbitfield Mask; } Clear;
+		struct { GLint X, Y; GLsizei Width, Height; } Viewport;
+		struct { const GLuint* Program; } UseProgram;
+		struct { const GLint* Location; float Value[16]; } UniformMat4;
+		struct { const GLint* Location; float Value[4]; } Uniform4f;
+		struct { const GLint* Location; float Value; } Uniform1f;
+		struct { const GLint* Location; GLint Value; } Uniform1i;
+		struct { GLuint Unit; const GLuint* Texture; } BindTexture;
+		struct { const GLuint* Buffer; const void* Data; GLsizeiptr Size; } UploadBuffer;
+		struct { const GLuint* Texture; GLsizei Width, Height; GLenum Format, DataType; const void* Data; } UploadTexture2D;
+		struct { const GLuint* Texture; GLint X, Y; GLsizei Width, Height; GLenum Format, DataType; const void* Data; } UploadTextureRegion;
+		struct { const GLuint* VertexArray; GLsizei IndexCount, InstanceCount; } DrawElementsInstanced;
+		struct { const GLuint* VertexArray; GLint First; GLsizei Count; } DrawArrays;
+		struct { const GLuint* Query; } QueryCounter;
+		struct { uint32_t Index; } Execute;
+	};
+};
+
+// One frame worth of recorded GL work. Recording is cheap and GL-free;
+// Replay() must run on the thread that owns the context.
+class RenderCommandList
+{
+public:
+	void Clear(const glm::vec4& color, GLbitfield mask = GL_COLOR_BUFFER_BIT);
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	void UseProgram(const GLuint* program);
+	void UniformMat4(const GLint* location, const glm::mat4& value);
+	void Uniform4f(const GLint* location, const glm::vec4& value);
+	void Uniform1f(const GLint* location, float value);
+	void Uniform1i(const GLint* location, GLint value);
+	void BindTexture(GLuint unit, const GLuint* texture);
+
+	// `data` is not copied. It must stay untouched until the frame after next has been
+	// recorded (double-buffer it per RenderThread::GetFrameIndex()), or come from Allocate().
+	void UploadBuffer(const GLuint* buffer, const void* data, GLsizeiptr size);
+	void UploadTexture2D(const GLuint* texture, GLsizei width, GLsizei height, GLenum format, GLenum dataType, const void* data);
+	// Tightly packed `width` x `height` texels at (x, y) of mip 0
+	void UploadTextureRegion(const GLuint* texture, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum dataType, const void* data);
+
+	void DrawElementsInstanced(const GLuint* vertexArray, GLsizei indexCount, GLsizei instanceCount);
+	void DrawArrays(const GLuint* vertexArray, GLint first, GLsizei count);
+	// GL_TIMESTAMP query, written when the GPU reaches this point of the list
+	void QueryCounter(const GLuint* query);
+
+	// Escape hatch for rare work such as creating or deleting GL objects
+	void Execute(std::function<void()> func);
+
+	// Scratch memory that lives until this list is replayed
+	void* Allocate(size_t size);
+
+	uint32_t GetCommandCount() const { return (uint32_t)m_Commands.size(); }
+
+	void Replay();
+	void Reset();
+private:
+	RenderCommand& Push(RenderCommandType type);
+private:
+	std::vector<RenderCommand> m_Commands;
+	std::vector<std::function<void()>> m_Functions;
+
+	static constexpr size_t s_BlockSize = 64 * 1024;
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> Data;
+		size_t Size = 0, Used = 0;
+	};
+	std::vector<Block> m_Blocks;
+	size_t m_CurrentBlock = 0;
+};
@@ -0,0 +1,200 @@
+#include "RenderThread.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+	using Clock = RenderThread::Clock;
+
+	struct FrameTimesSlot
+	{
+		uint64_t Frame = UINT64_MAX;
+		RenderThread::FrameTimes Times;
+	};
+
+	struct RenderThreadState
+	{
+		RenderCommandList Lists[2];
+		uint32_t RecordIndex = 0;
+		uint64_t FrameIndex = 0;
+
+		std::thread Thread;
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		RenderCommandList* Pending = nullptr;
+		uint64_t PendingFrame = 0;
+		Clock::time_point PendingSubmitted;
+		bool Busy = false;
+		bool Running = false;
+
+		std::function<void()> Present, Release;
+
+		std::array<FrameTimesSlot, 8> History; // guarded by Mutex
+	};
+
+	RenderThreadState s_Render;
+
+	void StoreFrameTimes(uint64_t frame, const RenderThread::FrameTimes& times)
+	{
+		FrameTimesSlot& slot = s_Render.History[frame % s_Render.History.size()];
+		slot.Frame = frame;
+		slot.Times = times;
+	}
+
+	void RenderMain(std::function<void()> makeCurrent)
+	{
+		makeCurrent();
+
+		for (;;)
+		{
+			RenderCommandList* list;
+			bool running;
+			uint64_t frame;
+			RenderThread::FrameTimes times;
+			{
+				std::unique_lock<std::mutex> lock(s_Render.Mutex);
+				s_Render.Condition.wait(lock, [] { return s_Render.Pending || !s_Render.Running; });
+				list = s_Render.Pending;
+				running = s_Render.Running;
+				frame = s_Render.PendingFrame;
+				times.Submitted = s_Render.PendingSubmitted;
+				s_Render.Pending = nullptr;
+			}
+
+			if (list)
+			{
+				times.ReplayStart = Clock::now();
+				list->Replay();
+				times.Replayed = Clock::now();
+				// The list Stop() flushes is not a frame
+				if (running && s_Render.Present)
+				{
+					s_Render.Present();
+					times.Presented = Clock::now();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(s_Render.Mutex);
+					if (running)
+						StoreFrameTimes(frame, times);
+					s_Render.Busy = false;
+				}
+				s_Render.Condition.notify_all();
+			}
+
+			if (!running)
+				break;
+		}
+
+		if (s_Render.Release)
+			s_Render.Release();
+	}
+
+	void WaitUntilIdle(std::unique_lock<std::mutex>& lock)
+	{
+		s_Render.Condition.wait(lock, [] { return !s_Render.Busy; });
+	}
+
+}
+
+void RenderThread::Start(std::function<void()> makeCurrent, std::function<void()> present, std::function<void()> release)
+{
+	if (s_Render.Running)
+		return;
+
+	s_Render.Present = std::move(present);
+	s_Render.Release = std::move(release);
+	s_Render.Running = true;
+	s_Render.Thread = std::thread(RenderMain, std::move(makeCurrent));
+}
+
+void RenderThread::Stop()
+{
+	RenderCommandList& recorded = s_Render.Lists[s_Render.RecordIndex];
+	if (!s_Render.Running)
+	{
+		recorded.Replay();
+		recorded.Reset();
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(s_Render.Mutex);
+		WaitUntilIdle(lock);
+		s_Render.Pending = &recorded;
+		s_Render.Busy = true;
+		s_Render.Running = false;
+	}
+	s_Render.Condition.notify_all();
+	s_Render.Thread.join();
+	recorded.Reset();
+}
+
+bool RenderThread::IsThreaded()
+{
+	return s_Render.Running;
+}
+
+RenderCommandList& RenderThread::GetCommandList()
+{
+	return s_Render.Lists[s_Render.RecordIndex];
+}
+
+uint64_t RenderThread::GetFrameIndex()
+{
+	return s_Render.FrameIndex;
+}
+
+void RenderThread::EndFrame()
+{
+	RenderCommandList& recorded = s_Render.Lists[s_Render.RecordIndex];
+	uint64_t frame = s_Render.FrameIndex++;
+	Clock::time_point submitted = Clock::now();
+
+	if (!s_Render.Running)
+	{
+		FrameTimes times;
+		times.Submitted = times.ReplayStart = submitted;
+		recorded.Replay();
+		recorded.Reset();
+		times.Replayed = Clock::now();
+
+		std::lock_guard<std::mutex> lock(s_Render.Mutex);
+		StoreFrameTimes(frame, times);
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(s_Render.Mutex);
+		WaitUntilIdle(lock);
+		s_Render.Pending = &recorded;
+		s_Render.PendingFrame = frame;
+		s_Render.PendingSubmitted = submitted;
+		s_Render.Busy = true;
+	}
+	s_Render.Condition.notify_all();
+
+	// The other list was replayed before the render thread went idle above
+	s_Render.RecordIndex ^= 1;
+	s_Render.Lists[s_Render.RecordIndex].Reset();
+}
+
+void RenderThread::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(s_Render.Mutex);
+	WaitUntilIdle(lock);
+}
+
+bool RenderThread::GetFrameTimes(uint64_t frame, FrameTimes& times)
+{
+	std::lock_guard<std::mutex> lock(s_Render.Mutex);
+	const FrameTimesSlot& slot = s_Render.History[frame % s_Render.History.size()];
+	if (slot.Frame != frame)
+		return false;
+	times = slot.Times;
+	return true;
+}
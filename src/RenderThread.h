@@ -0,0 +1,46 @@
+#pragma once
+
+#include "RenderCommandList.h"
+
+#include <chrono>
+#include <functional>
+
+// Replays recorded command lists on a thread that owns the GL context.
+// The main thread records frame N while frame N - 1 is replayed, so latency
+// grows by at most one frame. Until Start() is called every list is replayed
+// inline in EndFrame(), which is what hosts that keep the context on the main
+// thread (GLCore) use.
+class RenderThread
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct FrameTimes
+	{
+		Clock::time_point Submitted;           // EndFrame() was called
+		Clock::time_point ReplayStart, Replayed;
+		Clock::time_point Presented;           // present returned; unset when the host presents after an inline replay
+	};
+
+	// makeCurrent runs first on the new thread, present after each replayed frame,
+	// and release last, once Stop() has flushed the final list
+	static void Start(std::function<void()> makeCurrent, std::function<void()> present, std::function<void()> release);
+	// Replays whatever was recorded since the last EndFrame() (GL deletes from destructors) without
+	// presenting it, then joins. Without a render thread the list is replayed inline on the caller's context.
+	static void Stop();
+
+	static bool IsThreaded();
+
+	// List the main thread records into for the current frame
+	static RenderCommandList& GetCommandList();
+	// Incremented by EndFrame(); use its parity to double-buffer data handed to UploadBuffer
+	static uint64_t GetFrameIndex();
+
+	// Hands the recorded list over. Blocks only while the render thread is still busy with the previous frame.
+	static void EndFrame();
+	// Blocks until every handed-over frame has been replayed and presented
+	static void WaitIdle();
+	// Times of the frame recorded while GetFrameIndex() was `frame`; false until it has been replayed
+	// (and, on the render thread, presented), and once it is more than a few frames old
+	static bool GetFrameTimes(uint64_t frame, FrameTimes& times);
+};
@@ -21,8 +21,13 @@ public:
 	}
 };
 
-int main()
+int main(int argc, char** argv)
 {
+#ifdef GLCORE_SDL2
+	if (!Application::ParseCommandLine(argc, argv))
+		return 1;
+#endif
+
 	std::unique_ptr<Sandbox> app = std::make_unique<Sandbox>();
 	app->Run();
 }
@@ -1,5 +1,14 @@
 #include "SandboxLayer.h"
 
+#include "AllocationCounter.h"
+#include "EffectCompiler.h"
+#include "GpuProfiler.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+
+#include <ctime>
+#include <filesystem>
+
 using namespace GLCore;
 using namespace GLCore::Utils;
 
@@ -14,10 +23,15 @@ SandboxLayer::~SandboxLayer()
 
 void SandboxLayer::OnAttach()
 {
-	EnableGLDebugging();
+	JobSystem::Init();
+
+	RenderThread::GetCommandList().Execute([]()
+	{
+		EnableGLDebugging();
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	});
 
 	// Init here
 	m_Particle.ColorBegin = { 254 / 255.0f, 212 / 255.0f, 123 / 255.0f, 1.0f };
@@ -27,11 +41,164 @@ void SandboxLayer::OnAttach()
 	m_Particle.Velocity = { 0.0f, 0.0f };
 	m_Particle.VelocityVariation = { 3.0f, 1.0f };
 	m_Particle.Position = { 0.0f, 0.0f };
+
+	// Optional 4x4 flipbook sheet; flat quads are used when it is missing
+	auto atlas = std::make_shared<SpriteAtlas>();
+	if (atlas->LoadKTX("assets/particles.ktx"))
+	{
+		uint32_t firstFrame = atlas->AddGrid({ 0.0f, 0.0f, (float)atlas->GetWidth(), (float)atlas->GetHeight() }, 4, 4);
+		uint32_t flipbook = atlas->AddFlipbook(firstFrame, 16);
+		if (flipbook != SpriteAtlas::InvalidIndex)
+		{
+			m_Particle.Flipbook = flipbook;
+			m_SpriteAtlas = atlas;
+		}
+	}
+
+	LoadBehavior();
+	LoadEffects();
+
+	m_Telemetry.Open(TelemetryProps(), m_TelemetryError);
 }
 
 void SandboxLayer::OnDetach()
 {
 	// Shutdown here
+	WritePendingTelemetry(std::chrono::steady_clock::now(), true);
+	m_Telemetry.Close();
+	JobSystem::Shutdown();
+}
+
+void SandboxLayer::LoadBehavior()
+{
+	m_Behavior = ParticleBehavior::FromFile("assets/effects/embers.behavior", m_BehaviorError);
+	if (!m_Behavior)
+		m_UseBehavior = false;
+	m_ParticleSystem.GetPool().SetBehavior(m_UseBehavior ? m_Behavior : nullptr);
+}
+
+void SandboxLayer::LoadEffects()
+{
+	m_Sequencer.SetLibrary(&m_Effects);
+
+	// Prefer the compiled library; fall back to compiling the source in memory
+	if (m_Effects.Load("assets/effects.pfx", m_EffectsError))
+		return;
+
+	EffectCompiler compiler;
+	if (compiler.AddFile("assets/effects/library.effect", m_EffectsError))
+		m_Effects.Load(compiler.Build(), m_EffectsError);
+	m_SelectedEffect = 0;
+}
+
+// Circles, capsules and boxes drifting on Lissajous paths across the view
+void SandboxLayer::UpdateColliders(float ts)
+{
+	ColliderSet& set = m_ParticleSystem.GetColliders();
+	std::vector<Collider>& colliders = set.GetColliders();
+	if (!m_CollidersEnabled)
+	{
+		if (!colliders.empty())
+		{
+			colliders.clear();
+			set.Build();
+		}
+		return;
+	}
+
+	m_ColliderTime += ts;
+	auto bounds = m_CameraController.GetBounds();
+	glm::vec2 center = m_CameraController.GetCamera().GetPosition();
+	glm::vec2 half = glm::vec2(bounds.GetWidth(), bounds.GetHeight()) * 0.45f;
+	float size = 0.35f * std::sqrt(4.0f * half.x * half.y / m_ColliderCount);
+
+	colliders.resize(m_ColliderCount);
+	for (int i = 0; i < m_ColliderCount; i++)
+	{
+		float speed = 0.2f + 0.05f * (i % 7);
+		float a = m_ColliderTime * speed + i * 2.4f, b = 1.3f * m_ColliderTime * speed + i * 1.7f;
+		glm::vec2 position = center + half * glm::vec2(std::sin(a), std::sin(b));
+
+		Collider& collider = colliders[i];
+		collider.Shape = (ColliderShape)(i % 3);
+		collider.Velocity = half * glm::vec2(std::cos(a) * speed, std::cos(b) * 1.3f * speed);
+		collider.Position = position;
+		collider.Radius = size;
+		if (collider.Shape == ColliderShape::Capsule)
+		{
+			glm::vec2 direction = { std::cos(a * 1.5f), std::sin(a * 1.5f) };
+			collider.Position = position - direction * size;
+			collider.End = position + direction * size;
+			collider.Radius = size * 0.5f;
+		}
+		else if (collider.Shape == ColliderShape::Box)
+		{
+			collider.HalfExtents = { size, size * 0.5f };
+			collider.Rotation = a * 2.0f;
+		}
+	}
+	set.Build();
+}
+
+// Drifting wind zones, turning fans and repeating shockwaves scattered over the view
+void SandboxLayer::UpdateForceVolumes(float ts)
+{
+	ForceVolumeSet& set = m_ParticleSystem.GetForceVolumes();
+	int count = m_ForceVolumesEnabled ? m_ForceVolumeCount : 0;
+	while ((int)m_ForceVolumeIds.size() > count)
+	{
+		set.Remove(m_ForceVolumeIds.back());
+		m_ForceVolumeIds.pop_back();
+	}
+	if (count == 0)
+		return;
+	while ((int)m_ForceVolumeIds.size() < count)
+		m_ForceVolumeIds.push_back(set.Add(ForceVolume()));
+
+	m_ForceVolumeTime += ts;
+	auto bounds = m_CameraController.GetBounds();
+	glm::vec2 center = m_CameraController.GetCamera().GetPosition();
+	glm::vec2 half = glm::vec2(bounds.GetWidth(), bounds.GetHeight()) * 0.45f;
+	float size = 0.4f * std::sqrt(4.0f * half.x * half.y / count);
+	set.SetGrid(center - half * 1.2f, center + half * 1.2f, size * 2.0f);
+
+	for (int i = 0; i < count; i++)
+	{
+		// Fixed scattered anchors, so fans and shockwaves keep their cells
+		glm::vec2 anchor = center + half * glm::vec2(std::sin(i * 2.4f + 0.3f), std::sin(i * 1.7f + 1.1f));
+		float phase = m_ForceVolumeTime * (0.3f + 0.05f * (i % 5)) + i;
+
+		ForceVolume volume;
+		switch (i % 3)
+		{
+			case 0:
+				volume.Shape = ForceVolumeShape::Box;
+				volume.Position = anchor + glm::vec2(std::sin(phase) * size, 0.0f);
+				volume.HalfExtents = { size, size * 0.5f };
+				volume.Force = glm::vec2(std::cos(phase * 0.7f), 0.3f) * 4.0f;
+				break;
+			case 1:
+				volume.Shape = ForceVolumeShape::Cone;
+				volume.Position = anchor;
+				volume.Radius = size * 2.0f;
+				volume.Rotation = phase;
+				volume.Angle = 0.35f;
+				volume.Radial = 6.0f;
+				volume.Falloff = 1.0f;
+				break;
+			default:
+			{
+				float age = phase - std::floor(phase);
+				volume.Shape = ForceVolumeShape::Sphere;
+				volume.Position = anchor;
+				volume.Radius = size * 1.5f * age;
+				volume.Radial = 20.0f * (1.0f - age);
+				volume.Falloff = 1.0f;
+				break;
+			}
+		}
+		set.Set(m_ForceVolumeIds[i], volume);
+	}
 }
 
 void SandboxLayer::OnEvent(Event& event)
@@ -42,19 +209,38 @@ void SandboxLayer::OnEvent(Event& event)
 	if (event.GetEventType() == EventType::WindowResize)
 	{
 		WindowResizeEvent& e = (WindowResizeEvent&)event;
-		glViewport(0, 0, e.GetWidth(), e.GetHeight());
+		RenderThread::GetCommandList().Viewport(0, 0, e.GetWidth(), e.GetHeight());
+
+		// Captures keep the size they started with
+		if (m_Capture.IsCapturing())
+		{
+			m_Capture.Stop();
+			m_CaptureError = "stopped: window resized";
+		}
 	}
 }
 
 void SandboxLayer::OnUpdate(Timestep ts)
 {
+	using Clock = std::chrono::steady_clock;
+	auto toMs = [](Clock::duration duration) { return std::chrono::duration<float, std::milli>(duration).count(); };
+	Clock::time_point frameStart = Clock::now();
+	WritePendingTelemetry(frameStart, false);
+	AllocationStats allocationsBefore = GetAllocationStats();
+
+	m_Latency.BeginFrame();
+	m_Latency.MarkInputSampled();
+
 	m_CameraController.OnUpdate(ts);
 
 	// Render here
 
-	//glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-	glClearColor(0,0,0, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+	GpuProfiler::BeginFrame();
+	{
+		GpuProfileScope zone("Clear");
+		//RenderThread::GetCommandList().Clear({ 0.1f, 0.1f, 0.1f, 1.0f });
+		RenderThread::GetCommandList().Clear({ 0, 0, 0, 1.0f });
+	}
 
 	if (GLCore::Input::IsMouseButtonPressed(HZ_MOUSE_BUTTON_LEFT))
 	{
@@ -67,12 +253,109 @@ void SandboxLayer::OnUpdate(Timestep ts)
 		x = (x / width) * bounds.GetWidth() - bounds.GetWidth() * 0.5f;
 		y = bounds.GetHeight() * 0.5f - (y / height) * bounds.GetHeight();
 		m_Particle.Position = { x + pos.x, y + pos.y };
-		for (int i = 0; i < 5; i++)
-			m_ParticleSystem.Emit(m_Particle);
+		uint32_t effectCount = m_Effects.GetEffectCount();
+		if (m_SelectedEffect > (int)effectCount)
+		{
+			// Timelines play out on their own; a press starts one
+			if (!m_MouseWasDown)
+				m_Sequencer.Play(m_Effects.GetTimeline(m_SelectedEffect - 1 - effectCount), m_Particle.Position);
+		}
+		else if (m_SelectedEffect > 0)
+		{
+			// Each press restarts the effect
+			m_EffectTime = (m_MouseWasDown ? m_EffectTime : 0.0f) + ts;
+			m_Effects.Emit(m_Effects.GetEffect(m_SelectedEffect - 1), m_ParticleSystem.GetPool(), m_Particle.Position, m_EffectTime, ts);
+		}
+		else
+		{
+			for (int i = 0; i < 5; i++)
+				m_ParticleSystem.Emit(m_Particle);
+		}
+
+		// Dragging stirs the fluid along the mouse motion
+		if (m_ParticleSystem.GetFluidEnabled() && m_MouseWasDown && ts > 0.0f)
+		{
+			glm::vec2 velocity = (m_Particle.Position - m_LastMousePosition) / (float)ts;
+			m_ParticleSystem.GetFluid().AddSplat(m_Particle.Position, velocity * m_FluidForce, m_FluidDye, m_FluidRadius);
+		}
+		m_LastMousePosition = m_Particle.Position;
+		m_MouseWasDown = true;
 	}
+	else
+		m_MouseWasDown = false;
 
+	m_Sequencer.OnUpdate(m_ParticleSystem.GetPool(), ts);
+	UpdateColliders(ts);
+	UpdateForceVolumes(ts);
 	m_ParticleSystem.OnUpdate(ts);
+	m_Latency.MarkSimulated();
+	Clock::time_point updated = Clock::now();
+
 	m_ParticleSystem.OnRender(m_CameraController.GetCamera());
+	// Before ImGui, so previews come out without the UI
+	{
+		GpuProfileScope zone("Capture readback");
+		m_Capture.OnRender(RenderThread::GetCommandList());
+	}
+	m_Latency.MarkSubmitted(RenderThread::GetCommandList());
+	Clock::time_point rendered = Clock::now();
+	uint32_t commandCount = RenderThread::GetCommandList().GetCommandCount();
+	uint64_t renderFrame = RenderThread::GetFrameIndex();
+
+	GpuProfiler::EndFrame();
+	// A threaded host hands the list over itself once the UI is recorded; GLCore keeps
+	// the context on this thread, so there the list is replayed inline here
+	if (!RenderThread::IsThreaded())
+		RenderThread::EndFrame();
+
+	if (m_Telemetry.IsOpen())
+	{
+		// PresentMs is filled in once the frame has been swapped, at most two frames later
+		if (m_PendingTelemetryCount == m_PendingTelemetry.size())
+			WritePendingTelemetry(Clock::now(), true);
+		PendingTelemetry& pending = m_PendingTelemetry[(m_PendingTelemetryFirst + m_PendingTelemetryCount++) % m_PendingTelemetry.size()];
+		pending.RenderFrame = renderFrame;
+		pending.Rendered = rendered;
+
+		AllocationStats allocations = GetAllocationStats();
+		TelemetryRecord& record = pending.Record;
+		record = {};
+		record.Frame = m_TelemetryFrame++;
+		record.FrameMs = m_LastFrameStart == Clock::time_point() ? 0.0f : toMs(frameStart - m_LastFrameStart);
+		record.UpdateMs = toMs(updated - frameStart);
+		record.RenderMs = toMs(rendered - updated);
+		record.LiveParticles = m_ParticleSystem.GetPool().GetLiveCount();
+		record.CommandCount = commandCount;
+		record.Allocations = (uint32_t)(allocations.Count - allocationsBefore.Count);
+		record.AllocatedBytes = allocations.Bytes - allocationsBefore.Bytes;
+		record.UploadedBytes = m_ParticleSystem.GetUploadedBytes() - m_LastUploadedBytes;
+	}
+	m_LastFrameStart = frameStart;
+	m_LastUploadedBytes = m_ParticleSystem.GetUploadedBytes();
+}
+
+// Logs the frames whose swap time is known. `now` stands in for it when the list was replayed
+// inline (the host swapped before this frame started), or for every frame when `force` is set.
+void SandboxLayer::WritePendingTelemetry(std::chrono::steady_clock::time_point now, bool force)
+{
+	while (m_PendingTelemetryCount > 0)
+	{
+		PendingTelemetry& pending = m_PendingTelemetry[m_PendingTelemetryFirst % m_PendingTelemetry.size()];
+		std::chrono::steady_clock::time_point presented = now;
+		RenderThread::FrameTimes times;
+		if (RenderThread::IsThreaded())
+		{
+			if (RenderThread::GetFrameTimes(pending.RenderFrame, times))
+				presented = times.Presented;
+			else if (!force)
+				break;
+		}
+
+		pending.Record.PresentMs = std::chrono::duration<float, std::milli>(presented - pending.Rendered).count();
+		m_Telemetry.Write(pending.Record);
+		m_PendingTelemetryFirst++;
+		m_PendingTelemetryCount--;
+	}
 }
 
 void SandboxLayer::OnImGuiRender()
@@ -80,8 +363,216 @@ void SandboxLayer::OnImGuiRender()
 	// ImGui here
 
 	ImGui::Begin("Settings");
+	std::vector<const char*> effectNames = { "(Settings)" };
+	for (uint32_t i = 0; i < m_Effects.GetEffectCount(); i++)
+		effectNames.push_back(m_Effects.GetName(m_Effects.GetEffect(i)));
+	for (uint32_t i = 0; i < m_Effects.GetTimelineCount(); i++)
+		effectNames.push_back(m_Effects.GetName(m_Effects.GetTimeline(i)));
+	ImGui::Combo("Effect", &m_SelectedEffect, effectNames.data(), (int)effectNames.size());
+	if (m_Effects.GetEffectCount() == 0)
+		ImGui::TextColored({ 1.0f, 0.4f, 0.3f, 1.0f }, "%s", m_EffectsError.c_str());
+	if (m_Sequencer.GetInstanceCount() > 0)
+		ImGui::Text("%u timelines playing %u effects", m_Sequencer.GetInstanceCount(), m_Sequencer.GetPlaybackCount());
+
 	ImGui::ColorEdit4("Birth Color", glm::value_ptr(m_Particle.ColorBegin));
 	ImGui::ColorEdit4("Death Color", glm::value_ptr(m_Particle.ColorEnd));
 	ImGui::DragFloat("Life Time", &m_Particle.LifeTime, 0.1f, 0.0f, 1000.0f);
+
+	const char* samplings[] = { "Random", "R2", "Sobol", "Blue Noise" };
+	int sampling = (int)m_Particle.Sampling;
+	if (ImGui::Combo("Sampling", &sampling, samplings, 4))
+		m_Particle.Sampling = (EmissionSampling)sampling;
+
+	// Settled particles are baked into the canvas and freed
+	bool stampOnDeath = m_Particle.Stamp & ParticleStampOnDeath, stampAtRest = m_Particle.Stamp & ParticleStampAtRest;
+	if (ImGui::Checkbox("Stamp On Death", &stampOnDeath))
+		m_Particle.Stamp ^= ParticleStampOnDeath;
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Stamp At Rest", &stampAtRest))
+		m_Particle.Stamp ^= ParticleStampAtRest;
+	ParticleCanvas& canvas = m_ParticleSystem.GetCanvas();
+	ImGui::Text("Canvas: %llu stamped, %.2f MB of tiles uploaded", (unsigned long long)canvas.GetStampedCount(),
+		m_ParticleSystem.GetCanvasUploadedBytes() / (1024.0f * 1024.0f));
+	ImGui::SameLine();
+	if (ImGui::Button("Clear Canvas"))
+		canvas.Clear();
+
+	if (ImGui::Button("Burst"))
+		m_ParticleSystem.EmitBurst(m_Particle, (uint32_t)m_BurstCount);
+	ImGui::SameLine();
+	ImGui::SliderInt("Burst Size", &m_BurstCount, 1, (int)m_ParticleSystem.GetPool().GetCapacity());
+
+	if (m_SpriteAtlas && ImGui::Checkbox("Textured", &m_Textured))
+		m_ParticleSystem.SetSpriteAtlas(m_Textured ? m_SpriteAtlas : nullptr);
+
+	if (ImGui::Checkbox("Behavior Script", &m_UseBehavior))
+		m_ParticleSystem.GetPool().SetBehavior(m_UseBehavior && m_Behavior ? m_Behavior : nullptr);
+	ImGui::SameLine();
+	if (ImGui::Button("Reload"))
+		LoadBehavior();
+	if (!m_Behavior)
+		ImGui::TextColored({ 1.0f, 0.4f, 0.3f, 1.0f }, "%s", m_BehaviorError.c_str());
+
+	bool packed = m_ParticleSystem.GetPackedInstances();
+	if (ImGui::Checkbox("Packed Instances", &packed))
+		m_ParticleSystem.SetPackedInstances(packed);
+	ImGui::SameLine();
+	bool fused = m_ParticleSystem.GetFusedUpdate();
+	if (ImGui::Checkbox("Fused Update", &fused))
+		m_ParticleSystem.SetFusedUpdate(fused);
+	const ParticleTraffic& traffic = m_ParticleSystem.GetTraffic();
+	ImGui::Text("%s: %.2f MB read, %.2f MB written", m_ParticleSystem.IsFusing() ? "Fused" : "Multi-pass",
+		traffic.ReadBytes / (1024.0f * 1024.0f), traffic.WrittenBytes / (1024.0f * 1024.0f));
+	if (m_ParticleSystem.IsFusing())
+		ImGui::Text("%u of %u live particles in view", m_ParticleSystem.GetFusedStats().InstanceCount, m_ParticleSystem.GetFusedStats().LiveCount);
+
+	EmissionThrottle& throttle = m_ParticleSystem.GetPool().GetThrottle();
+	ImGui::Checkbox("Density Throttle", &throttle.GetProps().Enabled);
+	if (throttle.IsEnabled())
+	{
+		ImGui::DragFloat("Saturation Opacity", &throttle.GetProps().Opacity, 0.0001f, 0.9f, 0.9999f, "%.4f");
+		const EmissionThrottleStats& stats = throttle.GetStats();
+		ImGui::Text("%u of %u emitted, %u saturated cells, %.2fx overdraw", stats.Emitted, stats.Emitted + stats.Dropped, stats.SaturatedCells, stats.Overdraw);
+	}
+
+	bool fluid = m_ParticleSystem.GetFluidEnabled();
+	if (ImGui::Checkbox("Fluid", &fluid))
+		m_ParticleSystem.SetFluidEnabled(fluid);
+	if (fluid)
+	{
+		FluidGridProps& fluidProps = m_ParticleSystem.GetFluid().GetProps();
+		int resolution[2] = { (int)fluidProps.Width, (int)fluidProps.Height };
+		if (ImGui::DragInt2("Fluid Resolution", resolution, 1.0f, 4, 1024))
+		{
+			fluidProps.Width = (uint32_t)resolution[0];
+			fluidProps.Height = (uint32_t)resolution[1];
+		}
+		int iterations = (int)fluidProps.PressureIterations;
+		if (ImGui::SliderInt("Pressure Iterations", &iterations, 1, 100))
+			fluidProps.PressureIterations = (uint32_t)iterations;
+		ImGui::DragFloat("Vorticity", &fluidProps.Vorticity, 0.05f, 0.0f, 20.0f);
+		ImGui::DragFloat("Coupling", &fluidProps.Coupling, 0.1f, 0.0f, 60.0f);
+		ImGui::DragFloat("Stir Force", &m_FluidForce, 0.1f, 0.0f, 100.0f);
+		ImGui::DragFloat("Dye", &m_FluidDye, 0.01f, 0.0f, 10.0f);
+		ImGui::ColorEdit4("Dye Color", glm::value_ptr(fluidProps.DyeColor));
+	}
+
+	ImGui::Checkbox("Moving Colliders", &m_CollidersEnabled);
+	if (m_CollidersEnabled)
+		ImGui::SliderInt("Collider Count", &m_ColliderCount, 1, 1000);
+
+	ImGui::Checkbox("Force Volumes", &m_ForceVolumesEnabled);
+	if (m_ForceVolumesEnabled)
+	{
+		ImGui::SliderInt("Volume Count", &m_ForceVolumeCount, 1, 5000);
+		const ForceVolumeStats& stats = m_ParticleSystem.GetForceVolumes().GetStats();
+		ImGui::Text("%u bins, %u particles, %llu tests, %u re-binned", stats.Bins, stats.BinnedParticles, (unsigned long long)stats.Tests, stats.Rebinned);
+	}
+
+	ConstraintSolver& constraints = m_ParticleSystem.GetConstraints();
+	ParticleProps bodyLook = m_Particle;
+	bodyLook.SizeBegin = 0.04f;
+	if (ImGui::Button("Add Rope"))
+		constraints.AddRope(m_Particle.Position, m_Particle.Position + glm::vec2(0.8f, 0.0f), 24, bodyLook);
+	ImGui::SameLine();
+	if (ImGui::Button("Add Jelly"))
+		constraints.AddSoftBody(m_Particle.Position, { 0.4f, 0.4f }, 10, 10, bodyLook);
+	ImGui::SameLine();
+	if (ImGui::Button("Clear Bodies"))
+		constraints.Clear();
+	int solverIterations = (int)constraints.GetProps().Iterations;
+	if (ImGui::SliderInt("Solver Iterations", &solverIterations, 1, 32))
+		constraints.GetProps().Iterations = (uint32_t)solverIterations;
+	ImGui::Checkbox("Force Jacobi", &constraints.GetProps().ForceJacobi);
+	ImGui::Text("%u constraints, %u colors, %u Jacobi", constraints.GetConstraintCount(), constraints.GetColorCount(), constraints.GetJacobiCount());
+
+	const char* renderModes[] = { "Sprites", "Density Field" };
+	int renderMode = (int)m_ParticleSystem.GetRenderMode();
+	if (ImGui::Combo("Render Mode", &renderMode, renderModes, 2))
+		m_ParticleSystem.SetRenderMode((ParticleRenderMode)renderMode);
+
+	if (m_ParticleSystem.GetRenderMode() == ParticleRenderMode::DensityField)
+	{
+		DensityFieldProps& density = m_ParticleSystem.GetDensityField().GetProps();
+		const char* transfers[] = { "Threshold", "Volumetric" };
+		int transfer = (int)density.Transfer;
+		if (ImGui::Combo("Transfer", &transfer, transfers, 2))
+			density.Transfer = (DensityTransfer)transfer;
+		ImGui::SliderInt("Blur Radius", &density.BlurRadius, 0, 8);
+		ImGui::DragFloat("Density Scale", &density.DensityScale, 0.01f, 0.0f, 100.0f);
+		if (density.Transfer == DensityTransfer::Threshold)
+		{
+			ImGui::DragFloat("Threshold", &density.Threshold, 0.01f, 0.0f, 10.0f);
+			ImGui::DragFloat("Softness", &density.Softness, 0.01f, 0.0f, 10.0f);
+		}
+		else
+			ImGui::DragFloat("Absorption", &density.Absorption, 0.01f, 0.0f, 10.0f);
+	}
+	ImGui::End();
+
+	ImGui::Begin("Performance");
+	ImGui::Text("Input latency (ms)     p50     p95     p99");
+	const char* stages[] = { "Simulated", "Submitted", "Photon" };
+	for (int i = 0; i < (int)FrameLatency::Stage::Count; i++)
+	{
+		FrameLatency::Percentiles latency = m_Latency.GetPercentiles((FrameLatency::Stage)i);
+		ImGui::Text("  %-18s %6.2f  %6.2f  %6.2f", stages[i], latency.P50, latency.P95, latency.P99);
+	}
+	ImGui::Separator();
+	ImGui::Checkbox("Low-latency pacing", &m_Latency.PacingEnabled);
+	ImGui::DragFloat("Pacing Margin (ms)", &m_Latency.PacingMarginMs, 0.1f, 0.0f, 10.0f);
+	ImGui::Text("Frame %.2f ms, predicted work %.2f ms, delay %.2f ms",
+		m_Latency.GetFramePeriodMs(), m_Latency.GetPredictedWorkMs(), m_Latency.GetLastPacingDelayMs());
+	ImGui::Separator();
+	if (GpuProfiler::IsSupported())
+	{
+		ImGui::Text("GPU (ms)                last     avg     max");
+		for (const GpuZoneStats& zone : GpuProfiler::GetZoneStats())
+			ImGui::Text("  %*s%-*s %6.3f  %6.3f  %6.3f", (int)zone.Depth * 2, "", 20 - (int)zone.Depth * 2, zone.Name, zone.LastMs, zone.AverageMs, zone.MaxMs);
+		if (ImGui::Button("Export GPU Trace"))
+		{
+			std::time_t time = std::time(nullptr);
+			char name[64];
+			std::strftime(name, sizeof(name), "traces/gpu-%Y%m%d-%H%M%S.json", std::localtime(&time));
+			std::error_code ec;
+			std::filesystem::create_directories("traces", ec);
+			std::string error;
+			m_TraceStatus = GpuProfiler::ExportTrace(name, error) ? std::string("wrote ") + name : error;
+		}
+		ImGui::SameLine();
+		ImGui::Text("%s", m_TraceStatus.c_str());
+		if (GpuProfiler::GetDroppedCount())
+			ImGui::Text("%llu frames dropped waiting for query results", (unsigned long long)GpuProfiler::GetDroppedCount());
+	}
+	else
+		ImGui::Text("GPU timer queries unavailable");
+	ImGui::Separator();
+	if (m_Telemetry.IsOpen())
+		ImGui::Text("Telemetry: %llu records written, %llu dropped",
+			(unsigned long long)m_Telemetry.GetWrittenCount(), (unsigned long long)m_Telemetry.GetDroppedCount());
+	else
+		ImGui::TextColored({ 1.0f, 0.4f, 0.3f, 1.0f }, "Telemetry off: %s", m_TelemetryError.c_str());
+	ImGui::Separator();
+	const char* captureFormats[] = { "PNG", "Y4M" };
+	int captureFormat = (int)m_CaptureProps.Format;
+	if (ImGui::Combo("Capture Format", &captureFormat, captureFormats, 2))
+		m_CaptureProps.Format = (CaptureFormat)captureFormat;
+	if (m_Capture.IsCapturing())
+	{
+		if (ImGui::Button("Stop Capture"))
+			m_Capture.Stop();
+	}
+	else if (ImGui::Button("Start Capture"))
+	{
+		Window& window = Application::Get().GetWindow();
+		if (m_Capture.Start(m_CaptureProps, window.GetWidth(), window.GetHeight(), m_CaptureError))
+			m_CaptureError.clear();
+	}
+	if (m_Capture.IsBusy() || m_Capture.GetCapturedCount() > 0)
+		ImGui::Text("%s: %llu captured, %llu encoded, %llu dropped%s", m_Capture.GetPath().c_str(),
+			(unsigned long long)m_Capture.GetCapturedCount(), (unsigned long long)m_Capture.GetEncodedCount(),
+			(unsigned long long)m_Capture.GetDroppedCount(), m_Capture.HasWriteError() ? ", write failed" : "");
+	if (!m_CaptureError.empty())
+		ImGui::TextColored({ 1.0f, 0.4f, 0.3f, 1.0f }, "%s", m_CaptureError.c_str());
 	ImGui::End();
 }
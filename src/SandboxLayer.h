@@ -13,6 +13,14 @@
 #include <GLCoreUtils.h>
 
 #include "ParticleSystem.h"
+#include "ParticleBehavior.h"
+#include "EffectLibrary.h"
+#include "EffectSequencer.h"
+#include "FrameCapture.h"
+#include "FrameLatency.h"
+#include "Telemetry.h"
+
+#include <array>
 
 class SandboxLayer : public GLCore::Layer
 {
@@ -25,8 +33,63 @@ public:
 	virtual void OnEvent(GLCore::Event& event) override;
 	virtual void OnUpdate(GLCore::Timestep ts) override;
 	virtual void OnImGuiRender() override;
+private:
+	void LoadBehavior();
+	void LoadEffects();
+	void UpdateColliders(float ts);
+	void UpdateForceVolumes(float ts);
+	void WritePendingTelemetry(std::chrono::steady_clock::time_point now, bool force);
 private:
 	GLCore::Utils::OrthographicCameraController m_CameraController;
 	ParticleProps m_Particle;
 	ParticleSystem m_ParticleSystem;
+	FrameLatency m_Latency;
+
+	TelemetryWriter m_Telemetry;
+	std::string m_TelemetryError;
+	uint64_t m_TelemetryFrame = 0;
+	std::chrono::steady_clock::time_point m_LastFrameStart;
+	uint64_t m_LastUploadedBytes = 0;
+
+	// Frames waiting for their swap before they are logged
+	struct PendingTelemetry
+	{
+		TelemetryRecord Record;
+		uint64_t RenderFrame;
+		std::chrono::steady_clock::time_point Rendered;
+	};
+	std::array<PendingTelemetry, 4> m_PendingTelemetry;
+	uint32_t m_PendingTelemetryFirst = 0, m_PendingTelemetryCount = 0;
+
+	FrameCapture m_Capture;
+	FrameCaptureProps m_CaptureProps;
+	std::string m_CaptureError;
+	std::string m_TraceStatus;
+
+	std::shared_ptr<SpriteAtlas> m_SpriteAtlas;
+	bool m_Textured = false;
+
+	std::shared_ptr<ParticleBehavior> m_Behavior;
+	std::string m_BehaviorError;
+	bool m_UseBehavior = false;
+
+	EffectLibrary m_Effects;
+	std::string m_EffectsError;
+	EffectSequencer m_Sequencer;
+	int m_SelectedEffect = 0; // 0 = the settings below, then effects, then timelines
+	float m_EffectTime = 0.0f;
+	int m_BurstCount = 500;
+
+	glm::vec2 m_LastMousePosition = { 0.0f, 0.0f };
+	bool m_MouseWasDown = false;
+	float m_FluidForce = 8.0f, m_FluidDye = 0.6f, m_FluidRadius = 0.12f;
+
+	bool m_CollidersEnabled = false;
+	int m_ColliderCount = 60;
+	float m_ColliderTime = 0.0f;
+
+	bool m_ForceVolumesEnabled = false;
+	int m_ForceVolumeCount = 300;
+	float m_ForceVolumeTime = 0.0f;
+	std::vector<uint32_t> m_ForceVolumeIds;
 };
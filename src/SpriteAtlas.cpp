@@ -0,0 +1,259 @@
+#include "SpriteAtlas.h"
+
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+	const uint8_t s_KTXIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	struct KTXHeader
+	{
+		uint32_t Endianness;
+		uint32_t GLType, GLTypeSize, GLFormat, GLInternalFormat, GLBaseInternalFormat;
+		uint32_t PixelWidth, PixelHeight, PixelDepth;
+		uint32_t ArrayElements, Faces, MipLevels;
+		uint32_t KeyValueBytes;
+	};
+
+	uint32_t SwapBytes(uint32_t value)
+	{
+		return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+	}
+
+	// Bytes per 4x4 block of a compressed format; 0 for ones left to GL to check
+	uint32_t GetBlockSize(GLenum internalFormat)
+	{
+		switch (internalFormat)
+		{
+			case 0x83F0: case 0x83F1: // GL_COMPRESSED_RGB(A)_S3TC_DXT1_EXT
+			case GL_COMPRESSED_RED_RGTC1: case GL_COMPRESSED_SIGNED_RED_RGTC1:
+			case GL_COMPRESSED_RGB8_ETC2: case GL_COMPRESSED_SRGB8_ETC2:
+			case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2: case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+				return 8;
+			case 0x83F2: case 0x83F3: // GL_COMPRESSED_RGBA_S3TC_DXT3/DXT5_EXT
+			case GL_COMPRESSED_RG_RGTC2: case GL_COMPRESSED_SIGNED_RG_RGTC2:
+			case GL_COMPRESSED_RGBA_BPTC_UNORM: case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+			case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT: case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+			case GL_COMPRESSED_RGBA8_ETC2_EAC: case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+				return 16;
+		}
+		return 0;
+	}
+
+	// Bytes per pixel of an uncompressed format/type pair; 0 for ones LoadKTX does not take
+	uint32_t GetPixelSize(GLenum format, GLenum type)
+	{
+		switch (type)
+		{
+			case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_5_5_5_1:
+				return 2;
+			case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_2_10_10_10_REV: case GL_UNSIGNED_INT_10F_11F_11F_REV: case GL_UNSIGNED_INT_5_9_9_9_REV:
+				return 4;
+		}
+
+		uint32_t components = 0;
+		switch (format)
+		{
+			case GL_RED: case GL_RED_INTEGER: components = 1; break;
+			case GL_RG: case GL_RG_INTEGER: components = 2; break;
+			case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+			case GL_RGBA: case GL_BGRA: case GL_RGBA_INTEGER: components = 4; break;
+		}
+		switch (type)
+		{
+			case GL_UNSIGNED_BYTE: case GL_BYTE: return components;
+			case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: return components * 2;
+			case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: return components * 4;
+		}
+		return 0;
+	}
+
+}
+
+SpriteAtlas::~SpriteAtlas()
+{
+	if (!m_Initialized)
+		return;
+
+	RenderThread::GetCommandList().Execute([texture = m_Texture, buffer = m_TableBuffer]()
+	{
+		glDeleteTextures(1, &texture);
+		glDeleteBuffers(1, &buffer);
+	});
+}
+
+bool SpriteAtlas::LoadKTX(const std::string& filepath)
+{
+	std::ifstream stream(filepath, std::ios::binary);
+	if (!stream)
+		return false;
+	std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+	KTXHeader header;
+	if (file.size() < sizeof(s_KTXIdentifier) + sizeof(header) || std::memcmp(file.data(), s_KTXIdentifier, sizeof(s_KTXIdentifier)) != 0)
+		return false;
+	std::memcpy(&header, file.data() + sizeof(s_KTXIdentifier), sizeof(header));
+	size_t offset = sizeof(s_KTXIdentifier) + sizeof(header);
+
+	bool swap = header.Endianness == 0x01020304;
+	if (swap)
+	{
+		uint32_t* fields = (uint32_t*)&header;
+		for (size_t i = 0; i < sizeof(header) / sizeof(uint32_t); i++)
+			fields[i] = SwapBytes(fields[i]);
+	}
+
+	// Plain 2D textures only, with no more levels than a full mip chain
+	if (header.Endianness != 0x04030201 || header.PixelDepth > 1 || header.ArrayElements > 1 || header.Faces != 1 || header.PixelWidth == 0 || header.PixelHeight == 0)
+		return false;
+	uint32_t levels = std::max(1u, header.MipLevels), maxLevels = 1;
+	while ((std::max(header.PixelWidth, header.PixelHeight) >> maxLevels) > 0)
+		maxLevels++;
+	if (levels > maxLevels || header.KeyValueBytes > file.size() - offset)
+		return false;
+	offset += header.KeyValueBytes;
+
+	auto image = std::make_shared<KTXImage>();
+	image->InternalFormat = header.GLInternalFormat;
+	image->Format = header.GLFormat;
+	image->Type = header.GLType;
+	image->Compressed = header.GLType == 0;
+
+	// GL reads a whole level from what is uploaded, so each must be at least as large as its dimensions need
+	uint32_t pixelSize = image->Compressed ? 0 : GetPixelSize(image->Format, image->Type);
+	uint32_t blockSize = image->Compressed ? GetBlockSize(image->InternalFormat) : 0;
+	if (!image->Compressed && pixelSize == 0)
+		return false;
+
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		uint32_t imageSize;
+		if (sizeof(imageSize) > file.size() - offset)
+			return false;
+		std::memcpy(&imageSize, file.data() + offset, sizeof(imageSize));
+		offset += sizeof(imageSize);
+		if (swap)
+			imageSize = SwapBytes(imageSize);
+		if (imageSize > file.size() - offset)
+			return false;
+
+		// Uncompressed rows are padded to the default unpack alignment of 4
+		uint64_t levelWidth = std::max(1u, header.PixelWidth >> level), levelHeight = std::max(1u, header.PixelHeight >> level);
+		uint64_t levelSize = image->Compressed ? ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockSize : ((levelWidth * pixelSize + 3) & ~3ull) * levelHeight;
+		if (imageSize < levelSize)
+			return false;
+
+		image->Levels.emplace_back(file.begin() + offset, file.begin() + offset + imageSize);
+		offset += imageSize;
+		offset += std::min<size_t>(3 - ((imageSize + 3) % 4), file.size() - offset);
+	}
+
+	m_Width = header.PixelWidth;
+	m_Height = header.PixelHeight;
+	m_PendingImage = image;
+	return true;
+}
+
+uint32_t SpriteAtlas::AddRegion(const glm::vec4& uvRect)
+{
+	if (m_Regions.size() == MaxRegions)
+		return InvalidIndex;
+
+	m_Regions.push_back(uvRect);
+	m_TablesDirty = true;
+	return (uint32_t)m_Regions.size() - 1;
+}
+
+uint32_t SpriteAtlas::AddGrid(const glm::vec4& pixelRect, uint32_t columns, uint32_t rows)
+{
+	glm::vec2 atlasSize = { (float)std::max(1u, m_Width), (float)std::max(1u, m_Height) };
+	glm::vec2 origin = glm::vec2(pixelRect.x, pixelRect.y) / atlasSize;
+	glm::vec2 cell = glm::vec2(pixelRect.z - pixelRect.x, pixelRect.w - pixelRect.y) / atlasSize / glm::vec2(columns, rows);
+
+	uint32_t first = (uint32_t)m_Regions.size();
+	if ((uint64_t)columns * rows > MaxRegions - first)
+		return InvalidIndex;
+	for (uint32_t row = 0; row < rows; row++)
+	{
+		for (uint32_t column = 0; column < columns; column++)
+		{
+			// Texture origin is bottom left, frames are laid out from the top
+			glm::vec2 min = origin + cell * glm::vec2(column, rows - 1 - row);
+			AddRegion({ min, min + cell });
+		}
+	}
+	return first;
+}
+
+uint32_t SpriteAtlas::AddFlipbook(uint32_t firstRegion, uint32_t frameCount, float cycles)
+{
+	if (m_Flipbooks.size() == MaxFlipbooks || firstRegion >= m_Regions.size())
+		return InvalidIndex;
+
+	m_Flipbooks.push_back({ (float)firstRegion, (float)std::max(1u, frameCount), cycles, 0.0f });
+	m_TablesDirty = true;
+	return (uint32_t)m_Flipbooks.size() - 1;
+}
+
+void SpriteAtlas::Bind()
+{
+	RenderCommandList& commands = RenderThread::GetCommandList();
+
+	if (!m_Initialized)
+	{
+		commands.Execute([this]()
+		{
+			glCreateBuffers(1, &m_TableBuffer);
+			glNamedBufferData(m_TableBuffer, (MaxRegions + MaxFlipbooks) * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+		});
+		m_Initialized = true;
+	}
+
+	if (m_PendingImage)
+	{
+		commands.Execute([this, image = m_PendingImage, width = m_Width, height = m_Height]()
+		{
+			if (m_Texture)
+				glDeleteTextures(1, &m_Texture);
+
+			GLsizei levels = (GLsizei)image->Levels.size();
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_Texture);
+			glTextureStorage2D(m_Texture, levels, image->InternalFormat, width, height);
+			glTextureParameteri(m_Texture, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+			glTextureParameteri(m_Texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTextureParameteri(m_Texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTextureParameteri(m_Texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+			for (GLsizei level = 0; level < levels; level++)
+			{
+				GLsizei levelWidth = std::max(1, (GLsizei)width >> level), levelHeight = std::max(1, (GLsizei)height >> level);
+				const auto& data = image->Levels[level];
+				if (image->Compressed)
+					glCompressedTextureSubImage2D(m_Texture, level, 0, 0, levelWidth, levelHeight, image->InternalFormat, (GLsizei)data.size(), data.data());
+				else
+					glTextureSubImage2D(m_Texture, level, 0, 0, levelWidth, levelHeight, image->Format, image->Type, data.data());
+			}
+		});
+		m_PendingImage.reset();
+	}
+
+	if (m_TablesDirty)
+	{
+		// std140: vec4 u_Regions[MaxRegions]; vec4 u_Flipbooks[MaxFlipbooks];
+		size_t size = (MaxRegions + MaxFlipbooks) * sizeof(glm::vec4);
+		glm::vec4* tables = (glm::vec4*)commands.Allocate(size);
+		std::fill(tables, tables + MaxRegions + MaxFlipbooks, glm::vec4(0.0f));
+		std::copy(m_Regions.begin(), m_Regions.end(), tables);
+		std::copy(m_Flipbooks.begin(), m_Flipbooks.end(), tables + MaxRegions);
+		commands.UploadBuffer(&m_TableBuffer, tables, size);
+		m_TablesDirty = false;
+	}
+
+	commands.Execute([this]() { glBindBufferBase(GL_UNIFORM_BUFFER, 0, m_TableBuffer); });
+	commands.BindTexture(0, &m_Texture);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Texture atlas for sprite particles: a table of UV sub-rects plus a table of
+// flipbooks (runs of consecutive sub-rects). Both tables live in a uniform
+// buffer so the vertex shader can pick the frame from the particle's age and
+// the CPU never uploads per-frame UVs.
+class SpriteAtlas
+{
+public:
+	static constexpr uint32_t MaxRegions = 256;
+	static constexpr uint32_t MaxFlipbooks = 64;
+	static constexpr uint32_t InvalidIndex = UINT32_MAX; // returned by the Add functions once their table is full
+
+	~SpriteAtlas();
+
+	// KTX 1.1 files; block-compressed (BC/S3TC, BPTC, ETC2) levels are uploaded as-is.
+	// False for truncated files and levels smaller than their dimensions need.
+	bool LoadKTX(const std::string& filepath);
+
+	// uvRect = (min.x, min.y, max.x, max.y)
+	uint32_t AddRegion(const glm::vec4& uvRect);
+	// Splits a pixel rect of the atlas into columns x rows equal frames, row-major from the top left;
+	// adds nothing if they do not all fit
+	uint32_t AddGrid(const glm::vec4& pixelRect, uint32_t columns, uint32_t rows);
+	// Plays frameCount regions starting at firstRegion `cycles` times over a particle's life
+	uint32_t AddFlipbook(uint32_t firstRegion, uint32_t frameCount, float cycles = 1.0f);
+
+	uint32_t GetWidth() const { return m_Width; }
+	uint32_t GetHeight() const { return m_Height; }
+
+	// Records texture/table uploads when needed and binds the atlas to texture unit 0 and uniform block 0
+	void Bind();
+private:
+	struct KTXImage
+	{
+		GLenum InternalFormat = 0, Format = 0, Type = 0;
+		bool Compressed = false;
+		std::vector<std::vector<uint8_t>> Levels;
+	};
+private:
+	uint32_t m_Width = 0, m_Height = 0;
+	std::shared_ptr<KTXImage> m_PendingImage;
+
+	std::vector<glm::vec4> m_Regions;
+	std::vector<glm::vec4> m_Flipbooks; // (first region, frame count, cycles, unused)
+	bool m_TablesDirty = false;
+	bool m_Initialized = false;
+
+	// Render thread objects
+	GLuint m_Texture = 0, m_TableBuffer = 0;
+};
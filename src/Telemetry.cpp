@@ -0,0 +1,189 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+TelemetryWriter::TelemetryWriter()
+{
+	m_Ring.resize(RingCapacity);
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+	Close();
+}
+
+bool TelemetryWriter::Open(const TelemetryProps& props, std::string& error)
+{
+	Close();
+	m_Props = props;
+	m_Props.MaxFileBytes = std::max<uint64_t>(m_Props.MaxFileBytes, sizeof(TelemetryFileHeader) + sizeof(TelemetryRecord));
+	m_Props.MaxFiles = std::max(m_Props.MaxFiles, 1u);
+
+	std::error_code ec;
+	std::filesystem::create_directories(m_Props.Directory, ec);
+	if (ec)
+	{
+		error = "could not create " + m_Props.Directory + ": " + ec.message();
+		return false;
+	}
+
+	auto now = std::chrono::system_clock::now();
+	m_SessionStartNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+	m_OpenTime = std::chrono::steady_clock::now();
+
+	// Timestamped names sort oldest first, which is what rotation relies on
+	std::time_t time = std::chrono::system_clock::to_time_t(now);
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&time));
+	m_SessionName = m_Props.BaseName + "-" + stamp;
+
+	m_Sequence = 0;
+	m_Head.store(0, std::memory_order_relaxed);
+	m_Tail.store(0, std::memory_order_relaxed);
+	m_WrittenCount.store(0, std::memory_order_relaxed);
+	m_DroppedCount.store(0, std::memory_order_relaxed);
+
+	// The first file is opened here so a bad directory is reported to the caller
+	if (!OpenNextFile())
+	{
+		error = "could not open a telemetry log in " + m_Props.Directory;
+		return false;
+	}
+
+	m_Running = true;
+	m_Worker = std::thread(&TelemetryWriter::WorkerMain, this);
+	return true;
+}
+
+void TelemetryWriter::Close()
+{
+	if (!m_Worker.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Running = false;
+	}
+	m_Wake.notify_one();
+	m_Worker.join();
+}
+
+bool TelemetryWriter::Write(const TelemetryRecord& record)
+{
+	uint64_t head = m_Head.load(std::memory_order_relaxed);
+	uint64_t queued = head - m_Tail.load(std::memory_order_acquire);
+	if (queued >= RingCapacity)
+	{
+		m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	TelemetryRecord& slot = m_Ring[head & (RingCapacity - 1)];
+	slot = record;
+	slot.TimeNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_OpenTime).count();
+	m_Head.store(head + 1, std::memory_order_release);
+
+	// Don't wait for the timer when the ring fills up faster than expected
+	if (queued == RingCapacity / 2)
+		m_Wake.notify_one();
+	return true;
+}
+
+void TelemetryWriter::WorkerMain()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (m_Running)
+	{
+		m_Wake.wait_for(lock, std::chrono::milliseconds(m_Props.FlushIntervalMs));
+		lock.unlock();
+		Drain();
+		lock.lock();
+	}
+	lock.unlock();
+
+	Drain();
+	if (m_File)
+	{
+		std::fclose(m_File);
+		m_File = nullptr;
+	}
+}
+
+void TelemetryWriter::Drain()
+{
+	uint64_t head = m_Head.load(std::memory_order_acquire);
+	uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+	if (head == tail)
+		return;
+
+	while (tail < head)
+	{
+		if (m_File && m_FileBytes + sizeof(TelemetryRecord) > m_Props.MaxFileBytes)
+		{
+			std::fclose(m_File);
+			m_File = nullptr;
+		}
+		if (!m_File && !OpenNextFile())
+		{
+			// Nowhere to write (disk full, directory gone): drop rather than stall the producer
+			m_DroppedCount.fetch_add(head - tail, std::memory_order_relaxed);
+			m_Tail.store(head, std::memory_order_release);
+			return;
+		}
+
+		// Contiguous run up to the ring's end or the file's size limit
+		uint64_t fit = (m_Props.MaxFileBytes - m_FileBytes) / sizeof(TelemetryRecord);
+		uint64_t count = std::min({ head - tail, (uint64_t)RingCapacity - (tail & (RingCapacity - 1)), fit });
+		size_t written = std::fwrite(&m_Ring[tail & (RingCapacity - 1)], sizeof(TelemetryRecord), (size_t)count, m_File);
+		m_FileBytes += written * sizeof(TelemetryRecord);
+		m_WrittenCount.fetch_add(written, std::memory_order_relaxed);
+		if (written < count)
+			m_DroppedCount.fetch_add(count - written, std::memory_order_relaxed);
+
+		tail += count;
+		m_Tail.store(tail, std::memory_order_release);
+	}
+
+	// At most one flush interval is lost if the process dies
+	std::fflush(m_File);
+}
+
+bool TelemetryWriter::OpenNextFile()
+{
+	char suffix[16];
+	std::snprintf(suffix, sizeof(suffix), "-%06u.ptel", m_Sequence);
+	std::filesystem::path path = std::filesystem::path(m_Props.Directory) / (m_SessionName + suffix);
+
+	m_File = std::fopen(path.string().c_str(), "wb");
+	if (!m_File)
+		return false;
+
+	TelemetryFileHeader header = { TelemetryFileMagic, TelemetryFileVersion, (uint32_t)sizeof(TelemetryRecord), m_Sequence, m_SessionStartNs };
+	std::fwrite(&header, sizeof(header), 1, m_File);
+	m_FileBytes = sizeof(header);
+	m_Sequence++;
+
+	DeleteOldFiles();
+	return true;
+}
+
+void TelemetryWriter::DeleteOldFiles()
+{
+	std::error_code ec;
+	std::vector<std::filesystem::path> logs;
+	for (const auto& entry : std::filesystem::directory_iterator(m_Props.Directory, ec))
+	{
+		std::string name = entry.path().filename().string();
+		if (entry.path().extension() == ".ptel" && name.compare(0, m_Props.BaseName.size() + 1, m_Props.BaseName + "-") == 0)
+			logs.push_back(entry.path());
+	}
+	if (logs.size() <= m_Props.MaxFiles)
+		return;
+
+	std::sort(logs.begin(), logs.end());
+	for (size_t i = 0; i < logs.size() - m_Props.MaxFiles; i++)
+		std::filesystem::remove(logs[i], ec);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One frame of telemetry, written to disk as-is (64 bytes, little-endian)
+struct TelemetryRecord
+{
+	uint64_t Frame;
+	uint64_t TimeNs; // since the writer was opened, stamped by Write()
+	float FrameMs;   // wall time since the previous frame started
+	float UpdateMs, RenderMs, PresentMs; // PresentMs: end of recording until the swap returned
+	uint32_t LiveParticles; // active in the pool, not just the ones in view
+	uint32_t CommandCount;
+	uint32_t Allocations; // heap allocations during the frame
+	uint32_t Reserved;
+	uint64_t AllocatedBytes;
+	uint64_t UploadedBytes;
+};
+
+static_assert(sizeof(TelemetryRecord) == 64, "TelemetryRecord layout");
+
+// Log file layout: TelemetryFileHeader, then RecordSize-byte records until the end of the file
+static constexpr uint32_t TelemetryFileMagic = 0x4c455450; // "PTEL"
+static constexpr uint32_t TelemetryFileVersion = 1;
+
+struct TelemetryFileHeader
+{
+	uint32_t Magic, Version;
+	uint32_t RecordSize;
+	uint32_t Sequence;       // rotation index within the session
+	uint64_t SessionStartNs; // system clock, nanoseconds since the Unix epoch
+};
+
+struct TelemetryProps
+{
+	std::string Directory = "telemetry";
+	std::string BaseName = "session";
+	uint64_t MaxFileBytes = 64ull << 20; // a new file is started past this size
+	uint32_t MaxFiles = 16;              // oldest logs in Directory are deleted beyond this
+	uint32_t FlushIntervalMs = 250;
+};
+
+// Appends TelemetryRecords to rotating binary logs. Write() copies the record
+// into a single-producer/single-consumer ring and returns; a worker thread
+// drains the ring and owns every file operation, so the frame loop never
+// blocks on the disk. When the ring is full the record is dropped and counted.
+class TelemetryWriter
+{
+public:
+	static constexpr uint32_t RingCapacity = 4096; // power of two, about a minute at 60 Hz
+
+	TelemetryWriter();
+	~TelemetryWriter();
+
+	bool Open(const TelemetryProps& props, std::string& error);
+	// Flushes whatever is still in the ring
+	void Close();
+	bool IsOpen() const { return m_Worker.joinable(); }
+
+	// Producer side; call from one thread only
+	bool Write(const TelemetryRecord& record);
+
+	uint64_t GetWrittenCount() const { return m_WrittenCount.load(std::memory_order_relaxed); }
+	uint64_t GetDroppedCount() const { return m_DroppedCount.load(std::memory_order_relaxed); }
+	uint64_t GetSessionStartNs() const { return m_SessionStartNs; }
+private:
+	void WorkerMain();
+	void Drain();
+	bool OpenNextFile();
+	void DeleteOldFiles();
+private:
+	std::vector<TelemetryRecord> m_Ring;
+	// Head is only written by the producer, tail only by the worker
+	alignas(64) std::atomic<uint64_t> m_Head{ 0 };
+	alignas(64) std::atomic<uint64_t> m_Tail{ 0 };
+	alignas(64) std::atomic<uint64_t> m_WrittenCount{ 0 };
+	std::atomic<uint64_t> m_DroppedCount{ 0 };
+
+	TelemetryProps m_Props;
+	std::thread m_Worker;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	bool m_Running = false;
+
+	// Worker state
+	FILE* m_File = nullptr;
+	uint64_t m_FileBytes = 0;
+	uint32_t m_Sequence = 0;
+	uint64_t m_SessionStartNs = 0;
+	std::chrono::steady_clock::time_point m_OpenTime;
+	std::string m_SessionName;
+};
@@ -0,0 +1,44 @@
+// Compiles .effect text sources into one .pfx effect library:
+//     EffectConverter output.pfx input.effect [input.effect ...]
+// Built and run over assets/effects by `python3 build.py effects`.
+#include "EffectCompiler.h"
+#include "EffectLibrary.h"
+
+#include <cstdio>
+#include <string>
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		std::printf("usage: EffectConverter output.pfx input.effect [input.effect ...]\n");
+		return 1;
+	}
+
+	EffectCompiler compiler;
+	std::string error;
+	for (int i = 2; i < argc; i++)
+	{
+		if (!compiler.AddFile(argv[i], error))
+		{
+			std::fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+	}
+
+	if (!compiler.Write(argv[1], error))
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	// Round trip through the loader so a bad write never goes unnoticed
+	EffectLibrary library;
+	if (!library.Load(argv[1], error))
+	{
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	std::printf("%s: %u effects, %u timelines\n", argv[1], library.GetEffectCount(), library.GetTimelineCount());
+	return 0;
+}
@@ -0,0 +1,366 @@
+# Generates a glad style OpenGL core profile loader (include/glad/glad.h,
+# include/KHR/khrplatform.h and src/glad.c) from the Khronos glcorearb.h.
+#   python3 tools/GenerateGlad.py [--header /usr/include/GL/glcorearb.h] [--version 4.5] [--output ./thirdparty/glad]
+# The output keeps glad 0.1's interface (gladLoadGL, gladLoadGLLoader,
+# GLVersion and one GLAD_GL_VERSION_x_y flag per version), so it drops in
+# for the loader in ./include, which stops at GL 3.3 compatibility.
+import argparse
+import os
+import re
+
+parser=argparse.ArgumentParser()
+parser.add_argument("--header", default="/usr/include/GL/glcorearb.h")
+parser.add_argument("--khr", default=None, help="khrplatform.h to copy, next to the header's KHR directory by default")
+parser.add_argument("--version", default="4.5")
+parser.add_argument("--output", default="./thirdparty/glad")
+args=parser.parse_args()
+
+source=open(args.header).read()
+khrPath=args.khr or os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(args.header))), "KHR", "khrplatform.h")
+khr=open(khrPath).read()
+major, minor=(int(part) for part in args.version.split("."))
+
+copyright=re.search(r"/\*\n(\*\* Copyright.*?)\n\*/", source, re.S).group(1)
+blocks=re.findall(r"#ifndef (GL_VERSION_(\d)_(\d))\n#define \1 1\n(.*?)#endif /\* \1 \*/", source, re.S)
+
+# Per version: the types and enums it adds, and its entry points as (return type, name, parameters)
+versions=[]
+for name, blockMajor, blockMinor, body in blocks:
+    if (int(blockMajor), int(blockMinor)) > (major, minor):
+        continue
+    body=re.sub(r"#ifdef GL_GLEXT_PROTOTYPES\n.*?#endif\n", "", body, flags=re.S)
+    declarations, functions=[], []
+    for line in body.splitlines():
+        function=re.match(r"typedef (.+?) ?\(APIENTRYP PFN(\w+)PROC\) \((.*)\);$", line)
+        if function:
+            returnType, pfn, parameters=function.groups()
+            functions.append((returnType, pfn, parameters))
+        elif line.strip():
+            declarations.append(line)
+    versions.append((name, int(blockMajor), int(blockMinor), declarations, functions))
+
+# PFNGLxxxPROC names are upper case; the entry point keeps the case of the prototype
+prototypes=dict((name.upper(), name) for name in re.findall(r"GLAPI .*?APIENTRY (gl\w+) \(", source))
+
+def entry_point(pfn):
+    return prototypes[pfn]
+
+generated="""/*
+
+    OpenGL loader generated by tools/GenerateGlad.py from glcorearb.h.
+
+    APIs: gl=%d.%d
+    Profile: core
+    Extensions:
+
+    Loader: True
+
+    Interface of glad 0.1: gladLoadGL(), gladLoadGLLoader() and GLVersion,
+    with GLAD_GL_VERSION_x_y set for every version the context provides.
+
+    Declarations below are taken from glcorearb.h:
+
+%s
+*/
+""" % (major, minor, copyright)
+
+header=generated+"""
+#ifndef __glad_h_
+#define __glad_h_
+
+#ifdef __gl_h_
+#error OpenGL header already included, remove this include, glad already provides it
+#endif
+#define __gl_h_
+#define __gl_glcorearb_h_ 1
+
+#if defined(_WIN32) && !defined(APIENTRY) && !defined(__CYGWIN__) && !defined(__SCITECH_SNAP__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX 1
+#endif
+#include <windows.h>
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+#ifndef APIENTRYP
+#define APIENTRYP APIENTRY *
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct gladGLversionStruct {
+    int major;
+    int minor;
+};
+
+typedef void* (* GLADloadproc)(const char *name);
+
+#ifndef GLAPI
+# if defined(GLAD_GLAPI_EXPORT)
+#  if defined(_WIN32) || defined(__CYGWIN__)
+#   if defined(GLAD_GLAPI_EXPORT_BUILD)
+#    if defined(__GNUC__)
+#     define GLAPI __attribute__ ((dllexport)) extern
+#    else
+#     define GLAPI __declspec(dllexport) extern
+#    endif
+#   else
+#    if defined(__GNUC__)
+#     define GLAPI __attribute__ ((dllimport)) extern
+#    else
+#     define GLAPI __declspec(dllimport) extern
+#    endif
+#   endif
+#  elif defined(__GNUC__) && defined(GLAD_GLAPI_EXPORT_BUILD)
+#   define GLAPI __attribute__ ((visibility ("default"))) extern
+#  else
+#   define GLAPI extern
+#  endif
+# else
+#  define GLAPI extern
+# endif
+#endif
+
+GLAPI struct gladGLversionStruct GLVersion;
+
+GLAPI int gladLoadGL(void);
+
+GLAPI int gladLoadGLLoader(GLADloadproc);
+
+#include <stddef.h>
+"""
+for name, _, _, declarations, _ in versions:
+    header+="\n".join(declarations)+"\n"
+for name, _, _, _, functions in versions:
+    header+="#ifndef %s\n#define %s 1\nGLAPI int GLAD_%s;\n" % (name, name, name)
+    for returnType, pfn, parameters in functions:
+        function=entry_point(pfn)
+        header+="typedef %s (APIENTRYP PFN%sPROC)(%s);\n" % (returnType, pfn, parameters)
+        header+="GLAPI PFN%sPROC glad_%s;\n#define %s glad_%s\n" % (pfn, function, function, function)
+    header+="#endif\n"
+header+="""
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+"""
+
+loader=generated+"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glad/glad.h>
+
+static void* get_proc(const char *namez);
+
+#if defined(_WIN32) || defined(__CYGWIN__)
+#ifndef _WINDOWS_
+#undef APIENTRY
+#endif
+#include <windows.h>
+static HMODULE libGL;
+
+typedef void* (APIENTRYP PFNWGLGETPROCADDRESSPROC_PRIVATE)(const char*);
+static PFNWGLGETPROCADDRESSPROC_PRIVATE gladGetProcAddressPtr;
+
+#ifdef _MSC_VER
+#ifdef __has_include
+  #if __has_include(<winapifamily.h>)
+    #define HAVE_WINAPIFAMILY 1
+  #endif
+#elif _MSC_VER >= 1700 && !_USING_V110_SDK71_
+  #define HAVE_WINAPIFAMILY 1
+#endif
+#endif
+
+#ifdef HAVE_WINAPIFAMILY
+  #include <winapifamily.h>
+  #if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP) && WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_APP)
+    #define IS_UWP 1
+  #endif
+#endif
+
+static
+int open_gl(void) {
+#ifndef IS_UWP
+    libGL = LoadLibraryW(L"opengl32.dll");
+    if(libGL != NULL) {
+        void (* tmp)(void);
+        tmp = (void(*)(void)) GetProcAddress(libGL, "wglGetProcAddress");
+        gladGetProcAddressPtr = (PFNWGLGETPROCADDRESSPROC_PRIVATE) tmp;
+        return gladGetProcAddressPtr != NULL;
+    }
+#endif
+
+    return 0;
+}
+
+static
+void close_gl(void) {
+    if(libGL != NULL) {
+        FreeLibrary((HMODULE) libGL);
+        libGL = NULL;
+    }
+}
+#else
+#include <dlfcn.h>
+static void* libGL;
+
+#if !defined(__APPLE__) && !defined(__HAIKU__)
+typedef void* (APIENTRYP PFNGLXGETPROCADDRESSPROC_PRIVATE)(const char*);
+static PFNGLXGETPROCADDRESSPROC_PRIVATE gladGetProcAddressPtr;
+#endif
+
+static
+int open_gl(void) {
+#ifdef __APPLE__
+    static const char *NAMES[] = {
+        "../Frameworks/OpenGL.framework/OpenGL",
+        "/Library/Frameworks/OpenGL.framework/OpenGL",
+        "/System/Library/Frameworks/OpenGL.framework/OpenGL",
+        "/System/Library/Frameworks/OpenGL.framework/Versions/Current/OpenGL"
+    };
+#else
+    static const char *NAMES[] = {"libGL.so.1", "libGL.so"};
+#endif
+
+    unsigned int index = 0;
+    for(index = 0; index < (sizeof(NAMES) / sizeof(NAMES[0])); index++) {
+        libGL = dlopen(NAMES[index], RTLD_NOW | RTLD_GLOBAL);
+
+        if(libGL != NULL) {
+#if defined(__APPLE__) || defined(__HAIKU__)
+            return 1;
+#else
+            gladGetProcAddressPtr = (PFNGLXGETPROCADDRESSPROC_PRIVATE)dlsym(libGL,
+                "glXGetProcAddressARB");
+            return gladGetProcAddressPtr != NULL;
+#endif
+        }
+    }
+
+    return 0;
+}
+
+static
+void close_gl(void) {
+    if(libGL != NULL) {
+        dlclose(libGL);
+        libGL = NULL;
+    }
+}
+#endif
+
+static
+void* get_proc(const char *namez) {
+    void* result = NULL;
+    if(libGL == NULL) return NULL;
+
+#if !defined(__APPLE__) && !defined(__HAIKU__)
+    if(gladGetProcAddressPtr != NULL) {
+        result = gladGetProcAddressPtr(namez);
+    }
+#endif
+    if(result == NULL) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+        result = (void*)GetProcAddress((HMODULE) libGL, namez);
+#else
+        result = dlsym(libGL, namez);
+#endif
+    }
+
+    return result;
+}
+
+int gladLoadGL(void) {
+    int status = 0;
+
+    if(open_gl()) {
+        status = gladLoadGLLoader(&get_proc);
+        close_gl();
+    }
+
+    return status;
+}
+
+struct gladGLversionStruct GLVersion = { 0, 0 };
+
+"""
+for name, _, _, _, functions in versions:
+    loader+="int GLAD_%s = 0;\n" % name
+for name, _, _, _, functions in versions:
+    for returnType, pfn, parameters in functions:
+        loader+="PFN%sPROC glad_%s = NULL;\n" % (pfn, entry_point(pfn))
+for name, _, _, _, functions in versions:
+    loader+="static void load_%s(GLADloadproc load) {\n\tif(!GLAD_%s) return;\n" % (name, name)
+    for returnType, pfn, parameters in functions:
+        function=entry_point(pfn)
+        loader+="\tglad_%s = (PFN%sPROC)load(\"%s\");\n" % (function, pfn, function)
+    loader+="}\n"
+loader+="""static void find_coreGL(void) {
+
+    /* Thank you @elmindreda
+     * https://github.com/elmindreda/greg/blob/master/templates/greg.c.in#L176
+     * https://github.com/glfw/glfw/blob/master/src/context.c#L36
+     */
+    int i, major, minor;
+
+    const char* version;
+    const char* prefixes[] = {
+        "OpenGL ES-CM ",
+        "OpenGL ES-CL ",
+        "OpenGL ES ",
+        NULL
+    };
+
+    version = (const char*) glGetString(GL_VERSION);
+    if (!version) return;
+
+    for (i = 0;  prefixes[i];  i++) {
+        const size_t length = strlen(prefixes[i]);
+        if (strncmp(version, prefixes[i], length) == 0) {
+            version += length;
+            break;
+        }
+    }
+
+#ifdef _MSC_VER
+    sscanf_s(version, "%d.%d", &major, &minor);
+#else
+    sscanf(version, "%d.%d", &major, &minor);
+#endif
+
+    GLVersion.major = major; GLVersion.minor = minor;
+"""
+for name, blockMajor, blockMinor, _, _ in versions:
+    loader+="\tGLAD_%s = (major == %d && minor >= %d) || major > %d;\n" % (name, blockMajor, blockMinor, blockMajor)
+loader+="""}
+
+int gladLoadGLLoader(GLADloadproc load) {
+\tGLVersion.major = 0; GLVersion.minor = 0;
+\tglGetString = (PFNGLGETSTRINGPROC)load("glGetString");
+\tif(glGetString == NULL) return 0;
+\tif(glGetString(GL_VERSION) == NULL) return 0;
+\tfind_coreGL();
+"""
+for name, _, _, _, _ in versions:
+    loader+="\tload_%s(load);\n" % name
+loader+="""
+\treturn GLVersion.major != 0 || GLVersion.minor != 0;
+}
+"""
+
+for directory in ["include/glad", "include/KHR", "src"]:
+    os.makedirs(os.path.join(args.output, directory), exist_ok=True)
+open(os.path.join(args.output, "include/glad/glad.h"), "w").write(header)
+open(os.path.join(args.output, "include/KHR/khrplatform.h"), "w").write(khr)
+open(os.path.join(args.output, "src/glad.c"), "w").write(loader)
+print("Wrote a GL %d.%d core loader with %d functions to %s" % (major, minor, sum(len(version[4]) for version in versions), args.output))
@@ -0,0 +1,124 @@
+# Generates the sandbox's flipbook sheet, assets/particles.ktx: a 4x4 grid of
+# soft white puffs that grow and fade over the 16 frames, row-major from the
+# top left, as a KTX 1.1 texture with mips.
+#   python3 tools/GenerateParticleSheet.py [--size 256] [--uncompressed] [--output ./assets/particles.ktx]
+# Colour comes from the particle, so the sheet is white and only alpha varies.
+# By default it is BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM, core since GL 4.2), a
+# byte per texel instead of RGBA8's four; --uncompressed writes RGBA8.
+# The mip chain stops at 4x4, one BC7 block and a texel per frame, so frames
+# never blend together.
+import argparse
+import math
+import struct
+
+parser=argparse.ArgumentParser()
+parser.add_argument("--size", type=int, default=256, help="sheet width and height, a power of two of at least 4")
+parser.add_argument("--uncompressed", action="store_true", help="write RGBA8 instead of BC7")
+parser.add_argument("--output", default="./assets/particles.ktx")
+args=parser.parse_args()
+
+GRID=4
+FRAMES=GRID*GRID
+size=args.size
+frameSize=size//GRID
+if size<GRID or size&(size-1):
+    parser.error("--size must be a power of two of at least 4")
+
+def puff(frame, x, y):
+    # Radius grows and alpha falls over the flipbook; a few lobes keep it from looking like a disc
+    t=frame/(FRAMES-1)
+    radius=0.55+0.4*t
+    dx=(x+0.5)/frameSize*2.0-1.0
+    dy=(y+0.5)/frameSize*2.0-1.0
+    angle=math.atan2(dy, dx)
+    distance=math.hypot(dx, dy)/(radius*(1.0+0.08*math.sin(5.0*angle+frame*0.7)))
+    if distance>=1.0:
+        return 0.0
+    return (1.0-distance*distance)**2*(1.0-0.85*t)
+
+alpha=[[0.0]*size for _ in range(size)]
+for frame in range(FRAMES):
+    left=(frame%GRID)*frameSize
+    top=(frame//GRID)*frameSize
+    for y in range(frameSize):
+        for x in range(frameSize):
+            alpha[top+y][left+x]=puff(frame, x, y)
+
+# 2x2 box filter per level; white texels, so alpha is all that is filtered
+levels=[alpha]
+while len(levels[-1])>GRID:
+    previous=levels[-1]
+    half=len(previous)//2
+    levels.append([[(previous[2*y][2*x]+previous[2*y][2*x+1]+previous[2*y+1][2*x]+previous[2*y+1][2*x+1])*0.25
+        for x in range(half)] for y in range(half)])
+
+# BC7 mode 6: one subset, RGBA endpoints of 7 bits plus a shared low bit each, 4-bit indices.
+# RGB stays white; the alpha endpoints are the block's extremes, the larger one odd (low bit 1,
+# so its RGB is 255) and the smaller one even, so fully transparent texels stay exactly 0.
+BC7_WEIGHTS=[0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64]
+
+def encode_bc7(block):
+    high=min(255, max(block)|1)
+    low=min(block)&~1
+    endpoints=[(high>>1, 1), (low>>1, 0)]
+    palette=[((64-weight)*high+weight*low+32)>>6 for weight in BC7_WEIGHTS]
+    indices=[min(range(16), key=lambda i: abs(palette[i]-value)) for value in block]
+    # The first texel's index is stored with 3 bits, so it must be below 8
+    if indices[0]>=8:
+        endpoints.reverse()
+        indices=[15-index for index in indices]
+
+    bits=1<<6
+    position=7
+    def put(value, count):
+        nonlocal bits, position
+        bits|=value<<position
+        position+=count
+    for channel in range(3):
+        put(127, 7)
+        put(127, 7)
+    put(endpoints[0][0], 7)
+    put(endpoints[1][0], 7)
+    put(endpoints[0][1], 1)
+    put(endpoints[1][1], 1)
+    for texel, index in enumerate(indices):
+        put(index, 3 if texel==0 else 4)
+    return bits.to_bytes(16, "little")
+
+def to_bytes(value):
+    return min(255, int(value*255.0+0.5))
+
+def level_data(level):
+    if args.uncompressed:
+        # RGBA8 rows are always a multiple of 4 bytes, so no row or level padding is needed
+        data=bytearray()
+        for row in level:
+            for value in row:
+                data+=bytes((255, 255, 255, to_bytes(value)))
+        return data
+    data=bytearray()
+    for top in range(0, len(level), 4):
+        for left in range(0, len(level), 4):
+            data+=encode_bc7([to_bytes(level[top+y][left+x]) for y in range(4) for x in range(4)])
+    return data
+
+GL_UNSIGNED_BYTE=0x1401
+GL_RGBA=0x1908
+GL_RGBA8=0x8058
+GL_COMPRESSED_RGBA_BPTC_UNORM=0x8E8C
+identifier=bytes([0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A])
+if args.uncompressed:
+    header=struct.pack("<13I", 0x04030201, GL_UNSIGNED_BYTE, 1, GL_RGBA, GL_RGBA8, GL_RGBA, size, size, 0, 0, 1, len(levels), 0)
+else:
+    # Compressed: glType and glFormat are 0
+    header=struct.pack("<13I", 0x04030201, 0, 1, 0, GL_COMPRESSED_RGBA_BPTC_UNORM, GL_RGBA, size, size, 0, 0, 1, len(levels), 0)
+
+with open(args.output, "wb") as file:
+    file.write(identifier+header)
+    for level in levels:
+        # Both formats give levels that are a multiple of 4 bytes, so no mip padding either
+        data=level_data(level)
+        file.write(struct.pack("<I", len(data)))
+        file.write(data)
+
+print("Wrote "+args.output+": "+str(size)+"x"+str(size)+(" RGBA8" if args.uncompressed else " BC7")+", "+str(len(levels))+" levels")
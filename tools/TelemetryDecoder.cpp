@@ -0,0 +1,167 @@
+// Decodes TelemetryWriter logs into CSV and a percentile summary:
+//     TelemetryDecoder [--csv output.csv] log.ptel [log.ptel ...]
+// Logs are read in the order given; pass a session's files sorted by name.
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+struct Column
+{
+	const char* Name;
+	double (*Get)(const TelemetryRecord& record);
+};
+
+static const Column s_Columns[] = {
+	{ "frame_ms", [](const TelemetryRecord& r) { return (double)r.FrameMs; } },
+	{ "update_ms", [](const TelemetryRecord& r) { return (double)r.UpdateMs; } },
+	{ "render_ms", [](const TelemetryRecord& r) { return (double)r.RenderMs; } },
+	{ "present_ms", [](const TelemetryRecord& r) { return (double)r.PresentMs; } },
+	{ "particles", [](const TelemetryRecord& r) { return (double)r.LiveParticles; } },
+	{ "commands", [](const TelemetryRecord& r) { return (double)r.CommandCount; } },
+	{ "allocations", [](const TelemetryRecord& r) { return (double)r.Allocations; } },
+	{ "allocated_kb", [](const TelemetryRecord& r) { return r.AllocatedBytes / 1024.0; } },
+	{ "uploaded_kb", [](const TelemetryRecord& r) { return r.UploadedBytes / 1024.0; } },
+};
+
+static std::string FormatTime(uint64_t unixNs)
+{
+	std::time_t time = (std::time_t)(unixNs / 1000000000ull);
+	char text[32];
+	std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", std::localtime(&time));
+	return text;
+}
+
+static bool ReadLog(const char* filepath, std::vector<TelemetryRecord>& records, uint64_t& sessionStartNs)
+{
+	FILE* file = std::fopen(filepath, "rb");
+	if (!file)
+	{
+		std::fprintf(stderr, "could not open %s\n", filepath);
+		return false;
+	}
+
+	TelemetryFileHeader header;
+	if (std::fread(&header, sizeof(header), 1, file) != 1 || header.Magic != TelemetryFileMagic || header.Version != TelemetryFileVersion
+		|| header.RecordSize < sizeof(TelemetryRecord))
+	{
+		std::fprintf(stderr, "%s: not a telemetry log\n", filepath);
+		std::fclose(file);
+		return false;
+	}
+	sessionStartNs = header.SessionStartNs;
+
+	// Larger records come from newer writers; their extra fields are skipped
+	std::vector<uint8_t> buffer(header.RecordSize);
+	while (std::fread(buffer.data(), header.RecordSize, 1, file) == 1)
+	{
+		TelemetryRecord record;
+		std::memcpy(&record, buffer.data(), sizeof(record));
+		records.push_back(record);
+	}
+	std::fclose(file);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	const char* csvPath = nullptr;
+	std::vector<const char*> logs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+			csvPath = argv[++i];
+		else
+			logs.push_back(argv[i]);
+	}
+	if (logs.empty())
+	{
+		std::printf("usage: TelemetryDecoder [--csv output.csv] log.ptel [log.ptel ...]\n");
+		return 1;
+	}
+
+	std::vector<TelemetryRecord> records;
+	uint64_t sessionStartNs = 0;
+	for (const char* log : logs)
+	{
+		if (!ReadLog(log, records, sessionStartNs))
+			return 1;
+	}
+	if (records.empty())
+	{
+		std::printf("no records\n");
+		return 0;
+	}
+
+	if (csvPath)
+	{
+		FILE* csv = std::fopen(csvPath, "w");
+		if (!csv)
+		{
+			std::fprintf(stderr, "could not write %s\n", csvPath);
+			return 1;
+		}
+		std::fprintf(csv, "frame,time_s");
+		for (const Column& column : s_Columns)
+			std::fprintf(csv, ",%s", column.Name);
+		std::fprintf(csv, "\n");
+		for (const TelemetryRecord& record : records)
+		{
+			std::fprintf(csv, "%llu,%.6f", (unsigned long long)record.Frame, record.TimeNs * 1e-9);
+			for (const Column& column : s_Columns)
+				std::fprintf(csv, ",%.4f", column.Get(record));
+			std::fprintf(csv, "\n");
+		}
+		std::fclose(csv);
+	}
+
+	// Frames the writer dropped show up as gaps in the frame counter
+	uint64_t missing = 0;
+	for (size_t i = 1; i < records.size(); i++)
+	{
+		if (records[i].Frame > records[i - 1].Frame + 1)
+			missing += records[i].Frame - records[i - 1].Frame - 1;
+	}
+
+	double seconds = (records.back().TimeNs - records.front().TimeNs) * 1e-9;
+	std::printf("session %s, %zu records over %.1f s, %llu frames missing\n\n", FormatTime(sessionStartNs).c_str(),
+		records.size(), seconds, (unsigned long long)missing);
+
+	std::printf("%-14s %10s %10s %10s %10s %10s %10s\n", "", "mean", "p50", "p95", "p99", "p99.9", "max");
+	std::vector<double> values(records.size());
+	for (const Column& column : s_Columns)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			values[i] = column.Get(records[i]);
+			sum += values[i];
+		}
+		std::sort(values.begin(), values.end());
+		auto percentile = [&](double p) { return values[std::min(values.size() - 1, (size_t)(p * values.size()))]; };
+		std::printf("%-14s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", column.Name, sum / values.size(),
+			percentile(0.5), percentile(0.95), percentile(0.99), percentile(0.999), values.back());
+	}
+
+	// Worst frames with wall-clock times, to line spikes up with whatever else happened at night
+	std::vector<size_t> order(records.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	size_t worst = std::min<size_t>(10, order.size());
+	std::partial_sort(order.begin(), order.begin() + worst, order.end(),
+		[&](size_t a, size_t b) { return records[a].FrameMs > records[b].FrameMs; });
+
+	std::printf("\nslowest frames\n");
+	for (size_t i = 0; i < worst; i++)
+	{
+		const TelemetryRecord& record = records[order[i]];
+		std::printf("  %s  frame %-10llu %8.2f ms (update %.2f, render %.2f, present %.2f, %u allocations)\n",
+			FormatTime(sessionStartNs + record.TimeNs).c_str(), (unsigned long long)record.Frame,
+			record.FrameMs, record.UpdateMs, record.RenderMs, record.PresentMs, record.Allocations);
+	}
+	return 0;
+}